@@ -0,0 +1,95 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+/*
+ * Convert the text matrix files of MmWaveBeamforming in a directory to the
+ * binary format, writing a .bin file next to each .txt file, and check that
+ * the two versions hold the same values. MmWaveBeamforming then maps the
+ * binary files instead of parsing the text ones.
+ *
+ * ./waf --run "mmwave-beamforming-matrix-converter --directory=src/mmwave/model/BeamFormingMatrix"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-beamforming-matrix.h"
+#include <iostream>
+#include <cstring>
+
+using namespace ns3;
+
+static bool
+Convert (std::string directory, std::string name, uint32_t rowsPerInstance, bool complex)
+{
+	std::string input = directory + "/" + name + ".txt";
+	std::string output = directory + "/" + name + ".bin";
+	if (!BeamformingMatrixFile::ConvertTextFile (input, output, rowsPerInstance, complex))
+	{
+		std::cerr << "Cannot convert " << input << " to " << output << std::endl;
+		return false;
+	}
+
+	BeamformingMatrixFile text;
+	BeamformingMatrixFile binary;
+	if (!text.Load (input, rowsPerInstance, complex) || !binary.Load (output, rowsPerInstance, complex)
+			|| !binary.IsMapped () || text.GetNumInstance () != binary.GetNumInstance ()
+			|| text.GetNumColumns () != binary.GetNumColumns ())
+	{
+		std::cerr << "Cannot read back " << output << std::endl;
+		return false;
+	}
+	std::size_t rowSize = text.GetNumColumns () * sizeof (double) * (complex ? 2 : 1);
+	for (uint32_t instance = 0; instance < text.GetNumInstance (); instance++)
+	{
+		for (uint32_t row = 0; row < rowsPerInstance; row++)
+		{
+			if (std::memcmp (text.GetRealRow (instance, row), binary.GetRealRow (instance, row), rowSize) != 0)
+			{
+				std::cerr << "Instance " << instance << " differs in " << output << std::endl;
+				return false;
+			}
+		}
+	}
+
+	std::cout << "Converted " << name << " [instance:" << binary.GetNumInstance () << "][row:"
+			<< binary.GetNumRows () << "][column:" << binary.GetNumColumns () << "]" << std::endl;
+	return true;
+}
+
+int
+main (int argc, char *argv[])
+{
+	std::string directory = "src/mmwave/model/BeamFormingMatrix";
+	uint32_t pathNum = 20;
+
+	CommandLine cmd;
+	cmd.AddValue ("directory", "The directory of the matrix files", directory);
+	cmd.AddValue ("pathNum", "The number of paths of the spatial signatures", pathNum);
+	cmd.Parse (argc, argv);
+
+	bool ok = Convert (directory, "SmallScaleFading", 1, false)
+			&& Convert (directory, "TxAntenna", 1, true)
+			&& Convert (directory, "RxAntenna", 1, true)
+			&& Convert (directory, "TxSpatialSigniture", pathNum, true)
+			&& Convert (directory, "RxSpatialSigniture", pathNum, true);
+	return ok ? 0 : 1;
+}
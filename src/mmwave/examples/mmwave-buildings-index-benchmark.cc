@@ -0,0 +1,163 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Regression check and microbenchmark of MmWaveBuildingsIndex. A city grid of
+ * buildings is created and nodes are dropped at random in the streets and on
+ * the roofs. For every pair of nodes, the LOS decision of
+ * MmWave3gppBuildingsPropagationLossModel (segment against the buildings) and
+ * of BuildingsObstaclePropagationLossModel and MmWaveLosTracker (angular
+ * test) is computed both with the linear scan over the BuildingList and with
+ * the grid index. The decisions must be identical for every pair; the program
+ * returns 1 on the first mismatch.
+ *
+ * ./waf --run "mmwave-buildings-index-benchmark --blocks=60 --nodes=300"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/buildings-module.h"
+#include "ns3/mmwave-buildings-index.h"
+#include <iostream>
+
+using namespace ns3;
+
+static bool
+LinearIsLineIntersectBuildings (Vector L1, Vector L2)
+{
+	for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
+	{
+		if (MmWaveBuildingsIndex::IsLineIntersectBox (L1, L2, (*bit)->GetBoundaries ()))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+LinearIsLinkObstructed (Vector a, Vector b)
+{
+	double angle = MmWaveBuildingsIndex::OrientLink (a, b);
+	for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
+	{
+		if (MmWaveBuildingsIndex::IsLinkObstructedByBox (a, b, angle, (*bit)->GetBoundaries ()))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int
+main (int argc, char *argv[])
+{
+	uint32_t blocks = 60;
+	uint32_t nodes = 300;
+	double buildingSize = 40;
+	double streetWidth = 20;
+
+	CommandLine cmd;
+	cmd.AddValue ("blocks", "Number of blocks per side of the city grid", blocks);
+	cmd.AddValue ("nodes", "Number of nodes", nodes);
+	cmd.AddValue ("buildingSize", "Side of the buildings [m]", buildingSize);
+	cmd.AddValue ("streetWidth", "Width of the streets [m]", streetWidth);
+	cmd.Parse (argc, argv);
+
+	Ptr<UniformRandomVariable> height = CreateObject<UniformRandomVariable> ();
+	height->SetAttribute ("Min", DoubleValue (10));
+	height->SetAttribute ("Max", DoubleValue (40));
+	double pitch = buildingSize + streetWidth;
+	for (uint32_t row = 0; row < blocks; row++)
+	{
+		for (uint32_t col = 0; col < blocks; col++)
+		{
+			Ptr<Building> building = CreateObject<Building> ();
+			building->SetBoundaries (Box (col * pitch, col * pitch + buildingSize,
+					row * pitch, row * pitch + buildingSize, 0, height->GetValue ()));
+		}
+	}
+
+	// nodes at street level and on top of the buildings
+	Ptr<UniformRandomVariable> coordinate = CreateObject<UniformRandomVariable> ();
+	coordinate->SetAttribute ("Min", DoubleValue (-streetWidth));
+	coordinate->SetAttribute ("Max", DoubleValue (blocks * pitch));
+	std::vector<Vector> positions;
+	for (uint32_t i = 0; i < nodes; i++)
+	{
+		positions.push_back (Vector (coordinate->GetValue (), coordinate->GetValue (), i % 4 == 0 ? 45.0 : 1.5));
+	}
+
+	uint64_t pairs = (uint64_t) nodes * nodes;
+	SystemWallClockMs clock;
+	uint32_t linearLine = 0;
+	uint32_t linearObstructed = 0;
+	clock.Start ();
+	for (uint32_t a = 0; a < nodes; a++)
+	{
+		for (uint32_t b = 0; b < nodes; b++)
+		{
+			linearLine += LinearIsLineIntersectBuildings (positions[a], positions[b]);
+			linearObstructed += LinearIsLinkObstructed (positions[a], positions[b]);
+		}
+	}
+	int64_t linearMs = clock.End ();
+
+	MmWaveBuildingsIndex *index = MmWaveBuildingsIndex::Get ();
+	uint32_t indexLine = 0;
+	uint32_t indexObstructed = 0;
+	clock.Start ();
+	for (uint32_t a = 0; a < nodes; a++)
+	{
+		for (uint32_t b = 0; b < nodes; b++)
+		{
+			indexLine += index->IsLineIntersectBuildings (positions[a], positions[b]);
+			indexObstructed += index->IsLinkObstructed (positions[a], positions[b]);
+		}
+	}
+	int64_t indexMs = clock.End ();
+
+	uint32_t errors = 0;
+	for (uint32_t a = 0; a < nodes && errors == 0; a++)
+	{
+		for (uint32_t b = 0; b < nodes; b++)
+		{
+			if (LinearIsLineIntersectBuildings (positions[a], positions[b]) != index->IsLineIntersectBuildings (positions[a], positions[b])
+					|| LinearIsLinkObstructed (positions[a], positions[b]) != index->IsLinkObstructed (positions[a], positions[b]))
+			{
+				std::cerr << "nodes " << a << " " << positions[a] << " and " << b << " " << positions[b]
+						<< ": different decision" << std::endl;
+				errors++;
+				break;
+			}
+		}
+	}
+
+	std::cout << BuildingList::GetNBuildings () << " buildings, " << pairs << " links, "
+			<< indexLine << " intersect a building, " << indexObstructed << " obstructed" << std::endl;
+	std::cout << "linear scan: " << linearMs << " ms" << std::endl;
+	std::cout << "grid index:  " << indexMs << " ms" << std::endl;
+	if (indexMs > 0)
+	{
+		std::cout << "speedup:     " << (double)linearMs / indexMs << "x" << std::endl;
+	}
+	std::cout << "mismatches:  " << errors + (linearLine != indexLine) + (linearObstructed != indexObstructed) << std::endl;
+
+	Simulator::Destroy ();
+	return errors == 0 && linearLine == indexLine && linearObstructed == indexObstructed ? 0 : 1;
+}
@@ -0,0 +1,287 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+/*
+ * Microbenchmark of the channel matrix kernels used by MmWave3gppChannel.
+ * The nested complex3DVector_t implementation with bounds-checked accesses
+ * (the one used before the introduction of ChannelTensor) is compared against
+ * the flat ChannelTensor kernels, for the spatial correlation matrices of
+ * LongTermCovMatrixBeamforming and the per-cluster gain of CalLongTerm.
+ * The two EigenSolver options of MmWave3gppChannel are compared as well.
+ *
+ * ./waf --run "mmwave-channel-tensor-benchmark --txAntenna=64 --rxAntenna=16 --clusters=23"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-channel-tensor.h"
+#include <iostream>
+
+using namespace ns3;
+
+typedef std::vector<complexVector_t> complex2DVector_t;
+typedef std::vector<complex2DVector_t> complex3DVector_t;
+
+static void
+NestedTxCovariance (const complex3DVector_t &H, complex2DVector_t &txQ)
+{
+	uint16_t txSize = H.at(0).size();
+	uint16_t rxSize = H.size();
+	txQ.assign(txSize, complexVector_t (txSize));
+	for (uint16_t t1Index = 0; t1Index < txSize; t1Index++)
+	{
+		for (uint16_t t2Index = 0; t2Index < txSize; t2Index++)
+		{
+			for(uint16_t rxIndex = 0; rxIndex < rxSize; rxIndex++)
+			{
+				std::complex<double> cSum (0,0);
+				for (uint16_t cIndex = 0; cIndex < H.at(rxIndex).at(t1Index).size(); cIndex++)
+				{
+					cSum = cSum + std::conj(H.at(rxIndex).at(t1Index).at(cIndex))*
+							(H.at(rxIndex).at(t2Index).at(cIndex));
+				}
+				txQ[t1Index][t2Index] += cSum;
+			}
+		}
+	}
+}
+
+static void
+NestedRxCovariance (const complex3DVector_t &H, complex2DVector_t &rxQ)
+{
+	uint16_t txSize = H.at(0).size();
+	uint16_t rxSize = H.size();
+	rxQ.assign(rxSize, complexVector_t (rxSize));
+	for (uint16_t r1Index = 0; r1Index < rxSize; r1Index++)
+	{
+		for (uint16_t r2Index = 0; r2Index < rxSize; r2Index++)
+		{
+			for(uint16_t txIndex = 0; txIndex < txSize; txIndex++)
+			{
+				std::complex<double> cSum (0,0);
+				for (uint16_t cIndex = 0; cIndex < H.at(r1Index).at(txIndex).size(); cIndex++)
+				{
+					cSum = cSum + H.at(r1Index).at(txIndex).at(cIndex)*
+							std::conj(H.at(r2Index).at(txIndex).at(cIndex));
+				}
+				rxQ[r1Index][r2Index] += cSum;
+			}
+		}
+	}
+}
+
+static void
+NestedClusterGain (const complex3DVector_t &H, const complexVector_t &txW,
+		const complexVector_t &rxW, complexVector_t &longTerm)
+{
+	longTerm.clear();
+	uint16_t numCluster = H.at(0).at(0).size();
+	for (uint16_t cIndex = 0; cIndex < numCluster; cIndex++)
+	{
+		std::complex<double> txSum(0,0);
+		for(uint16_t txIndex = 0; txIndex < txW.size(); txIndex++)
+		{
+			std::complex<double> rxSum(0,0);
+			for (uint16_t rxIndex = 0; rxIndex < rxW.size(); rxIndex++)
+			{
+				rxSum = rxSum + std::conj(rxW.at(rxIndex))*H.at(rxIndex).at(txIndex).at(cIndex);
+			}
+			txSum = txSum + txW.at(txIndex)*rxSum;
+		}
+		longTerm.push_back(txSum);
+	}
+}
+
+static complexVector_t
+NestedPowerMethod (const complex2DVector_t &Q)
+{
+	complexVector_t antennaWeights = Q.at (0);
+	int iter = 10;
+	double diff = 1;
+	while(iter != 0 && diff>1e-10)
+	{
+		complexVector_t antennaWeights_New;
+		for(uint16_t row = 0; row<Q.size (); row++)
+		{
+			std::complex<double> sum(0,0);
+			for (uint16_t col = 0; col< Q.size (); col++)
+			{
+				sum += Q.at (row).at (col)*antennaWeights.at (col);
+			}
+			antennaWeights_New.push_back(sum);
+		}
+		double weightSum = 0;
+		for (uint16_t i = 0; i< Q.size (); i++)
+		{
+			weightSum += norm(antennaWeights_New. at(i));
+		}
+		diff = 0;
+		for (uint16_t i = 0; i< Q.size (); i++)
+		{
+			antennaWeights_New. at(i) = antennaWeights_New. at(i)/sqrt(weightSum);
+			diff += std::norm(antennaWeights_New. at(i)-antennaWeights. at(i));
+		}
+		iter--;
+		antennaWeights = antennaWeights_New;
+	}
+	return antennaWeights;
+}
+
+int
+main (int argc, char *argv[])
+{
+	uint32_t txAntenna = 64;
+	uint32_t rxAntenna = 16;
+	uint32_t clusters = 23;
+	uint32_t iterations = 100;
+
+	CommandLine cmd;
+	cmd.AddValue ("txAntenna", "Number of transmit antenna elements", txAntenna);
+	cmd.AddValue ("rxAntenna", "Number of receive antenna elements", rxAntenna);
+	cmd.AddValue ("clusters", "Number of clusters (including sub-clusters)", clusters);
+	cmd.AddValue ("iterations", "Number of repetitions of each kernel", iterations);
+	cmd.Parse (argc, argv);
+
+	// each cluster is a plane wave on two uniform linear arrays, with an exponential
+	// power delay profile, so that the correlation matrices have a dominant eigenvector
+	// as in the 3GPP channel
+	Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+	complex3DVector_t nested (rxAntenna, complex2DVector_t (txAntenna, complexVector_t (clusters)));
+	ChannelTensor tensor;
+	tensor.Resize (rxAntenna, txAntenna, clusters);
+	for (uint32_t n = 0; n < clusters; n++)
+	{
+		double rxSin = sin (rv->GetValue (-M_PI / 2, M_PI / 2));
+		double txSin = sin (rv->GetValue (-M_PI / 2, M_PI / 2));
+		double phase = rv->GetValue (-M_PI, M_PI);
+		double amplitude = exp (-0.5 * n);
+		for (uint32_t u = 0; u < rxAntenna; u++)
+		{
+			for (uint32_t s = 0; s < txAntenna; s++)
+			{
+				std::complex<double> h = amplitude * exp (std::complex<double> (0, phase + M_PI * (u * rxSin + s * txSin)));
+				nested[u][s][n] = h;
+				tensor.Set (u, s, n, h);
+			}
+		}
+	}
+	complexVector_t txW (txAntenna), rxW (rxAntenna);
+	for (uint32_t s = 0; s < txAntenna; s++)
+	{
+		txW[s] = std::complex<double> (rv->GetValue (-1, 1), rv->GetValue (-1, 1));
+	}
+	for (uint32_t u = 0; u < rxAntenna; u++)
+	{
+		rxW[u] = std::complex<double> (rv->GetValue (-1, 1), rv->GetValue (-1, 1));
+	}
+
+	SystemWallClockMs clock;
+	complex2DVector_t nestedTxQ, nestedRxQ;
+	complexVector_t flatTxQ, flatRxQ, nestedGain, flatGain;
+
+	clock.Start ();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		NestedTxCovariance (nested, nestedTxQ);
+		NestedRxCovariance (nested, nestedRxQ);
+		NestedClusterGain (nested, txW, rxW, nestedGain);
+	}
+	int64_t nestedMs = clock.End ();
+
+	clock.Start ();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		tensor.TxCovariance (flatTxQ);
+		tensor.RxCovariance (flatRxQ);
+		tensor.ClusterGain (txW, rxW, flatGain);
+	}
+	int64_t tensorMs = clock.End ();
+
+	double maxError = 0;
+	for (uint32_t t1 = 0; t1 < txAntenna; t1++)
+	{
+		for (uint32_t t2 = 0; t2 < txAntenna; t2++)
+		{
+			maxError = std::max (maxError, std::abs (nestedTxQ[t1][t2] - flatTxQ[t1 * txAntenna + t2]));
+		}
+	}
+	for (uint32_t r1 = 0; r1 < rxAntenna; r1++)
+	{
+		for (uint32_t r2 = 0; r2 < rxAntenna; r2++)
+		{
+			maxError = std::max (maxError, std::abs (nestedRxQ[r1][r2] - flatRxQ[r1 * rxAntenna + r2]));
+		}
+	}
+	for (uint32_t n = 0; n < clusters; n++)
+	{
+		maxError = std::max (maxError, std::abs (nestedGain[n] - flatGain[n]));
+	}
+
+	std::cout << "H[" << rxAntenna << "][" << txAntenna << "][" << clusters << "], "
+			<< iterations << " iterations" << std::endl;
+	std::cout << "complex3DVector_t: " << nestedMs << " ms" << std::endl;
+	std::cout << "ChannelTensor:     " << tensorMs << " ms" << std::endl;
+	if (tensorMs > 0)
+	{
+		std::cout << "speedup:           " << (double)nestedMs / tensorMs << "x" << std::endl;
+	}
+	std::cout << "max abs error:     " << maxError << std::endl;
+
+	// dominant eigenvector of the tx correlation matrix: legacy power method,
+	// blocked solver from the first row of Q and blocked solver warm-started
+	// from the previous solution, as done for a spatially consistent update
+	CovarianceEigenSolver solver;
+	complexVector_t legacyW, coldW, warmW, noInitial;
+	clock.Start ();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		legacyW = NestedPowerMethod (nestedTxQ);
+	}
+	int64_t legacyMs = clock.End ();
+	uint16_t coldIter = 0;
+	clock.Start ();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		coldIter = solver.Solve (flatTxQ, txAntenna, noInitial, coldW);
+	}
+	int64_t coldMs = clock.End ();
+	uint16_t warmIter = 0;
+	clock.Start ();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		warmW = coldW;
+		warmIter = solver.Solve (flatTxQ, txAntenna, warmW, warmW);
+	}
+	int64_t warmMs = clock.End ();
+
+	std::complex<double> alignment (0, 0);
+	for (uint32_t s = 0; s < txAntenna; s++)
+	{
+		alignment += std::conj (legacyW[s]) * coldW[s];
+	}
+	std::cout << "power method (legacy):        " << legacyMs << " ms" << std::endl;
+	std::cout << "blocked power method (cold):  " << coldMs << " ms, " << coldIter << " iterations" << std::endl;
+	std::cout << "blocked power method (warm):  " << warmMs << " ms, " << warmIter << " iterations" << std::endl;
+	std::cout << "|<legacy, blocked>|:          " << std::abs (alignment) << std::endl;
+
+	return 0;
+}
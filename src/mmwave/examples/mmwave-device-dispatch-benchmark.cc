@@ -0,0 +1,196 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+/*
+ * Regression check and microbenchmark of MmWaveSpectrumPhy::IsNeglectedTransmission.
+ * A dense deployment of eNBs, IAB nodes and UEs is installed, and every pair of
+ * their spectrum PHYs is evaluated both with the chain of DynamicCasts of the
+ * transmitting device used by StartRx before the device kind was cached, and with
+ * the current switch on the cached kinds. The two decisions must be identical for
+ * every pair; the program returns 1 on the first mismatch.
+ *
+ * ./waf --run "mmwave-device-dispatch-benchmark --ues=500 --rounds=20"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/mmwave-helper.h"
+#include <iostream>
+
+using namespace ns3;
+
+static bool
+LegacyIsNeglectedTransmission (Ptr<MmWaveSpectrumPhy> rxPhy, Ptr<SpectrumPhy> txPhy)
+{
+	Ptr<MmWaveEnbNetDevice> EnbTx  = DynamicCast<MmWaveEnbNetDevice> (txPhy->GetDevice ());
+	Ptr<MmWaveUeNetDevice>  UeTx   = DynamicCast<MmWaveUeNetDevice> (txPhy->GetDevice ());
+	Ptr<McUeNetDevice>      McUeTx = DynamicCast<McUeNetDevice> (txPhy->GetDevice ());
+	Ptr<MmWaveIabNetDevice> iabTx  = DynamicCast<MmWaveIabNetDevice> (txPhy->GetDevice ());
+
+	if ((rxPhy->GetDeviceType () == ENB && EnbTx != 0)
+			|| (rxPhy->GetDeviceType () == UE && UeTx != 0)
+			|| (rxPhy->GetDeviceType () == MCUE && McUeTx != 0)
+			|| (rxPhy->GetDeviceType () == IAB && (rxPhy->GetDevice () == iabTx)))
+	{
+		return true;
+	}
+	if (iabTx && !(DynamicCast<MmWaveSpectrumPhy> (txPhy)->GetAccessSpectrumPhy ())
+			&& (rxPhy->GetDeviceType () == UE || rxPhy->GetDeviceType () == MCUE))
+	{
+		return true;
+	}
+	if (iabTx && !(DynamicCast<MmWaveSpectrumPhy> (txPhy)->GetAccessSpectrumPhy ())
+			&& rxPhy->GetDeviceType () == IAB && !rxPhy->GetAccessSpectrumPhy ())
+	{
+		return true;
+	}
+	if ((rxPhy->GetDeviceType () == IAB) && !rxPhy->GetAccessSpectrumPhy () && (UeTx || McUeTx))
+	{
+		return true;
+	}
+	if (iabTx && (DynamicCast<MmWaveSpectrumPhy> (txPhy)->GetAccessSpectrumPhy ())
+			&& rxPhy->GetDeviceType () == IAB && rxPhy->GetAccessSpectrumPhy ())
+	{
+		return true;
+	}
+	if (EnbTx && rxPhy->GetDeviceType () == IAB && rxPhy->GetAccessSpectrumPhy ())
+	{
+		return true;
+	}
+	if (iabTx && (DynamicCast<MmWaveSpectrumPhy> (txPhy)->GetAccessSpectrumPhy ())
+			&& rxPhy->GetDeviceType () == ENB)
+	{
+		return true;
+	}
+	return false;
+}
+
+int
+main (int argc, char *argv[])
+{
+	uint32_t enbs = 4;
+	uint32_t iabs = 4;
+	uint32_t ues = 500;
+	uint32_t rounds = 20;
+
+	CommandLine cmd;
+	cmd.AddValue ("enbs", "Number of eNBs", enbs);
+	cmd.AddValue ("iabs", "Number of IAB nodes", iabs);
+	cmd.AddValue ("ues", "Number of UEs", ues);
+	cmd.AddValue ("rounds", "Number of evaluations of every pair of PHYs", rounds);
+	cmd.Parse (argc, argv);
+
+	Ptr<MmWaveHelper> mmwaveHelper = CreateObject<MmWaveHelper> ();
+
+	NodeContainer enbNodes, iabNodes, ueNodes;
+	enbNodes.Create (enbs);
+	iabNodes.Create (iabs);
+	ueNodes.Create (ues);
+	MobilityHelper mobility;
+	mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+	mobility.SetPositionAllocator ("ns3::RandomBoxPositionAllocator",
+			"X", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=200.0]"),
+			"Y", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=200.0]"),
+			"Z", StringValue ("ns3::ConstantRandomVariable[Constant=1.5]"));
+	mobility.Install (enbNodes);
+	mobility.Install (iabNodes);
+	mobility.Install (ueNodes);
+
+	NetDeviceContainer enbDevs = mmwaveHelper->InstallEnbDevice (enbNodes);
+	NetDeviceContainer iabDevs = mmwaveHelper->InstallIabDevice (iabNodes);
+	NetDeviceContainer ueDevs = mmwaveHelper->InstallUeDevice (ueNodes);
+
+	// the downlink PHY of every device, and both the access and the backhaul PHY of the IAB nodes
+	std::vector<Ptr<MmWaveSpectrumPhy> > phys;
+	for (uint32_t i = 0; i < enbDevs.GetN (); i++)
+	{
+		phys.push_back (DynamicCast<MmWaveEnbNetDevice> (enbDevs.Get (i))->GetPhy ()->GetDlSpectrumPhy ());
+	}
+	for (uint32_t i = 0; i < iabDevs.GetN (); i++)
+	{
+		Ptr<MmWaveIabNetDevice> iabDev = DynamicCast<MmWaveIabNetDevice> (iabDevs.Get (i));
+		phys.push_back (iabDev->GetAccessPhy ()->GetDlSpectrumPhy ());
+		phys.push_back (iabDev->GetBackhaulPhy ()->GetDlSpectrumPhy ());
+	}
+	for (uint32_t i = 0; i < ueDevs.GetN (); i++)
+	{
+		phys.push_back (DynamicCast<MmWaveUeNetDevice> (ueDevs.Get (i))->GetPhy ()->GetDlSpectrumPhy ());
+	}
+
+	uint64_t pairs = (uint64_t) phys.size () * phys.size () * rounds;
+	SystemWallClockMs clock;
+	uint64_t legacyNeglected = 0;
+	clock.Start ();
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		for (uint32_t rx = 0; rx < phys.size (); rx++)
+		{
+			for (uint32_t tx = 0; tx < phys.size (); tx++)
+			{
+				legacyNeglected += LegacyIsNeglectedTransmission (phys[rx], phys[tx]);
+			}
+		}
+	}
+	int64_t legacyMs = clock.End ();
+	uint64_t neglected = 0;
+	clock.Start ();
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		for (uint32_t rx = 0; rx < phys.size (); rx++)
+		{
+			for (uint32_t tx = 0; tx < phys.size (); tx++)
+			{
+				neglected += phys[rx]->IsNeglectedTransmission (phys[tx]);
+			}
+		}
+	}
+	int64_t dispatchMs = clock.End ();
+
+	uint32_t errors = 0;
+	for (uint32_t rx = 0; rx < phys.size (); rx++)
+	{
+		for (uint32_t tx = 0; tx < phys.size (); tx++)
+		{
+			if (LegacyIsNeglectedTransmission (phys[rx], phys[tx]) != phys[rx]->IsNeglectedTransmission (phys[tx]))
+			{
+				std::cerr << "RX PHY " << rx << " (kind " << phys[rx]->GetDeviceType () << ") TX PHY " << tx
+						<< " (kind " << phys[tx]->GetDeviceType () << "): different decision" << std::endl;
+				errors++;
+			}
+		}
+	}
+
+	std::cout << phys.size () << " PHYs, " << pairs << " RX/TX pairs, "
+			<< neglected / rounds << " neglected per round" << std::endl;
+	std::cout << "DynamicCast chain: " << legacyMs << " ms" << std::endl;
+	std::cout << "cached kind:       " << dispatchMs << " ms" << std::endl;
+	if (dispatchMs > 0)
+	{
+		std::cout << "speedup:           " << (double)legacyMs / dispatchMs << "x" << std::endl;
+	}
+	std::cout << "mismatches:        " << errors + (legacyNeglected != neglected) << std::endl;
+
+	Simulator::Destroy ();
+	return errors == 0 && legacyNeglected == neglected ? 0 : 1;
+}
@@ -0,0 +1,299 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+/*
+ * Microbenchmark of the flex-TTI MAC schedulers with a large number of UEs
+ * (MmWaveFlexTtiMacScheduler by default, any other with --scheduler).
+ * The scheduler is driven directly through its SAPs, the way MmWaveEnbMac does:
+ * every TTI all the UEs report a DL CQI and a BSR, the DL RLC buffers (with the
+ * sizes and delays of the queued packets) of a subset of them are refreshed, the HARQ feedback and the UL-CQI of the allocations of
+ * the previous TTI are returned (with a fraction of NACKs) and a schedule is
+ * triggered. Some UEs are periodically released and configured again, so that
+ * the per-UE state is created and removed while the scheduler runs.
+ *
+ * ./waf --run "mmwave-flex-tti-scheduler-benchmark --ues=500 --ttis=2000"
+ * ./waf --run "mmwave-flex-tti-scheduler-benchmark --scheduler=ns3::MmWaveFlexTtiPfMacScheduler"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-helper.h"
+#include "ns3/mmwave-mac-scheduler.h"
+#include <iostream>
+
+using namespace ns3;
+
+class BenchmarkMacSchedSapUser : public MmWaveMacSchedSapUser
+{
+public:
+	BenchmarkMacSchedSapUser (Ptr<MmWavePhyMacCommon> config, uint32_t nackPeriod)
+		:m_config (config),
+		 m_nackPeriod (nackPeriod),
+		 m_numFeedback (0),
+		 m_numDlDci (0),
+		 m_numUlDci (0),
+		 m_digest (14695981039346656037ULL)
+	{
+	}
+
+	virtual void SchedConfigInd (const struct SchedConfigIndParameters& params)
+	{
+		for (unsigned i = 0; i < params.m_sfAllocInfo.m_slotAllocInfo.size (); i++)
+		{
+			const SlotAllocInfo &slot = params.m_sfAllocInfo.m_slotAllocInfo[i];
+			if (slot.m_slotType == SlotAllocInfo::CTRL || slot.m_dci.m_tbSize == 0)
+			{
+				continue;
+			}
+			Digest (slot.m_dci.m_rnti);
+			Digest (slot.m_dci.m_format);
+			Digest (slot.m_dci.m_symStart);
+			Digest (slot.m_dci.m_numSym);
+			Digest (slot.m_dci.m_mcs);
+			Digest (slot.m_dci.m_tbSize);
+			Digest (slot.m_dci.m_harqProcess);
+			Digest (slot.m_dci.m_rv);
+			bool nack = m_nackPeriod > 0 && ++m_numFeedback % m_nackPeriod == 0;
+			if (slot.m_dci.m_format == DciInfoElementTdma::DL_dci)
+			{
+				DlHarqInfo harqInfo;
+				harqInfo.m_rnti = slot.m_dci.m_rnti;
+				harqInfo.m_harqProcessId = slot.m_dci.m_harqProcess;
+				harqInfo.m_harqStatus = nack ? DlHarqInfo::NACK : DlHarqInfo::ACK;
+				harqInfo.m_numRetx = slot.m_dci.m_rv;
+				m_dlHarqInfoList.push_back (harqInfo);
+				m_numDlDci++;
+			}
+			else
+			{
+				UlHarqInfo harqInfo;
+				harqInfo.m_rnti = slot.m_dci.m_rnti;
+				harqInfo.m_harqProcessId = slot.m_dci.m_harqProcess;
+				harqInfo.m_receptionStatus = nack ? UlHarqInfo::NotOk : UlHarqInfo::Ok;
+				harqInfo.m_tpc = 0;
+				harqInfo.m_numRetx = slot.m_dci.m_rv;
+				m_ulHarqInfoList.push_back (harqInfo);
+
+				// UL-CQI of the slot, reported as MmWaveEnbPhy does once the TB is received
+				MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters ulCqi;
+				ulCqi.m_sfnSf = params.m_sfAllocInfo.m_sfnSf;
+				ulCqi.m_sfnSf.m_slotNum = slot.m_dci.m_symStart;
+				ulCqi.m_ulCqi.m_type = UlCqiInfo::PUSCH;
+				ulCqi.m_ulCqi.m_sinr.assign (m_config->GetTotalNumChunk (), 10.0 + slot.m_dci.m_rnti % 10);
+				m_ulCqiList.push_back (ulCqi);
+				m_numUlDci++;
+			}
+		}
+	}
+
+	// FNV-1a over the fields of the DCIs, to compare the allocations of two builds
+	void Digest (uint32_t value)
+	{
+		m_digest = (m_digest ^ value) * 1099511628211ULL;
+	}
+
+	Ptr<MmWavePhyMacCommon> m_config;
+	uint32_t m_nackPeriod;
+	uint64_t m_numFeedback;
+	uint64_t m_numDlDci;
+	uint64_t m_numUlDci;
+	uint64_t m_digest;
+	std::vector<DlHarqInfo> m_dlHarqInfoList;
+	std::vector<UlHarqInfo> m_ulHarqInfoList;
+	std::vector<MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters> m_ulCqiList;
+};
+
+class BenchmarkMacCschedSapUser : public MmWaveMacCschedSapUser
+{
+public:
+	virtual void CschedCellConfigCnf (const struct CschedCellConfigCnfParameters& params) {}
+	virtual void CschedUeConfigCnf (const struct CschedUeConfigCnfParameters& params) {}
+	virtual void CschedLcConfigCnf (const struct CschedLcConfigCnfParameters& params) {}
+	virtual void CschedLcReleaseCnf (const struct CschedLcReleaseCnfParameters& params) {}
+	virtual void CschedUeReleaseCnf (const struct CschedUeReleaseCnfParameters& params) {}
+	virtual void CschedUeConfigUpdateInd (const struct CschedUeConfigUpdateIndParameters& params) {}
+	virtual void CschedCellConfigUpdateInd (const struct CschedCellConfigUpdateIndParameters& params) {}
+};
+
+static void
+ConfigureUe (MmWaveMacCschedSapProvider *cschedSap, uint16_t rnti)
+{
+	MmWaveMacCschedSapProvider::CschedUeConfigReqParameters ueConfig;
+	ueConfig.m_rnti = rnti;
+	ueConfig.m_transmissionMode = 0;
+	ueConfig.m_reconfigureFlag = true;
+	ueConfig.m_ueCapabilities.m_iab = false;
+	ueConfig.m_ueCapabilities.m_numIabDevsPerRnti = 0;
+	cschedSap->CschedUeConfigReq (ueConfig);
+
+	MmWaveMacCschedSapProvider::CschedLcConfigReqParameters lcConfig;
+	lcConfig.m_rnti = rnti;
+	lcConfig.m_reconfigureFlag = false;
+	LogicalChannelConfigListElement_s lc;
+	lc.m_logicalChannelIdentity = 3;
+	lc.m_logicalChannelGroup = 1;
+	lc.m_direction = LogicalChannelConfigListElement_s::DIR_BOTH;
+	lc.m_qosBearerType = LogicalChannelConfigListElement_s::QBT_NON_GBR;
+	lc.m_qci = 9;
+	lcConfig.m_logicalChannelConfigList.push_back (lc);
+	cschedSap->CschedLcConfigReq (lcConfig);
+}
+
+static void
+ReportDlBuffer (MmWaveMacSchedSapProvider *schedSap, uint16_t rnti, uint32_t size)
+{
+	MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters rlcBuffer;
+	rlcBuffer.m_rnti = rnti;
+	rlcBuffer.m_logicalChannelIdentity = 3;
+	rlcBuffer.m_rlcTransmissionQueueSize = size;
+	rlcBuffer.m_rlcTransmissionQueueHolDelay = 0;
+	rlcBuffer.m_rlcRetransmissionQueueSize = 0;
+	rlcBuffer.m_rlcRetransmissionHolDelay = 0;
+	rlcBuffer.m_rlcStatusPduSize = 0;
+	rlcBuffer.m_arrivalRate = 0;
+	for (uint32_t queued = 0; queued < size; queued += 1428)
+	{
+		rlcBuffer.m_txPacketSizes.push_back (std::min (size - queued, 1428u));
+		rlcBuffer.m_txPacketDelays.push_back (queued / 1428);
+	}
+	schedSap->SchedDlRlcBufferReq (rlcBuffer);
+}
+
+int
+main (int argc, char *argv[])
+{
+	uint32_t ues = 500;
+	uint32_t ttis = 2000;
+	uint32_t activeUes = 50;
+	uint32_t nackPeriod = 10;
+	uint32_t churnPeriod = 100;
+	std::string scheduler = "ns3::MmWaveFlexTtiMacScheduler";
+
+	CommandLine cmd;
+	cmd.AddValue ("scheduler", "TypeId of the MAC scheduler", scheduler);
+	cmd.AddValue ("ues", "Number of UEs attached to the scheduler", ues);
+	cmd.AddValue ("ttis", "Number of scheduled TTIs", ttis);
+	cmd.AddValue ("activeUes", "Number of UEs whose DL buffer is refreshed in each TTI", activeUes);
+	cmd.AddValue ("nackPeriod", "One HARQ feedback out of nackPeriod is a NACK (0 for none)", nackPeriod);
+	cmd.AddValue ("churnPeriod", "Every churnPeriod TTIs one UE out of 20 is released and configured again (0 for never)", churnPeriod);
+	cmd.Parse (argc, argv);
+
+	Ptr<MmWavePhyMacCommon> config = CreateObject<MmWavePhyMacCommon> ();
+	ObjectFactory schedulerFactory;
+	schedulerFactory.SetTypeId (scheduler);
+	Ptr<MmWaveMacScheduler> sched = schedulerFactory.Create<MmWaveMacScheduler> ();
+	sched->ConfigureCommonParameters (config);
+	BenchmarkMacSchedSapUser schedSapUser (config, nackPeriod);
+	BenchmarkMacCschedSapUser cschedSapUser;
+	sched->SetMacSchedSapUser (&schedSapUser);
+	sched->SetMacCschedSapUser (&cschedSapUser);
+	MmWaveMacSchedSapProvider *schedSap = sched->GetMacSchedSapProvider ();
+	MmWaveMacCschedSapProvider *cschedSap = sched->GetMacCschedSapProvider ();
+
+	MmWaveMacCschedSapProvider::CschedCellConfigReqParameters cellConfig;
+	cschedSap->CschedCellConfigReq (cellConfig);
+	for (uint16_t rnti = 1; rnti <= ues; rnti++)
+	{
+		ConfigureUe (cschedSap, rnti);
+		ReportDlBuffer (schedSap, rnti, 100000);
+	}
+
+	SystemWallClockMs clock;
+	clock.Start ();
+	uint32_t frameNum = 0;
+	uint32_t sfNum = 0;
+	for (uint32_t tti = 0; tti < ttis; tti++)
+	{
+		SfnSf sfnSf (frameNum, sfNum, 0);
+
+		if (churnPeriod > 0 && tti > 0 && tti % churnPeriod == 0)
+		{
+			for (uint16_t rnti = 1 + (tti / churnPeriod) % 20; rnti <= ues; rnti += 20)
+			{
+				MmWaveMacCschedSapProvider::CschedUeReleaseReqParameters release;
+				release.m_rnti = rnti;
+				cschedSap->CschedUeReleaseReq (release);
+				ConfigureUe (cschedSap, rnti);
+			}
+		}
+
+		MmWaveMacSchedSapProvider::SchedDlCqiInfoReqParameters dlCqi;
+		dlCqi.m_sfnsf = sfnSf;
+		MmWaveMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters ulMacCtrl;
+		ulMacCtrl.m_sfnSf = sfnSf;
+		for (uint16_t rnti = 1; rnti <= ues; rnti++)
+		{
+			DlCqiInfo cqi;
+			cqi.m_rnti = rnti;
+			cqi.m_ri = 1;
+			cqi.m_cqiType = DlCqiInfo::WB;
+			cqi.m_wbCqi = 5 + (rnti + tti) % 10;
+			cqi.m_wbPmi = 0;
+			dlCqi.m_cqiList.push_back (cqi);
+
+			MacCeElement bsr;
+			bsr.m_rnti = rnti;
+			bsr.m_macCeType = MacCeElement::BSR;
+			bsr.m_macCeValue.m_phr = 0;
+			bsr.m_macCeValue.m_crnti = 0;
+			bsr.m_macCeValue.m_bufferStatus.assign (4, 0);
+			bsr.m_macCeValue.m_bufferStatus[0] = 20 + rnti % 20;
+			ulMacCtrl.m_macCeList.push_back (bsr);
+		}
+		schedSap->SchedDlCqiInfoReq (dlCqi);
+		schedSap->SchedUlMacCtrlInfoReq (ulMacCtrl);
+		for (uint32_t i = 0; i < activeUes && i < ues; i++)
+		{
+			ReportDlBuffer (schedSap, 1 + (tti * activeUes + i) % ues, 100000);
+		}
+
+		for (unsigned i = 0; i < schedSapUser.m_ulCqiList.size (); i++)
+		{
+			schedSap->SchedUlCqiInfoReq (schedSapUser.m_ulCqiList[i]);
+		}
+		schedSapUser.m_ulCqiList.clear ();
+
+		MmWaveMacSchedSapProvider::SchedTriggerReqParameters trigger;
+		trigger.m_sfnSf = sfnSf;
+		trigger.m_dlHarqInfoList.swap (schedSapUser.m_dlHarqInfoList);
+		trigger.m_ulHarqInfoList.swap (schedSapUser.m_ulHarqInfoList);
+		schedSap->SchedTriggerReq (trigger);
+
+		if (++sfNum == config->GetSubframesPerFrame ())
+		{
+			sfNum = 0;
+			frameNum++;
+		}
+	}
+	int64_t elapsedMs = clock.End ();
+
+	std::cout << scheduler << ": " << ues << " UEs, " << ttis << " TTIs" << std::endl;
+	std::cout << "DL DCIs:       " << schedSapUser.m_numDlDci << std::endl;
+	std::cout << "UL DCIs:       " << schedSapUser.m_numUlDci << std::endl;
+	std::cout << "DCI digest:    " << std::hex << schedSapUser.m_digest << std::dec << std::endl;
+	std::cout << "total:         " << elapsedMs << " ms" << std::endl;
+	std::cout << "per TTI:       " << (double)elapsedMs * 1000 / ttis << " us" << std::endl;
+
+	sched->Dispose ();
+	Simulator::Destroy ();
+	return 0;
+}
@@ -0,0 +1,196 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+/*
+ * Regression check and microbenchmark of MmWaveMiErrorModel::Mib.
+ * The per-RB implementation used before the introduction of MiSum (which
+ * copied the SpectrumValue and selected the MI table for every RB) is run
+ * on random SINRs, RB maps and MCSs, and both the MI and the resulting
+ * TB decode decision must be bit-identical to the ones of the current code.
+ * The program returns 1 on the first mismatch.
+ *
+ * ./waf --run "mmwave-mi-error-model-benchmark --rbs=72 --tbs=100000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/spectrum-value.h"
+#include "ns3/mmwave-mi-error-model.h"
+#include <iostream>
+#include <cstring>
+
+using namespace ns3;
+
+static double
+LegacyMib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs)
+{
+	double MI;
+	double MIsum = 0.0;
+	SpectrumValue sinrCopy = sinr;
+
+	for (uint32_t i = 0; i < map.size (); i++)
+	{
+		double sinrLin = sinrCopy[map.at (i)];
+		if (mcs <= MMWAVE_MI_QPSK_MAX_ID) // QPSK
+		{
+			if (sinrLin > MI_map_qpsk_axis[MMWAVE_MI_MAP_QPSK_SIZE-1])
+			{
+				MI = 1;
+			}
+			else
+			{
+				static const double scalingCoeffQpsk =
+						(MMWAVE_MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MMWAVE_MI_MAP_QPSK_SIZE-1] - MI_map_qpsk_axis[0]);
+				double sinrIndexDouble = (sinrLin -  MI_map_qpsk_axis[0]) * scalingCoeffQpsk + 1;
+				uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
+				MI = MI_map_qpsk[sinrIndex];
+			}
+		}
+		else if (mcs > MMWAVE_MI_QPSK_MAX_ID && mcs <= MMWAVE_MI_16QAM_MAX_ID )	// 16-QAM
+		{
+			if (sinrLin > MI_map_16qam_axis[MMWAVE_MI_MAP_16QAM_SIZE-1])
+			{
+				MI = 1;
+			}
+			else
+			{
+				static const double scalingCoeff16qam =
+						(MMWAVE_MI_MAP_16QAM_SIZE - 1) / (MI_map_16qam_axis[MMWAVE_MI_MAP_16QAM_SIZE-1] - MI_map_16qam_axis[0]);
+				double sinrIndexDouble = (sinrLin -  MI_map_16qam_axis[0]) * scalingCoeff16qam + 1;
+				uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
+				MI = MI_map_16qam[sinrIndex];
+			}
+		}
+		else // 64-QAM
+		{
+			if (sinrLin > MI_map_64qam_axis[MMWAVE_MI_MAP_64QAM_SIZE-1])
+			{
+				MI = 1;
+			}
+			else
+			{
+				static const double scalingCoeff64qam =
+						(MMWAVE_MI_MAP_64QAM_SIZE - 1) / (MI_map_64qam_axis[MMWAVE_MI_MAP_64QAM_SIZE-1] - MI_map_64qam_axis[0]);
+				double sinrIndexDouble = (sinrLin -  MI_map_64qam_axis[0]) * scalingCoeff64qam + 1;
+				uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
+				MI = MI_map_64qam[sinrIndex];
+			}
+		}
+		MIsum += MI;
+	}
+	MI = MIsum / map.size ();
+	return MI;
+}
+
+static bool
+SameBits (double a, double b)
+{
+	return std::memcmp (&a, &b, sizeof (double)) == 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+	uint32_t rbs = 72;
+	uint32_t tbs = 100000;
+
+	CommandLine cmd;
+	cmd.AddValue ("rbs", "Number of RBs of the SINR vector", rbs);
+	cmd.AddValue ("tbs", "Number of random TBs", tbs);
+	cmd.Parse (argc, argv);
+
+	std::vector<double> freqs;
+	for (uint32_t rb = 0; rb < rbs; rb++)
+	{
+		freqs.push_back (28e9 + rb * 1e6);
+	}
+	Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+	Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+
+	// random TBs: SINR between -10 and 30 dB (beyond the end of all the MI tables),
+	// a random contiguous or scattered set of RBs and a random MCS
+	std::vector<SpectrumValue> sinrs;
+	std::vector<std::vector<int> > maps;
+	std::vector<uint8_t> mcss;
+	std::vector<double> draws;
+	for (uint32_t tb = 0; tb < tbs; tb++)
+	{
+		SpectrumValue sinr (model);
+		for (uint32_t rb = 0; rb < rbs; rb++)
+		{
+			sinr[rb] = std::pow (10.0, rv->GetValue (-10, 30) / 10);
+		}
+		std::vector<int> map;
+		uint32_t first = rv->GetInteger (0, rbs - 1);
+		uint32_t last = rv->GetInteger (first, rbs - 1);
+		uint32_t step = rv->GetInteger (1, 3);
+		for (uint32_t rb = first; rb <= last; rb += step)
+		{
+			map.push_back (rb);
+		}
+		sinrs.push_back (sinr);
+		maps.push_back (map);
+		mcss.push_back (rv->GetInteger (0, MMWAVE_MI_64QAM_MAX_ID));
+		draws.push_back (rv->GetValue (0, 1));
+	}
+
+	SystemWallClockMs clock;
+	std::vector<double> legacyMi (tbs), mi (tbs);
+	clock.Start ();
+	for (uint32_t tb = 0; tb < tbs; tb++)
+	{
+		legacyMi[tb] = LegacyMib (sinrs[tb], maps[tb], mcss[tb]);
+	}
+	int64_t legacyMs = clock.End ();
+	clock.Start ();
+	for (uint32_t tb = 0; tb < tbs; tb++)
+	{
+		mi[tb] = MmWaveMiErrorModel::Mib (sinrs[tb], maps[tb], mcss[tb]);
+	}
+	int64_t miMs = clock.End ();
+
+	uint32_t errors = 0;
+	for (uint32_t tb = 0; tb < tbs; tb++)
+	{
+		// decode decision as taken by the PHY for a first transmission of 1500 bytes
+		uint8_t ecrId = McsEcrBlerTableMapping[mcss[tb]];
+		double legacyBler = MmWaveMiErrorModel::MappingMiBler (legacyMi[tb], ecrId, 1500 * 8);
+		double bler = MmWaveMiErrorModel::MappingMiBler (mi[tb], ecrId, 1500 * 8);
+		if (!SameBits (legacyMi[tb], mi[tb]) || !SameBits (legacyBler, bler)
+				|| (draws[tb] > legacyBler) != (draws[tb] > bler))
+		{
+			std::cerr << "TB " << tb << " MCS " << (uint16_t) mcss[tb] << ": MI " << legacyMi[tb]
+					<< " instead of " << mi[tb] << std::endl;
+			errors++;
+		}
+	}
+
+	std::cout << tbs << " TBs on " << rbs << " RBs" << std::endl;
+	std::cout << "per-RB Mib:  " << legacyMs << " ms" << std::endl;
+	std::cout << "batched Mib: " << miMs << " ms" << std::endl;
+	if (miMs > 0)
+	{
+		std::cout << "speedup:     " << (double)legacyMs / miMs << "x" << std::endl;
+	}
+	std::cout << "mismatches:  " << errors << std::endl;
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+/*
+ * Convert a text ray-tracing trace file to the binary format that
+ * MmWaveChannelRaytracing memory maps, and check that the two files hold
+ * the same traces. The binary file is then selected with
+ *
+ * --ns3::MmWaveChannelRaytracing::TraceFile=<output>
+ *
+ * ./waf --run "mmwave-raytracing-trace-converter --input=src/mmwave/model/Raytracing/traces10cm.txt
+ *   --output=src/mmwave/model/Raytracing/traces10cm.bin"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-raytracing-trace.h"
+#include <iostream>
+#include <algorithm>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+	std::string input = "src/mmwave/model/Raytracing/traces10cm.txt";
+	std::string output = "src/mmwave/model/Raytracing/traces10cm.bin";
+
+	CommandLine cmd;
+	cmd.AddValue ("input", "The text trace file", input);
+	cmd.AddValue ("output", "The binary trace file to be written", output);
+	cmd.Parse (argc, argv);
+
+	if (!RaytracingTrace::ConvertTextFile (input, output))
+	{
+		std::cerr << "Cannot convert " << input << " to " << output << std::endl;
+		return 1;
+	}
+
+	RaytracingTrace text;
+	RaytracingTrace binary;
+	if (!text.Load (input) || !binary.Load (output) || !binary.IsMapped ()
+			|| text.GetNumTraces () != binary.GetNumTraces ())
+	{
+		std::cerr << "Cannot read back " << output << std::endl;
+		return 1;
+	}
+	for (uint32_t traceIndex = 0; traceIndex < text.GetNumTraces (); traceIndex++)
+	{
+		bool same = text.GetNumPaths (traceIndex) == binary.GetNumPaths (traceIndex);
+		for (uint8_t row = 0; same && row < RaytracingTrace::NUM_ROWS; row++)
+		{
+			RaytracingTrace::Row r = static_cast<RaytracingTrace::Row> (row);
+			uint32_t length = text.GetRowLength (traceIndex, r);
+			same = length == binary.GetRowLength (traceIndex, r)
+					&& std::equal (text.GetRow (traceIndex, r), text.GetRow (traceIndex, r) + length,
+							binary.GetRow (traceIndex, r));
+		}
+		if (!same)
+		{
+			std::cerr << "Trace " << traceIndex << " differs in " << output << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "Converted " << binary.GetNumTraces () << " traces to " << output << std::endl;
+	return 0;
+}
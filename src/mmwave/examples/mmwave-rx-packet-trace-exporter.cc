@@ -0,0 +1,55 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Convert the binary RxPacketTrace, written when a simulation is run with
+ *
+ * --ns3::MmWavePhyRxTrace::TraceFormat=Binary
+ *
+ * to the text RxPacketTrace.txt that the simulation writes with the default
+ * Text format.
+ *
+ * ./waf --run "mmwave-rx-packet-trace-exporter --input=RxPacketTrace.bin --output=RxPacketTrace.txt"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-phy-rx-trace.h"
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+	std::string input = "RxPacketTrace.bin";
+	std::string output = "RxPacketTrace.txt";
+
+	CommandLine cmd;
+	cmd.AddValue ("input", "The binary trace file", input);
+	cmd.AddValue ("output", "The text trace file to be written", output);
+	cmd.Parse (argc, argv);
+
+	if (!MmWavePhyRxTrace::ExportBinaryTrace (input, output))
+	{
+		std::cerr << "Cannot export " << input << " to " << output << std::endl;
+		return 1;
+	}
+	std::cout << "Exported " << input << " to " << output << std::endl;
+	return 0;
+}
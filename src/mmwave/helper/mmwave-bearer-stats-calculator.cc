@@ -33,9 +33,13 @@
 #include "mmwave-bearer-stats-calculator.h"
 #include "ns3/string.h"
 #include "ns3/nstime.h"
+#include "ns3/enum.h"
 #include <ns3/log.h>
 #include <vector>
 #include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
 
 namespace ns3 {
 
@@ -43,17 +47,25 @@ NS_LOG_COMPONENT_DEFINE ("MmWaveBearerStatsCalculator");
 
 NS_OBJECT_ENSURE_REGISTERED ( MmWaveBearerStatsCalculator);
 
+const char MmWaveBearerStatsCalculator::ColumnarPduWriter::MAGIC[8] = {'M', 'M', 'W', 'P', 'D', 'U', 'C', '1'};
+
 MmWaveBearerStatsCalculator::MmWaveBearerStatsCalculator ()
   : m_firstWrite (true),
     m_pendingOutput (false), 
-    m_protocolType ("RLC")
+    m_protocolType ("RLC"),
+    m_outputFormat (TEXT),
+    m_chunkRows (4096),
+    m_kpiLayer (MmWaveKpiCalculator::RLC)
 {
   NS_LOG_FUNCTION (this);
 }
 
 MmWaveBearerStatsCalculator::MmWaveBearerStatsCalculator (std::string protocolType)
   : m_firstWrite (true),
-    m_pendingOutput (false)
+    m_pendingOutput (false),
+    m_outputFormat (TEXT),
+    m_chunkRows (4096),
+    m_kpiLayer (MmWaveKpiCalculator::RLC)
 {
   NS_LOG_FUNCTION (this);
   m_protocolType = protocolType;
@@ -101,6 +113,20 @@ MmWaveBearerStatsCalculator::GetTypeId (void)
                    StringValue ("UlPdcpStats.txt"),
                    MakeStringAccessor (&MmWaveBearerStatsCalculator::SetUlPdcpOutputFilename),
                    MakeStringChecker ())
+    .AddAttribute ("OutputFormat",
+                   "Format of the received PDUs: Text writes a line per PDU to the output file, "
+                   "Columnar writes chunks of binary columns to the output file with the .bin extension, "
+                   "None does not write the PDUs",
+                   EnumValue (MmWaveBearerStatsCalculator::TEXT),
+                   MakeEnumAccessor (&MmWaveBearerStatsCalculator::m_outputFormat),
+                   MakeEnumChecker (MmWaveBearerStatsCalculator::TEXT, "Text",
+                                    MmWaveBearerStatsCalculator::COLUMNAR, "Columnar",
+                                    MmWaveBearerStatsCalculator::NONE, "None"))
+    .AddAttribute ("ChunkSize",
+                   "Number of PDUs in each chunk of the Columnar format",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&MmWaveBearerStatsCalculator::m_chunkRows),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
@@ -113,6 +139,23 @@ MmWaveBearerStatsCalculator::DoDispose ()
     {
       ShowResults ();
     }
+  CloseColumnarFiles ();
+}
+
+void
+MmWaveBearerStatsCalculator::CloseColumnarFiles (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_ulColumnarFile.Close ();
+  m_dlColumnarFile.Close ();
+}
+
+void
+MmWaveBearerStatsCalculator::SetKpiCalculator (Ptr<MmWaveKpiCalculator> kpiStats)
+{
+  NS_LOG_FUNCTION (this << kpiStats);
+  m_kpiStats = kpiStats;
+  m_kpiLayer = m_protocolType == "PDCP" ? MmWaveKpiCalculator::PDCP : MmWaveKpiCalculator::RLC;
 }
 
 void 
@@ -146,32 +189,24 @@ MmWaveBearerStatsCalculator::UlTxPdu (uint16_t cellId, uint64_t imsi, uint16_t r
 {
   NS_LOG_FUNCTION (this << "UlTxPdu" << cellId << imsi << rnti << (uint32_t) lcid << packetSize);
 
-  if (!m_ulOutFile.is_open ())
+  if (m_kpiStats != 0)
+    {
+      m_kpiStats->NotifyTxPdu (m_kpiLayer, true, cellId, rnti, lcid, packetSize);
+    }
+
+  if (m_outputFormat == TEXT && !m_ulOutFile.is_open ())
   {
   	m_ulOutFile.open (GetUlOutputFilename ().c_str ());
   }
 
-  // if (m_protocolType == "RLC")
-  // {
-  // 	m_ulOutFile << "R ";
-  // }
-  // else
-  // {
-  // 	m_ulOutFile << "P ";
-  // }
-
-  // m_ulOutFile << "Tx " << Simulator::Now ().GetNanoSeconds () / 1.0e9 << " "<< cellId << " "
-  // 		<< rnti << " " << imsi << " " << (uint32_t) lcid << " " << packetSize << " " << std::endl;
-
-  /*ImsiLcidPair_t p (imsi, lcid);
   if (Simulator::Now () >= m_startTime)
     {
-      m_ulCellId[p] = cellId;
-      m_flowId[p] = LteFlowId_t (rnti, lcid);
-      m_ulTxPackets[p]++;
-      m_ulTxData[p] += packetSize;
+      BearerStats &bearer = GetBearer (imsi, lcid);
+      bearer.m_ul.m_cellId = cellId;
+      bearer.m_flowId = LteFlowId_t (rnti, lcid);
+      bearer.m_ul.m_txPackets++;
+      bearer.m_ul.m_txData += packetSize;
     }
-  m_pendingOutput = true;*/
 }
 
 void
@@ -179,33 +214,24 @@ MmWaveBearerStatsCalculator::DlTxPdu (uint16_t cellId, uint64_t imsi, uint16_t r
 {
   NS_LOG_FUNCTION (this << "DlTxPDU" << cellId << imsi << rnti << (uint32_t) lcid << packetSize);
 
-  if (!m_dlOutFile.is_open ())
+  if (m_kpiStats != 0)
+    {
+      m_kpiStats->NotifyTxPdu (m_kpiLayer, false, cellId, rnti, lcid, packetSize);
+    }
+
+  if (m_outputFormat == TEXT && !m_dlOutFile.is_open ())
   {
   	m_dlOutFile.open (GetDlOutputFilename ().c_str ());
   }
 
-  // if (m_protocolType == "RLC")
-  // {
-  // 	m_dlOutFile << "R ";
-  // }
-  // else
-  // {
-  // 	m_dlOutFile << "P ";
-  // }
-
-  // m_dlOutFile << "Tx " << Simulator::Now ().GetNanoSeconds () / 1.0e9 << " "<< cellId << " "
-  // 		<< rnti << " " << imsi << " " << (uint32_t) lcid << " " << packetSize << " " << std::endl;
-
-
-  /*ImsiLcidPair_t p (imsi, lcid);
   if (Simulator::Now () >= m_startTime)
     {
-      m_dlCellId[p] = cellId;
-      m_flowId[p] = LteFlowId_t (rnti, lcid);
-      m_dlTxPackets[p]++;
-      m_dlTxData[p] += packetSize;
+      BearerStats &bearer = GetBearer (imsi, lcid);
+      bearer.m_dl.m_cellId = cellId;
+      bearer.m_flowId = LteFlowId_t (rnti, lcid);
+      bearer.m_dl.m_txPackets++;
+      bearer.m_dl.m_txData += packetSize;
     }
-  m_pendingOutput = true;*/
 }
 
 void
@@ -214,44 +240,21 @@ MmWaveBearerStatsCalculator::UlRxPdu (uint16_t cellId, uint64_t imsi, uint16_t r
 {
   NS_LOG_FUNCTION (this << "UlRxPDU" << cellId << imsi << rnti << (uint32_t) lcid << packetSize << delay);
 
-  if (!m_ulOutFile.is_open ())
-  {
-  	m_ulOutFile.open (GetUlOutputFilename ().c_str ());
-  }
-
-  // if (m_protocolType == "RLC")
-  // {
-  // 	m_ulOutFile << "R ";
-  // }
-  // else
-  // {
-  // 	m_ulOutFile << "P ";
-  // }
-
-  // m_ulOutFile << "Rx " << Simulator::Now ().GetNanoSeconds () / 1.0e9 << " "<< cellId << " "
-  		// << rnti << " " << imsi << " " << (uint32_t) lcid << " " << packetSize << " " << delay << std::endl;
-
-  m_ulOutFile << Simulator::Now ().GetNanoSeconds () / 1.0e9 << " "<< cellId << " "
-      << rnti << " " << imsi << " " << (uint32_t) lcid << " " << packetSize << " " << delay << std::endl;
+  WriteRxPdu (true, cellId, rnti, imsi, lcid, packetSize, delay);
+  if (m_kpiStats != 0)
+    {
+      m_kpiStats->NotifyRxPdu (m_kpiLayer, true, cellId, rnti, lcid, packetSize, delay);
+    }
 
-  /*ImsiLcidPair_t p (imsi, lcid);
   if (Simulator::Now () >= m_startTime)
     {
-      m_ulCellId[p] = cellId;
-      m_ulRxPackets[p]++;
-      m_ulRxData[p] += packetSize;
-
-      Uint64StatsMap::iterator it = m_ulDelay.find (p);
-      if (it == m_ulDelay.end ())
-        {
-          NS_LOG_DEBUG (this << " Creating UL stats calculators for IMSI " << p.m_imsi << " and LCID " << (uint32_t) p.m_lcId);
-          m_ulDelay[p] = CreateObject<MinMaxAvgTotalCalculator<uint64_t> > ();
-          m_ulPduSize[p] = CreateObject<MinMaxAvgTotalCalculator<uint32_t> > ();
-        }
-      m_ulDelay[p]->Update (delay);
-      m_ulPduSize[p]->Update (packetSize);
+      DirectionStats &ul = GetBearer (imsi, lcid).m_ul;
+      ul.m_cellId = cellId;
+      ul.m_rxPackets++;
+      ul.m_rxData += packetSize;
+      ul.m_delay.Update (delay);
+      ul.m_pduSize.Update (packetSize);
     }
-  m_pendingOutput = true;*/
 }
 
 void
@@ -259,44 +262,67 @@ MmWaveBearerStatsCalculator::DlRxPdu (uint16_t cellId, uint64_t imsi, uint16_t r
 {
   NS_LOG_FUNCTION (this << "DlRxPDU" << cellId << imsi << rnti << (uint32_t) lcid << packetSize << delay);
 
-  if (!m_dlOutFile.is_open ())
-  {
-  	m_dlOutFile.open (GetDlOutputFilename ().c_str ());
-  }
-
-  // if (m_protocolType == "RLC")
-  // {
-  // 	m_dlOutFile << "R ";
-  // }
-  // else
-  // {
-  // 	m_dlOutFile << "P ";
-  // }
-
-  // m_dlOutFile << "Rx " << Simulator::Now ().GetNanoSeconds () / 1.0e9 << " "<< cellId << " "
-  // 		<< rnti << " " << imsi << " " << (uint32_t) lcid << " " << packetSize << " " << delay << std::endl;
-
-  m_dlOutFile << Simulator::Now ().GetNanoSeconds () / 1.0e9 << " "<< cellId << " "
-      << rnti << " " << imsi << " " << (uint32_t) lcid << " " << packetSize << " " << delay << std::endl;
+  WriteRxPdu (false, cellId, rnti, imsi, lcid, packetSize, delay);
+  if (m_kpiStats != 0)
+    {
+      m_kpiStats->NotifyRxPdu (m_kpiLayer, false, cellId, rnti, lcid, packetSize, delay);
+    }
 
- /* ImsiLcidPair_t p (imsi, lcid);
   if (Simulator::Now () >= m_startTime)
     {
-      m_dlCellId[p] = cellId;
-      m_dlRxPackets[p]++;
-      m_dlRxData[p] += packetSize;
+      DirectionStats &dl = GetBearer (imsi, lcid).m_dl;
+      dl.m_cellId = cellId;
+      dl.m_rxPackets++;
+      dl.m_rxData += packetSize;
+      dl.m_delay.Update (delay);
+      dl.m_pduSize.Update (packetSize);
+    }
+}
 
-      Uint64StatsMap::iterator it = m_dlDelay.find (p);
-      if (it == m_dlDelay.end ())
+void
+MmWaveBearerStatsCalculator::WriteRxPdu (bool uplink, uint16_t cellId, uint16_t rnti, uint64_t imsi, uint8_t lcid,
+                                         uint32_t packetSize, uint64_t delay)
+{
+  if (m_outputFormat == NONE)
+    {
+      return;
+    }
+  int64_t timeNs = Simulator::Now ().GetNanoSeconds ();
+  if (m_outputFormat == COLUMNAR)
+    {
+      ColumnarPduWriter &file = uplink ? m_ulColumnarFile : m_dlColumnarFile;
+      if (!file.IsOpen ())
         {
-          NS_LOG_DEBUG (this << " Creating DL stats calculators for IMSI " << p.m_imsi << " and LCID " << (uint32_t) p.m_lcId);
-          m_dlDelay[p] = CreateObject<MinMaxAvgTotalCalculator<uint64_t> > ();
-          m_dlPduSize[p] = CreateObject<MinMaxAvgTotalCalculator<uint32_t> > ();
+          std::string filename = uplink ? GetUlOutputFilename () : GetDlOutputFilename ();
+          std::string::size_type dot = filename.rfind (".txt");
+          filename = (dot != std::string::npos && dot + 4 == filename.size () ? filename.substr (0, dot) : filename) + ".bin";
+          if (!file.Open (filename, m_chunkRows))
+            {
+              NS_FATAL_ERROR ("Can't open file " << filename);
+            }
+          // the calculators are not disposed at the end of the simulation
+          Simulator::ScheduleDestroy (&MmWaveBearerStatsCalculator::CloseColumnarFiles,
+                                      Ptr<MmWaveBearerStatsCalculator> (this));
         }
-      m_dlDelay[p]->Update (delay);
-      m_dlPduSize[p]->Update (packetSize);
+      file.Append (timeNs, cellId, rnti, imsi, lcid, packetSize, delay);
+      return;
     }
-  m_pendingOutput = true;*/
+
+  std::ofstream &outFile = uplink ? m_ulOutFile : m_dlOutFile;
+  if (!outFile.is_open ())
+  {
+  	outFile.open (uplink ? GetUlOutputFilename ().c_str () : GetDlOutputFilename ().c_str ());
+  }
+  WritePduLine (outFile, timeNs, cellId, rnti, imsi, lcid, packetSize, delay);
+  outFile.flush ();
+}
+
+void
+MmWaveBearerStatsCalculator::WritePduLine (std::ostream &os, int64_t timeNs, uint16_t cellId, uint16_t rnti, uint64_t imsi,
+                                           uint8_t lcid, uint32_t packetSize, uint64_t delay)
+{
+  os << timeNs / 1.0e9 << " "<< cellId << " "
+      << rnti << " " << imsi << " " << (uint32_t) lcid << " " << packetSize << " " << delay << "\n";
 }
 
 void
@@ -361,84 +387,48 @@ void
 MmWaveBearerStatsCalculator::WriteUlResults (std::ofstream& outFile)
 {
   NS_LOG_FUNCTION (this);
-
-  // Get the unique IMSI / LCID list
-
-  std::vector < ImsiLcidPair_t > pairVector;
-  for (Uint32Map::iterator it = m_ulTxPackets.begin (); it != m_ulTxPackets.end (); ++it)
-    {
-      if (find (pairVector.begin (), pairVector.end (), (*it).first) == pairVector.end ())
-        {
-          pairVector.push_back ((*it).first);
-        }
-    }
-
-  Time endTime = m_startTime + m_epochDuration;
-  for (std::vector<ImsiLcidPair_t>::iterator it = pairVector.begin (); it != pairVector.end (); ++it)
-    {
-      ImsiLcidPair_t p = *it;
-      outFile << m_startTime.GetNanoSeconds () / 1.0e9 << "\t";
-      outFile << endTime.GetNanoSeconds () / 1.0e9 << "\t";
-      outFile << GetUlCellId (p.m_imsi, p.m_lcId) << "\t";
-      outFile << p.m_imsi << "\t";
-      outFile << m_flowId[p].m_rnti << "\t";
-      outFile << (uint32_t) m_flowId[p].m_lcId << "\t";
-      outFile << GetUlTxPackets (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetUlTxData (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetUlRxPackets (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetUlRxData (p.m_imsi, p.m_lcId) << "\t";
-      std::vector<double> stats = GetUlDelayStats (p.m_imsi, p.m_lcId);
-      for (std::vector<double>::iterator it = stats.begin (); it != stats.end (); ++it)
-        {
-          outFile << (*it) * 1e-9 << "\t";
-        }
-      stats = GetUlPduSizeStats (p.m_imsi, p.m_lcId);
-      for (std::vector<double>::iterator it = stats.begin (); it != stats.end (); ++it)
-        {
-          outFile << (*it) << "\t";
-        }
-      outFile << std::endl;
-    }
-
-  outFile.close ();
+  WriteResults (outFile, true);
 }
 
 void
 MmWaveBearerStatsCalculator::WriteDlResults (std::ofstream& outFile)
 {
   NS_LOG_FUNCTION (this);
+  WriteResults (outFile, false);
+}
 
-  // Get the unique IMSI list
-  std::vector < ImsiLcidPair_t > pairVector;
-  for (Uint32Map::iterator it = m_dlTxPackets.begin (); it != m_dlTxPackets.end (); ++it)
+void
+MmWaveBearerStatsCalculator::WriteResults (std::ofstream& outFile, bool uplink)
+{
+  // the bearers with a transmission in the epoch, in (IMSI, LCID) order
+  Time endTime = m_startTime + m_epochDuration;
+  for (std::map<ImsiLcidPair_t, uint32_t>::iterator it = m_bearerSlots.begin (); it != m_bearerSlots.end (); ++it)
     {
-      if (find (pairVector.begin (), pairVector.end (), (*it).first) == pairVector.end ())
+      const BearerStats &bearer = m_bearers[it->second];
+      const DirectionStats &stats = uplink ? bearer.m_ul : bearer.m_dl;
+      if (stats.m_txPackets == 0)
         {
-          pairVector.push_back ((*it).first);
+          continue;
         }
-    }
-
-  Time endTime = m_startTime + m_epochDuration;
-  for (std::vector<ImsiLcidPair_t>::iterator pair = pairVector.begin (); pair != pairVector.end (); ++pair)
-    {
-      ImsiLcidPair_t p = *pair;
       outFile << m_startTime.GetNanoSeconds () / 1.0e9 << "\t";
       outFile << endTime.GetNanoSeconds () / 1.0e9 << "\t";
-      outFile << GetDlCellId (p.m_imsi, p.m_lcId) << "\t";
-      outFile << p.m_imsi << "\t";
-      outFile << m_flowId[p].m_rnti << "\t";
-      outFile << (uint32_t) m_flowId[p].m_lcId << "\t";
-      outFile << GetDlTxPackets (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetDlTxData (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetDlRxPackets (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetDlRxData (p.m_imsi, p.m_lcId) << "\t";
-      std::vector<double> stats = GetDlDelayStats (p.m_imsi, p.m_lcId);
-      for (std::vector<double>::iterator it = stats.begin (); it != stats.end (); ++it)
+      outFile << stats.m_cellId << "\t";
+      outFile << bearer.m_imsiLcid.m_imsi << "\t";
+      outFile << bearer.m_flowId.m_rnti << "\t";
+      outFile << (uint32_t) bearer.m_flowId.m_lcId << "\t";
+      outFile << stats.m_txPackets << "\t";
+      outFile << stats.m_txData << "\t";
+      outFile << stats.m_rxPackets << "\t";
+      outFile << stats.m_rxData << "\t";
+      std::vector<double> delay = uplink ? GetUlDelayStats (bearer.m_imsiLcid.m_imsi, bearer.m_imsiLcid.m_lcId)
+                                         : GetDlDelayStats (bearer.m_imsiLcid.m_imsi, bearer.m_imsiLcid.m_lcId);
+      for (std::vector<double>::iterator it = delay.begin (); it != delay.end (); ++it)
         {
           outFile << (*it) * 1e-9 << "\t";
         }
-      stats = GetDlPduSizeStats (p.m_imsi, p.m_lcId);
-      for (std::vector<double>::iterator it = stats.begin (); it != stats.end (); ++it)
+      std::vector<double> size = uplink ? GetUlPduSizeStats (bearer.m_imsiLcid.m_imsi, bearer.m_imsiLcid.m_lcId)
+                                        : GetDlPduSizeStats (bearer.m_imsiLcid.m_imsi, bearer.m_imsiLcid.m_lcId);
+      for (std::vector<double>::iterator it = size.begin (); it != size.end (); ++it)
         {
           outFile << (*it) << "\t";
         }
@@ -453,19 +443,16 @@ MmWaveBearerStatsCalculator::ResetResults (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_ulTxPackets.erase (m_ulTxPackets.begin (), m_ulTxPackets.end ());
-  m_ulRxPackets.erase (m_ulRxPackets.begin (), m_ulRxPackets.end ());
-  m_ulRxData.erase (m_ulRxData.begin (), m_ulRxData.end ());
-  m_ulTxData.erase (m_ulTxData.begin (), m_ulTxData.end ());
-  m_ulDelay.erase (m_ulDelay.begin (), m_ulDelay.end ());
-  m_ulPduSize.erase (m_ulPduSize.begin (), m_ulPduSize.end ());
-
-  m_dlTxPackets.erase (m_dlTxPackets.begin (), m_dlTxPackets.end ());
-  m_dlRxPackets.erase (m_dlRxPackets.begin (), m_dlRxPackets.end ());
-  m_dlRxData.erase (m_dlRxData.begin (), m_dlRxData.end ());
-  m_dlTxData.erase (m_dlTxData.begin (), m_dlTxData.end ());
-  m_dlDelay.erase (m_dlDelay.begin (), m_dlDelay.end ());
-  m_dlPduSize.erase (m_dlPduSize.begin (), m_dlPduSize.end ());
+  // the slots are kept, so that a bearer keeps its slot across the epochs
+  for (std::vector<BearerStats>::iterator it = m_bearers.begin (); it != m_bearers.end (); ++it)
+    {
+      uint32_t ulCellId = it->m_ul.m_cellId;
+      uint32_t dlCellId = it->m_dl.m_cellId;
+      it->m_ul.Reset ();
+      it->m_dl.Reset ();
+      it->m_ul.m_cellId = ulCellId;
+      it->m_dl.m_cellId = dlCellId;
+    }
 }
 
 void
@@ -487,73 +474,96 @@ MmWaveBearerStatsCalculator::EndEpoch (void)
   m_endEpochEvent = Simulator::Schedule (m_epochDuration, &MmWaveBearerStatsCalculator::EndEpoch, this);
 }
 
+MmWaveBearerStatsCalculator::BearerStats*
+MmWaveBearerStatsCalculator::FindBearer (uint64_t imsi, uint8_t lcid)
+{
+  std::map<ImsiLcidPair_t, uint32_t>::const_iterator it = m_bearerSlots.find (ImsiLcidPair_t (imsi, lcid));
+  if (it == m_bearerSlots.end ())
+    {
+      return 0;
+    }
+  return &m_bearers[it->second];
+}
+
+MmWaveBearerStatsCalculator::BearerStats&
+MmWaveBearerStatsCalculator::GetBearer (uint64_t imsi, uint8_t lcid)
+{
+  ImsiLcidPair_t p (imsi, lcid);
+  std::pair<std::map<ImsiLcidPair_t, uint32_t>::iterator, bool> ret =
+    m_bearerSlots.insert (std::make_pair (p, (uint32_t) m_bearers.size ()));
+  if (ret.second)
+    {
+      NS_LOG_DEBUG (this << " Slot " << ret.first->second << " for IMSI " << imsi << " and LCID " << (uint32_t) lcid);
+      BearerStats bearer;
+      bearer.m_imsiLcid = p;
+      bearer.m_ul.Reset ();
+      bearer.m_dl.Reset ();
+      m_bearers.push_back (bearer);
+    }
+  return m_bearers[ret.first->second];
+}
+
 uint32_t
 MmWaveBearerStatsCalculator::GetUlTxPackets (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulTxPackets[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_ul.m_txPackets : 0;
 }
 
 uint32_t
 MmWaveBearerStatsCalculator::GetUlRxPackets (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulRxPackets[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_ul.m_rxPackets : 0;
 }
 
 uint64_t
 MmWaveBearerStatsCalculator::GetUlTxData (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulTxData[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_ul.m_txData : 0;
 }
 
 uint64_t
 MmWaveBearerStatsCalculator::GetUlRxData (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulRxData[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_ul.m_rxData : 0;
 }
 
 double
 MmWaveBearerStatsCalculator::GetUlDelay (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  Uint64StatsMap::iterator it = m_ulDelay.find (p);
-  if (it == m_ulDelay.end ())
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  if (bearer == 0 || bearer->m_ul.m_delay.m_count == 0)
     {
       NS_LOG_ERROR ("UL delay for " << imsi << " - " << (uint16_t) lcid << " not found");
       return 0;
 
     }
-  return m_ulDelay[p]->getMean ();
+  return bearer->m_ul.m_delay.m_mean;
 }
 
 std::vector<double>
 MmWaveBearerStatsCalculator::GetUlDelayStats (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  std::vector<double> stats;
-  Uint64StatsMap::iterator it = m_ulDelay.find (p);
-  if (it == m_ulDelay.end ())
-    {
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
+  std::vector<double> stats (4, 0.0);
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  if (bearer == 0 || bearer->m_ul.m_delay.m_count == 0)
+    {
       return stats;
-
     }
-  stats.push_back (m_ulDelay[p]->getMean ());
-  stats.push_back (m_ulDelay[p]->getStddev ());
-  stats.push_back (m_ulDelay[p]->getMin ());
-  stats.push_back (m_ulDelay[p]->getMax ());
+  const RunningStats &delay = bearer->m_ul.m_delay;
+  stats[0] = delay.m_mean;
+  stats[1] = std::sqrt (delay.m_count > 1 ? delay.m_s / (delay.m_count - 1) : 0.0);
+  stats[2] = delay.m_min;
+  stats[3] = delay.m_max;
   return stats;
 }
 
@@ -561,22 +571,17 @@ std::vector<double>
 MmWaveBearerStatsCalculator::GetUlPduSizeStats (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  std::vector<double> stats;
-  Uint32StatsMap::iterator it = m_ulPduSize.find (p);
-  if (it == m_ulPduSize.end ())
-    {
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
+  std::vector<double> stats (4, 0.0);
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  if (bearer == 0 || bearer->m_ul.m_pduSize.m_count == 0)
+    {
       return stats;
-
     }
-  stats.push_back (m_ulPduSize[p]->getMean ());
-  stats.push_back (m_ulPduSize[p]->getStddev ());
-  stats.push_back (m_ulPduSize[p]->getMin ());
-  stats.push_back (m_ulPduSize[p]->getMax ());
+  const RunningStats &size = bearer->m_ul.m_pduSize;
+  stats[0] = size.m_mean;
+  stats[1] = std::sqrt (size.m_count > 1 ? size.m_s / (size.m_count - 1) : 0.0);
+  stats[2] = size.m_min;
+  stats[3] = size.m_max;
   return stats;
 }
 
@@ -584,84 +589,78 @@ uint32_t
 MmWaveBearerStatsCalculator::GetDlTxPackets (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlTxPackets[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_dl.m_txPackets : 0;
 }
 
 uint32_t
 MmWaveBearerStatsCalculator::GetDlRxPackets (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlRxPackets[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_dl.m_rxPackets : 0;
 }
 
 uint64_t
 MmWaveBearerStatsCalculator::GetDlTxData (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlTxData[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_dl.m_txData : 0;
 }
 
 uint64_t
 MmWaveBearerStatsCalculator::GetDlRxData (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlRxData[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_dl.m_rxData : 0;
 }
 
 uint32_t
 MmWaveBearerStatsCalculator::GetUlCellId (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulCellId[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_ul.m_cellId : 0;
 }
 
 uint32_t
 MmWaveBearerStatsCalculator::GetDlCellId (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlCellId[p];
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  return bearer ? bearer->m_dl.m_cellId : 0;
 }
 
 double
 MmWaveBearerStatsCalculator::GetDlDelay (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  Uint64StatsMap::iterator it = m_dlDelay.find (p);
-  if (it == m_dlDelay.end ())
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  if (bearer == 0 || bearer->m_dl.m_delay.m_count == 0)
     {
       NS_LOG_ERROR ("DL delay for " << imsi << " not found");
       return 0;
     }
-  return m_dlDelay[p]->getMean ();
+  return bearer->m_dl.m_delay.m_mean;
 }
 
 std::vector<double>
 MmWaveBearerStatsCalculator::GetDlDelayStats (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  std::vector<double> stats;
-  Uint64StatsMap::iterator it = m_dlDelay.find (p);
-  if (it == m_dlDelay.end ())
-    {
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
+  std::vector<double> stats (4, 0.0);
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  if (bearer == 0 || bearer->m_dl.m_delay.m_count == 0)
+    {
       return stats;
-
     }
-  stats.push_back (m_dlDelay[p]->getMean ());
-  stats.push_back (m_dlDelay[p]->getStddev ());
-  stats.push_back (m_dlDelay[p]->getMin ());
-  stats.push_back (m_dlDelay[p]->getMax ());
+  const RunningStats &delay = bearer->m_dl.m_delay;
+  stats[0] = delay.m_mean;
+  stats[1] = std::sqrt (delay.m_count > 1 ? delay.m_s / (delay.m_count - 1) : 0.0);
+  stats[2] = delay.m_min;
+  stats[3] = delay.m_max;
   return stats;
 }
 
@@ -669,25 +668,193 @@ std::vector<double>
 MmWaveBearerStatsCalculator::GetDlPduSizeStats (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  std::vector<double> stats;
-  Uint32StatsMap::iterator it = m_dlPduSize.find (p);
-  if (it == m_dlPduSize.end ())
-    {
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
+  std::vector<double> stats (4, 0.0);
+  BearerStats *bearer = FindBearer (imsi, lcid);
+  if (bearer == 0 || bearer->m_dl.m_pduSize.m_count == 0)
+    {
       return stats;
-
     }
-  stats.push_back (m_dlPduSize[p]->getMean ());
-  stats.push_back (m_dlPduSize[p]->getStddev ());
-  stats.push_back (m_dlPduSize[p]->getMin ());
-  stats.push_back (m_dlPduSize[p]->getMax ());
+  const RunningStats &size = bearer->m_dl.m_pduSize;
+  stats[0] = size.m_mean;
+  stats[1] = std::sqrt (size.m_count > 1 ? size.m_s / (size.m_count - 1) : 0.0);
+  stats[2] = size.m_min;
+  stats[3] = size.m_max;
   return stats;
 }
 
+void
+MmWaveBearerStatsCalculator::RunningStats::Reset ()
+{
+  m_count = 0;
+  m_mean = 0;
+  m_s = 0;
+  m_min = std::numeric_limits<double>::max ();
+  m_max = -std::numeric_limits<double>::max ();
+}
+
+void
+MmWaveBearerStatsCalculator::RunningStats::Update (double value)
+{
+  m_count++;
+  m_min = std::min (m_min, value);
+  m_max = std::max (m_max, value);
+  if (m_count == 1)
+    {
+      m_mean = value;
+      m_s = 0;
+    }
+  else
+    {
+      double meanPrev = m_mean;
+      m_mean = meanPrev + (value - meanPrev) / m_count;
+      m_s = m_s + (value - meanPrev) * (value - m_mean);
+    }
+}
+
+void
+MmWaveBearerStatsCalculator::DirectionStats::Reset ()
+{
+  m_cellId = 0;
+  m_txPackets = 0;
+  m_txData = 0;
+  m_rxPackets = 0;
+  m_rxData = 0;
+  m_delay.Reset ();
+  m_pduSize.Reset ();
+}
+
+MmWaveBearerStatsCalculator::ColumnarPduWriter::ColumnarPduWriter ()
+  : m_chunkRows (0),
+    m_numRows (0)
+{
+}
+
+uint32_t
+MmWaveBearerStatsCalculator::ColumnarPduWriter::GetChunkSize (uint32_t chunkRows)
+{
+  // the columns follow the row count, largest first, so that every value is aligned
+  return 8 + ROW_SIZE * ((chunkRows + 7) / 8 * 8);
+}
+
+bool
+MmWaveBearerStatsCalculator::ColumnarPduWriter::Open (const std::string &filename, uint32_t chunkRows)
+{
+  m_chunkRows = (chunkRows + 7) / 8 * 8;
+  m_numRows = 0;
+  m_chunk.assign (GetChunkSize (chunkRows), 0);
+  // keep up to 16 chunks in memory while the background thread writes
+  return m_writer.Open (filename, MAGIC, m_chunk.size (), 16 * m_chunk.size ());
+}
+
+bool
+MmWaveBearerStatsCalculator::ColumnarPduWriter::IsOpen () const
+{
+  return m_writer.IsOpen ();
+}
+
+template <typename T>
+T*
+MmWaveBearerStatsCalculator::ColumnarPduWriter::GetColumn (uint32_t offset)
+{
+  return reinterpret_cast<T*> (&m_chunk[8 + offset * m_chunkRows]);
+}
+
+void
+MmWaveBearerStatsCalculator::ColumnarPduWriter::Append (int64_t timeNs, uint16_t cellId, uint16_t rnti, uint64_t imsi,
+                                                        uint8_t lcid, uint32_t packetSize, uint64_t delay)
+{
+  GetColumn<int64_t> (0)[m_numRows] = timeNs;
+  GetColumn<uint64_t> (8)[m_numRows] = imsi;
+  GetColumn<uint64_t> (16)[m_numRows] = delay;
+  GetColumn<uint32_t> (24)[m_numRows] = packetSize;
+  GetColumn<uint16_t> (28)[m_numRows] = cellId;
+  GetColumn<uint16_t> (30)[m_numRows] = rnti;
+  GetColumn<uint8_t> (32)[m_numRows] = lcid;
+  if (++m_numRows == m_chunkRows)
+    {
+      WriteChunk ();
+    }
+}
+
+void
+MmWaveBearerStatsCalculator::ColumnarPduWriter::WriteChunk ()
+{
+  std::memcpy (&m_chunk[0], &m_numRows, sizeof (m_numRows));
+  m_writer.Append (&m_chunk[0]);
+  m_numRows = 0;
+}
+
+void
+MmWaveBearerStatsCalculator::ColumnarPduWriter::Close ()
+{
+  if (!m_writer.IsOpen ())
+    {
+      return;
+    }
+  if (m_numRows > 0)
+    {
+      // clear the rows left over from the previous chunk
+      uint32_t offsets[] = {0, 8, 16, 24, 28, 30, 32, 33};
+      for (uint32_t column = 0; column + 1 < sizeof (offsets) / sizeof (offsets[0]); column++)
+        {
+          uint32_t width = offsets[column + 1] - offsets[column];
+          std::memset (&m_chunk[8 + offsets[column] * m_chunkRows + width * m_numRows], 0,
+                       width * (m_chunkRows - m_numRows));
+        }
+      WriteChunk ();
+    }
+  m_writer.Close ();
+}
+
+bool
+MmWaveBearerStatsCalculator::ExportColumnarTrace (const std::string &columnarFile, const std::string &textFile)
+{
+  uint32_t chunkSize;
+  FILE *in = MmWaveBinaryTraceWriter::OpenForReading (columnarFile, ColumnarPduWriter::MAGIC, &chunkSize);
+  if (in == 0 || (chunkSize - 8) % (8 * ColumnarPduWriter::ROW_SIZE) != 0)
+    {
+      if (in != 0)
+        {
+          fclose (in);
+        }
+      return false;
+    }
+  std::ofstream out (textFile.c_str ());
+  if (!out.is_open ())
+    {
+      fclose (in);
+      return false;
+    }
+
+  uint32_t chunkRows = (chunkSize - 8) / ColumnarPduWriter::ROW_SIZE;
+  std::vector<char> chunk (chunkSize);
+  while (fread (&chunk[0], chunkSize, 1, in) == 1)
+    {
+      uint32_t numRows;
+      std::memcpy (&numRows, &chunk[0], sizeof (numRows));
+      if (numRows > chunkRows)
+        {
+          fclose (in);
+          return false;
+        }
+      const char *columns = &chunk[8];
+      const int64_t *timeNs = reinterpret_cast<const int64_t*> (columns);
+      const uint64_t *imsi = reinterpret_cast<const uint64_t*> (columns + 8 * chunkRows);
+      const uint64_t *delay = reinterpret_cast<const uint64_t*> (columns + 16 * chunkRows);
+      const uint32_t *packetSize = reinterpret_cast<const uint32_t*> (columns + 24 * chunkRows);
+      const uint16_t *cellId = reinterpret_cast<const uint16_t*> (columns + 28 * chunkRows);
+      const uint16_t *rnti = reinterpret_cast<const uint16_t*> (columns + 30 * chunkRows);
+      const uint8_t *lcid = reinterpret_cast<const uint8_t*> (columns + 32 * chunkRows);
+      for (uint32_t row = 0; row < numRows; row++)
+        {
+          WritePduLine (out, timeNs[row], cellId[row], rnti[row], imsi[row], lcid[row], packetSize[row], delay[row]);
+        }
+    }
+  bool ok = !ferror (in) && out.good ();
+  fclose (in);
+  return ok;
+}
+
 std::string
 MmWaveBearerStatsCalculator::GetUlOutputFilename (void)
 {
@@ -35,8 +35,11 @@
 #include "ns3/object.h"
 #include "ns3/basic-data-calculators.h"
 #include "ns3/lte-common.h"
+#include "mmwave-binary-trace-writer.h"
+#include "mmwave-kpi-calculator.h"
 #include <string>
 #include <map>
+#include <vector>
 #include <fstream>
 
 namespace ns3
@@ -73,10 +76,26 @@ typedef std::map<ImsiLcidPair_t, LteFlowId_t> FlowIdMap;
  *   - Average, min, max and standard deviation of PDU delay (delay is
  *     calculated from the generation of the PDU to its reception)
  *   - Average, min, max and standard deviation of PDU size
+ *
+ * The statistics of every (IMSI, LCID) pair are kept in a flat table, in
+ * the slot assigned to the pair when its first PDU is notified.
+ *
+ * Every received PDU is also written to the output file, either as a text
+ * line (Text format) or, with the Columnar format, as a row of chunks of
+ * binary columns written by a background thread, which ExportColumnarTrace
+ * converts back to the text lines. With the None format no PDU is written,
+ * e.g., when the PDUs are only aggregated by a MmWaveKpiCalculator.
  */
 class MmWaveBearerStatsCalculator : public LteStatsCalculator
 {
 public:
+  enum OutputFormat
+  {
+    TEXT,
+    COLUMNAR,
+    NONE
+  };
+
   /**
    * Class constructor
    */
@@ -354,7 +373,149 @@ public:
   std::vector<double>
   GetDlPduSizeStats (uint64_t imsi, uint8_t lcid);
 
+  /**
+   * Writes the line of a received PDU as in the Text format
+   * @param os the stream
+   * @param timeNs reception time in nanoseconds
+   * @param cellId CellId of the attached Enb
+   * @param rnti C-RNTI of the UE
+   * @param imsi IMSI of the UE
+   * @param lcid LCID
+   * @param packetSize size of the PDU in bytes
+   * @param delay RLC to RLC delay in nanoseconds
+   */
+  static void
+  WritePduLine (std::ostream &os, int64_t timeNs, uint16_t cellId, uint16_t rnti, uint64_t imsi,
+                uint8_t lcid, uint32_t packetSize, uint64_t delay);
+
+  /**
+   * Converts a file written with the Columnar format to the Text format
+   * @param columnarFile name of the columnar file
+   * @param textFile name of the text file to be written
+   * @return false if the columnar file could not be read or the text file written
+   */
+  static bool
+  ExportColumnarTrace (const std::string &columnarFile, const std::string &textFile);
+
+  /**
+   * Forwards the transmitted and received PDUs to a KPI calculator
+   * @param kpiStats the KPI calculator
+   */
+  void
+  SetKpiCalculator (Ptr<MmWaveKpiCalculator> kpiStats);
+
 private:
+  /**
+   * Running count, mean, variance, min and max of a metric, updated as
+   * MinMaxAvgTotalCalculator does
+   */
+  struct RunningStats
+  {
+    uint32_t m_count;
+    double m_mean;
+    double m_s;
+    double m_min;
+    double m_max;
+
+    void Reset ();
+    void Update (double value);
+  };
+
+  /**
+   * Statistics of one direction of a bearer in the current epoch
+   */
+  struct DirectionStats
+  {
+    uint32_t m_cellId;
+    uint32_t m_txPackets;
+    uint64_t m_txData;
+    uint32_t m_rxPackets;
+    uint64_t m_rxData;
+    RunningStats m_delay;
+    RunningStats m_pduSize;
+
+    void Reset ();
+  };
+
+  /**
+   * Slot of the table of the statistics
+   */
+  struct BearerStats
+  {
+    ImsiLcidPair_t m_imsiLcid;
+    LteFlowId_t m_flowId;
+    DirectionStats m_ul;
+    DirectionStats m_dl;
+  };
+
+  /**
+   * Received PDUs of one direction, written in chunks of ChunkSize rows.
+   * Every chunk is a record of the binary file: the number of rows used
+   * (uint32), 4 bytes of padding, then the columns of ChunkSize values
+   * each: time (int64, ns), IMSI (uint64), delay (uint64, ns), PDU size
+   * (uint32), CellId (uint16), RNTI (uint16) and LCID (uint8).
+   */
+  class ColumnarPduWriter
+  {
+  public:
+    ColumnarPduWriter ();
+
+    bool Open (const std::string &filename, uint32_t chunkRows);
+    bool IsOpen () const;
+    void Append (int64_t timeNs, uint16_t cellId, uint16_t rnti, uint64_t imsi, uint8_t lcid,
+                 uint32_t packetSize, uint64_t delay);
+    void Close ();
+
+    static uint32_t GetChunkSize (uint32_t chunkRows);
+
+    static const char MAGIC[8];
+    static const uint32_t ROW_SIZE = 8 + 8 + 8 + 4 + 2 + 2 + 1;
+
+  private:
+    template <typename T>
+    T* GetColumn (uint32_t offset);
+    void WriteChunk ();
+
+    MmWaveBinaryTraceWriter m_writer;
+    std::vector<char> m_chunk;
+    uint32_t m_chunkRows;
+    uint32_t m_numRows;
+  };
+
+  /**
+   * Gets the slot of the statistics of a bearer
+   * @param imsi IMSI of the UE
+   * @param lcid LCID
+   * @return pointer to the slot, or 0 if no PDU of the bearer has been notified
+   */
+  BearerStats*
+  FindBearer (uint64_t imsi, uint8_t lcid);
+
+  /**
+   * Gets the slot of the statistics of a bearer, creating it at the first PDU
+   */
+  BearerStats&
+  GetBearer (uint64_t imsi, uint8_t lcid);
+
+  /**
+   * Writes the statistics of one direction
+   */
+  void
+  WriteResults (std::ofstream& outFile, bool uplink);
+
+  /**
+   * Writes a received PDU to the output file of its direction
+   */
+  void
+  WriteRxPdu (bool uplink, uint16_t cellId, uint16_t rnti, uint64_t imsi, uint8_t lcid,
+              uint32_t packetSize, uint64_t delay);
+
+  /**
+   * Writes the last chunks of the columnar files and closes them
+   */
+  void
+  CloseColumnarFiles (void);
+
   /**
    * Called after each epoch to write collected
    * statistics to output files. During first call
@@ -401,23 +562,8 @@ private:
 
   EventId m_endEpochEvent; //!< Event id for next end epoch event
 
-  FlowIdMap m_flowId; //!< List of FlowIds, ie. (RNTI, LCID) by (IMSI, LCID) pair
-
-  Uint32Map m_dlCellId; //!< List of DL CellIds by (IMSI, LCID) pair
-  Uint32Map m_dlTxPackets; //!< Number of DL TX Packets by (IMSI, LCID) pair
-  Uint32Map m_dlRxPackets; //!< Number of DL RX Packets by (IMSI, LCID) pair
-  Uint64Map m_dlTxData; //!< Amount of DL TX Data by (IMSI, LCID) pair
-  Uint64Map m_dlRxData; //!< Amount of DL RX Data by (IMSI, LCID) pair
-  Uint64StatsMap m_dlDelay; //!< DL delay by (IMSI, LCID) pair
-  Uint32StatsMap m_dlPduSize; //!< DL PDU Size by (IMSI, LCID) pair
-
-  Uint32Map m_ulCellId; //!< List of UL CellIds by (IMSI, LCID) pair
-  Uint32Map m_ulTxPackets; //!< Number of UL TX Packets by (IMSI, LCID) pair
-  Uint32Map m_ulRxPackets; //!< Number of UL RX Packets by (IMSI, LCID) pair
-  Uint64Map m_ulTxData; //!< Amount of UL TX Data by (IMSI, LCID) pair
-  Uint64Map m_ulRxData; //!< Amount of UL RX Data by (IMSI, LCID) pair
-  Uint64StatsMap m_ulDelay; //!< UL delay by (IMSI, LCID) pair
-  Uint32StatsMap m_ulPduSize; //!< UL PDU Size by (IMSI, LCID) pair
+  std::vector<BearerStats> m_bearers; //!< Statistics of every bearer, by slot
+  std::map<ImsiLcidPair_t, uint32_t> m_bearerSlots; //!< Slot of each (IMSI, LCID) pair
 
   /**
    * Start time of the on going epoch
@@ -456,6 +602,14 @@ private:
 
   std::ofstream m_dlOutFile;
   std::ofstream m_ulOutFile;
+
+  OutputFormat m_outputFormat;
+  uint32_t m_chunkRows; //!< rows of each chunk of the columnar output
+  ColumnarPduWriter m_dlColumnarFile;
+  ColumnarPduWriter m_ulColumnarFile;
+
+  Ptr<MmWaveKpiCalculator> m_kpiStats;
+  MmWaveKpiCalculator::Layer m_kpiLayer;
 };
 
 } // namespace ns3
@@ -0,0 +1,209 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "mmwave-binary-trace-writer.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/fatal-error.h>
+#include <cstring>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveBinaryTraceWriter");
+
+MmWaveBinaryTraceWriter::MmWaveBinaryTraceWriter ()
+	: m_file (0),
+	  m_recordSize (0),
+	  m_chunkSize (0),
+	  m_appended (0),
+	  m_lastPublished (0),
+	  m_lastWritten (0),
+	  m_published (0),
+	  m_written (0),
+	  m_closing (false)
+{
+}
+
+MmWaveBinaryTraceWriter::~MmWaveBinaryTraceWriter ()
+{
+	Close ();
+}
+
+bool
+MmWaveBinaryTraceWriter::Open (const std::string &filename, const char magic[8], uint32_t recordSize,
+		std::size_t bufferSize)
+{
+	NS_ASSERT_MSG (m_file == 0, "The trace file is already open");
+	NS_ASSERT (recordSize > 0);
+	m_file = std::fopen (filename.c_str (), "wb");
+	if (m_file == 0)
+	{
+		return false;
+	}
+	Header header;
+	std::memcpy (header.m_magic, magic, sizeof (header.m_magic));
+	header.m_byteOrder = BYTE_ORDER_MARK;
+	header.m_recordSize = recordSize;
+	if (std::fwrite (&header, sizeof (header), 1, m_file) != 1)
+	{
+		std::fclose (m_file);
+		m_file = 0;
+		return false;
+	}
+
+	m_recordSize = recordSize;
+	bufferSize = std::max<std::size_t> (bufferSize / recordSize, 2) * recordSize;
+	m_buffer.assign (bufferSize, 0);
+	// wake up the writer every 1/8 of the buffer, in whole records
+	m_chunkSize = std::max<uint64_t> (bufferSize / 8 / recordSize, 1) * recordSize;
+	m_appended = m_lastPublished = m_lastWritten = 0;
+	m_published = m_written = 0;
+	m_closing = false;
+	m_writer = std::thread (&MmWaveBinaryTraceWriter::Run, this);
+	NS_LOG_INFO ("Opened " << filename << " with a buffer of " << bufferSize << " bytes");
+	return true;
+}
+
+void
+MmWaveBinaryTraceWriter::Append (const void *record)
+{
+	NS_ASSERT (m_file != 0);
+	if (m_appended + m_recordSize - m_lastWritten > m_buffer.size ())
+	{
+		// the buffer looks full: hand everything over to the writer and wait for space
+		std::unique_lock<std::mutex> lock (m_mutex);
+		m_published = m_lastPublished = m_appended;
+		m_dataReady.notify_one ();
+		while (m_appended + m_recordSize - m_written > m_buffer.size ())
+		{
+			m_spaceReady.wait (lock);
+		}
+		m_lastWritten = m_written;
+	}
+	// the buffer size is a multiple of the record size, so a record never wraps
+	std::memcpy (&m_buffer[m_appended % m_buffer.size ()], record, m_recordSize);
+	m_appended += m_recordSize;
+	if (m_appended - m_lastPublished >= m_chunkSize)
+	{
+		Publish ();
+	}
+}
+
+void
+MmWaveBinaryTraceWriter::Publish ()
+{
+	std::lock_guard<std::mutex> lock (m_mutex);
+	m_published = m_lastPublished = m_appended;
+	m_lastWritten = m_written;
+	m_dataReady.notify_one ();
+}
+
+void
+MmWaveBinaryTraceWriter::Close ()
+{
+	if (m_file == 0)
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock (m_mutex);
+		m_published = m_lastPublished = m_appended;
+		m_closing = true;
+		m_dataReady.notify_one ();
+	}
+	m_writer.join ();
+	std::fclose (m_file);
+	m_file = 0;
+	m_buffer.clear ();
+}
+
+void
+MmWaveBinaryTraceWriter::Run ()
+{
+	std::unique_lock<std::mutex> lock (m_mutex);
+	while (true)
+	{
+		while (m_published == m_written && !m_closing)
+		{
+			m_dataReady.wait (lock);
+		}
+		if (m_published == m_written)
+		{
+			break;
+		}
+		uint64_t begin = m_written;
+		uint64_t end = m_published;
+		lock.unlock ();
+
+		// the bytes in [begin, end) are not touched by the simulation thread
+		// until m_written moves past them
+		while (begin < end)
+		{
+			uint64_t offset = begin % m_buffer.size ();
+			uint64_t length = std::min<uint64_t> (end - begin, m_buffer.size () - offset);
+			if (std::fwrite (&m_buffer[offset], 1, length, m_file) != length)
+			{
+				NS_FATAL_ERROR ("Could not write the binary trace file");
+			}
+			begin += length;
+		}
+
+		lock.lock ();
+		m_written = end;
+		m_spaceReady.notify_one ();
+	}
+	std::fflush (m_file);
+}
+
+FILE*
+MmWaveBinaryTraceWriter::OpenForReading (const std::string &filename, const char magic[8], uint32_t recordSize)
+{
+	uint32_t fileRecordSize;
+	FILE *file = OpenForReading (filename, magic, &fileRecordSize);
+	if (file != 0 && fileRecordSize != recordSize)
+	{
+		std::fclose (file);
+		return 0;
+	}
+	return file;
+}
+
+FILE*
+MmWaveBinaryTraceWriter::OpenForReading (const std::string &filename, const char magic[8], uint32_t *recordSize)
+{
+	FILE *file = std::fopen (filename.c_str (), "rb");
+	if (file == 0)
+	{
+		return 0;
+	}
+	Header header;
+	if (std::fread (&header, sizeof (header), 1, file) != 1
+			|| std::memcmp (header.m_magic, magic, sizeof (header.m_magic)) != 0
+			|| header.m_byteOrder != BYTE_ORDER_MARK
+			|| header.m_recordSize == 0)
+	{
+		std::fclose (file);
+		return 0;
+	}
+	*recordSize = header.m_recordSize;
+	return file;
+}
+
+} /* namespace ns3 */
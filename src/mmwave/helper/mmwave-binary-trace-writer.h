@@ -0,0 +1,140 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef SRC_MMWAVE_HELPER_MMWAVE_BINARY_TRACE_WRITER_H_
+#define SRC_MMWAVE_HELPER_MMWAVE_BINARY_TRACE_WRITER_H_
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace ns3 {
+
+/**
+ * \brief Writer of a trace file made of fixed-size binary records.
+ *
+ * The records are copied by the simulation thread into an in-memory ring
+ * buffer, and a background thread writes the buffer to the file in large
+ * chunks, so that a trace event costs a copy and not a write to the file
+ * system. The simulation only waits for the writer when the ring buffer is
+ * full; no record is ever dropped.
+ *
+ * File layout (native byte order):
+ *   - header: magic (8 bytes), byte order mark (uint32), record size (uint32)
+ *   - the records, in the order they were appended
+ *
+ * Append must be called from a single thread.
+ */
+class MmWaveBinaryTraceWriter
+{
+public:
+	struct Header
+	{
+		char m_magic[8];
+		uint32_t m_byteOrder;
+		uint32_t m_recordSize;
+	};
+
+	static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	MmWaveBinaryTraceWriter ();
+	~MmWaveBinaryTraceWriter ();
+
+	/**
+	 * Create the file, write its header and start the writer thread
+	 * @params the name of the file
+	 * @params the magic identifying the type of the records
+	 * @params the size of a record in bytes
+	 * @params the size of the ring buffer in bytes, rounded down to a multiple of the record size
+	 * @returns false if the file could not be created
+	 */
+	bool Open (const std::string &filename, const char magic[8], uint32_t recordSize, std::size_t bufferSize);
+
+	bool IsOpen () const
+	{
+		return m_file != 0;
+	}
+
+	/**
+	 * Copy a record to the ring buffer
+	 * @params pointer to the record size bytes of the record
+	 */
+	void Append (const void *record);
+
+	/**
+	 * Write the buffered records, stop the writer thread and close the file
+	 */
+	void Close ();
+
+	/**
+	 * Open a file written by this class and check its header
+	 * @params the name of the file
+	 * @params the expected magic
+	 * @params the expected record size
+	 * @returns the file, positioned on the first record, or 0 if the file
+	 * could not be opened or is of another type
+	 */
+	static FILE* OpenForReading (const std::string &filename, const char magic[8], uint32_t recordSize);
+
+	/**
+	 * Open a file written by this class, whatever the size of its records
+	 * @params the name of the file
+	 * @params the expected magic
+	 * @params set to the record size of the file
+	 * @returns the file, positioned on the first record, or 0 if the file
+	 * could not be opened or is of another type
+	 */
+	static FILE* OpenForReading (const std::string &filename, const char magic[8], uint32_t *recordSize);
+
+private:
+	MmWaveBinaryTraceWriter (const MmWaveBinaryTraceWriter &);
+	MmWaveBinaryTraceWriter& operator= (const MmWaveBinaryTraceWriter &);
+
+	void Publish ();
+	void Run ();
+
+	FILE *m_file;
+	uint32_t m_recordSize;
+	std::vector<char> m_buffer;
+	uint64_t m_chunkSize;				// bytes appended before the writer is woken up
+
+	// owned by the simulation thread
+	uint64_t m_appended;				// bytes appended since the file was opened
+	uint64_t m_lastPublished;
+	uint64_t m_lastWritten;				// copy of m_written, refreshed when the buffer looks full
+
+	// shared with the writer thread, protected by m_mutex
+	uint64_t m_published;				// bytes the writer may write
+	uint64_t m_written;					// bytes written to the file
+	bool m_closing;
+	std::mutex m_mutex;
+	std::condition_variable m_dataReady;
+	std::condition_variable m_spaceReady;
+	std::thread m_writer;
+};
+
+} /* namespace ns3 */
+
+#endif /* SRC_MMWAVE_HELPER_MMWAVE_BINARY_TRACE_WRITER_H_ */
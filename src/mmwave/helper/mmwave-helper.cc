@@ -2745,7 +2745,12 @@ MmWaveHelper::EnableTransportBlockTrace ()
 void
 MmWaveHelper::EnableRlcTraces (void)
 {
-  NS_ASSERT_MSG (m_rlcStats == 0, "please make sure that MmWaveHelper::EnableRlcTraces is called at most once");
+  if (m_rlcStats != 0)
+    {
+      // the calculator was created by EnableKpiTraces, without an output of its own
+      RestoreOutputFormat (m_rlcStats, "RLC");
+      return;
+    }
   m_rlcStats = CreateObject<MmWaveBearerStatsCalculator> ("RLC");
   m_radioBearerStatsConnector->EnableRlcStats (m_rlcStats);
 }
@@ -2759,11 +2764,29 @@ MmWaveHelper::GetRlcStats (void)
 void
 MmWaveHelper::EnablePdcpTraces (void)
 {
-  NS_ASSERT_MSG (m_pdcpStats == 0, "please make sure that MmWaveHelper::EnablePdcpTraces is called at most once");
+  if (m_pdcpStats != 0)
+    {
+      // the calculator was created by EnableKpiTraces, without an output of its own
+      RestoreOutputFormat (m_pdcpStats, "PDCP");
+      return;
+    }
   m_pdcpStats = CreateObject<MmWaveBearerStatsCalculator> ("PDCP");
   m_radioBearerStatsConnector->EnablePdcpStats (m_pdcpStats);
 }
 
+void
+MmWaveHelper::RestoreOutputFormat (Ptr<MmWaveBearerStatsCalculator> stats, std::string layer)
+{
+  EnumValue format;
+  stats->GetAttribute ("OutputFormat", format);
+  NS_ASSERT_MSG (m_kpiStats != 0 && format.Get () == MmWaveBearerStatsCalculator::NONE,
+                 "please make sure that the " << layer << " traces are enabled at most once");
+  struct TypeId::AttributeInformation info;
+  bool found = MmWaveBearerStatsCalculator::GetTypeId ().LookupAttributeByName ("OutputFormat", &info);
+  NS_ASSERT (found);
+  stats->SetAttribute ("OutputFormat", *info.initialValue);
+}
+
 Ptr<MmWaveBearerStatsCalculator>
 MmWaveHelper::GetPdcpStats (void)
 {
@@ -2784,5 +2807,42 @@ MmWaveHelper::GetMcStats (void)
   return m_mcStats;
 }
 
+void
+MmWaveHelper::EnableKpiTraces (void)
+{
+  NS_ASSERT_MSG (m_kpiStats == 0, "please make sure that MmWaveHelper::EnableKpiTraces is called at most once");
+  m_kpiStats = CreateObject<MmWaveKpiCalculator> ();
+
+  Config::Connect ("/NodeList/*/DeviceList/*/MmWaveUePhy/DlSpectrumPhy/RxPacketTraceUe",
+      MakeBoundCallback (&MmWaveKpiCalculator::RxPacketTraceUeCallback, m_kpiStats));
+  Config::Connect ("/NodeList/*/DeviceList/*/BackhaulPhy/DlSpectrumPhy/RxPacketTraceUe", // IAB backhaul
+      MakeBoundCallback (&MmWaveKpiCalculator::RxPacketTraceUeCallback, m_kpiStats));
+  Config::Connect ("/NodeList/*/DeviceList/*/MmWaveEnbPhy/DlSpectrumPhy/RxPacketTraceEnb",
+      MakeBoundCallback (&MmWaveKpiCalculator::RxPacketTraceEnbCallback, m_kpiStats));
+  Config::Connect ("/NodeList/*/DeviceList/*/AccessPhy/DlSpectrumPhy/RxPacketTraceEnb", // IAB access
+      MakeBoundCallback (&MmWaveKpiCalculator::RxPacketTraceEnbCallback, m_kpiStats));
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::MmWaveIabNetDevice/BackhaulTargetEnb",
+      MakeBoundCallback (&MmWaveKpiCalculator::BackhaulTargetEnbCallback, m_kpiStats));
+
+  if (m_rlcStats == 0)
+    {
+      EnableRlcTraces ();
+      m_rlcStats->SetAttribute ("OutputFormat", EnumValue (MmWaveBearerStatsCalculator::NONE));
+    }
+  m_rlcStats->SetKpiCalculator (m_kpiStats);
+  if (m_pdcpStats == 0)
+    {
+      EnablePdcpTraces ();
+      m_pdcpStats->SetAttribute ("OutputFormat", EnumValue (MmWaveBearerStatsCalculator::NONE));
+    }
+  m_pdcpStats->SetKpiCalculator (m_kpiStats);
+}
+
+Ptr<MmWaveKpiCalculator>
+MmWaveHelper::GetKpiStats (void)
+{
+  return m_kpiStats;
+}
+
 }
 
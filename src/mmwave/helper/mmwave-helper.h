@@ -65,6 +65,7 @@
 #include <ns3/mmwave-channel-matrix.h>
 #include <ns3/mmwave-bearer-stats-calculator.h>
 #include <ns3/mc-stats-calculator.h>
+#include <ns3/mmwave-kpi-calculator.h>
 #include <ns3/mmwave-bearer-stats-connector.h>
 #include <ns3/propagation-loss-model.h>
 #include <ns3/mmwave-channel-raytracing.h>
@@ -148,6 +149,15 @@ public:
 	void AttachIabToClosestWiredEnb (NetDeviceContainer iabDevices, NetDeviceContainer enbDevices);
 	
 	void EnableTraces ();
+	/**
+	 * Aggregate the PHY, RLC and PDCP traces into windowed KPIs, instead of
+	 * writing a line per TB and PDU. The RLC and PDCP traces are enabled
+	 * without output, unless they were enabled before. EnableTraces may be
+	 * called before or after, in which case the RLC and PDCP calculators are
+	 * shared and keep their OutputFormat.
+	 */
+	void EnableKpiTraces (void);
+	Ptr<MmWaveKpiCalculator> GetKpiStats (void);
 
 	void SetSchedulerType (std::string type);
 	std::string GetSchedulerType () const;
@@ -231,6 +241,11 @@ private:
 	Ptr<MmWaveBearerStatsCalculator> GetRlcStats (void);
 	void EnablePdcpTraces (void);
 	Ptr<MmWaveBearerStatsCalculator> GetPdcpStats (void);
+	/**
+	 * Restore the default OutputFormat of a RLC or PDCP calculator created by
+	 * EnableKpiTraces, when the traces of that layer are enabled afterwards
+	 */
+	void RestoreOutputFormat (Ptr<MmWaveBearerStatsCalculator> stats, std::string layer);
 	void EnableMcTraces (void);
 	Ptr<McStatsCalculator> GetMcStats (void);
 
@@ -304,6 +319,7 @@ private:
 	Ptr<MmWaveBearerStatsCalculator> m_rlcStats;
 	Ptr<MmWaveBearerStatsCalculator> m_pdcpStats;
 	Ptr<McStatsCalculator> m_mcStats;
+	Ptr<MmWaveKpiCalculator> m_kpiStats;
 	Ptr<MmWaveBearerStatsConnector> m_radioBearerStatsConnector;
   	Ptr<CoreNetworkStatsCalculator> m_cnStats;
 
@@ -0,0 +1,468 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mmwave-kpi-calculator.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include <ns3/mmwave-enb-net-device.h>
+#include <ns3/mmwave-iab-net-device.h>
+#include <ns3/log.h>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveKpiCalculator");
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveKpiCalculator);
+
+MmWaveKpiHistogram::MmWaveKpiHistogram ()
+{
+  Reset ();
+}
+
+uint32_t
+MmWaveKpiHistogram::GetBucket (uint64_t value)
+{
+  const uint64_t subBuckets = 1 << PRECISION_BITS;
+  if (value < subBuckets)
+    {
+      return value;
+    }
+  uint32_t msb = 63;
+  while ((value >> msb) == 0)
+    {
+      msb--;
+    }
+  uint32_t shift = msb - PRECISION_BITS;
+  return (shift + 1) * subBuckets + ((value >> shift) - subBuckets);
+}
+
+uint64_t
+MmWaveKpiHistogram::GetBucketLow (uint32_t bucket)
+{
+  const uint64_t subBuckets = 1 << PRECISION_BITS;
+  if (bucket < subBuckets)
+    {
+      return bucket;
+    }
+  uint32_t shift = bucket / subBuckets - 1;
+  return (subBuckets + bucket % subBuckets) << shift;
+}
+
+uint64_t
+MmWaveKpiHistogram::GetBucketHigh (uint32_t bucket)
+{
+  const uint64_t subBuckets = 1 << PRECISION_BITS;
+  if (bucket < subBuckets)
+    {
+      return bucket;
+    }
+  uint32_t shift = bucket / subBuckets - 1;
+  return GetBucketLow (bucket) + ((uint64_t (1) << shift) - 1);
+}
+
+void
+MmWaveKpiHistogram::Add (uint64_t value)
+{
+  uint32_t bucket = GetBucket (value);
+  if (bucket >= m_buckets.size ())
+    {
+      m_buckets.resize (bucket + 1, 0);
+    }
+  m_buckets[bucket]++;
+  m_count++;
+  m_min = std::min (m_min, value);
+  m_max = std::max (m_max, value);
+  m_sum += value;
+}
+
+uint64_t
+MmWaveKpiHistogram::GetQuantile (double q) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  // rank of the quantile, between 1 and m_count
+  uint64_t rank = std::max<uint64_t> (1, std::ceil (std::min (std::max (q, 0.0), 1.0) * m_count));
+  uint64_t seen = 0;
+  for (uint32_t bucket = 0; bucket < m_buckets.size (); bucket++)
+    {
+      seen += m_buckets[bucket];
+      if (seen >= rank)
+        {
+          uint64_t low = GetBucketLow (bucket);
+          uint64_t value = low + (GetBucketHigh (bucket) - low) / 2;
+          return std::min (std::max (value, m_min), m_max);
+        }
+    }
+  return m_max;
+}
+
+uint64_t
+MmWaveKpiHistogram::GetCount () const
+{
+  return m_count;
+}
+
+uint64_t
+MmWaveKpiHistogram::GetMin () const
+{
+  return m_count > 0 ? m_min : 0;
+}
+
+uint64_t
+MmWaveKpiHistogram::GetMax () const
+{
+  return m_max;
+}
+
+double
+MmWaveKpiHistogram::GetMean () const
+{
+  return m_count > 0 ? m_sum / m_count : 0.0;
+}
+
+void
+MmWaveKpiHistogram::Reset ()
+{
+  // the buckets are kept, so that a histogram does not allocate at every window
+  std::fill (m_buckets.begin (), m_buckets.end (), 0);
+  m_count = 0;
+  m_min = std::numeric_limits<uint64_t>::max ();
+  m_max = 0;
+  m_sum = 0;
+}
+
+bool
+MmWaveKpiCalculator::KpiKey::operator< (const KpiKey &other) const
+{
+  if (m_layer != other.m_layer)
+    {
+      return m_layer < other.m_layer;
+    }
+  if (m_uplink != other.m_uplink)
+    {
+      return m_uplink < other.m_uplink;
+    }
+  if (m_cellId != other.m_cellId)
+    {
+      return m_cellId < other.m_cellId;
+    }
+  if (m_hop != other.m_hop)
+    {
+      return m_hop < other.m_hop;
+    }
+  if (m_rnti != other.m_rnti)
+    {
+      return m_rnti < other.m_rnti;
+    }
+  return m_lcid < other.m_lcid;
+}
+
+void
+MmWaveKpiCalculator::KpiEntry::Reset ()
+{
+  m_txPdus = 0;
+  m_txBytes = 0;
+  m_rxPdus = 0;
+  m_rxBytes = 0;
+  m_errors = 0;
+  m_sinrDbSum = 0;
+  m_delay.Reset ();
+}
+
+MmWaveKpiCalculator::MmWaveKpiCalculator ()
+  : m_windowStarted (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MmWaveKpiCalculator::~MmWaveKpiCalculator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+MmWaveKpiCalculator::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::MmWaveKpiCalculator")
+    .SetParent<Object> ()
+    .AddConstructor<MmWaveKpiCalculator> ()
+    .AddAttribute ("Window",
+                   "Duration of the windows over which the KPIs are aggregated",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&MmWaveKpiCalculator::m_window),
+                   MakeTimeChecker (NanoSeconds (1)))
+    .AddAttribute ("OutputFilename",
+                   "Name of the file where the KPIs will be saved.",
+                   StringValue ("KpiStats.txt"),
+                   MakeStringAccessor (&MmWaveKpiCalculator::SetOutputFilename),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+void
+MmWaveKpiCalculator::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+}
+
+std::string
+MmWaveKpiCalculator::GetOutputFilename (void)
+{
+  return m_outputFilename;
+}
+
+void
+MmWaveKpiCalculator::SetOutputFilename (std::string outputFilename)
+{
+  m_outputFilename = outputFilename;
+}
+
+void
+MmWaveKpiCalculator::RxPacketTraceUeCallback (Ptr<MmWaveKpiCalculator> kpiStats, std::string path, RxPacketTraceParams params)
+{
+  kpiStats->NotifyRxTb (false, params.m_cellId, params.m_rnti, params.m_tbSize, params.m_sinr, params.m_corrupt);
+}
+
+void
+MmWaveKpiCalculator::RxPacketTraceEnbCallback (Ptr<MmWaveKpiCalculator> kpiStats, std::string path, RxPacketTraceParams params)
+{
+  kpiStats->NotifyRxTb (true, params.m_cellId, params.m_rnti, params.m_tbSize, params.m_sinr, params.m_corrupt);
+}
+
+void
+MmWaveKpiCalculator::BackhaulTargetEnbCallback (Ptr<MmWaveKpiCalculator> kpiStats, std::string path, uint16_t cellId, Ptr<NetDevice> enb)
+{
+  NS_LOG_LOGIC ("backhaul of cell " << cellId << " attached, path " << path);
+  // the hops of the cells downstream of the IAB node change as well
+  kpiStats->m_hops.clear ();
+}
+
+void
+MmWaveKpiCalculator::NotifyRxTb (bool uplink, uint16_t cellId, uint16_t rnti, uint32_t tbSize, double sinr, bool corrupt)
+{
+  NS_LOG_FUNCTION (this << uplink << cellId << rnti << tbSize << sinr << corrupt);
+  KpiEntry &entry = GetEntry (PHY, uplink, cellId, rnti, 0);
+  if (corrupt)
+    {
+      entry.m_errors++;
+    }
+  else
+    {
+      entry.m_rxPdus++;
+      entry.m_rxBytes += tbSize;
+    }
+  entry.m_sinrDbSum += 10 * std::log10 (sinr);
+}
+
+void
+MmWaveKpiCalculator::NotifyTxPdu (Layer layer, bool uplink, uint16_t cellId, uint16_t rnti, uint8_t lcid, uint32_t packetSize)
+{
+  NS_LOG_FUNCTION (this << layer << uplink << cellId << rnti << (uint32_t) lcid << packetSize);
+  KpiEntry &entry = GetEntry (layer, uplink, cellId, rnti, lcid);
+  entry.m_txPdus++;
+  entry.m_txBytes += packetSize;
+}
+
+void
+MmWaveKpiCalculator::NotifyRxPdu (Layer layer, bool uplink, uint16_t cellId, uint16_t rnti, uint8_t lcid, uint32_t packetSize,
+                                  uint64_t delay)
+{
+  NS_LOG_FUNCTION (this << layer << uplink << cellId << rnti << (uint32_t) lcid << packetSize << delay);
+  KpiEntry &entry = GetEntry (layer, uplink, cellId, rnti, lcid);
+  entry.m_rxPdus++;
+  entry.m_rxBytes += packetSize;
+  entry.m_delay.Add (delay);
+}
+
+MmWaveKpiCalculator::KpiEntry&
+MmWaveKpiCalculator::GetEntry (Layer layer, bool uplink, uint16_t cellId, uint16_t rnti, uint8_t lcid)
+{
+  Time now = Simulator::Now ();
+  if (!m_windowStarted)
+    {
+      m_windowStarted = true;
+      m_windowStart = TimeStep (now.GetTimeStep () / m_window.GetTimeStep () * m_window.GetTimeStep ());
+      // the calculator is not disposed at the end of the simulation
+      Simulator::ScheduleDestroy (&MmWaveKpiCalculator::Flush, Ptr<MmWaveKpiCalculator> (this));
+    }
+  else if (now >= m_windowStart + m_window)
+    {
+      WriteWindow ();
+      m_windowStart = TimeStep (now.GetTimeStep () / m_window.GetTimeStep () * m_window.GetTimeStep ());
+    }
+
+  KpiKey key;
+  key.m_layer = layer;
+  key.m_uplink = uplink;
+  key.m_cellId = cellId;
+  key.m_hop = GetHop (cellId);
+  key.m_rnti = rnti;
+  key.m_lcid = lcid;
+  std::map<KpiKey, KpiEntry>::iterator it = m_entries.find (key);
+  if (it == m_entries.end ())
+    {
+      KpiEntry entry;
+      entry.Reset ();
+      it = m_entries.insert (std::make_pair (key, entry)).first;
+    }
+  return it->second;
+}
+
+uint16_t
+MmWaveKpiCalculator::GetHop (uint16_t cellId)
+{
+  std::map<uint16_t, uint16_t>::iterator it = m_hops.find (cellId);
+  if (it != m_hops.end ())
+    {
+      return it->second;
+    }
+
+  // follow the backhaul of the IAB nodes up to a wired gNB
+  uint16_t hop = 0;
+  uint16_t currentCellId = cellId;
+  for (bool found = true; found && hop <= NodeList::GetNNodes (); )
+    {
+      found = false;
+      for (NodeList::Iterator node = NodeList::Begin (); node != NodeList::End () && !found; ++node)
+        {
+          for (uint32_t i = 0; i < (*node)->GetNDevices () && !found; i++)
+            {
+              Ptr<MmWaveIabNetDevice> iab = (*node)->GetDevice (i)->GetObject<MmWaveIabNetDevice> ();
+              if (iab == 0 || iab->GetCellId () != currentCellId)
+                {
+                  continue;
+                }
+              found = true;
+              hop++;
+              Ptr<NetDevice> target = iab->GetBackhaulTargetEnb ();
+              Ptr<MmWaveIabNetDevice> targetIab = target != 0 ? target->GetObject<MmWaveIabNetDevice> () : 0;
+              if (targetIab == 0)
+                {
+                  // a wired gNB, or an IAB node that is not attached yet
+                  return m_hops[cellId] = hop;
+                }
+              currentCellId = targetIab->GetCellId ();
+            }
+        }
+    }
+  return m_hops[cellId] = hop;
+}
+
+void
+MmWaveKpiCalculator::WriteWindow (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_outFile.is_open ())
+    {
+      m_outFile.open (GetOutputFilename ().c_str ());
+      if (!m_outFile.is_open ())
+        {
+          NS_LOG_ERROR ("Can't open file " << GetOutputFilename ().c_str ());
+          return;
+        }
+      m_outFile << "% start\tend\tlayer\tdir\tCellId\thop\tRNTI\tLCID\tnTxPDUs\tTxBytes\tnRxPDUs\tRxBytes\tRxMbps\t";
+      m_outFile << "nErrors\tBLER\tSINR\t";
+      m_outFile << "delay\tp50\tp95\tp99\tmax";
+      m_outFile << std::endl;
+    }
+
+  // the last window ends when the simulation does
+  Time windowEnd = std::min (m_windowStart + m_window, Simulator::Now ());
+  if (windowEnd <= m_windowStart)
+    {
+      windowEnd = m_windowStart + m_window;
+    }
+  double duration = (windowEnd - m_windowStart).GetSeconds ();
+  static const char *layerNames[] = {"PHY", "RLC", "PDCP"};
+
+  for (std::map<KpiKey, KpiEntry>::iterator it = m_entries.begin (); it != m_entries.end (); ++it)
+    {
+      const KpiKey &key = it->first;
+      KpiEntry &entry = it->second;
+      if (entry.m_txPdus == 0 && entry.m_rxPdus == 0 && entry.m_errors == 0)
+        {
+          continue;
+        }
+      m_outFile << m_windowStart.GetSeconds () << "\t" << windowEnd.GetSeconds () << "\t";
+      m_outFile << layerNames[key.m_layer] << "\t" << (key.m_uplink ? "UL" : "DL") << "\t";
+      m_outFile << key.m_cellId << "\t" << key.m_hop << "\t" << key.m_rnti << "\t" << (uint32_t) key.m_lcid << "\t";
+      if (key.m_layer == PHY)
+        {
+          m_outFile << "-\t-\t";
+        }
+      else
+        {
+          m_outFile << entry.m_txPdus << "\t" << entry.m_txBytes << "\t";
+        }
+      m_outFile << entry.m_rxPdus << "\t" << entry.m_rxBytes << "\t" << entry.m_rxBytes * 8 / duration / 1e6 << "\t";
+      if (key.m_layer == PHY)
+        {
+          uint64_t tbs = entry.m_rxPdus + entry.m_errors;
+          m_outFile << entry.m_errors << "\t" << (double) entry.m_errors / tbs << "\t" << entry.m_sinrDbSum / tbs << "\t";
+          m_outFile << "-\t-\t-\t-\t-";
+        }
+      else
+        {
+          m_outFile << "-\t-\t-\t";
+          const MmWaveKpiHistogram &delay = entry.m_delay;
+          if (delay.GetCount () == 0)
+            {
+              m_outFile << "-\t-\t-\t-\t-";
+            }
+          else
+            {
+              m_outFile << delay.GetMean () / 1e9 << "\t" << delay.GetQuantile (0.5) / 1e9 << "\t";
+              m_outFile << delay.GetQuantile (0.95) / 1e9 << "\t" << delay.GetQuantile (0.99) / 1e9 << "\t";
+              m_outFile << delay.GetMax () / 1e9;
+            }
+        }
+      m_outFile << "\n";
+      entry.Reset ();
+    }
+  m_outFile.flush ();
+}
+
+void
+MmWaveKpiCalculator::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_windowStarted)
+    {
+      WriteWindow ();
+      m_windowStarted = false;
+    }
+  if (m_outFile.is_open ())
+    {
+      m_outFile.close ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,257 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MMWAVE_KPI_CALCULATOR_H_
+#define MMWAVE_KPI_CALCULATOR_H_
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/net-device.h"
+#include <ns3/mmwave-phy-mac-common.h>
+#include <string>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+namespace ns3
+{
+
+/**
+ * \ingroup mmwave
+ *
+ * Streaming histogram of non-negative integer values, with the log-linear
+ * buckets of an HDR histogram: the values below 2^PRECISION_BITS have a
+ * bucket each, and every larger power of two is split into
+ * 2^PRECISION_BITS buckets of equal width. The quantiles are therefore
+ * exact for the small values and have a relative error below
+ * 2^-PRECISION_BITS for the others, whatever the number of samples, and
+ * the histogram only grows with the order of magnitude of the largest value.
+ */
+class MmWaveKpiHistogram
+{
+public:
+  static const uint32_t PRECISION_BITS = 6;
+
+  MmWaveKpiHistogram ();
+
+  /**
+   * Adds a sample
+   * @param value the sample
+   */
+  void Add (uint64_t value);
+
+  /**
+   * Gets a quantile of the samples
+   * @param q the quantile, in [0, 1]
+   * @return the middle of the bucket of the quantile, clamped to the
+   * range of the samples, or 0 if there is no sample
+   */
+  uint64_t GetQuantile (double q) const;
+
+  uint64_t GetCount () const;
+  uint64_t GetMin () const;
+  uint64_t GetMax () const;
+  double GetMean () const;
+
+  /**
+   * Removes all the samples
+   */
+  void Reset ();
+
+private:
+  static uint32_t GetBucket (uint64_t value);
+  static uint64_t GetBucketLow (uint32_t bucket);
+  static uint64_t GetBucketHigh (uint32_t bucket);
+
+  std::vector<uint32_t> m_buckets;
+  uint64_t m_count;
+  uint64_t m_min;
+  uint64_t m_max;
+  double m_sum;
+};
+
+/**
+ * \ingroup mmwave
+ *
+ * This class is an ns-3 trace sink that aggregates the PHY, RLC and PDCP
+ * traces online into key performance indicators, so that a simulation
+ * writes a few lines per bearer and time window instead of a line per
+ * transport block or PDU.
+ *
+ * The KPIs are kept per layer, direction, cell, hop, RNTI and LCID, where
+ * the hop of a cell is the number of wireless backhaul links between the
+ * cell and a wired gNB (0 for the cells of the wired gNBs, 1 for the cells
+ * of the IAB nodes attached to them, ...). The transport blocks have LCID 0.
+ *
+ * At the end of every window in which an entry was updated, a line is
+ * written to the output file with:
+ *
+ *   - number and bytes of the transmitted PDUs (RLC and PDCP)
+ *   - number and bytes of the received TBs or PDUs, and the received
+ *     throughput over the window; the corrupted TBs are not counted
+ *   - number of corrupted TBs and BLER (PHY)
+ *   - mean SINR of the TBs, in dB (PHY)
+ *   - mean, 50th, 95th and 99th percentile and max of the delay, in s
+ *     (RLC and PDCP)
+ *
+ * The fields that do not apply to a layer are written as "-".
+ */
+class MmWaveKpiCalculator : public Object
+{
+public:
+  enum Layer
+  {
+    PHY,
+    RLC,
+    PDCP
+  };
+
+  /**
+   * Class constructor
+   */
+  MmWaveKpiCalculator ();
+
+  /**
+   * Class destructor
+   */
+  virtual
+  ~MmWaveKpiCalculator ();
+
+  // Inherited from ns3::Object
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  void DoDispose ();
+
+  /**
+   * Notifies a transport block received by a PHY
+   * @param uplink true if the TB was received by a gNB or IAB access PHY
+   * @param cellId the cell of the link
+   * @param rnti the RNTI of the UE or IAB node in the cell
+   * @param tbSize the size of the TB in bytes
+   * @param sinr the average SINR of the TB, linear
+   * @param corrupt true if the TB was corrupted
+   */
+  void
+  NotifyRxTb (bool uplink, uint16_t cellId, uint16_t rnti, uint32_t tbSize, double sinr, bool corrupt);
+
+  /**
+   * Notifies the transmission of a PDU by a RLC or PDCP entity
+   * @param layer RLC or PDCP
+   * @param uplink the direction of the bearer
+   * @param cellId the cell of the bearer
+   * @param rnti the RNTI of the UE or IAB node in the cell
+   * @param lcid the LCID of the bearer
+   * @param packetSize the size of the PDU in bytes
+   */
+  void
+  NotifyTxPdu (Layer layer, bool uplink, uint16_t cellId, uint16_t rnti, uint8_t lcid, uint32_t packetSize);
+
+  /**
+   * Notifies the reception of a PDU by a RLC or PDCP entity
+   * @param delay the delay of the PDU in ns
+   */
+  void
+  NotifyRxPdu (Layer layer, bool uplink, uint16_t cellId, uint16_t rnti, uint8_t lcid, uint32_t packetSize,
+               uint64_t delay);
+
+  /**
+   * Trace sinks of the RxPacketTraceUe and RxPacketTraceEnb trace sources
+   */
+  static void RxPacketTraceUeCallback (Ptr<MmWaveKpiCalculator> kpiStats, std::string path, RxPacketTraceParams params);
+  static void RxPacketTraceEnbCallback (Ptr<MmWaveKpiCalculator> kpiStats, std::string path, RxPacketTraceParams params);
+
+  /**
+   * Trace sink of the BackhaulTargetEnb trace source of the IAB nodes,
+   * which invalidates the hops of the cells
+   */
+  static void BackhaulTargetEnbCallback (Ptr<MmWaveKpiCalculator> kpiStats, std::string path, uint16_t cellId, Ptr<NetDevice> enb);
+
+  /**
+   * Writes the KPIs of the current window and closes the output file
+   */
+  void
+  Flush (void);
+
+  std::string GetOutputFilename (void);
+  void SetOutputFilename (std::string outputFilename);
+
+private:
+  struct KpiKey
+  {
+    uint8_t m_layer;
+    bool m_uplink;
+    uint16_t m_cellId;
+    uint16_t m_hop;
+    uint16_t m_rnti;
+    uint8_t m_lcid;
+
+    bool operator< (const KpiKey &other) const;
+  };
+
+  struct KpiEntry
+  {
+    uint64_t m_txPdus;
+    uint64_t m_txBytes;
+    uint64_t m_rxPdus;
+    uint64_t m_rxBytes;
+    uint64_t m_errors;
+    double m_sinrDbSum;
+    MmWaveKpiHistogram m_delay;
+
+    void Reset ();
+  };
+
+  /**
+   * Gets the entry of a key in the current window, writing the previous
+   * windows first if the current window is over
+   */
+  KpiEntry&
+  GetEntry (Layer layer, bool uplink, uint16_t cellId, uint16_t rnti, uint8_t lcid);
+
+  /**
+   * Gets the number of wireless backhaul links between a cell and a wired gNB
+   */
+  uint16_t
+  GetHop (uint16_t cellId);
+
+  /**
+   * Writes the entries updated in the current window and resets them
+   */
+  void
+  WriteWindow (void);
+
+  Time m_window;
+  Time m_windowStart;
+  bool m_windowStarted;
+  std::string m_outputFilename;
+  std::ofstream m_outFile;
+
+  // the entries are kept across the windows, so that their histograms are reused
+  std::map<KpiKey, KpiEntry> m_entries;
+  std::map<uint16_t, uint16_t> m_hops;    // hop of the cells, cleared when a backhaul is attached
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_KPI_CALCULATOR_H_ */
@@ -34,7 +34,11 @@
 #include <ns3/log.h>
 #include "mmwave-phy-rx-trace.h"
 #include <ns3/simulator.h>
+#include <ns3/enum.h>
+#include <ns3/uinteger.h>
 #include <stdio.h>
+#include <cstring>
+#include <vector>
 
 namespace ns3 {
 
@@ -44,8 +48,17 @@ NS_OBJECT_ENSURE_REGISTERED (MmWavePhyRxTrace);
 
 std::ofstream MmWavePhyRxTrace::m_rxPacketTraceFile;
 std::string MmWavePhyRxTrace::m_rxPacketTraceFilename;
+MmWaveBinaryTraceWriter MmWavePhyRxTrace::m_rxPacketTraceWriter;
+const char MmWavePhyRxTrace::RX_PACKET_TRACE_MAGIC[8] = {'M', 'M', 'W', 'R', 'X', 'P', 'T', '1'};
+
+static_assert (sizeof (MmWavePhyRxTrace::RxPacketTraceRecord) == 64,
+		"the binary RxPacketTrace records must have the same layout on every platform");
+
+static const char *g_rxPacketTraceHeader = "\tframe\tsubF\t1stSym\tsymbol#\tcellId\trnti\ttbSize\tmcs\trv\tSINR(dB)\tcorrupt\tTBler";
 
 MmWavePhyRxTrace::MmWavePhyRxTrace()
+	: m_format (TEXT),
+	  m_bufferSize (64 << 20)
 {
 }
 
@@ -63,6 +76,18 @@ MmWavePhyRxTrace::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::MmWavePhyRxTrace")
     .SetParent<Object> ()
     .AddConstructor<MmWavePhyRxTrace> ()
+    .AddAttribute ("TraceFormat",
+                   "Format of the RxPacketTrace: Text writes RxPacketTrace.txt, Binary writes "
+                   "fixed-size records to RxPacketTrace.bin from a background thread",
+                   EnumValue (MmWavePhyRxTrace::TEXT),
+                   MakeEnumAccessor (&MmWavePhyRxTrace::m_format),
+                   MakeEnumChecker (MmWavePhyRxTrace::TEXT, "Text",
+                                    MmWavePhyRxTrace::BINARY, "Binary"))
+    .AddAttribute ("BufferSize",
+                   "Size in bytes of the ring buffer of the binary RxPacketTrace",
+                   UintegerValue (64 << 20),
+                   MakeUintegerAccessor (&MmWavePhyRxTrace::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -180,19 +205,7 @@ MmWavePhyRxTrace::ReportDLTbSize (uint64_t imsi, uint64_t tbSize)
 void
 MmWavePhyRxTrace::RxPacketTraceUeCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path, RxPacketTraceParams params)
 {
-	if (!m_rxPacketTraceFile.is_open())
-	{
-		m_rxPacketTraceFilename = "RxPacketTrace.txt";
-		m_rxPacketTraceFile.open(m_rxPacketTraceFilename.c_str ());
-		if (!m_rxPacketTraceFile.is_open())
-		{
-			NS_FATAL_ERROR ("Could not open tracefile");
-		}
-	}
-	m_rxPacketTraceFile << "DL\t" << params.m_frameNum << "\t" << (unsigned)params.m_sfNum << "\t" << (unsigned)params.m_symStart
-			<< "\t" << (unsigned)params.m_numSym << "\t" << params.m_cellId
-			<< "\t" << params.m_rnti << "\t" << params.m_tbSize << "\t" << (unsigned)params.m_mcs << "\t" << (unsigned)params.m_rv << "\t"
-			<< 10*std::log10(params.m_sinr) << "\t" << " \t" << params.m_corrupt << "\t" <<  params.m_tbler << std::endl;
+	WriteRxPacketTrace (phyStats, false, params);
 
 	if (params.m_corrupt)
 	{
@@ -205,28 +218,136 @@ MmWavePhyRxTrace::RxPacketTraceUeCallback (Ptr<MmWavePhyRxTrace> phyStats, std::
 void
 MmWavePhyRxTrace::RxPacketTraceEnbCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path, RxPacketTraceParams params)
 {
+	WriteRxPacketTrace (phyStats, true, params);
+
+		if (params.m_corrupt)
+		{
+			NS_LOG_DEBUG ("UL TB error\t" << params.m_frameNum << "\t" << (unsigned)params.m_sfNum << "\t" << (unsigned)params.m_symStart
+			    << "\t" << (unsigned)params.m_numSym
+					<< "\t" << params.m_rnti << "\t" << params.m_tbSize << "\t" << (unsigned)params.m_mcs << "\t" << (unsigned)params.m_rv << "\t"
+					<< 10*std::log10(params.m_sinr) << "\t" << params.m_tbler << "\t" << params.m_corrupt << "\t" << params.m_sinrMin);
+		}
+}
+
+void
+MmWavePhyRxTrace::WriteRxPacketTrace (Ptr<MmWavePhyRxTrace> phyStats, bool uplink, const RxPacketTraceParams &params)
+{
+	if (phyStats->m_format == BINARY)
+	{
+		if (!m_rxPacketTraceWriter.IsOpen ())
+		{
+			m_rxPacketTraceFilename = "RxPacketTrace.bin";
+			if (!m_rxPacketTraceWriter.Open (m_rxPacketTraceFilename, RX_PACKET_TRACE_MAGIC,
+					sizeof (RxPacketTraceRecord), phyStats->m_bufferSize))
+			{
+				NS_FATAL_ERROR ("Could not open tracefile");
+			}
+			Simulator::ScheduleDestroy (&MmWavePhyRxTrace::CloseBinaryTrace);
+		}
+		RxPacketTraceRecord record;
+		std::memset (&record, 0, sizeof (record));
+		record.m_timeNs = Simulator::Now ().GetNanoSeconds ();
+		record.m_cellId = params.m_cellId;
+		record.m_frameNum = params.m_frameNum;
+		record.m_tbSize = params.m_tbSize;
+		record.m_sinr = params.m_sinr;
+		record.m_sinrMin = params.m_sinrMin;
+		record.m_tbler = params.m_tbler;
+		record.m_rnti = params.m_rnti;
+		record.m_uplink = uplink;
+		record.m_sfNum = params.m_sfNum;
+		record.m_slotNum = params.m_slotNum;
+		record.m_symStart = params.m_symStart;
+		record.m_numSym = params.m_numSym;
+		record.m_mcs = params.m_mcs;
+		record.m_rv = params.m_rv;
+		record.m_corrupt = params.m_corrupt;
+		m_rxPacketTraceWriter.Append (&record);
+		return;
+	}
+
 	if (!m_rxPacketTraceFile.is_open())
 	{
 		m_rxPacketTraceFilename = "RxPacketTrace.txt";
 		m_rxPacketTraceFile.open(m_rxPacketTraceFilename.c_str ());
-		m_rxPacketTraceFile << "\tframe\tsubF\t1stSym\tsymbol#\tcellId\trnti\ttbSize\tmcs\trv\tSINR(dB)\tcorrupt\tTBler" << std::endl;
 		if (!m_rxPacketTraceFile.is_open())
 		{
 			NS_FATAL_ERROR ("Could not open tracefile");
 		}
+		// the header is written only if the first TB is an UL one
+		if (uplink)
+		{
+			m_rxPacketTraceFile << g_rxPacketTraceHeader << std::endl;
+		}
 	}
-	m_rxPacketTraceFile << "UL\t" << params.m_frameNum << "\t" << (unsigned)params.m_sfNum << "\t" << (unsigned)params.m_symStart
-				<< "\t" << (unsigned)params.m_numSym << "\t" << params.m_cellId
-				<< "\t" << params.m_rnti << "\t" << params.m_tbSize << "\t" << (unsigned)params.m_mcs << "\t" << (unsigned)params.m_rv << "\t"
-				<< 10*std::log10(params.m_sinr) << " \t" << params.m_corrupt << "\t" << params.m_tbler << std::endl;
+	WriteRxPacketTraceLine (m_rxPacketTraceFile, uplink, params);
+	m_rxPacketTraceFile.flush ();
+}
 
-		if (params.m_corrupt)
+void
+MmWavePhyRxTrace::WriteRxPacketTraceLine (std::ostream &os, bool uplink, const RxPacketTraceParams &params)
+{
+	os << (uplink ? "UL\t" : "DL\t") << params.m_frameNum << "\t" << (unsigned)params.m_sfNum << "\t" << (unsigned)params.m_symStart
+			<< "\t" << (unsigned)params.m_numSym << "\t" << params.m_cellId
+			<< "\t" << params.m_rnti << "\t" << params.m_tbSize << "\t" << (unsigned)params.m_mcs << "\t" << (unsigned)params.m_rv << "\t"
+			<< 10*std::log10(params.m_sinr) << (uplink ? " \t" : "\t \t") << params.m_corrupt << "\t" << params.m_tbler << "\n";
+}
+
+void
+MmWavePhyRxTrace::CloseBinaryTrace ()
+{
+	m_rxPacketTraceWriter.Close ();
+}
+
+bool
+MmWavePhyRxTrace::ExportBinaryTrace (const std::string &binaryFile, const std::string &textFile)
+{
+	FILE *in = MmWaveBinaryTraceWriter::OpenForReading (binaryFile, RX_PACKET_TRACE_MAGIC, sizeof (RxPacketTraceRecord));
+	if (in == 0)
+	{
+		return false;
+	}
+	std::ofstream out (textFile.c_str ());
+	if (!out.is_open ())
+	{
+		fclose (in);
+		return false;
+	}
+
+	std::vector<RxPacketTraceRecord> records (4096);
+	bool first = true;
+	std::size_t count;
+	while ((count = fread (&records[0], sizeof (RxPacketTraceRecord), records.size (), in)) > 0)
+	{
+		for (std::size_t i = 0; i < count; i++)
 		{
-			NS_LOG_DEBUG ("UL TB error\t" << params.m_frameNum << "\t" << (unsigned)params.m_sfNum << "\t" << (unsigned)params.m_symStart
-			    << "\t" << (unsigned)params.m_numSym
-					<< "\t" << params.m_rnti << "\t" << params.m_tbSize << "\t" << (unsigned)params.m_mcs << "\t" << (unsigned)params.m_rv << "\t"
-					<< 10*std::log10(params.m_sinr) << "\t" << params.m_tbler << "\t" << params.m_corrupt << "\t" << params.m_sinrMin);
+			const RxPacketTraceRecord &record = records[i];
+			RxPacketTraceParams params;
+			params.m_cellId = record.m_cellId;
+			params.m_rnti = record.m_rnti;
+			params.m_frameNum = record.m_frameNum;
+			params.m_sfNum = record.m_sfNum;
+			params.m_slotNum = record.m_slotNum;
+			params.m_symStart = record.m_symStart;
+			params.m_numSym = record.m_numSym;
+			params.m_tbSize = record.m_tbSize;
+			params.m_mcs = record.m_mcs;
+			params.m_rv = record.m_rv;
+			params.m_sinr = record.m_sinr;
+			params.m_sinrMin = record.m_sinrMin;
+			params.m_tbler = record.m_tbler;
+			params.m_corrupt = record.m_corrupt;
+			if (first && record.m_uplink)
+			{
+				out << g_rxPacketTraceHeader << "\n";
+			}
+			first = false;
+			WriteRxPacketTraceLine (out, record.m_uplink, params);
 		}
+	}
+	bool ok = !ferror (in) && out.good ();
+	fclose (in);
+	return ok;
 }
 
 } /* namespace ns3 */
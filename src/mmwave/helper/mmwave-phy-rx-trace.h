@@ -31,6 +31,7 @@
 #include <ns3/object.h>
 #include <ns3/spectrum-value.h>
 #include <ns3/mmwave-phy-mac-common.h>
+#include "mmwave-binary-trace-writer.h"
 #include <fstream>
 #include <iostream>
 
@@ -39,6 +40,36 @@ namespace ns3 {
 class MmWavePhyRxTrace : public Object
 {
 public:
+	enum TraceFormat
+	{
+		TEXT,		// RxPacketTrace.txt, one line per TB
+		BINARY		// RxPacketTrace.bin, one RxPacketTraceRecord per TB
+	};
+
+	/**
+	 * Fixed-size record of a received TB in the binary RxPacketTrace
+	 */
+	struct RxPacketTraceRecord
+	{
+		int64_t m_timeNs;
+		uint64_t m_cellId;
+		uint32_t m_frameNum;
+		uint32_t m_tbSize;
+		double m_sinr;
+		double m_sinrMin;
+		double m_tbler;
+		uint16_t m_rnti;
+		uint8_t m_uplink;
+		uint8_t m_sfNum;
+		uint8_t m_slotNum;
+		uint8_t m_symStart;
+		uint8_t m_numSym;
+		uint8_t m_mcs;
+		uint8_t m_rv;
+		uint8_t m_corrupt;
+		uint8_t m_padding[6];
+	};
+
 	MmWavePhyRxTrace();
 	virtual ~MmWavePhyRxTrace();
 	static TypeId GetTypeId (void);
@@ -53,7 +84,27 @@ public:
 	static void RxPacketTraceUeCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path, RxPacketTraceParams param);
 	static void RxPacketTraceEnbCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path, RxPacketTraceParams param);
 
+	/**
+	 * Write the line of a received TB as in RxPacketTrace.txt
+	 */
+	static void WriteRxPacketTraceLine (std::ostream &os, bool uplink, const RxPacketTraceParams &params);
+
+	/**
+	 * Convert a binary RxPacketTrace to the text format
+	 * @params the name of the binary file
+	 * @params the name of the text file to be written
+	 * @returns false if the binary file could not be read or the text file written
+	 */
+	static bool ExportBinaryTrace (const std::string &binaryFile, const std::string &textFile);
+
+	/**
+	 * Write the buffered records of the binary RxPacketTrace and close it
+	 */
+	static void CloseBinaryTrace ();
+
 private:
+	static void WriteRxPacketTrace (Ptr<MmWavePhyRxTrace> phyStats, bool uplink, const RxPacketTraceParams &params);
+
 	//void ReportInterferenceTrace (uint64_t imsi, SpectrumValue& sinr);
 	//void ReportPacketCountUe (UePhyPacketCountParameter param);
 	//void ReportPacketCountEnb (EnbPhyPacketCountParameter param);
@@ -61,6 +112,11 @@ private:
 
 	static std::ofstream m_rxPacketTraceFile;
 	static std::string m_rxPacketTraceFilename;
+	static MmWaveBinaryTraceWriter m_rxPacketTraceWriter;
+	static const char RX_PACKET_TRACE_MAGIC[8];
+
+	TraceFormat m_format;
+	uint32_t m_bufferSize;		// bytes of the ring buffer of the binary trace
 };
 
 } /* namespace ns3 */
@@ -785,47 +785,7 @@ BuildingsObstaclePropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<Mobili
 	if (a1->IsOutdoor () && b1->IsOutdoor ())
 	{
 		/*Determine LOS or NLOS*/
-		bool los = true;
-		for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
-		{
-			Box boundaries = (*bit)->GetBoundaries ();
-			Vector locationA = a->GetPosition ();
-			Vector locationB = b->GetPosition ();
-			Angles pathAngles (locationB, locationA);
-			double angle = pathAngles.phi;
-			if (angle >= M_PI/2 || angle < -M_PI/2)
-			{
-				locationA = b->GetPosition ();
-				locationB = a->GetPosition ();
-				Angles pathAngles (locationB, locationA);
-				angle = pathAngles.phi;
-			}
-
-			if (angle >=0 && angle < M_PI/2 )
-			{
-				Vector loc1(boundaries.xMax,boundaries.yMin,boundaries.zMin);
-				Vector loc2(boundaries.xMin,boundaries.yMax,boundaries.zMin);
-				Angles angles1 (loc1,locationA);
-				Angles angles2 (loc2,locationA);
-				if (angle > angles1.phi && angle < angles2.phi && locationB.x > boundaries.xMin && locationB.y > boundaries.yMin)
-				{
-					los = false;
-					break;
-				}
-			}
-			else if (angle >= -M_PI/2 && angle < 0)
-			{
-				Vector loc1(boundaries.xMin,boundaries.yMin,boundaries.zMin);
-				Vector loc2(boundaries.xMax,boundaries.yMax,boundaries.zMin);
-				Angles angles1 (loc1,locationA);
-				Angles angles2 (loc2,locationA);
-				if (angle > angles1.phi && angle < angles2.phi && locationB.x > boundaries.xMin && locationB.y < boundaries.yMax)
-				{
-					los = false;
-					break;
-				}
-			}
-		}
+		bool los = m_losTracker->IsLos (a, b);
 
 		int nlosSamples = m_losTracker->GetNlosSamples(a,b); // sample to be used in the Aditya's traces
 		int losSamples = m_losTracker->GetLosSamples(a,b); // sample to be used in the Aditya's traces
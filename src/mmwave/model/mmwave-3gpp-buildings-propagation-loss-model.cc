@@ -30,6 +30,7 @@
 #include "ns3/double.h"
 #include <ns3/mobility-building-info.h>
 #include <ns3/building-list.h>
+#include "mmwave-buildings-index.h"
 #include <ns3/angles.h>
 #include "ns3/config-store.h"
 #include "ns3/string.h"
@@ -39,6 +40,7 @@
 #include <ns3/mmwave-iab-net-device.h>
 #include <ns3/node.h>
 #include "ns3/boolean.h"
+#include "ns3/double.h"
 
 NS_LOG_COMPONENT_DEFINE ("MmWave3gppBuildingsPropagationLossModel");
 
@@ -78,6 +80,25 @@ MmWave3gppBuildingsPropagationLossModel::~MmWave3gppBuildingsPropagationLossMode
 	}
 }
 
+void
+MmWave3gppBuildingsPropagationLossModel::DoDispose ()
+{
+	m_linkCache.Clear ();
+	BuildingsPropagationLossModel::DoDispose ();
+}
+
+void
+MmWave3gppBuildingsPropagationLossModel::SetUpdateDistance (double distance)
+{
+	m_linkCache.SetUpdateDistance (distance);
+}
+
+double
+MmWave3gppBuildingsPropagationLossModel::GetUpdateDistance () const
+{
+	return m_linkCache.GetUpdateDistance ();
+}
+
 TypeId
 MmWave3gppBuildingsPropagationLossModel::GetTypeId (void)
 {
@@ -89,6 +110,13 @@ MmWave3gppBuildingsPropagationLossModel::GetTypeId (void)
 					BooleanValue (true),
 					MakeBooleanAccessor (&MmWave3gppBuildingsPropagationLossModel::m_updateCondition),
 					MakeBooleanChecker ())
+		.AddAttribute ("UpdateDistance",
+					"Distance [m] a node can move before the los/nlos condition of its links is updated, "
+					"0 to update it at any movement",
+					DoubleValue (0),
+					MakeDoubleAccessor (&MmWave3gppBuildingsPropagationLossModel::SetUpdateDistance,
+										&MmWave3gppBuildingsPropagationLossModel::GetUpdateDistance),
+					MakeDoubleChecker<double> (0))
 	;
 	return tid;
 }
@@ -126,8 +154,13 @@ MmWave3gppBuildingsPropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<Mobi
 			/* The outdoor case, determine LOS/NLOS
 			 * The channel condition should be NLOS if the line intersect one of the buildings, otherwise LOS.
 			 * */
-			bool intersect = IsLineIntersectBuildings(a->GetPosition(), b->GetPosition());
-			if(!intersect)
+			bool los;
+			if (!m_linkCache.Lookup (a, b, los))
+			{
+				los = !IsLineIntersectBuildings(a->GetPosition(), b->GetPosition());
+				m_linkCache.Store (a, b, los);
+			}
+			if(los)
 			{
 				condition.m_channelCondition = 'l';
 				condition.m_shadowing = 0;
@@ -330,42 +363,7 @@ MmWave3gppBuildingsPropagationLossModel::mmWaveNlosLoss (Ptr<MobilityModel> a, P
 bool
 MmWave3gppBuildingsPropagationLossModel::IsLineIntersectBuildings(Vector L1, Vector L2 ) const
 {
-	for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
-	{
-		Box boundaries = (*bit)->GetBoundaries ();
-
-		Vector boxSize (0.5*(boundaries.xMax - boundaries.xMin),
-				0.5*(boundaries.yMax - boundaries.yMin),
-				0.5*(boundaries.zMax - boundaries.zMin));
-		Vector boxCenter (boundaries.xMin + boxSize.x,
-				boundaries.yMin + boxSize.y,
-				boundaries.zMin + boxSize.z);
-
-		// Put line in box space
-		Vector LB1 (L1.x-boxCenter.x, L1.y-boxCenter.y, L1.z-boxCenter.z);
-		Vector LB2 (L2.x-boxCenter.x, L2.y-boxCenter.y, L2.z-boxCenter.z);
-
-		// Get line midpoint and extent
-		Vector LMid (0.5*(LB1.x+LB2.x), 0.5*(LB1.y+LB2.y), 0.5*(LB1.z+LB2.z));
-		Vector L (LB1.x - LMid.x, LB1.y - LMid.y, LB1.z - LMid.z);
-		Vector LExt ( std::abs(L.x), std::abs(L.y), std::abs(L.z) );
-
-		// Use Separating Axis Test
-		// Separation vector from box center to line center is LMid, since the line is in box space
-		// If the line did not intersect this building, jump to the next building.
-		if ( std::abs( LMid.x ) > boxSize.x + LExt.x ) continue;
-		if ( std::abs( LMid.y ) > boxSize.y + LExt.y ) continue;
-		if ( std::abs( LMid.z ) > boxSize.z + LExt.z ) continue;
-		// Crossproducts of line and each axis
-		if ( std::abs( LMid.y * L.z - LMid.z * L.y)  >  (boxSize.y * LExt.z + boxSize.z * LExt.y) ) continue;
-		if ( std::abs( LMid.x * L.z - LMid.z * L.x)  >  (boxSize.x * LExt.z + boxSize.z * LExt.x) ) continue;
-		if ( std::abs( LMid.x * L.y - LMid.y * L.x)  >  (boxSize.x * LExt.y + boxSize.y * LExt.x) ) continue;
-
-		// No separating axis, the line intersects
-		// If the line intersect this building, return true.
-		return true;
-	}
-	return false;
+	return MmWaveBuildingsIndex::Get ()->IsLineIntersectBuildings (L1, L2);
 }
 
 void
@@ -29,6 +29,7 @@
 #include <ns3/buildings-propagation-loss-model.h>
 #include <ns3/simulator.h>
 #include "mmwave-phy-mac-common.h"
+#include "mmwave-link-condition-cache.h"
 #include <fstream>
 
 namespace ns3 {
@@ -47,6 +48,11 @@ public:
 	void SetConfigurationParameters (Ptr<MmWavePhyMacCommon> ptrConfig);
 	std::string GetScenario();
 	char GetChannelCondition(Ptr<MobilityModel> a, Ptr<MobilityModel> b);
+	void SetUpdateDistance (double distance);
+	double GetUpdateDistance () const;
+
+protected:
+	virtual void DoDispose ();
 
 private:
 	//The IsLineIntersectBuildings method is based on
@@ -64,6 +70,7 @@ private:
 	Ptr<MmWave3gppPropagationLossModel> m_3gppNlos;
 	mutable channelConditionMap_t m_conditionMap;
 	bool m_updateCondition;
+	mutable MmWaveLinkConditionCache m_linkCache;	// los/nlos of the outdoor links, kept while the nodes do not move
 	mutable Time m_prevTime;
 	Ptr<MmWavePhyMacCommon> m_phyMacConfig;
 };
@@ -41,6 +41,9 @@
 #include <random>       // std::default_random_engine
 #include <ns3/boolean.h>
 #include <ns3/integer.h>
+#include <ns3/enum.h>
+#include <ns3/uinteger.h>
+#include <thread>
 #include "mmwave-spectrum-value-helper.h"
 
 namespace ns3{
@@ -171,7 +174,15 @@ MmWave3gppChannel::MmWave3gppChannel ()
 	m_normalRvBlockage = CreateObject<NormalRandomVariable> ();
 	m_normalRvBlockage->SetAttribute ("Mean", DoubleValue (0));
 	m_normalRvBlockage->SetAttribute ("Variance", DoubleValue (1));
+	m_sharedStreams.m_uniformRv = m_uniformRv;
+	m_sharedStreams.m_uniformRvBlockage = m_uniformRvBlockage;
+	m_sharedStreams.m_normalRv = m_normalRv;
+	m_sharedStreams.m_normalRvBlockage = m_normalRvBlockage;
 	m_forceInitialBfComputation = false;
+	m_initialThreads = 0;
+	m_tableResolution = 0;
+	m_spectralGainCache = true;
+	m_eigenSolverType = POWER_METHOD;
 }
 
 TypeId
@@ -209,6 +220,33 @@ MmWave3gppChannel::GetTypeId (void)
 				BooleanValue (true),
 				MakeBooleanAccessor (&MmWave3gppChannel::m_portraitMode),
 				MakeBooleanChecker ())
+	.AddAttribute ("EigenSolver",
+				"Algorithm used to compute the beamforming vectors from the spatial correlation matrices",
+				EnumValue (MmWave3gppChannel::POWER_METHOD),
+				MakeEnumAccessor (&MmWave3gppChannel::m_eigenSolverType),
+				MakeEnumChecker (MmWave3gppChannel::POWER_METHOD, "PowerMethod",
+								 MmWave3gppChannel::BLOCKED_POWER_METHOD, "BlockedPowerMethod"))
+	.AddAttribute ("SpectralGainCache",
+				"Reuse the per-subband BF gain of a link until its channel, propagation condition or Doppler phase changes",
+				BooleanValue (true),
+				MakeBooleanAccessor (&MmWave3gppChannel::m_spectralGainCache),
+				MakeBooleanChecker ())
+	.AddAttribute ("InitialThreads",
+				"Number of threads used by Initial to generate the channels between UEs and eNBs. "
+				"If 0, the channels are generated by the simulation thread. Each link draws from its own random "
+				"streams, whatever the number of threads, so that the realizations are the same for any value. "
+				"Note that these realizations differ from those of earlier versions, which drew the initial "
+				"channels from the shared random variables, even with the default value and the same seed and run",
+				UintegerValue (0),
+				MakeUintegerAccessor (&MmWave3gppChannel::m_initialThreads),
+				MakeUintegerChecker<uint32_t> ())
+	.AddAttribute ("TableResolution",
+				"If positive, the BS/UT heights and the 2D distance are rounded to a multiple of this value (in m) "
+				"before looking up the cached parameters of TR 38.900 Table 7.5-6, so that close links share the same table. "
+				"If 0, a table is shared only by links with exactly the same heights and distance",
+				DoubleValue (0),
+				MakeDoubleAccessor (&MmWave3gppChannel::m_tableResolution),
+				MakeDoubleChecker<double> (0))
 	;
 	return tid;
 }
@@ -228,6 +266,7 @@ void
 MmWave3gppChannel::SetConfigurationParameters (Ptr<MmWavePhyMacCommon> ptrConfig)
 {
 	m_phyMacConfig = ptrConfig;
+	m_tableCache.clear ();
 }
 
 Ptr<MmWavePhyMacCommon>
@@ -240,14 +279,7 @@ MmWave3gppChannel::GetConfigurationParameters (void) const
 void
 MmWave3gppChannel::ConnectDevices (Ptr<NetDevice> dev1, Ptr<NetDevice> dev2)
 {
-	key_t key = std::make_pair(dev1,dev2);
-
-	std::map< key_t, int >::iterator iter = m_connectedPair.find(key);
-	if (iter != m_connectedPair.end ())
-	{
-		m_connectedPair.erase (iter);
-	}
-	m_connectedPair.insert(std::make_pair(key,1));
+	m_connectedPair[m_linkIndex.GetLinkId (dev1, dev2)] = 1;
 }
 
 
@@ -375,6 +407,13 @@ MmWave3gppChannel::Initial(NetDeviceContainer ueDevices, NetDeviceContainer enbD
 
 	m_forceInitialBfComputation = true;
 
+	// the channels are first prepared one by one, then generated (in parallel with
+	// m_initialThreads > 1) and finally stored in the same order as they were prepared.
+	// The pairs that cannot be prepared are handled by DoCalcRxPowerSpectralDensity afterwards.
+	std::vector<InitialChannel> channels;
+	std::vector< std::pair<Ptr<const MobilityModel>, Ptr<const MobilityModel> > > deferredPairs;
+	std::vector< Ptr<const SpectrumValue> > deferredPsds;
+
 	for (NetDeviceContainer::Iterator i = ueDevices.Begin(); i != ueDevices.End(); i++)
 	{
 		for (NetDeviceContainer::Iterator j = enbDevices.Begin(); j != enbDevices.End(); j++)
@@ -411,7 +450,11 @@ MmWave3gppChannel::Initial(NetDeviceContainer ueDevices, NetDeviceContainer enbD
 
 			Ptr<const SpectrumValue> fakePsd = 
 				MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_phyMacConfig, 0, listOfSubchannels);
-			DoCalcRxPowerSpectralDensity(fakePsd, a, b);
+			if (!PrepareInitialChannel (a, b, fakePsd, channels))
+			{
+				deferredPairs.push_back (std::make_pair (a, b));
+				deferredPsds.push_back (fakePsd);
+			}
 
 
 			// Ptr<MmWaveUeNetDevice> UeDev =
@@ -438,10 +481,160 @@ MmWave3gppChannel::Initial(NetDeviceContainer ueDevices, NetDeviceContainer enbD
 		
 	}
 
+	if (!channels.empty ())
+	{
+		uint32_t numThreads = std::max<uint32_t> (std::min<uint32_t> (m_initialThreads, channels.size ()), 1);
+		NS_LOG_INFO ("Generate " << channels.size () << " channels with " << numThreads << " threads");
+		std::vector<std::thread> workers;
+		for (uint32_t t = 1; t < numThreads; t++)
+		{
+			workers.push_back (std::thread (&MmWave3gppChannel::GenerateInitialChannels, this,
+					std::ref (channels), t, numThreads));
+		}
+		GenerateInitialChannels (channels, 0, numThreads);
+		for (uint32_t t = 0; t < workers.size (); t++)
+		{
+			workers[t].join ();
+		}
+		for (uint32_t i = 0; i < channels.size (); i++)
+		{
+			CommitInitialChannel (channels[i]);
+		}
+	}
+	for (uint32_t i = 0; i < deferredPairs.size (); i++)
+	{
+		DoCalcRxPowerSpectralDensity (deferredPsds[i], deferredPairs[i].first, deferredPairs[i].second);
+	}
+
 	m_forceInitialBfComputation = false;
 
 }
 
+bool
+MmWave3gppChannel::PrepareInitialChannel (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b,
+		Ptr<const SpectrumValue> psd, std::vector<InitialChannel> &channels) const
+{
+	Ptr<NetDevice> txDevice = a->GetObject<Node> ()->GetDevice (0);
+	Ptr<NetDevice> rxDevice = b->GetObject<Node> ()->GetDevice (0);
+	uint32_t linkId = m_linkIndex.GetLinkId (txDevice, rxDevice);
+	uint32_t reverseLinkId = LinkIndex::GetReverseLinkId (linkId);
+
+	// the channel exists or one of the two directions is already being generated
+	if (m_channelMap.Find (linkId) != 0 || m_channelMap.Find (reverseLinkId) != 0
+			|| m_linkStreams.Find (linkId) != 0 || m_linkStreams.Find (reverseLinkId) != 0)
+	{
+		return false;
+	}
+
+	auto returnParams = GetTxRxInfo(a, b);
+	bool skipBf = std::get<8>(returnParams);
+	if (skipBf || std::get<4>(returnParams)->IsOmniTx() || std::get<5>(returnParams)->IsOmniTx())
+	{
+		return false;
+	}
+	NS_ASSERT_MSG(a->GetDistanceFrom(b)!=0, "the position of tx and rx devices cannot be the same");
+
+	InitialChannel channel;
+	channel.m_linkId = linkId;
+	channel.m_a = a;
+	channel.m_b = b;
+	channel.m_txDevice = txDevice;
+	channel.m_rxDevice = rxDevice;
+	channel.m_txAntennaNum[0] = std::get<0>(returnParams);
+	channel.m_txAntennaNum[1] = std::get<1>(returnParams);
+	channel.m_rxAntennaNum[0] = std::get<2>(returnParams);
+	channel.m_rxAntennaNum[1] = std::get<3>(returnParams);
+	channel.m_txAntenna = std::get<4>(returnParams);
+	channel.m_rxAntenna = std::get<5>(returnParams);
+	channel.m_locUT = std::get<6>(returnParams);
+	channel.m_psd = psd;
+	GetChannelCondition (a, b, channel.m_los, channel.m_o2i);
+	channel.m_txAngle = Angles (b->GetPosition (), a->GetPosition ());
+	channel.m_rxAngle = Angles (a->GetPosition (), b->GetPosition ());
+
+	Vector rxSpeed = b->GetVelocity();
+	Vector txSpeed = a->GetVelocity();
+	channel.m_speed = Vector (rxSpeed.x-txSpeed.x,rxSpeed.y-txSpeed.y,rxSpeed.z-txSpeed.z);
+
+	double x = a->GetPosition().x-b->GetPosition().x;
+	double y = a->GetPosition().y-b->GetPosition().y;
+	channel.m_dis2D = sqrt (x*x +y*y);
+	channel.m_dis3D = a->GetDistanceFrom(b);
+	channel.m_table = Get3gppTable(channel.m_los, channel.m_o2i, std::get<9>(returnParams), channel.m_locUT.z, channel.m_dis2D);
+
+	// the streams are created in the order of the links, thus the stream numbers
+	// automatically assigned to them do not depend on the number of threads
+	ChannelRandomStreams &streams = m_linkStreams[linkId];
+	streams.m_uniformRv = CreateObject<UniformRandomVariable> ();
+	streams.m_uniformRvBlockage = CreateObject<UniformRandomVariable> ();
+	streams.m_normalRv = CreateObject<NormalRandomVariable> ();
+	streams.m_normalRv->SetAttribute ("Mean", DoubleValue (0));
+	streams.m_normalRv->SetAttribute ("Variance", DoubleValue (1));
+	streams.m_normalRvBlockage = CreateObject<NormalRandomVariable> ();
+	streams.m_normalRvBlockage->SetAttribute ("Mean", DoubleValue (0));
+	streams.m_normalRvBlockage->SetAttribute ("Variance", DoubleValue (1));
+
+	channels.push_back (channel);
+	return true;
+}
+
+void
+MmWave3gppChannel::GenerateInitialChannels (std::vector<InitialChannel> &channels, uint32_t first, uint32_t step) const
+{
+	// the scratch buffers of the BF computation are per thread
+	complexVector_t txQ;
+	complexVector_t rxQ;
+	CovarianceEigenSolver solver = m_eigenSolver;
+	for (uint32_t i = first; i < channels.size (); i += step)
+	{
+		InitialChannel &channel = channels[i];
+		const ChannelRandomStreams *streams = m_linkStreams.Find (channel.m_linkId);
+		NS_ASSERT (streams != 0);
+		channel.m_params = GetNewChannel(channel.m_table, channel.m_locUT, channel.m_los, channel.m_o2i,
+				channel.m_txAntenna, channel.m_rxAntenna, channel.m_txAntennaNum, channel.m_rxAntennaNum,
+				channel.m_rxAngle, channel.m_txAngle, channel.m_speed, channel.m_dis2D, channel.m_dis3D, *streams);
+		if (!m_cellScan)
+		{
+			// the beam search changes the sectors of the antennas, thus it is done in CommitInitialChannel
+			LongTermCovMatrixBeamforming (channel.m_params, txQ, rxQ, solver);
+			CalLongTerm (channel.m_params);
+		}
+	}
+}
+
+void
+MmWave3gppChannel::CommitInitialChannel (InitialChannel &channel) const
+{
+	if(m_updatePeriod.GetMilliSeconds() > 0)
+	{
+		Simulator::Schedule (m_updatePeriod, &MmWave3gppChannel::DeleteChannel,this,channel.m_a,channel.m_b);
+	}
+	if(m_cellScan)
+	{
+		BeamSearchBeamforming (channel.m_psd, channel.m_params, channel.m_txAntenna, channel.m_rxAntenna,
+				channel.m_txAntennaNum, channel.m_rxAntennaNum);
+	}
+	channel.m_txAntenna->SetBeamformingVector (channel.m_params->m_txW, channel.m_rxDevice);
+	channel.m_rxAntenna->SetBeamformingVector (channel.m_params->m_rxW, channel.m_txDevice);
+	if(m_cellScan)
+	{
+		CalLongTerm (channel.m_params);
+	}
+	m_channelMap[channel.m_linkId] = channel.m_params;
+	InvalidateSpectralGain (channel.m_linkId);
+}
+
+const MmWave3gppChannel::ChannelRandomStreams&
+MmWave3gppChannel::GetRandomStreams (uint32_t linkId) const
+{
+	const ChannelRandomStreams *streams = m_linkStreams.Find (linkId);
+	if (streams == 0)
+	{
+		streams = m_linkStreams.Find (LinkIndex::GetReverseLinkId (linkId));
+	}
+	return streams != 0 ? *streams : m_sharedStreams;
+}
+
     std::tuple<uint8_t, uint8_t, uint8_t, uint8_t, Ptr<AntennaArrayModel>, Ptr<AntennaArrayModel>, Vector,
     bool, bool, double>
     MmWave3gppChannel::GetTxRxInfo(Ptr<const MobilityModel> a, Ptr<const MobilityModel> b) const
@@ -861,13 +1054,60 @@ Ptr<SpectrumValue>
 MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
                                                    Ptr<const MobilityModel> a,
                                                    Ptr<const MobilityModel> b) const
+{
+	return DoCalcRxPowerSpectralDensityInPlace (Copy (txPsd), a, b);
+}
+
+Ptr<SpectrumValue>
+MmWave3gppChannel::DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> rxPsd,
+                                                   Ptr<const MobilityModel> a,
+                                                   Ptr<const MobilityModel> b) const
 {
     NS_LOG_FUNCTION (this);
-    Ptr<SpectrumValue> rxPsd = Copy (txPsd);
 
     Ptr<NetDevice> txDevice = a->GetObject<Node> ()->GetDevice (0);
     Ptr<NetDevice> rxDevice = b->GetObject<Node> ()->GetDevice (0);
 
+    // the forward and the reverse link have adjacent identifiers
+    uint32_t linkId = m_linkIndex.GetLinkId (txDevice, rxDevice);
+    uint32_t reverseLinkId = LinkIndex::GetReverseLinkId (linkId);
+
+    Vector rxSpeed = b->GetVelocity();
+    Vector txSpeed = a->GetVelocity();
+    Vector relativeSpeed (rxSpeed.x-txSpeed.x,rxSpeed.y-txSpeed.y,rxSpeed.z-txSpeed.z);
+
+    // A cached gain is still valid if the channel was not created, updated or deleted since it
+    // was computed (these events drop the entry), the condition did not change, the antennas are
+    // not in omni mode and the Doppler phase is the same, i.e., the devices are not moving
+    // relative to each other or the time did not advance.
+    SpectralGain *gainIt = m_spectralGainMap.Find (linkId);
+    if (m_spectralGainCache && gainIt != 0)
+    {
+	SpectralGain &cached = *gainIt;
+	bool los = false;
+	bool o2i = false;
+	GetChannelCondition (a, b, los, o2i);
+	bool still = relativeSpeed.x == 0 && relativeSpeed.y == 0 && relativeSpeed.z == 0;
+	if (cached.m_los == los && cached.m_o2i == o2i
+			&& cached.m_spectrumModel == rxPsd->GetSpectrumModel ()
+			&& !cached.m_txAntenna->IsOmniTx () && !cached.m_rxAntenna->IsOmniTx ()
+			&& cached.m_speed.x == relativeSpeed.x && cached.m_speed.y == relativeSpeed.y
+			&& cached.m_speed.z == relativeSpeed.z
+			&& (still || cached.m_time == Simulator::Now ()))
+	{
+	    NS_LOG_LOGIC ("Reuse the spectral gain of the link");
+	    Values::iterator vit = rxPsd->ValuesBegin ();
+	    for (uint32_t iSubband = 0; vit != rxPsd->ValuesEnd (); vit++, iSubband++)
+	    {
+		if ((*vit) != 0.00)
+		{
+		    *vit = (*vit)*cached.m_gain[iSubband];
+		}
+	    }
+	    return rxPsd;
+	}
+    }
+
     auto returnParams = GetTxRxInfo(a, b);
 
     /* 
@@ -906,68 +1146,32 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 
     NS_ASSERT_MSG(a->GetDistanceFrom(b)!=0, "the position of tx and rx devices cannot be the same");
 
-    Vector rxSpeed = b->GetVelocity();
-    Vector txSpeed = a->GetVelocity();
-    Vector relativeSpeed (rxSpeed.x-txSpeed.x,rxSpeed.y-txSpeed.y,rxSpeed.z-txSpeed.z);
-
-    key_t key = std::make_pair(txDevice,rxDevice);
-    key_t keyReverse = std::make_pair(rxDevice,txDevice);
-
-    std::map< key_t, Ptr<Params3gpp> >::iterator it = m_channelMap.find (key);
-    std::map< key_t, Ptr<Params3gpp> >::iterator itReverse = m_channelMap.find (keyReverse);
+    Ptr<Params3gpp> *it = m_channelMap.Find (linkId);
+    Ptr<Params3gpp> *itReverse = m_channelMap.Find (reverseLinkId);
 
     Ptr<Params3gpp> channelParams;
 
     bool reverseLink = false;
 
     //Step 2: Assign propagation condition (LOS/NLOS).
-
-    char condition;
-    if (DynamicCast<MmWave3gppPropagationLossModel> (m_3gppPathloss)!=0)
-    {
-        condition = m_3gppPathloss->GetObject<MmWave3gppPropagationLossModel> () 
-		->GetChannelCondition(a->GetObject<MobilityModel>(),b->GetObject<MobilityModel>());
-    }
-    else if (DynamicCast<MmWave3gppBuildingsPropagationLossModel> (m_3gppPathloss)!=0)
-    {
-        condition = m_3gppPathloss->GetObject<MmWave3gppBuildingsPropagationLossModel> ()
-		->GetChannelCondition(a->GetObject<MobilityModel>(),b->GetObject<MobilityModel>());
-    }
-    else
-    {
-	NS_FATAL_ERROR("unkonw pathloss model");
-    }
     bool los = false;
     bool o2i = false;
-    if(condition == 'l')
-    {
-        los = true;
-    }
-    else if(condition == 'i')
-    {
-        o2i = true;
-    }
-    else if(condition == 's')
-    {
-        // in this special case, we condiser los + outdoor to indoor.
-        los = true;
-        o2i = true;
-    }
+    GetChannelCondition (a, b, los, o2i);
 
     // Every m_updatedPeriod, the channel matrix is deleted and a consistent channel update is triggered.
     // When there is a LOS/NLOS switch, a new uncorrelated channel is created.
     // Therefore, LOS/NLOS condition of updating is always consistent with the previous channel.
 
     //I only update the fowrad channel.
-    if ((it == m_channelMap.end () && itReverse == m_channelMap.end ()) ||
-		    (it != m_channelMap.end () && it->second->m_channel.size() == 0)||
-		    (it != m_channelMap.end () && it->second->m_los != los))
+    if ((it == 0 && itReverse == 0) ||
+		    (it != 0 && (*it)->m_channel.IsEmpty())||
+		    (it != 0 && (*it)->m_los != los))
     {
 	NS_LOG_INFO("Update or create the forward channel");
-	NS_LOG_LOGIC("it == m_channelMap.end () " << (it == m_channelMap.end ()));
-	NS_LOG_LOGIC("itReverse == m_channelMap.end () " << (itReverse == m_channelMap.end ()));
-	NS_LOG_LOGIC("it->second->m_channel.size() == 0 " << (it->second->m_channel.size() == 0));
-	NS_LOG_LOGIC("it->second->m_los != los" << (it->second->m_los != los));
+	NS_LOG_LOGIC("it == 0 " << (it == 0));
+	NS_LOG_LOGIC("itReverse == 0 " << (itReverse == 0));
+	NS_LOG_LOGIC("(*it)->m_channel.IsEmpty() " << (it != 0 && (*it)->m_channel.IsEmpty()));
+	NS_LOG_LOGIC("(*it)->m_los != los" << (it != 0 && (*it)->m_los != los));
 		
 	//Step 1: The parameters are configured in the example code.
 	/*make sure txAngle rxAngle exist, i.e., the position of tx and rx cannot be the same*/
@@ -987,8 +1191,8 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 	Ptr<ParamsTable> table3gpp = Get3gppTable(los, o2i, hBS, hUT, distance2D);
 
 	// Step 4-11 are performed in function GetNewChannel()
-	if((it == m_channelMap.end () && itReverse == m_channelMap.end ()) ||
-			(it != m_channelMap.end () && it->second->m_channel.size() == 0))
+	if((it == 0 && itReverse == 0) ||
+			(it != 0 && (*it)->m_channel.IsEmpty()))
 	{
 	    // delete the channel parameter to cause the channel to be updated again.
 	    // The m_updatePeriod can be configured to be relatively large in order to disable updates.
@@ -1002,19 +1206,20 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 	double distance3D = a->GetDistanceFrom(b);
 
 	bool channelUpdate = false;
-	if(it != m_channelMap.end () && it->second->m_channel.size() == 0)
+	if(it != 0 && (*it)->m_channel.IsEmpty())
 	{
 	    //if the channel map is not empty, we only update the channel.
 	    NS_LOG_DEBUG ("Update forward channel consistently between device " << a << " " << b);
-	    it->second->m_locUT = locUT;
-	    it->second->m_los = los;
-	    it->second->m_o2i = o2i;
-	    channelParams = UpdateChannel(it->second, table3gpp, txAntennaArray, rxAntennaArray, txAntennaNum, rxAntennaNum, rxAngle, txAngle);
-	    it->second->m_dis3D = distance3D;
-	    it->second->m_dis2D = distance2D;
-            it->second->m_speed = relativeSpeed;
-            it->second->m_generatedTime = Now();
-	    it->second->m_preLocUT = locUT;
+	    (*it)->m_locUT = locUT;
+	    (*it)->m_los = los;
+	    (*it)->m_o2i = o2i;
+	    channelParams = UpdateChannel(*it, table3gpp, txAntennaArray, rxAntennaArray, txAntennaNum, rxAntennaNum, rxAngle, txAngle,
+			    GetRandomStreams (linkId));
+	    (*it)->m_dis3D = distance3D;
+	    (*it)->m_dis2D = distance2D;
+            (*it)->m_speed = relativeSpeed;
+            (*it)->m_generatedTime = Now();
+	    (*it)->m_preLocUT = locUT;
 	    channelUpdate = true;
 	}
 	else
@@ -1022,7 +1227,7 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
             // if the channel map is empty, we create a new channel.
 	    NS_LOG_INFO("Create new channel");
 	    channelParams = GetNewChannel(table3gpp, locUT, los, o2i, txAntennaArray, rxAntennaArray, 
-			    txAntennaNum, rxAntennaNum, rxAngle, txAngle, relativeSpeed, distance2D, distance3D);
+			    txAntennaNum, rxAntennaNum, rxAngle, txAngle, relativeSpeed, distance2D, distance3D, GetRandomStreams (linkId));
 	}
 		
 		// the connected pair is set in the GetTxRxInfo method
@@ -1094,35 +1299,71 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 			{
 				NS_LOG_INFO("channelParams->m_txW.size() == 0 " << (channelParams->m_txW.size() == 0));
 				NS_LOG_INFO("channelParams->m_rxW.size() == 0 " << (channelParams->m_rxW.size() == 0));
-				m_channelMap[key] = channelParams;
+				m_channelMap[linkId] = channelParams;
+				InvalidateSpectralGain (linkId);
 				return rxPsd;
 			}
 		}
 
 		CalLongTerm (channelParams);
-		m_channelMap[key] = channelParams;
+		m_channelMap[linkId] = channelParams;
+		InvalidateSpectralGain (linkId);
 	}
-	else if (itReverse == m_channelMap.end ()) //Find channel matrix in the forward link
+	else if (itReverse == 0) //Find channel matrix in the forward link
 	{
-		channelParams = (*it).second;
+		channelParams = *it;
 	}
 	else //Find channel matrix in the Reverse link
 	{
 		reverseLink = true;
-		channelParams = (*itReverse).second;
+		channelParams = *itReverse;
 	}
 
-	Ptr<SpectrumValue> bfPsd = CalBeamformingGain(rxPsd, channelParams, relativeSpeed);
-
-	SpectrumValue bfGain = (*bfPsd)/(*rxPsd);
-	uint8_t nbands = bfGain.GetSpectrumModel ()->GetNumBands ();
-	if (reverseLink == false)
+	// the PSD without beamforming is needed only to log the gain, and it is lost
+	// when the gain is applied in place
+	Ptr<SpectrumValue> noBfPsd = g_log.IsEnabled (LOG_DEBUG) ? Copy (rxPsd) : Ptr<SpectrumValue> ();
+	Ptr<SpectrumValue> bfPsd;
+	if (m_spectralGainCache)
 	{
-		NS_LOG_DEBUG ("****** DL BF gain == " << Sum (bfGain)/nbands << " RX PSD " << Sum(*rxPsd)/nbands); // print avg bf gain
+		// compute the gain of all the subbands, so that the entry can be reused
+		// also by transmissions that occupy a different set of subbands
+		SpectralGain &cached = m_spectralGainMap[linkId];
+		cached.m_txAntenna = txAntennaArray;
+		cached.m_rxAntenna = rxAntennaArray;
+		cached.m_spectrumModel = rxPsd->GetSpectrumModel ();
+		cached.m_los = los;
+		cached.m_o2i = o2i;
+		cached.m_speed = relativeSpeed;
+		cached.m_time = Simulator::Now ();
+		CalSubbandGain (0, channelParams, relativeSpeed, rxPsd->GetSpectrumModel ()->GetNumBands (), cached.m_gain);
+
+		bfPsd = rxPsd;
+		Values::iterator vit = bfPsd->ValuesBegin ();
+		for (uint32_t iSubband = 0; vit != bfPsd->ValuesEnd (); vit++, iSubband++)
+		{
+			if ((*vit) != 0.00)
+			{
+				*vit = (*vit)*cached.m_gain[iSubband];
+			}
+		}
 	}
 	else
 	{
-		NS_LOG_DEBUG ("****** UL BF gain == " << Sum (bfGain)/nbands << " RX PSD " << Sum(*rxPsd)/nbands);
+		bfPsd = CalBeamformingGain(rxPsd, channelParams, relativeSpeed);
+	}
+
+	if (noBfPsd)
+	{
+		SpectrumValue bfGain = (*bfPsd)/(*noBfPsd);
+		uint8_t nbands = bfGain.GetSpectrumModel ()->GetNumBands ();
+		if (reverseLink == false)
+		{
+			NS_LOG_DEBUG ("****** DL BF gain == " << Sum (bfGain)/nbands << " RX PSD " << Sum(*noBfPsd)/nbands); // print avg bf gain
+		}
+		else
+		{
+			NS_LOG_DEBUG ("****** UL BF gain == " << Sum (bfGain)/nbands << " RX PSD " << Sum(*noBfPsd)/nbands);
+		}
 	}
 	return bfPsd;
 }
@@ -1130,163 +1371,112 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 void
 MmWave3gppChannel::LongTermCovMatrixBeamforming(Ptr<Params3gpp> params) const
 {
-	//generate transmitter side spatial correlation matrix
-	uint8_t txSize = params->m_channel.at(0).size();
-	uint8_t rxSize = params->m_channel.size();
-	complex2DVector_t txQ;
-	txQ.resize(txSize);
+	LongTermCovMatrixBeamforming (params, m_txQ, m_rxQ, m_eigenSolver);
+}
 
-	for (uint8_t txIndex = 0; txIndex < txSize; txIndex++)
-	{
-		txQ.at(txIndex).resize(txSize);
-	}
+void
+MmWave3gppChannel::LongTermCovMatrixBeamforming(Ptr<Params3gpp> params, complexVector_t &txQ,
+		complexVector_t &rxQ, CovarianceEigenSolver &solver) const
+{
+	//generate transmitter side spatial correlation matrix
+	uint16_t txSize = params->m_channel.GetTxSize();
+	uint16_t rxSize = params->m_channel.GetRxSize();
 
 	//compute the transmitter side spatial correlation matrix txQ = H*H, where H is the sum of H_n over n clusters.
-	for (uint8_t t1Index = 0; t1Index < txSize; t1Index++)
-	{
-		for (uint8_t t2Index = 0; t2Index < txSize; t2Index++)
-		{
-			for(uint8_t rxIndex = 0; rxIndex < rxSize; rxIndex++)
-			{
-				std::complex<double> cSum (0,0);
-				for (uint8_t cIndex = 0; cIndex < params->m_channel.at(rxIndex).at(t1Index).size(); cIndex++)
-				{
-					cSum = cSum + std::conj(params->m_channel.at(rxIndex).at(t1Index).at(cIndex))*
-							(params->m_channel.at(rxIndex).at(t2Index).at(cIndex));
-				}
-				txQ[t1Index][t2Index] += cSum;
-			}
-
-		}
-	}
+	params->m_channel.TxCovariance(txQ);
 
+	//compute the receiver side spatial correlation matrix rxQ = HH*, where H is the sum of H_n over n clusters.
+	params->m_channel.RxCovariance(rxQ);
 
 	//calculate beamforming vector from spatial correlation matrix.
-	complexVector_t antennaWeights;
-	uint8_t txAntenna = txQ.size ();
-	for (uint8_t eIndex = 0; eIndex < txAntenna; eIndex++)
+	switch (m_eigenSolverType)
 	{
-		antennaWeights.push_back(txQ.at (0).at (eIndex));
+	case BLOCKED_POWER_METHOD:
+		{
+			// the previous weights of the link (if any) are the starting point
+			uint16_t txIter = solver.Solve(txQ, txSize, params->m_txW, params->m_txW);
+			uint16_t rxIter = solver.Solve(rxQ, rxSize, params->m_rxW, params->m_rxW);
+			NS_LOG_LOGIC("eigen solver converged in " << txIter << " (tx) and " << rxIter << " (rx) iterations");
+			break;
+		}
+	default:
+		params->m_txW = PowerMethod(txQ, txSize);
+		params->m_rxW = PowerMethod(rxQ, rxSize);
+		break;
 	}
+}
 
+complexVector_t
+MmWave3gppChannel::PowerMethod(const complexVector_t &Q, uint16_t size) const
+{
+	complexVector_t antennaWeights (Q.begin(), Q.begin() + size);
+	complexVector_t antennaWeights_New (size);
 
 	int iter = 10;
 	double diff = 1;
 	while(iter != 0 && diff>1e-10)
 	{
-		complexVector_t antennaWeights_New;
-
-		for(uint8_t row = 0; row<txAntenna; row++)
+		for(uint16_t row = 0; row<size; row++)
 		{
+			const std::complex<double> *qRow = &Q[row*size];
 			std::complex<double> sum(0,0);
-			for (uint8_t col = 0; col< txAntenna; col++)
+			for (uint16_t col = 0; col< size; col++)
 			{
-				sum += txQ.at (row).at (col)*antennaWeights.at (col);
+				sum += qRow[col]*antennaWeights[col];
 			}
-
-		    antennaWeights_New.push_back(sum);
+			antennaWeights_New[row] = sum;
 		}
 		//normalize antennaWeights;
 		double weightSum = 0;
-		for (uint8_t i = 0; i< txAntenna; i++)
+		for (uint16_t i = 0; i< size; i++)
 		{
-			weightSum += norm(antennaWeights_New. at(i));
+			weightSum += norm(antennaWeights_New[i]);
 		}
-		for (uint8_t i = 0; i< txAntenna; i++)
+		for (uint16_t i = 0; i< size; i++)
 		{
-			antennaWeights_New. at(i) = antennaWeights_New. at(i)/sqrt(weightSum);
+			antennaWeights_New[i] = antennaWeights_New[i]/sqrt(weightSum);
 		}
 		diff = 0;
-		for (uint8_t i = 0; i< txAntenna; i++)
+		for (uint16_t i = 0; i< size; i++)
 		{
-			diff += std::norm(antennaWeights_New. at(i)-antennaWeights. at(i));
+			diff += std::norm(antennaWeights_New[i]-antennaWeights[i]);
 		}
 		iter--;
-		antennaWeights = antennaWeights_New;
-	}
-
-	params->m_txW = antennaWeights;
-
-	//compute the receiver side spatial correlation matrix rxQ = HH*, where H is the sum of H_n over n clusters.
-	complex2DVector_t rxQ;
-	rxQ.resize(rxSize);
-	for (uint8_t r1Index = 0; r1Index < rxSize; r1Index++)
-	{
-		rxQ.at(r1Index).resize(rxSize);
+		antennaWeights.swap(antennaWeights_New);
 	}
+	return antennaWeights;
+}
 
-	for (uint8_t r1Index = 0; r1Index < rxSize; r1Index++)
-	{
-		for (uint8_t r2Index = 0; r2Index < rxSize; r2Index++)
-		{
-			for(uint8_t txIndex = 0; txIndex < txSize; txIndex++)
-            {
-				std::complex<double> cSum (0,0);
-				for (uint8_t cIndex = 0; cIndex < params->m_channel.at(r1Index).at(txIndex).size(); cIndex++)
-				{
-					cSum = cSum + params->m_channel.at(r1Index).at(txIndex).at(cIndex)*
-							std::conj(params->m_channel.at(r2Index).at(txIndex).at(cIndex));
-				}
-				rxQ[r1Index][r2Index] += cSum;
-            }
+Ptr<SpectrumValue>
+MmWave3gppChannel::CalBeamformingGain (Ptr<const SpectrumValue> txPsd, Ptr<Params3gpp> params, Vector speed) const
+{
+	NS_LOG_FUNCTION (this);
 
-		}
-	}
+	Ptr<SpectrumValue> tempPsd = Copy<SpectrumValue> (txPsd);
 
-	//calculate beamforming vector from spatial correlation matrix.
-	antennaWeights.clear();
-	uint8_t rxAntenna = rxQ.size ();
-	for (uint8_t eIndex = 0; eIndex < rxAntenna; eIndex++)
-	{
-		antennaWeights.push_back(rxQ.at (0).at (eIndex));
-	}
+	doubleVector_t gain;
+	CalSubbandGain (txPsd, params, speed, txPsd->GetSpectrumModel ()->GetNumBands (), gain);
 
-	iter = 10;
-	diff = 1;
-	while(iter != 0 && diff>1e-10)
+	Values::iterator vit = tempPsd->ValuesBegin ();
+	uint16_t iSubband = 0;
+	while (vit != tempPsd->ValuesEnd ())
 	{
-		complexVector_t antennaWeights_New;
-
-		for(uint8_t row = 0; row<rxAntenna; row++)
-		{
-			std::complex<double> sum(0,0);
-			for (uint8_t col = 0; col< rxAntenna; col++)
-			{
-				sum += rxQ.at (row).at (col)*antennaWeights.at (col);
-			}
-
-		    antennaWeights_New.push_back(sum);
-		}
-
-		//normalize antennaWeights;
-		double weightSum = 0;
-		for (uint8_t i = 0; i< rxAntenna; i++)
-		{
-			weightSum += norm(antennaWeights_New. at(i));
-		}
-		for (uint8_t i = 0; i< rxAntenna; i++)
-		{
-			antennaWeights_New. at(i) = antennaWeights_New. at(i)/sqrt(weightSum);
-		}
-		diff = 0;
-		for (uint8_t i = 0; i< rxAntenna; i++)
+		if ((*vit) != 0.00)
 		{
-			diff += std::norm(antennaWeights_New. at(i)-antennaWeights. at(i));
+			*vit = (*vit)*gain[iSubband];
 		}
-		iter--;
-		antennaWeights = antennaWeights_New;
+		vit++;
+		iSubband++;
 	}
-
-	params->m_rxW = antennaWeights;
+	return tempPsd;
 }
 
-Ptr<SpectrumValue>
-MmWave3gppChannel::CalBeamformingGain (Ptr<const SpectrumValue> txPsd, Ptr<Params3gpp> params, Vector speed) const
+void
+MmWave3gppChannel::CalSubbandGain (Ptr<const SpectrumValue> txPsd, Ptr<Params3gpp> params, Vector speed,
+		uint32_t numBands, doubleVector_t &gain) const
 {
 	NS_LOG_FUNCTION (this);
 
-	Ptr<SpectrumValue> tempPsd = Copy<SpectrumValue> (txPsd);
-
 	//NS_ASSERT_MSG (params->m_delay.size()==params->m_channel.at(0).at(0).size(), "the cluster number of channel and delay spread should be the same");
 	//NS_ASSERT_MSG (params->m_txW.size()==params->m_channel.at(0).size(), "the tx antenna size of channel and antenna weights should be the same");
 	//NS_ASSERT_MSG (params->m_rxW.size()==params->m_channel.size(), "the rx antenna size of channel and antenna weights should be the same");
@@ -1295,41 +1485,88 @@ MmWave3gppChannel::CalBeamformingGain (Ptr<const SpectrumValue> txPsd, Ptr<Param
 
 	//channel[rx][tx][cluster]
 	uint8_t numCluster = params->m_delay.size();
-	//uint8_t txAntenna = params->m_txW.size();
-	//uint8_t rxAntenna = params->m_rxW.size();
 	//the update of Doppler is simplified by only taking the center angle of each cluster in to consideration.
-	Values::iterator vit = tempPsd->ValuesBegin ();
-	uint16_t iSubband = 0;
 	double slotTime = Simulator::Now ().GetSeconds ();
-	complexVector_t doppler;
+	// the long term component and the Doppler do not depend on the subband,
+	// thus they are combined once per cluster outside the subband loop
+	complexVector_t clusterGain (numCluster);
+	doubleVector_t clusterDelayPhase (numCluster);
 	for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
 	{
 		//cluster angle angle[direction][n],where, direction = 0(aoa), 1(zoa).
 		double temp_doppler = 2*M_PI*(sin(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*cos(params->m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180)*speed.x
 				+ sin(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*sin(params->m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180)*speed.y
 				+ cos(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*speed.z)*slotTime*m_phyMacConfig->GetCenterFrequency ()/3e8;
-		doppler.push_back(exp(std::complex<double> (0, temp_doppler)));
-
+		clusterGain[cIndex] = params->m_longTerm.at(cIndex)*exp(std::complex<double> (0, temp_doppler));
+		clusterDelayPhase[cIndex] = -2*M_PI*params->m_delay.at (cIndex);
 	}
 
-	while (vit != tempPsd->ValuesEnd ())
+	gain.assign (numBands, 0.0);
+	double fStart = m_phyMacConfig->GetCenterFrequency () - GetSystemBandwidth ()/2;
+	double chunkWidth = m_phyMacConfig->GetChunkWidth ();
+	for (uint32_t iSubband = 0; iSubband < numBands; iSubband++)
 	{
-		std::complex<double> subsbandGain (0.0,0.0);
-		if ((*vit) != 0.00)
+		if (txPsd != 0 && (*txPsd)[iSubband] == 0.00)
 		{
-			double fsb = m_phyMacConfig->GetCenterFrequency () - GetSystemBandwidth ()/2 + m_phyMacConfig->GetChunkWidth ()*iSubband ;
-			for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
-			{
-				double delay = -2*M_PI*fsb*(params->m_delay.at (cIndex));
-				std::complex<double> txSum(0,0);
-				subsbandGain = subsbandGain + params->m_longTerm.at(cIndex)*doppler.at(cIndex)*exp(std::complex<double>(0, delay));
-			}
-			*vit = (*vit)*(norm (subsbandGain));
+			continue;
 		}
-		vit++;
-		iSubband++;
+		double fsb = fStart + chunkWidth*iSubband ;
+		double gainRe = 0, gainIm = 0;
+		for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+		{
+			double delay = clusterDelayPhase[cIndex]*fsb;
+			double c = cos (delay);
+			double sn = sin (delay);
+			gainRe += clusterGain[cIndex].real ()*c - clusterGain[cIndex].imag ()*sn;
+			gainIm += clusterGain[cIndex].real ()*sn + clusterGain[cIndex].imag ()*c;
+		}
+		gain[iSubband] = gainRe*gainRe + gainIm*gainIm;
 	}
-	return tempPsd;
+}
+
+void
+MmWave3gppChannel::GetChannelCondition (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b,
+		bool &los, bool &o2i) const
+{
+    char condition;
+    if (DynamicCast<MmWave3gppPropagationLossModel> (m_3gppPathloss)!=0)
+    {
+        condition = m_3gppPathloss->GetObject<MmWave3gppPropagationLossModel> () 
+		->GetChannelCondition(a->GetObject<MobilityModel>(),b->GetObject<MobilityModel>());
+    }
+    else if (DynamicCast<MmWave3gppBuildingsPropagationLossModel> (m_3gppPathloss)!=0)
+    {
+        condition = m_3gppPathloss->GetObject<MmWave3gppBuildingsPropagationLossModel> ()
+		->GetChannelCondition(a->GetObject<MobilityModel>(),b->GetObject<MobilityModel>());
+    }
+    else
+    {
+	NS_FATAL_ERROR("unkonw pathloss model");
+    }
+    los = false;
+    o2i = false;
+    if(condition == 'l')
+    {
+        los = true;
+    }
+    else if(condition == 'i')
+    {
+        o2i = true;
+    }
+    else if(condition == 's')
+    {
+        // in this special case, we condiser los + outdoor to indoor.
+        los = true;
+        o2i = true;
+    }
+}
+
+void
+MmWave3gppChannel::InvalidateSpectralGain (uint32_t linkId) const
+{
+	// the forward and the reverse link share the same Params3gpp object
+	m_spectralGainMap.Erase (linkId);
+	m_spectralGainMap.Erase (LinkIndex::GetReverseLinkId (linkId));
 }
 
 double
@@ -1356,40 +1593,76 @@ MmWave3gppChannel::SetPathlossModel (Ptr<PropagationLossModel> pathloss)
 	{
 		NS_FATAL_ERROR("unkonw pathloss model");
 	}
+	m_tableCache.clear ();
 }
 
 
 void
 MmWave3gppChannel::CalLongTerm (Ptr<Params3gpp> params) const
 {
-	uint8_t txAntenna = params->m_txW.size();
-	uint8_t rxAntenna = params->m_rxW.size();
-
 	//store the long term part to reduce computation load
 	//only the small scale fading is need to be updated if the large scale parameters and antenna weights remain unchanged.
-	complexVector_t longTerm;
-	uint8_t numCluster = params->m_delay.size();
+	params->m_channel.ClusterGain(params->m_txW, params->m_rxW, params->m_longTerm);
+}
 
-	for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+Ptr<ParamsTable>
+MmWave3gppChannel::Get3gppTable (bool los, bool o2i, double hBS, double hUT, double distance2D) const
+{
+	// only uLgZSD and offsetZOD depend on the heights and on the 2D distance (see Calc3gppTable)
+	bool useDistance = true;
+	bool useHeights = true;
+	if (m_scenario == "RMa")
 	{
-		std::complex<double> txSum(0,0);
-		for(uint8_t txIndex = 0; txIndex < txAntenna; txIndex++)
-		{
-			std::complex<double> rxSum(0,0);
-			for (uint8_t rxIndex = 0; rxIndex < rxAntenna; rxIndex++)
-			{
-				rxSum = rxSum + std::conj(params->m_rxW.at(rxIndex))*params->m_channel.at(rxIndex).at(txIndex).at(cIndex);
-			}
-			txSum = txSum + params->m_txW.at(txIndex)*rxSum;
-		}
-		longTerm.push_back(txSum);
+		useDistance = !los;
+		useHeights = false;
+	}
+	else if (m_scenario == "UMa")
+	{
+		// only hUT is used
+		hBS = 0;
+	}
+	else if (m_scenario == "InH-OfficeMixed"||m_scenario == "InH-OfficeOpen")
+	{
+		useDistance = false;
+		useHeights = false;
 	}
-	params->m_longTerm = longTerm;
 
+	if (m_tableResolution > 0)
+	{
+		hBS = std::round (hBS/m_tableResolution)*m_tableResolution;
+		hUT = std::round (hUT/m_tableResolution)*m_tableResolution;
+		distance2D = std::max (std::round (distance2D/m_tableResolution), 1.0)*m_tableResolution;
+	}
+	if (!useDistance)
+	{
+		distance2D = 0;
+	}
+	if (!useHeights)
+	{
+		hBS = 0;
+		hUT = 0;
+	}
+
+	std::tuple<bool, bool, double, double, double> key (los, o2i, hBS, hUT, distance2D);
+	std::map< std::tuple<bool, bool, double, double, double>, Ptr<ParamsTable> >::iterator it = m_tableCache.find (key);
+	if (it != m_tableCache.end ())
+	{
+		return it->second;
+	}
+
+	// bound the memory used with moving nodes, whose distance changes at every update
+	const uint32_t maxCachedTables = 4096;
+	if (m_tableCache.size () >= maxCachedTables)
+	{
+		m_tableCache.clear ();
+	}
+	Ptr<ParamsTable> table3gpp = Calc3gppTable (los, o2i, hBS, hUT, distance2D);
+	m_tableCache.insert (std::make_pair (key, table3gpp));
+	return table3gpp;
 }
 
 Ptr<ParamsTable>
-MmWave3gppChannel::Get3gppTable (bool los, bool o2i, double hBS, double hUT, double distance2D) const
+MmWave3gppChannel::Calc3gppTable (bool los, bool o2i, double hBS, double hUT, double distance2D) const
 {
 	double fcGHz = m_phyMacConfig->GetCenterFrequency ()/1e9;
 	Ptr<ParamsTable> table3gpp = CreateObject<ParamsTable> ();
@@ -1582,19 +1855,21 @@ MmWave3gppChannel::DeleteChannel(Ptr<const MobilityModel> a, Ptr<const MobilityM
 	Ptr<NetDevice> dev1 = a->GetObject<Node> ()->GetDevice (0);
 	Ptr<NetDevice> dev2 = b->GetObject<Node> ()->GetDevice (0);
 	NS_LOG_INFO("a position " << a->GetPosition() << " b " << b->GetPosition());
-	Ptr<Params3gpp> params = m_channelMap.find(std::make_pair(dev1,dev2))->second;
+	uint32_t linkId = m_linkIndex.FindLinkId (dev1, dev2);
+	Ptr<Params3gpp> *it = m_channelMap.Find (linkId);
+	NS_ASSERT_MSG(it != 0, "Channel not found");
+	Ptr<Params3gpp> params = *it;
 	NS_LOG_INFO("params " << params);
-	NS_LOG_INFO("params m_channel size" << params->m_channel.size());
-	NS_ASSERT_MSG(m_channelMap.find(std::make_pair(dev1,dev2)) != m_channelMap.end(), "Channel not found");
-	params->m_channel.clear();
-	m_channelMap[std::make_pair(dev1,dev2)] = params;
+	NS_LOG_INFO("params m_channel size" << params->m_channel.GetRxSize());
+	params->m_channel.Clear();
+	InvalidateSpectralGain (linkId);
 }
 
 Ptr<Params3gpp>
-MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool los, bool o2i,
-		Ptr<AntennaArrayModel> txAntenna, Ptr<AntennaArrayModel> rxAntenna,
+MmWave3gppChannel::GetNewChannel(const Ptr<ParamsTable> &table3gpp, Vector locUT, bool los, bool o2i,
+		const Ptr<AntennaArrayModel> &txAntenna, const Ptr<AntennaArrayModel> &rxAntenna,
 		uint8_t *txAntennaNum, uint8_t *rxAntennaNum,  Angles &rxAngle, Angles &txAngle,
-		Vector speed, double dis2D, double dis3D) const
+		Vector speed, double dis2D, double dis3D, const ChannelRandomStreams &streams) const
 {
 	uint8_t numOfCluster = table3gpp->m_numOfCluster;
 	uint8_t raysPerCluster = table3gpp->m_raysPerCluster;
@@ -1622,7 +1897,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	//Generate paramNum independent LSPs.
 	for (uint8_t iter = 0; iter < paramNum; iter++)
 	{
-		LSPsIndep.push_back(m_normalRv->GetValue());
+		LSPsIndep.push_back(streams.m_normalRv->GetValue());
 	}
 	for (uint8_t row = 0; row < paramNum; row++)
 	{
@@ -1684,7 +1959,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	double minTau = 100.0;
 	for (uint8_t cIndex = 0; cIndex < numOfCluster; cIndex++)
 	{
-		double tau = -1*table3gpp->m_rTau*DS*log(m_uniformRv->GetValue(0,1)); //(7.5-1)
+		double tau = -1*table3gpp->m_rTau*DS*log(streams.m_uniformRv->GetValue(0,1)); //(7.5-1)
 		if(minTau > tau)
 		{
 			minTau = tau;
@@ -1707,7 +1982,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	for (uint8_t cIndex = 0; cIndex < numOfCluster; cIndex++)
 	{
 		double power = exp(-1*clusterDelay.at(cIndex)*(table3gpp->m_rTau-1)/table3gpp->m_rTau/DS)*
-				pow(10,-1*m_normalRv->GetValue()*table3gpp->m_shadowingStd/10); //(7.5-5)
+				pow(10,-1*streams.m_normalRv->GetValue()*table3gpp->m_shadowingStd/10); //(7.5-5)
 		powerSum +=power;
 		clusterPower.push_back(power);
 	}
@@ -1881,21 +2156,21 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	for (uint8_t cIndex = 0; cIndex < numReducedCluster; cIndex++)
 	{
 		int Xn = 1;
-		if (m_uniformRv->GetValue(0,1) < 0.5)
+		if (streams.m_uniformRv->GetValue(0,1) < 0.5)
 		{
 			Xn = -1;
 		}
-		clusterAoa.at(cIndex) = clusterAoa.at(cIndex)*Xn+(m_normalRv->GetValue()*ASA/7)+rxAngle.phi*180/M_PI; //(7.5-11)
-		clusterAod.at(cIndex) = clusterAod.at(cIndex)*Xn+(m_normalRv->GetValue()*ASD/7)+txAngle.phi*180/M_PI;
+		clusterAoa.at(cIndex) = clusterAoa.at(cIndex)*Xn+(streams.m_normalRv->GetValue()*ASA/7)+rxAngle.phi*180/M_PI; //(7.5-11)
+		clusterAod.at(cIndex) = clusterAod.at(cIndex)*Xn+(streams.m_normalRv->GetValue()*ASD/7)+txAngle.phi*180/M_PI;
 		if (o2i)
 		{
-			clusterZoa.at(cIndex) = clusterZoa.at(cIndex)*Xn+(m_normalRv->GetValue()*ZSA/7)+90; //(7.5-16)
+			clusterZoa.at(cIndex) = clusterZoa.at(cIndex)*Xn+(streams.m_normalRv->GetValue()*ZSA/7)+90; //(7.5-16)
 		}
 		else
 		{
-			clusterZoa.at(cIndex) = clusterZoa.at(cIndex)*Xn+(m_normalRv->GetValue()*ZSA/7)+rxAngle.theta*180/M_PI; //(7.5-16)
+			clusterZoa.at(cIndex) = clusterZoa.at(cIndex)*Xn+(streams.m_normalRv->GetValue()*ZSA/7)+rxAngle.theta*180/M_PI; //(7.5-16)
 		}
-		clusterZod.at(cIndex) = clusterZod.at(cIndex)*Xn+(m_normalRv->GetValue()*ZSD/7)+txAngle.theta*180/M_PI+table3gpp->m_offsetZOD; //(7.5-19)
+		clusterZod.at(cIndex) = clusterZod.at(cIndex)*Xn+(streams.m_normalRv->GetValue()*ZSD/7)+txAngle.theta*180/M_PI+table3gpp->m_offsetZOD; //(7.5-19)
 
 	}
 
@@ -2049,7 +2324,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	doubleVector_t attenuation_dB;
 	if(m_blockage)
 	{
-		 attenuation_dB = CalAttenuationOfBlockage (channelParams, clusterAoa, clusterZoa);
+		 attenuation_dB = CalAttenuationOfBlockage (channelParams, clusterAoa, clusterZoa, streams);
 		 for (uint8_t cInd = 0; cInd < numReducedCluster; cInd++)
 		 {
 			 clusterPower.at (cInd) = clusterPower.at (cInd)/pow(10,attenuation_dB.at (cInd)/10);
@@ -2121,11 +2396,11 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 		doubleVector_t temp;
 		for(uint8_t mInd = 0; mInd < raysPerCluster; mInd++)
 		{
-			temp.push_back(m_uniformRv->GetValue(-1*M_PI, M_PI));
+			temp.push_back(streams.m_uniformRv->GetValue(-1*M_PI, M_PI));
 		}
 		clusterPhase.push_back(temp);
 	}
-	double losPhase = m_uniformRv->GetValue(-1*M_PI, M_PI);
+	double losPhase = streams.m_uniformRv->GetValue(-1*M_PI, M_PI);
 	channelParams->m_clusterPhase = clusterPhase;
 	channelParams->m_losPhase = losPhase;
 
@@ -2158,18 +2433,11 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 	NS_LOG_INFO ("1st strongest cluster:"<<(int)cluster1st<<", 2nd strongest cluster:"<<(int)cluster2nd);
 
-	complex3DVector_t H_usn; //channel coffecient H_usn[u][s][n];
+	ChannelTensor H_usn; //channel coffecient H_usn[u][s][n];
 	//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4.
-
-	H_usn.resize(uSize);
-	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
-	{
-		H_usn.at(uIndex).resize(sSize);
-		for (uint16_t sIndex = 0; sIndex < sSize; sIndex++)
-		{
-			H_usn.at(uIndex).at(sIndex).resize(numReducedCluster);
-		}
-	}
+	//The sub-clusters are stored after the reduced clusters, starting from the strongest cluster with the lowest index.
+	uint8_t numSubCluster = (cluster1st == cluster2nd) ? 2 : 4;
+	H_usn.Resize(uSize, sSize, numReducedCluster + numSubCluster);
 	//double slotTime = Simulator::Now ().GetSeconds ();
 	// The following for loops computes the channel coefficients
 	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
@@ -2211,7 +2479,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 					}
 					//rays *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
 					rays *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = rays;
+					H_usn.Set(uIndex, sIndex, nIndex, rays);
 				}
 				else //(7.5-28)
 				{
@@ -2280,9 +2548,14 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 					raysSub1 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
 					raysSub2 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
 					raysSub3 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = raysSub1;
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub2);
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub3);
+					uint8_t subIndex = numReducedCluster;
+					if (cluster1st != cluster2nd && nIndex == std::max (cluster1st, cluster2nd))
+					{
+						subIndex += 2;
+					}
+					H_usn.Set(uIndex, sIndex, nIndex, raysSub1);
+					H_usn.Set(uIndex, sIndex, subIndex, raysSub2);
+					H_usn.Set(uIndex, sIndex, subIndex + 1, raysSub3);
 
 				}
 			}
@@ -2307,12 +2580,8 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 				double K_linear = pow(10,K_factor/10);
 				// the LOS path should be attenuated if blockage is enabled.
-				H_usn.at(uIndex).at(sIndex).at(0) = sqrt(1/(K_linear+1))*H_usn.at(uIndex).at(sIndex).at(0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10);  //(7.5-30) for tau = tau1
-				double tempSize = H_usn.at(uIndex).at(sIndex).size();
-				for(uint8_t nIndex = 1; nIndex < tempSize; nIndex++)
-				{
-					H_usn.at(uIndex).at(sIndex).at(nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
-				}
+				H_usn.Set(uIndex, sIndex, 0, sqrt(1/(K_linear+1))*H_usn.Get(uIndex, sIndex, 0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10));  //(7.5-30) for tau = tau1
+				H_usn.Scale(uIndex, sIndex, 1, sqrt(1/(K_linear+1))); //(7.5-30) for tau = tau2...taunN
 
 			}
 		}
@@ -2376,7 +2645,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 	}
 
-	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.size() << "][" << H_usn.at(0).size() << "][" << H_usn.at (0).at(0).size()<<"]");
+	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.GetRxSize() << "][" << H_usn.GetTxSize() << "][" << H_usn.GetNumCluster()<<"]");
 
 
 	/*std::cout << "Delay:";
@@ -2400,9 +2669,10 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 }
 
 Ptr<Params3gpp>
-MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  table3gpp,
+MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, const Ptr<ParamsTable> &table3gpp,
 		Ptr<AntennaArrayModel> txAntenna, Ptr<AntennaArrayModel> rxAntenna,
-		uint8_t *txAntennaNum, uint8_t *rxAntennaNum, Angles &rxAngle, Angles &txAngle) const
+		uint8_t *txAntennaNum, uint8_t *rxAntennaNum, Angles &rxAngle, Angles &txAngle,
+		const ChannelRandomStreams &streams) const
 {
 	Ptr<Params3gpp> params = params3gpp;
 	uint8_t raysPerCluster = table3gpp->m_raysPerCluster;
@@ -2445,7 +2715,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 	for (uint8_t cIndex = 0; cIndex < params->m_numCluster; cIndex++)
 	{
 		double power = exp(-1*clusterDelay.at(cIndex)*(table3gpp->m_rTau-1)/table3gpp->m_rTau/DS)*
-				pow(10,-1*m_normalRv->GetValue()*table3gpp->m_shadowingStd/10); //(7.5-5)
+				pow(10,-1*streams.m_normalRv->GetValue()*table3gpp->m_shadowingStd/10); //(7.5-5)
 		powerSum +=power;
 		clusterPower.push_back(power);
 	}
@@ -2543,10 +2813,10 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 				}
 
 				//We can generate a new correlated normal RV with the following formula
-				params->m_norRvAngles.at(cInd).at(AOD_INDEX) = R_phi*params->m_norRvAngles.at(cInd).at(AOD_INDEX)+sqrt(1-R_phi*R_phi)*m_normalRv->GetValue();
-				params->m_norRvAngles.at(cInd).at(ZOD_INDEX) = R_theta*params->m_norRvAngles.at(cInd).at(ZOD_INDEX)+sqrt(1-R_theta*R_theta)*m_normalRv->GetValue();
-				params->m_norRvAngles.at(cInd).at(AOA_INDEX) = R_phi*params->m_norRvAngles.at(cInd).at(AOA_INDEX)+sqrt(1-R_phi*R_phi)*m_normalRv->GetValue();
-				params->m_norRvAngles.at(cInd).at(ZOA_INDEX) = R_theta*params->m_norRvAngles.at(cInd).at(ZOA_INDEX)+sqrt(1-R_theta*R_theta)*m_normalRv->GetValue();
+				params->m_norRvAngles.at(cInd).at(AOD_INDEX) = R_phi*params->m_norRvAngles.at(cInd).at(AOD_INDEX)+sqrt(1-R_phi*R_phi)*streams.m_normalRv->GetValue();
+				params->m_norRvAngles.at(cInd).at(ZOD_INDEX) = R_theta*params->m_norRvAngles.at(cInd).at(ZOD_INDEX)+sqrt(1-R_theta*R_theta)*streams.m_normalRv->GetValue();
+				params->m_norRvAngles.at(cInd).at(AOA_INDEX) = R_phi*params->m_norRvAngles.at(cInd).at(AOA_INDEX)+sqrt(1-R_phi*R_phi)*streams.m_normalRv->GetValue();
+				params->m_norRvAngles.at(cInd).at(ZOA_INDEX) = R_theta*params->m_norRvAngles.at(cInd).at(ZOA_INDEX)+sqrt(1-R_theta*R_theta)*streams.m_normalRv->GetValue();
 
 				//The normal RV is transformed to uniform RV with the desired correlation.
 				ranPhiAOD = (0.5*erfc(-1*params->m_norRvAngles.at(cInd).at(AOD_INDEX)/sqrt(2)))*2*M_PI-M_PI;
@@ -2697,7 +2967,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 	doubleVector_t attenuation_dB;
 	if(m_blockage)
 	{
-		 attenuation_dB = CalAttenuationOfBlockage (params, clusterAoa, clusterZoa);
+		 attenuation_dB = CalAttenuationOfBlockage (params, clusterAoa, clusterZoa, streams);
 		 for (uint8_t cInd = 0; cInd < params->m_numCluster; cInd++)
 		 {
 			 clusterPower.at (cInd) = clusterPower.at (cInd)/pow(10,attenuation_dB.at (cInd)/10);
@@ -2802,18 +3072,11 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 	NS_LOG_INFO ("1st strongest cluster:"<<(int)cluster1st<<", 2nd strongest cluster:"<<(int)cluster2nd);
 
-	complex3DVector_t H_usn; //channel coffecient H_usn[u][s][n];
+	ChannelTensor H_usn; //channel coffecient H_usn[u][s][n];
 	//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4.
-
-	H_usn.resize(uSize);
-	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
-	{
-		H_usn.at(uIndex).resize(sSize);
-		for (uint16_t sIndex = 0; sIndex < sSize; sIndex++)
-		{
-			H_usn.at(uIndex).at(sIndex).resize(params->m_numCluster);
-		}
-	}
+	//The sub-clusters are stored after the reduced clusters, starting from the strongest cluster with the lowest index.
+	uint8_t numSubCluster = (cluster1st == cluster2nd) ? 2 : 4;
+	H_usn.Resize(uSize, sSize, params->m_numCluster + numSubCluster);
 	//double slotTime = Simulator::Now ().GetSeconds ();
 	// The following for loops computes the channel coefficients
 	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
@@ -2855,7 +3118,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 					}
 					//rays *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
 					rays *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = rays;
+					H_usn.Set(uIndex, sIndex, nIndex, rays);
 				}
 				else //(7.5-28)
 				{
@@ -2921,9 +3184,14 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 					raysSub1 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
 					raysSub2 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
 					raysSub3 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = raysSub1;
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub2);
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub3);
+					uint8_t subIndex = params->m_numCluster;
+					if (cluster1st != cluster2nd && nIndex == std::max (cluster1st, cluster2nd))
+					{
+						subIndex += 2;
+					}
+					H_usn.Set(uIndex, sIndex, nIndex, raysSub1);
+					H_usn.Set(uIndex, sIndex, subIndex, raysSub2);
+					H_usn.Set(uIndex, sIndex, subIndex + 1, raysSub3);
 
 				}
 			}
@@ -2948,12 +3216,8 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 				double K_linear = pow(10,K_factor/10);
 
-				H_usn.at(uIndex).at(sIndex).at(0) = sqrt(1/(K_linear+1))*H_usn.at(uIndex).at(sIndex).at(0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10);  //(7.5-30) for tau = tau1
-				double tempSize = H_usn.at(uIndex).at(sIndex).size();
-				for(uint8_t nIndex = 1; nIndex < tempSize; nIndex++)
-				{
-					H_usn.at(uIndex).at(sIndex).at(nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
-				}
+				H_usn.Set(uIndex, sIndex, 0, sqrt(1/(K_linear+1))*H_usn.Get(uIndex, sIndex, 0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10));  //(7.5-30) for tau = tau1
+				H_usn.Scale(uIndex, sIndex, 1, sqrt(1/(K_linear+1))); //(7.5-30) for tau = tau2...taunN
 
 			}
 		}
@@ -3000,7 +3264,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 	}
 
-	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.size() << "][" << H_usn.at(0).size() << "][" << H_usn.at (0).at(0).size()<<"]");
+	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.GetRxSize() << "][" << H_usn.GetTxSize() << "][" << H_usn.GetNumCluster()<<"]");
 
 
 	/*std::cout << "Delay:";
@@ -3075,7 +3339,7 @@ MmWave3gppChannel::BeamSearchBeamforming (Ptr<const SpectrumValue> txPsd, Ptr<Pa
 
 doubleVector_t
 MmWave3gppChannel::CalAttenuationOfBlockage (Ptr<Params3gpp> params,
-		doubleVector_t clusterAOA, doubleVector_t clusterZOA) const
+		doubleVector_t clusterAOA, doubleVector_t clusterZOA, const ChannelRandomStreams &streams) const
 {
 	doubleVector_t powerAttenuation;
 	uint8_t clusterNum = clusterAOA.size ();
@@ -3111,17 +3375,17 @@ MmWave3gppChannel::CalAttenuationOfBlockage (Ptr<Params3gpp> params,
 		{
 			//draw value from table 7.6.4.1-2 Blocking region parameters
 			doubleVector_t table;
-			table.push_back (m_normalRvBlockage->GetValue()); //phi_k: store the normal RV that will be mapped to uniform (0,360) later.
+			table.push_back (streams.m_normalRvBlockage->GetValue()); //phi_k: store the normal RV that will be mapped to uniform (0,360) later.
 			if(m_scenario == "InH-OfficeMixed" || m_scenario == "InH-OfficeOpen")
 			{
-				table.push_back (m_uniformRvBlockage->GetValue(15, 45)); //x_k
+				table.push_back (streams.m_uniformRvBlockage->GetValue(15, 45)); //x_k
 				table.push_back (90); //Theta_k
-				table.push_back (m_uniformRvBlockage->GetValue(5, 15)); //y_k
+				table.push_back (streams.m_uniformRvBlockage->GetValue(5, 15)); //y_k
 				table.push_back (2); //r
 			}
 			else
 			{
-				table.push_back (m_uniformRvBlockage->GetValue(5, 15)); //x_k
+				table.push_back (streams.m_uniformRvBlockage->GetValue(5, 15)); //x_k
 				table.push_back (90); //Theta_k
 				table.push_back (5); //y_k
 				table.push_back (10); //r
@@ -3184,7 +3448,7 @@ MmWave3gppChannel::CalAttenuationOfBlockage (Ptr<Params3gpp> params,
 
 				//Generate a new correlated normal RV with the following formula
 				params->m_nonSelfBlocking.at(blockInd).at(PHI_INDEX) =
-						R*params->m_nonSelfBlocking.at(blockInd).at(PHI_INDEX) + sqrt(1-R*R)*m_normalRvBlockage->GetValue ();
+						R*params->m_nonSelfBlocking.at(blockInd).at(PHI_INDEX) + sqrt(1-R*R)*streams.m_normalRvBlockage->GetValue ();
 			}
 		}
 
@@ -34,6 +34,7 @@
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/net-device.h>
 #include <map>
+#include <vector>
 #include <ns3/angles.h>
 #include <ns3/net-device-container.h>
 #include <ns3/random-variable-stream.h>
@@ -41,6 +42,8 @@
 #include "ns3/mmwave-3gpp-propagation-loss-model.h"
 #include <ns3/antenna-array-model.h>
 #include "ns3/mmwave-3gpp-buildings-propagation-loss-model.h"
+#include "ns3/mmwave-channel-tensor.h"
+#include "ns3/mmwave-link-table.h"
 
 #define AOA_INDEX 0
 #define ZOA_INDEX 1
@@ -73,7 +76,7 @@ struct Params3gpp : public SimpleRefCount<Params3gpp>
 {
 	complexVector_t 		m_txW; // tx antenna weights.
 	complexVector_t 		m_rxW; // rx antenna weights.
-	complex3DVector_t  		m_channel; // channel matrix H[u][s][n].
+	ChannelTensor  		m_channel; // channel matrix H[u][s][n].
 	doubleVector_t  		m_delay; // cluster delay.
 	double2DVector_t		m_angle; //cluster angle angle[direction][n], where direction = 0(aoa), 1(zoa), 2(aod), 3(zod) in degree.
 	complexVector_t 		m_longTerm; // long term conponet.
@@ -166,6 +169,16 @@ class MmWave3gppChannel : public SpectrumPropagationLossModel
 {
 public:
 
+	/**
+	 * Algorithm used to compute the dominant eigenvector of the spatial
+	 * correlation matrices in LongTermCovMatrixBeamforming
+	 */
+	enum EigenSolverType
+	{
+		POWER_METHOD,        // 10 iterations of the power method starting from the first row of Q
+		BLOCKED_POWER_METHOD // blocked power method warm-started from the previous weights of the link
+	};
+
 	/** 
     * Constructor
     */
@@ -221,6 +234,44 @@ public:
 
 private:
 
+	/**
+	 * Random variables used to draw and update the channel realizations
+	 */
+	struct ChannelRandomStreams
+	{
+		Ptr<UniformRandomVariable> m_uniformRv;
+		Ptr<UniformRandomVariable> m_uniformRvBlockage;
+		Ptr<NormalRandomVariable> m_normalRv;
+		Ptr<NormalRandomVariable> m_normalRvBlockage;
+	};
+
+	/**
+	 * Inputs and output of the generation of a channel in Initial
+	 */
+	struct InitialChannel
+	{
+		uint32_t m_linkId;
+		Ptr<const MobilityModel> m_a;
+		Ptr<const MobilityModel> m_b;
+		Ptr<NetDevice> m_txDevice;
+		Ptr<NetDevice> m_rxDevice;
+		Ptr<AntennaArrayModel> m_txAntenna;
+		Ptr<AntennaArrayModel> m_rxAntenna;
+		uint8_t m_txAntennaNum[2];
+		uint8_t m_rxAntennaNum[2];
+		Ptr<ParamsTable> m_table;
+		Ptr<const SpectrumValue> m_psd;
+		Vector m_locUT;
+		bool m_los;
+		bool m_o2i;
+		Angles m_txAngle;
+		Angles m_rxAngle;
+		Vector m_speed;
+		double m_dis2D;
+		double m_dis3D;
+		Ptr<Params3gpp> m_params;
+	};
+
 	/**
 	 * Inherited from SpectrumPropagationLossModel, it returns the PSD at the receiver
 	 * @params the transmitted PSD
@@ -232,6 +283,17 @@ private:
 														Ptr<const MobilityModel> a,
 														Ptr<const MobilityModel> b) const;
 
+	/**
+	 * Same as DoCalcRxPowerSpectralDensity, applying the channel to a PSD owned by the caller
+	 * @params the transmitted PSD, which may be modified and returned
+	 * @params the mobility model of the transmitter
+	 * @params the mobility model of the receiver
+	 * @returns the received PSD
+	 */
+	Ptr<SpectrumValue> DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> rxPsd,
+			Ptr<const MobilityModel> a,
+			Ptr<const MobilityModel> b) const;
+
 	/**
 	 * Get the Tx and Rx info for the link
 	 */
@@ -253,12 +315,13 @@ private:
 	 * @params the relative speed between tx and rx
 	 * @params the 2D distance between tx and rx
 	 * @params the 3D distance between tx and rx
+	 * @params the random variables of the link
 	 * @returns the channel realization in a Params3gpp object
 	 */
-	Ptr<Params3gpp> GetNewChannel(Ptr<ParamsTable> table3gpp, Vector locUT, bool los, bool o2i,
-			Ptr<AntennaArrayModel> txAntenna, Ptr<AntennaArrayModel> rxAntenna,
+	Ptr<Params3gpp> GetNewChannel(const Ptr<ParamsTable> &table3gpp, Vector locUT, bool los, bool o2i,
+			const Ptr<AntennaArrayModel> &txAntenna, const Ptr<AntennaArrayModel> &rxAntenna,
 			uint8_t *txAntennaNum, uint8_t *rxAntennaNum, Angles &rxAngle, Angles &txAngle,
-			Vector speed, double dis2D, double dis3D) const;
+			Vector speed, double dis2D, double dis3D, const ChannelRandomStreams &streams) const;
 
 	/**
 	 * Update the channel realization with procedure A of TR 38.900 Sec 7.6.3.2 
@@ -271,11 +334,13 @@ private:
 	 * @params the number of rxAntenna per row
 	 * @params the rxAngle
 	 * @params the txAngle
+	 * @params the random variables of the link
 	 * @returns the channel realization in a Params3gpp object
 	 */
-	Ptr<Params3gpp> UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable> table3gpp,
+	Ptr<Params3gpp> UpdateChannel(Ptr<Params3gpp> params3gpp, const Ptr<ParamsTable> &table3gpp,
 			Ptr<AntennaArrayModel> txAntenna, Ptr<AntennaArrayModel> rxAntenna,
-			uint8_t *txAntennaNum, uint8_t *rxAntennaNum, Angles &rxAngle, Angles &txAngle) const;
+			uint8_t *txAntennaNum, uint8_t *rxAntennaNum, Angles &rxAngle, Angles &txAngle,
+			const ChannelRandomStreams &streams) const;
 
 	/**
 	 * Compute the optimal BF vector with the Power Method (Maximum Ratio Transmission method).
@@ -283,6 +348,61 @@ private:
 	 * @params the channel realizationin as a Params3gpp object
 	 */
 	void LongTermCovMatrixBeamforming (Ptr<Params3gpp> params) const;
+
+	/**
+	 * Same as above, with the scratch buffers and the eigen-solver given by the caller,
+	 * so that it can be run concurrently on different links
+	 * @params the channel realizationin as a Params3gpp object
+	 * @params the buffer for the tx spatial correlation matrix
+	 * @params the buffer for the rx spatial correlation matrix
+	 * @params the eigen-solver used with BLOCKED_POWER_METHOD
+	 */
+	void LongTermCovMatrixBeamforming (Ptr<Params3gpp> params, complexVector_t &txQ,
+			complexVector_t &rxQ, CovarianceEigenSolver &solver) const;
+
+	/**
+	 * Prepare the generation of the channel between two devices in Initial, i.e., look up
+	 * everything that involves other objects and assign its own random streams to the link
+	 * @params the mobility model of the transmitter
+	 * @params the mobility model of the receiver
+	 * @params the PSD used for the beam search
+	 * @params the vector where the channel to be generated is appended
+	 * @returns false if the channel cannot be generated in advance, e.g., it already exists
+	 */
+	bool PrepareInitialChannel (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b,
+			Ptr<const SpectrumValue> psd, std::vector<InitialChannel> &channels) const;
+
+	/**
+	 * Generate the channel realizations and (if the beam search is not used) the BF vectors
+	 * of the channels first, first + step, first + 2*step, ... This only involves objects
+	 * owned by the channels, thus several calls can be run in parallel.
+	 * @params the channels prepared by PrepareInitialChannel
+	 * @params the index of the first channel
+	 * @params the step between the channels
+	 */
+	void GenerateInitialChannels (std::vector<InitialChannel> &channels, uint32_t first, uint32_t step) const;
+
+	/**
+	 * Store a channel generated by GenerateInitialChannels and set the BF vectors of the antennas
+	 * as DoCalcRxPowerSpectralDensity does for a new channel
+	 * @params the generated channel
+	 */
+	void CommitInitialChannel (InitialChannel &channel) const;
+
+	/**
+	 * @params the identifier of a link in m_linkIndex
+	 * @returns the random variables of the link, or the shared ones if the link has not its own
+	 */
+	const ChannelRandomStreams& GetRandomStreams (uint32_t linkId) const;
+
+	/**
+	 * Compute the dominant eigenvector of a spatial correlation matrix with 10 iterations
+	 * of the power method
+	 * @params the correlation matrix, size x size, row-major
+	 * @params the size of the matrix
+	 * @returns the normalized dominant eigenvector
+	 */
+	complexVector_t PowerMethod (const complexVector_t &Q, uint16_t size) const;
 	
 	/**
 	 * Scan all sectors with predefined code book and select the one returns maximum gain.
@@ -309,6 +429,34 @@ private:
 	 */
 	Ptr<SpectrumValue> CalBeamformingGain (Ptr<const SpectrumValue> txPsd,
 												Ptr<Params3gpp> params, Vector speed) const;
+
+	/**
+	 * Compute the BF gain of each subband, i.e., the factor CalBeamformingGain applies to the txPsd
+	 * @params the tx PSD, the gain of the subbands with zero power is not computed.
+	 *         If 0, the gain of all the subbands is computed
+	 * @params the channel realizationin as a Params3gpp object
+	 * @params the relative speed between UE and eNB
+	 * @params the number of subbands
+	 * @params the vector where the gain of each subband is stored
+	 */
+	void CalSubbandGain (Ptr<const SpectrumValue> txPsd, Ptr<Params3gpp> params, Vector speed,
+			uint32_t numBands, doubleVector_t &gain) const;
+
+	/**
+	 * Get the LOS/NLOS and O2I condition of the link from the pathloss model
+	 * @params the mobility model of the transmitter
+	 * @params the mobility model of the receiver
+	 * @params set to true if the link is in LOS
+	 * @params set to true if the receiver is indoor
+	 */
+	void GetChannelCondition (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b,
+			bool &los, bool &o2i) const;
+
+	/**
+	 * Drop the cached spectral gains of both directions of a link
+	 * @params the identifier of the link in m_linkIndex
+	 */
+	void InvalidateSpectralGain (uint32_t linkId) const;
 	
 	/**
 	 * Returns the bandwidth used in a scenario
@@ -318,7 +466,9 @@ private:
 
 	/**
 	 * Returns the ParamsTable with the parameters of TR 38.900 Table 7.5-6
-	 * that apply to a certain scenario
+	 * that apply to a certain scenario. The tables are cached, and the heights and the
+	 * distance are part of the key only for the scenarios in which they are used.
+	 * The returned table is shared and must not be modified.
 	 * @params the los condition
 	 * @params the o2i condition
 	 * @params the BS height (i.e., eNB)
@@ -329,6 +479,19 @@ private:
 	Ptr<ParamsTable> Get3gppTable (bool los, bool o2i,
 										double hBS, double hUT, double distance2D) const;
 
+	/**
+	 * Compute a new ParamsTable with the parameters of TR 38.900 Table 7.5-6
+	 * that apply to a certain scenario
+	 * @params the los condition
+	 * @params the o2i condition
+	 * @params the BS height (i.e., eNB)
+	 * @params the UT height (i.e., UE)
+	 * @params the 2D distance
+	 * @return the ParamsTable structure
+	 */
+	Ptr<ParamsTable> Calc3gppTable (bool los, bool o2i,
+										double hBS, double hUT, double distance2D) const;
+
 	/**
 	 * Delete the m_channel entry associated to the Params3gpp object of pair (a,b)
 	 * but keep the other parameters, so that the spatial consistency procedure can be used
@@ -342,24 +505,48 @@ private:
 	 * @params the channel realizationin as a Params3gpp object
 	 * @params cluster azimuth angle of arrival
 	 * @params cluster zenith angle of arrival
+	 * @params the random variables of the link
 	 */
 	doubleVector_t CalAttenuationOfBlockage(Ptr<Params3gpp> params,
-			doubleVector_t clusterAOA, doubleVector_t clusterZOA) const;
+			doubleVector_t clusterAOA, doubleVector_t clusterZOA, const ChannelRandomStreams &streams) const;
 
-	mutable std::map< key_t, int > m_connectedPair;
-	mutable std::map< key_t, Ptr<Params3gpp> > m_channelMap;
+	/**
+	 * Per-subband gain of a link, which is reused as long as the channel realization,
+	 * the propagation condition, the relative speed and (if the devices move) the
+	 * simulation time do not change
+	 */
+	struct SpectralGain
+	{
+		Ptr<AntennaArrayModel> m_txAntenna;
+		Ptr<AntennaArrayModel> m_rxAntenna;
+		Ptr<const SpectrumModel> m_spectrumModel;
+		bool m_los;
+		bool m_o2i;
+		Vector m_speed;
+		Time m_time;
+		doubleVector_t m_gain;
+	};
+
+	mutable LinkIndex m_linkIndex;
+	mutable LinkTable<int> m_connectedPair;
+	mutable LinkTable< Ptr<Params3gpp> > m_channelMap;
+	mutable LinkTable<SpectralGain> m_spectralGainMap;
+	mutable LinkTable<ChannelRandomStreams> m_linkStreams;
 
 	Ptr<UniformRandomVariable> m_uniformRv;
 	Ptr<UniformRandomVariable> m_uniformRvBlockage;
 
 	Ptr<NormalRandomVariable> m_normalRv; //there is a bug in the NormalRandomVariable::GetValue() function.
 	Ptr<NormalRandomVariable> m_normalRvBlockage;
-
+	ChannelRandomStreams m_sharedStreams; // the random variables above, used by the links without their own
 
 	Ptr<ExponentialRandomVariable> m_expRv;
 	Ptr<MmWavePhyMacCommon> m_phyMacConfig;
 	Ptr<PropagationLossModel> m_3gppPathloss;
 	Ptr<ParamsTable> m_table3gpp;
+	double m_tableResolution; // resolution of the heights and of the distance in the key of m_tableCache
+	// (los, o2i, hBS, hUT, distance2D) -> table, the values not used by the scenario are set to 0
+	mutable std::map< std::tuple<bool, bool, double, double, double>, Ptr<ParamsTable> > m_tableCache;
 	Time m_updatePeriod;
 	bool m_cellScan;
 	bool m_blockage;
@@ -368,6 +555,12 @@ private:
 	std::string m_scenario;
 	double m_blockerSpeed;
 	bool m_forceInitialBfComputation;
+	bool m_spectralGainCache;
+	uint32_t m_initialThreads;
+	EigenSolverType m_eigenSolverType;
+	mutable CovarianceEigenSolver m_eigenSolver;
+	mutable complexVector_t m_txQ; // scratch buffers for the spatial correlation matrices
+	mutable complexVector_t m_rxQ;
 
 };
 
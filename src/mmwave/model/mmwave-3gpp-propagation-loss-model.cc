@@ -674,7 +674,14 @@ MmWave3gppPropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel
 		NS_FATAL_ERROR ("Unknown channel condition");
 	}
 
-	if(m_shadowingEnabled)
+	if(m_shadowingEnabled && (*it).second.m_shadowing > -1e5
+			&& uePos.x == (*it).second.m_position.x && uePos.y == (*it).second.m_position.y)
+	{
+		// the UE did not move since the last update, so R = 1 and the
+		// shadowing is unchanged: skip the draw and the map update
+		lossDb += (*it).second.m_shadowing;
+	}
+	else if(m_shadowingEnabled)
 	{
 		channelCondition cond;
 		cond = (*it).second;
@@ -514,12 +514,22 @@ MmWaveAmc::CreateCqiFeedbackWbTdma (const SpectrumValue& sinr, uint8_t numSym, u
 		}
 		sinrAvg /= chunkId;
 
+		// the MI of the whole band only depends on the modulation order, so it is
+		// evaluated at most once per modulation, and only the BLER is evaluated per MCS
+		double mi[3];
+		bool miValid[3] = {false, false, false};
 		mcs = 0;
 		MmWaveTbStats_t tbStats;
+		MmWaveHarqProcessInfoList_t harqInfoList;
 		while (mcs <= 28)
 		{
-			MmWaveHarqProcessInfoList_t harqInfoList;
-			tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (sinr, chunkMap, tbSize, mcs, harqInfoList);
+			uint8_t modulation = (mcs <= MMWAVE_MI_QPSK_MAX_ID) ? 0 : ((mcs <= MMWAVE_MI_16QAM_MAX_ID) ? 1 : 2);
+			if (!miValid[modulation])
+			{
+				mi[modulation] = MmWaveMiErrorModel::Mib (sinr, chunkMap, mcs);
+				miValid[modulation] = true;
+			}
+			tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (mi[modulation], tbSize, mcs, harqInfoList);
 			if (tbStats.tbler > 0.1)
 			{
 				break;
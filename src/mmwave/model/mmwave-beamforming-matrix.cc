@@ -0,0 +1,277 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+
+#include "mmwave-beamforming-matrix.h"
+#include <ns3/log.h>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ns3{
+
+NS_LOG_COMPONENT_DEFINE ("BeamformingMatrixFile");
+
+const char BeamformingMatrixFile::MAGIC[8] = {'M', 'M', 'W', 'B', 'F', 'M', 'X', '1'};
+
+BeamformingMatrixFile::BeamformingMatrixFile ()
+	:m_numInstance (0),
+	 m_numRows (0),
+	 m_numColumns (0),
+	 m_complex (false),
+	 m_data (0),
+	 m_mapping (0),
+	 m_mappingSize (0)
+{
+}
+
+BeamformingMatrixFile::~BeamformingMatrixFile ()
+{
+	Clear ();
+}
+
+void
+BeamformingMatrixFile::Clear ()
+{
+	if (m_mapping != 0)
+	{
+		munmap (m_mapping, m_mappingSize);
+		m_mapping = 0;
+		m_mappingSize = 0;
+	}
+	m_textData.clear ();
+	m_numInstance = 0;
+	m_numRows = 0;
+	m_numColumns = 0;
+	m_data = 0;
+}
+
+std::complex<double>
+BeamformingMatrixFile::ParseComplex (std::string strCmplx)
+{
+    double re = 0.00;
+    double im = 0.00;
+    size_t findj = 0;
+    std::complex<double> out_complex;
+
+    findj = strCmplx.find("i");
+    if( findj == std::string::npos )
+    {
+        im = -1.00;
+    }
+    else
+    {
+        strCmplx[findj] = '\0';
+    }
+    if( ( strCmplx.find("+",1) == std::string::npos && strCmplx.find("-",1) == std::string::npos ) && im != -1 )
+    {
+        /* No real value */
+        re = -1.00;
+    }
+    std::stringstream stream( strCmplx );
+    if( re != -1.00 )
+    {
+        stream>>re;
+    }
+    else
+    {
+        re = 0;
+    }
+    if( im != -1 )
+    {
+        stream>>im;
+    }
+    else
+    {
+        im = 0.00;
+    }
+    out_complex = std::complex<double>(re,im);
+    return out_complex;
+}
+
+bool
+BeamformingMatrixFile::Load (const std::string &filename, uint32_t rowsPerInstance, bool complex)
+{
+	NS_LOG_FUNCTION (this << filename << rowsPerInstance << complex);
+	Clear ();
+
+	int fd = open (filename.c_str (), O_RDONLY);
+	if (fd < 0)
+	{
+		NS_LOG_INFO ("Cannot open " << filename);
+		return false;
+	}
+	struct stat st;
+	Header header;
+	bool binary = fstat (fd, &st) == 0
+			&& static_cast<std::size_t> (st.st_size) >= sizeof (Header)
+			&& pread (fd, &header, sizeof (Header), 0) == sizeof (Header)
+			&& std::memcmp (header.m_magic, MAGIC, sizeof (MAGIC)) == 0;
+
+	bool ok;
+	if (binary)
+	{
+		ok = LoadBinary (fd, st.st_size, rowsPerInstance, complex);
+	}
+	else
+	{
+		ok = LoadText (filename, rowsPerInstance, complex);
+	}
+	close (fd);
+	return ok;
+}
+
+bool
+BeamformingMatrixFile::LoadBinary (int fd, std::size_t size, uint32_t rowsPerInstance, bool complex)
+{
+	void *mapping = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		NS_LOG_INFO ("mmap failed");
+		return false;
+	}
+
+	const Header *header = static_cast<const Header*> (mapping);
+	std::size_t numValues = static_cast<std::size_t> (header->m_numInstance) * header->m_numRows
+			* header->m_numColumns * (header->m_complex ? 2 : 1);
+	if (header->m_byteOrder != BYTE_ORDER_MARK
+			|| (header->m_complex != 0) != complex
+			|| header->m_numRows != rowsPerInstance
+			|| size < sizeof (Header) + numValues * sizeof (double))
+	{
+		NS_LOG_INFO ("Malformed binary matrix file");
+		munmap (mapping, size);
+		return false;
+	}
+
+	m_mapping = mapping;
+	m_mappingSize = size;
+	m_numInstance = header->m_numInstance;
+	m_numRows = header->m_numRows;
+	m_numColumns = header->m_numColumns;
+	m_complex = complex;
+	m_data = reinterpret_cast<const double*> (static_cast<const char*> (mapping) + sizeof (Header));
+	NS_LOG_INFO ("Mapped [instance:" << m_numInstance << "][row:" << m_numRows << "][column:" << m_numColumns << "]");
+	return true;
+}
+
+bool
+BeamformingMatrixFile::LoadText (const std::string &filename, uint32_t rowsPerInstance, bool complex)
+{
+	std::ifstream file (filename.c_str (), std::ifstream::in);
+	if (!file.good () || rowsPerInstance == 0)
+	{
+		return false;
+	}
+
+	std::string line;
+	std::string token;
+	uint32_t numLines = 0;
+	uint32_t numColumns = 0;
+	while (std::getline (file, line)) //Parse each line of the file
+	{
+		if (line.find_first_not_of (" \t\r") == std::string::npos)
+		{
+			continue;
+		}
+		std::size_t offset = m_textData.size ();
+		std::istringstream stream (line);
+		while (getline (stream, token, ',')) //Parse each comma separated string in a line
+		{
+			if (complex)
+			{
+				std::complex<double> value = ParseComplex (token);
+				m_textData.push_back (value.real ());
+				m_textData.push_back (value.imag ());
+			}
+			else
+			{
+				double value = 0.00;
+				std::stringstream valueStream (token);
+				valueStream >> value;
+				m_textData.push_back (value);
+			}
+		}
+
+		uint32_t columns = (m_textData.size () - offset) / (complex ? 2 : 1);
+		if (numLines == 0)
+		{
+			numColumns = columns;
+		}
+		else if (columns != numColumns)
+		{
+			NS_LOG_INFO ("Line " << numLines << " has " << columns << " values instead of " << numColumns);
+			Clear ();
+			return false;
+		}
+		numLines++;
+	}
+
+	// an incomplete instance at the end of the file is ignored
+	m_numInstance = numLines / rowsPerInstance;
+	m_numRows = rowsPerInstance;
+	m_numColumns = numColumns;
+	m_complex = complex;
+	m_textData.resize (static_cast<std::size_t> (m_numInstance) * m_numRows * m_numColumns * (complex ? 2 : 1));
+	m_data = m_textData.empty () ? 0 : &m_textData[0];
+	NS_LOG_INFO ("Parsed [instance:" << m_numInstance << "][row:" << m_numRows << "][column:" << m_numColumns << "]");
+	return true;
+}
+
+bool
+BeamformingMatrixFile::ConvertTextFile (const std::string &textFile, const std::string &binaryFile,
+		uint32_t rowsPerInstance, bool complex)
+{
+	NS_LOG_FUNCTION (textFile << binaryFile << rowsPerInstance << complex);
+	BeamformingMatrixFile matrix;
+	if (!matrix.LoadText (textFile, rowsPerInstance, complex))
+	{
+		return false;
+	}
+
+	Header header;
+	std::memcpy (header.m_magic, MAGIC, sizeof (MAGIC));
+	header.m_byteOrder = BYTE_ORDER_MARK;
+	header.m_complex = complex;
+	header.m_numInstance = matrix.m_numInstance;
+	header.m_numRows = matrix.m_numRows;
+	header.m_numColumns = matrix.m_numColumns;
+	header.m_reserved = 0;
+
+	std::ofstream file (binaryFile.c_str (), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	file.write (reinterpret_cast<const char*> (&header), sizeof (Header));
+	if (!matrix.m_textData.empty ())
+	{
+		file.write (reinterpret_cast<const char*> (&matrix.m_textData[0]),
+				matrix.m_textData.size () * sizeof (double));
+	}
+	file.close ();
+	return !file.fail ();
+}
+
+}  //namespace ns3
@@ -0,0 +1,177 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+
+#ifndef MMWAVE_BEAMFORMING_MATRIX_H_
+#define MMWAVE_BEAMFORMING_MATRIX_H_
+
+#include <complex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+namespace ns3{
+
+/**
+ * \brief Read-only store of one of the matrix files used by MmWaveBeamforming
+ * (antenna weights, spatial signatures or small scale fading).
+ *
+ * A file holds a number of instances, each made of the same number of rows of
+ * real or complex values. It is read either from the original text format (one
+ * row per line, comma-separated values, complex values written as a+bi) or from
+ * a binary file produced by ConvertTextFile, which is memory mapped and accessed
+ * in place.
+ *
+ * Binary layout (native byte order): a 32 byte header with the magic "MMWBFMX1",
+ * a byte order mark, the value type, the number of instances, rows per instance
+ * and columns, followed by all the rows as arrays of doubles (complex values are
+ * stored as interleaved real and imaginary parts).
+ */
+class BeamformingMatrixFile
+{
+public:
+	BeamformingMatrixFile ();
+	~BeamformingMatrixFile ();
+
+	/**
+	 * Load a matrix file, memory mapping it if it is in the binary format and
+	 * parsing it otherwise. Any previously loaded matrix is released.
+	 * @params the name of the file
+	 * @params the number of rows of each instance
+	 * @params true if the values are complex
+	 * @returns false if the file could not be opened or does not match the expected shape
+	 */
+	bool Load (const std::string &filename, uint32_t rowsPerInstance, bool complex);
+
+	/**
+	 * Release the loaded matrix
+	 */
+	void Clear ();
+
+	bool IsLoaded () const
+	{
+		return m_numInstance > 0;
+	}
+
+	bool IsMapped () const
+	{
+		return m_mapping != 0;
+	}
+
+	uint32_t GetNumInstance () const
+	{
+		return m_numInstance;
+	}
+	uint32_t GetNumRows () const
+	{
+		return m_numRows;
+	}
+	uint32_t GetNumColumns () const
+	{
+		return m_numColumns;
+	}
+
+	/**
+	 * @params the instance
+	 * @params the row within the instance
+	 * @returns a pointer to the GetNumColumns complex values of the row
+	 */
+	const std::complex<double>* GetComplexRow (uint32_t instance, uint32_t row) const
+	{
+		return reinterpret_cast<const std::complex<double>*> (m_data + RowOffset (instance, row));
+	}
+
+	/**
+	 * @params the instance
+	 * @params the row within the instance
+	 * @returns a pointer to the GetNumColumns real values of the row
+	 */
+	const double* GetRealRow (uint32_t instance, uint32_t row) const
+	{
+		return m_data + RowOffset (instance, row);
+	}
+
+	/**
+	 * Convert a text matrix file to the binary format
+	 * @params the name of the text file
+	 * @params the name of the binary file to be written
+	 * @params the number of rows of each instance
+	 * @params true if the values are complex
+	 * @returns false if the text file could not be read or the binary file written
+	 */
+	static bool ConvertTextFile (const std::string &textFile, const std::string &binaryFile,
+			uint32_t rowsPerInstance, bool complex);
+
+	/**
+	 * \brief Get complex number from a string
+	 * \param strCmplx a string store complex bumber i.e. 3+2i,
+	 * \return a complex number of the string
+	 */
+	static std::complex<double> ParseComplex (std::string strCmplx);
+
+private:
+	struct Header
+	{
+		char m_magic[8];
+		uint32_t m_byteOrder;
+		uint32_t m_complex;
+		uint32_t m_numInstance;
+		uint32_t m_numRows;
+		uint32_t m_numColumns;
+		uint32_t m_reserved;
+	};
+
+	BeamformingMatrixFile (const BeamformingMatrixFile &);
+	BeamformingMatrixFile& operator= (const BeamformingMatrixFile &);
+
+	std::size_t RowOffset (uint32_t instance, uint32_t row) const
+	{
+		return ((static_cast<std::size_t> (instance) * m_numRows + row) * m_numColumns) * (m_complex ? 2 : 1);
+	}
+
+	bool LoadBinary (int fd, std::size_t size, uint32_t rowsPerInstance, bool complex);
+	bool LoadText (const std::string &filename, uint32_t rowsPerInstance, bool complex);
+
+	static const char MAGIC[8];
+	static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	uint32_t m_numInstance;
+	uint32_t m_numRows;
+	uint32_t m_numColumns;
+	bool m_complex;
+	const double *m_data;
+
+	// memory mapped binary file
+	void *m_mapping;
+	std::size_t m_mappingSize;
+
+	// storage of the values parsed from a text file
+	std::vector<double> m_textData;
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_BEAMFORMING_MATRIX_H_ */
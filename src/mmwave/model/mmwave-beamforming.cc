@@ -42,6 +42,9 @@
 #include <algorithm>
 #include <ns3/double.h>
 #include <ns3/boolean.h>
+#include <ns3/string.h>
+#include <sstream>
+#include <sys/stat.h>
 
 namespace ns3{
 
@@ -53,11 +56,8 @@ NS_OBJECT_ENSURE_REGISTERED (MmWaveBeamforming);
 // period of updating channel matrix
 static const uint32_t g_numInstance = 100;
 
-complex2DVector_t g_enbAntennaInstance; //100 instance of txW
-complex2DVector_t g_ueAntennaInstance; //100 instance of rxW
-complex3DVector_t g_enbSpatialInstance; //this stores 100 instance of txE
-complex3DVector_t g_ueSpatialInstance; //this stores 100 instance of rxE
-double2DVector_t g_smallScaleFadingInstance;    //this stores 100 instance of sigma vector
+// matrix files already loaded, indexed by directory
+static std::map<std::string, Ptr<BeamformingMatrixSet> > g_matrixSets;
 
 /*
  * The delay spread and Doppler shift is not based on measurement data at this time
@@ -79,8 +79,6 @@ MmWaveBeamforming::MmWaveBeamforming (uint32_t enbAntenna, uint32_t ueAntenna)
 	m_ueSpeed (0.0),
 	m_update(true)
 {
-	if (g_smallScaleFadingInstance.empty ())
-	LoadFile();
 	m_uniformRV = CreateObject<UniformRandomVariable> ();
 	Initialize();
 }
@@ -111,6 +109,13 @@ MmWaveBeamforming::GetTypeId (void)
 									DoubleValue (0.0),
 									MakeDoubleAccessor (&MmWaveBeamforming::m_ueSpeed),
 									MakeDoubleChecker<double> ())
+	 .AddAttribute ("MatrixDirectory",
+									"Directory of the beamforming matrix files (in the text format or in the binary format "
+									"produced by the mmwave-beamforming-matrix-converter example). "
+									"If empty, the BeamFormingMatrix directory of the module sources is used",
+									StringValue (""),
+									MakeStringAccessor (&MmWaveBeamforming::m_matrixDirectory),
+									MakeStringChecker ())
 	;
   	return tid;
 }
@@ -138,215 +143,80 @@ MmWaveBeamforming::GetConfigurationParameters (void) const
 	return m_phyMacConfig;
 }
 
-std::complex<double>
-MmWaveBeamforming::ParseComplex (std::string strCmplx)
-{
-    double re = 0.00;
-    double im = 0.00;
-    size_t findj = 0;
-    std::complex<double> out_complex;
-
-    findj = strCmplx.find("i");
-    if( findj == std::string::npos )
-    {
-        im = -1.00;
-    }
-    else
-    {
-        strCmplx[findj] = '\0';
-    }
-    if( ( strCmplx.find("+",1) == std::string::npos && strCmplx.find("-",1) == std::string::npos ) && im != -1 )
-    {
-        /* No real value */
-        re = -1.00;
-    }
-    std::stringstream stream( strCmplx );
-    if( re != -1.00 )
-    {
-        stream>>re;
-    }
-    else
-    {
-        re = 0;
-    }
-    if( im != -1 )
-    {
-        stream>>im;
-    }
-    else
-    {
-        im = 0.00;
-    }
-    //  std::cout<<" ---  "<<re<<"  "<<im<<std::endl;
-    out_complex = std::complex<double>(re,im);
-    return out_complex;
-}
-
 void
 MmWaveBeamforming::LoadFile()
 {
-	LoadSmallScaleFading ();
-	LoadEnbAntenna ();
-	LoadUeAntenna ();
-	LoadEnbSpatialSignature ();
-	LoadUeSpatialSignature ();
+	GetMatrices ();
 }
 
-
-void
-MmWaveBeamforming::LoadSmallScaleFading ()
+std::string
+MmWaveBeamforming::GetMatrixDirectory () const
 {
-	std::string filename = "src/mmwave/model/BeamFormingMatrix/SmallScaleFading.txt";
-	NS_LOG_FUNCTION (this << "Loading SmallScaleFading file " << filename);
-	std::ifstream singlefile;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " SmallScaleFading file not found");
-    std::string line;
-    std::string token;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	doubleVector_t path;
-        std::istringstream stream(line);
-        while( getline(stream,token,',') ) //Parse each comma separated string in a line
-        {
-            double sigma = 0.00;
-            std::stringstream stream( token );
-            stream>>sigma;
-        	path.push_back(sigma);
-		}
-        g_smallScaleFadingInstance.push_back (path);
+	std::string directory = m_matrixDirectory;
+	if (directory.empty ())
+	{
+#ifdef MMWAVE_BEAMFORMING_MATRIX_DIR
+		directory = MMWAVE_BEAMFORMING_MATRIX_DIR;
+#else
+		directory = "src/mmwave/model/BeamFormingMatrix";
+#endif
 	}
-	NS_LOG_INFO ("SmallScaleFading[instance:"<<g_smallScaleFadingInstance.size()<<"][path:"<<g_smallScaleFadingInstance[0].size()<<"]");
-}
 
-void
-MmWaveBeamforming::LoadEnbAntenna ()
-{
-	std::string filename = "src/mmwave/model/BeamFormingMatrix/TxAntenna.txt";
-	NS_LOG_FUNCTION (this << "Loading TxAntenna file " << filename);
-	std::ifstream singlefile;
-	std::complex<double> complexVar;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " TxAntenna file not found");
-    std::string line;
-    std::string token;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	complexVector_t txAntenna;
-        std::istringstream stream(line);
-        while( getline(stream,token,',') ) //Parse each comma separated string in a line
-        {
-        	complexVar = ParseComplex(token);
-		    txAntenna.push_back(complexVar);
-		}
-		g_enbAntennaInstance.push_back(txAntenna);
+	std::ostringstream configDirectory;
+	configDirectory << directory << "/" << m_enbAntennaSize << "x" << m_ueAntennaSize;
+	struct stat st;
+	if (stat (configDirectory.str ().c_str (), &st) == 0 && S_ISDIR (st.st_mode))
+	{
+		return configDirectory.str ();
 	}
-    NS_LOG_INFO ("TxAntenna[instance:"<<g_enbAntennaInstance.size()<<"][antennaSize:"<<g_enbAntennaInstance[0].size()<<"]");
+	return directory;
 }
 
-
-void
-MmWaveBeamforming::LoadUeAntenna ()
+Ptr<BeamformingMatrixSet>
+MmWaveBeamforming::GetMatrices ()
 {
-	std::string filename = "src/mmwave/model/BeamFormingMatrix/RxAntenna.txt";
-	NS_LOG_FUNCTION (this << "Loading RxAntenna file " << filename);
-	std::ifstream singlefile;
-	std::complex<double> complexVar;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " RxAntenna file not found");
-
-    std::string line;
-    std::string token;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	complexVector_t rxAntenna;
-		std::istringstream stream(line);
-		while( getline(stream,token,',') ) //Parse each comma separated string in a line
-		{
-			complexVar = ParseComplex(token);
-		    rxAntenna.push_back(complexVar);
-		}
-		g_ueAntennaInstance.push_back(rxAntenna);
+	if (m_matrices != 0)
+	{
+		return m_matrices;
 	}
-    NS_LOG_INFO ("RxAntenna[instance:"<<g_ueAntennaInstance.size()<<"][antennaSize:"<<g_ueAntennaInstance[0].size()<<"]");
-}
 
-void
-MmWaveBeamforming::LoadEnbSpatialSignature ()
-{
-	std::string filename = "src/mmwave/model/BeamFormingMatrix/TxSpatialSigniture.txt";
-	NS_LOG_FUNCTION (this << "Loading TxspatialSigniture file " << filename);
-	std::ifstream singlefile;
-	std::string line;
-	std::string token;
-
-	uint16_t counter = 1;
-	std::complex<double> complexVar;
-	complex2DVector_t txSpatialMatrix;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_ASSERT_MSG (singlefile.good (), "TxSpatialSigniture file not found");
-
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	complexVector_t txSpatialElement;
-		std::istringstream stream(line);
-		while( getline(stream,token,',') ) //Parse each comma separated string in a line
-		{
-			complexVar = ParseComplex(token);
-			txSpatialElement.push_back(complexVar);
-		}
-		txSpatialMatrix.push_back(txSpatialElement);
-		if(counter % m_pathNum ==0 )
-		{
-			g_enbSpatialInstance.push_back(txSpatialMatrix);
-			txSpatialMatrix.clear();
-		}
-	    counter++;
-    }
-    NS_LOG_INFO ("TxspatialSigniture[instance:"<<g_enbSpatialInstance.size()<<"][path:"<<g_enbSpatialInstance[0].size()<<"][antennaSize:"<<g_enbSpatialInstance[0][0].size()<<"]");
+	std::string directory = GetMatrixDirectory ();
+	std::map<std::string, Ptr<BeamformingMatrixSet> >::iterator it = g_matrixSets.find (directory);
+	if (it != g_matrixSets.end ())
+	{
+		m_matrices = it->second;
+		return m_matrices;
+	}
+
+	NS_LOG_FUNCTION (this << "Loading beamforming matrices from " << directory);
+	Ptr<BeamformingMatrixSet> matrices = Create<BeamformingMatrixSet> ();
+	LoadMatrix (matrices->m_smallScaleFading, directory, "SmallScaleFading", 1, false);
+	LoadMatrix (matrices->m_enbAntenna, directory, "TxAntenna", 1, true);
+	LoadMatrix (matrices->m_ueAntenna, directory, "RxAntenna", 1, true);
+	LoadMatrix (matrices->m_enbSpatial, directory, "TxSpatialSigniture", m_pathNum, true);
+	LoadMatrix (matrices->m_ueSpatial, directory, "RxSpatialSigniture", m_pathNum, true);
+	g_matrixSets[directory] = matrices;
+	m_matrices = matrices;
+	return m_matrices;
 }
 
 void
-MmWaveBeamforming::LoadUeSpatialSignature ()
+MmWaveBeamforming::LoadMatrix (BeamformingMatrixFile &matrix, std::string directory, std::string name,
+		uint32_t rowsPerInstance, bool complex) const
 {
-	std::string strFilename = "src/mmwave/model/BeamFormingMatrix/RxSpatialSigniture.txt";
-	NS_LOG_FUNCTION (this << "Loading RxspatialSigniture file " << strFilename);
-	std::ifstream singlefile;
-	std::complex<double> complexVar;
-	complex2DVector_t rxSpatialMatrix;
-	singlefile.open (strFilename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << strFilename);
-	NS_ASSERT_MSG (singlefile.good (), " RxSpatialSigniture file not found");
-
-	std::string line;
-	std::string token;
-	int counter = 1;
-	while (std::getline(singlefile, line) ) //Parse each line of the file
+	std::string filename = directory + "/" + name + ".bin";
+	if (!matrix.Load (filename, rowsPerInstance, complex))
 	{
-		 complexVector_t rxSpatialElement;
-	     std::istringstream stream(line);
-	     while (getline(stream,token,',') ) //Parse each comma separated string in a line
-	     {
-	    	 complexVar = ParseComplex (token);
-	    	 rxSpatialElement.push_back (complexVar);
-	     }
-	     rxSpatialMatrix.push_back (rxSpatialElement);
-	     if (counter % m_pathNum == 0)
-	     {
-		   	 g_ueSpatialInstance.push_back (rxSpatialMatrix);
-		   	 rxSpatialMatrix.clear ();
-		 }
-	     counter++;
+		filename = directory + "/" + name + ".txt";
+		if (!matrix.Load (filename, rowsPerInstance, complex))
+		{
+			NS_FATAL_ERROR (name << " file not found in " << directory);
+		}
 	}
-	NS_LOG_INFO ("RxspatialSigniture[instance:"<<g_ueSpatialInstance.size()<<"][path:"<<g_ueSpatialInstance[0].size()<<"][antennaSize:"<<g_ueSpatialInstance[0][0].size()<<"]");
+	NS_ABORT_MSG_IF (matrix.GetNumInstance () < g_numInstance,
+			filename << " has " << matrix.GetNumInstance () << " instances instead of " << g_numInstance);
+	NS_LOG_INFO (name << "[instance:" << matrix.GetNumInstance () << "][row:" << matrix.GetNumRows ()
+			<< "][column:" << matrix.GetNumColumns () << "]" << (matrix.IsMapped () ? " mapped" : ""));
 }
 
 
@@ -404,23 +274,32 @@ MmWaveBeamforming::Initial(NetDeviceContainer ueDevices, NetDeviceContainer enbD
 void
 MmWaveBeamforming::SetChannelMatrix (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice)
 {
-	key_t key = std::make_pair(ueDevice,enbDevice);
+	uint32_t linkId = m_linkIndex.GetLinkId (ueDevice, enbDevice);
 	int randomInstance = m_uniformRV->GetValue (0, g_numInstance-1);
 	NS_LOG_UNCOND ("************* UPDATING CHANNEL MATRIX (instance " << randomInstance << ") *************");
 
+	Ptr<BeamformingMatrixSet> matrices = GetMatrices ();
 	Ptr<BeamformingParams> bfParams = Create<BeamformingParams> ();
-	bfParams->m_enbW = g_enbAntennaInstance.at (randomInstance);
-	bfParams->m_ueW = g_ueAntennaInstance.at (randomInstance);
-	bfParams->m_channelMatrix.m_enbSpatialMatrix = g_enbSpatialInstance.at (randomInstance);
-	bfParams->m_channelMatrix.m_ueSpatialMatrix = g_ueSpatialInstance.at (randomInstance);
-	bfParams->m_channelMatrix.m_powerFraction = g_smallScaleFadingInstance.at (randomInstance);
-	bfParams->m_beam = GetLongTermFading (bfParams);
-	std::map< key_t, Ptr<BeamformingParams> >::iterator iter = m_channelMatrixMap.find(key);
-	if (iter != m_channelMatrixMap.end ())
+	const std::complex<double> *enbW = matrices->m_enbAntenna.GetComplexRow (randomInstance, 0);
+	bfParams->m_enbW.assign (enbW, enbW + matrices->m_enbAntenna.GetNumColumns ());
+	const std::complex<double> *ueW = matrices->m_ueAntenna.GetComplexRow (randomInstance, 0);
+	bfParams->m_ueW.assign (ueW, ueW + matrices->m_ueAntenna.GetNumColumns ());
+	complex2DVector_t &enbSpatialMatrix = bfParams->m_channelMatrix.m_enbSpatialMatrix;
+	enbSpatialMatrix.resize (m_pathNum);
+	complex2DVector_t &ueSpatialMatrix = bfParams->m_channelMatrix.m_ueSpatialMatrix;
+	ueSpatialMatrix.resize (m_pathNum);
+	for (uint32_t pathIndex = 0; pathIndex < m_pathNum; pathIndex++)
 	{
-		m_channelMatrixMap.erase (iter);
+		const std::complex<double> *enbE = matrices->m_enbSpatial.GetComplexRow (randomInstance, pathIndex);
+		enbSpatialMatrix[pathIndex].assign (enbE, enbE + matrices->m_enbSpatial.GetNumColumns ());
+		const std::complex<double> *ueE = matrices->m_ueSpatial.GetComplexRow (randomInstance, pathIndex);
+		ueSpatialMatrix[pathIndex].assign (ueE, ueE + matrices->m_ueSpatial.GetNumColumns ());
 	}
-	m_channelMatrixMap.insert(std::make_pair(key,bfParams));
+	const double *powerFraction = matrices->m_smallScaleFading.GetRealRow (randomInstance, 0);
+	bfParams->m_channelMatrix.m_powerFraction.assign (powerFraction,
+			powerFraction + matrices->m_smallScaleFading.GetNumColumns ());
+	bfParams->m_beam = GetLongTermFading (bfParams);
+	m_channelMatrixMap[linkId] = bfParams;
 	//update channel matrix periodically
 	//Simulator::Schedule (Seconds (m_longTermUpdatePeriod), &MmWaveBeamforming::SetChannelMatrix,this,ueDevice,enbDevice);
 }
@@ -428,10 +307,9 @@ MmWaveBeamforming::SetChannelMatrix (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enb
 void
 MmWaveBeamforming::SetBeamformingVector (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice)
 {
-	key_t key = std::make_pair(ueDevice,enbDevice);
-	std::map< key_t, Ptr<BeamformingParams> >::iterator it = m_channelMatrixMap.find(key);
-	NS_ASSERT_MSG (it != m_channelMatrixMap.end (), "could not find");
-	Ptr<BeamformingParams> bfParams = it->second;
+	Ptr<BeamformingParams> *it = m_channelMatrixMap.Find (m_linkIndex.FindLinkId (ueDevice, enbDevice));
+	NS_ASSERT_MSG (it != 0, "could not find");
+	Ptr<BeamformingParams> bfParams = *it;
 
 	antennaPair antennaArrays = GetUeEnbAntennaPair(ueDevice, enbDevice);
 	Ptr<AntennaArrayModel> enbAntennaArray = antennaArrays.second;
@@ -547,32 +425,37 @@ Ptr<SpectrumValue>
 MmWaveBeamforming::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 												Ptr<const MobilityModel> a,
 												Ptr<const MobilityModel> b) const
+{
+	return DoCalcRxPowerSpectralDensityInPlace (Copy (txPsd), a, b);
+}
+
+Ptr<SpectrumValue>
+MmWaveBeamforming::DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> rxPsd,
+												Ptr<const MobilityModel> a,
+												Ptr<const MobilityModel> b) const
 {
 	bool downlink;
 	Ptr<NetDevice> enbDevice, ueDevice;
 
 	Ptr<NetDevice> txDevice = a->GetObject<Node> ()->GetDevice (0);
 	Ptr<NetDevice> rxDevice = b->GetObject<Node> ()->GetDevice (0);
-	Ptr<SpectrumValue> rxPsd = Copy (txPsd);
-	key_t dlkey = std::make_pair(rxDevice,txDevice);
-	key_t ulkey = std::make_pair(txDevice,rxDevice);
-
-	std::map< key_t, Ptr<BeamformingParams> >::iterator it;
-	if (m_channelMatrixMap.find(dlkey) != m_channelMatrixMap.end ())
+	// the matrices are stored for the (ue, enb) link, i.e., (rx, tx) in downlink
+	uint32_t dlLinkId = m_linkIndex.FindLinkId (rxDevice, txDevice);
+	Ptr<BeamformingParams> *it = 0;
+	if ((it = m_channelMatrixMap.Find (dlLinkId)) != 0)
 	{
 		// this is downlink case
 		downlink = true;
 		enbDevice = txDevice;
 		ueDevice = rxDevice;
-		it = m_channelMatrixMap.find(dlkey);
 	}
-	else if (m_channelMatrixMap.find(ulkey) != m_channelMatrixMap.end ())
+	else if (dlLinkId != LinkIndex::NO_LINK
+			&& (it = m_channelMatrixMap.Find (LinkIndex::GetReverseLinkId (dlLinkId))) != 0)
 	{
 		// this is uplink case
 		downlink = false;
 		ueDevice = txDevice;
 		enbDevice = rxDevice;
-		it = m_channelMatrixMap.find(ulkey);
 	}
 	else
 	{
@@ -581,7 +464,7 @@ MmWaveBeamforming::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 		return rxPsd;
 	}
 
-	Ptr<BeamformingParams> bfParams = it->second;
+	Ptr<BeamformingParams> bfParams = *it;
 
 	antennaPair antennaArrays = GetUeEnbAntennaPair(ueDevice, enbDevice);
 	Ptr<AntennaArrayModel> enbAntennaArray = antennaArrays.second;
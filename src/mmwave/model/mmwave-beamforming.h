@@ -47,6 +47,8 @@
 #include <ns3/mmwave-phy-mac-common.h>
 #include <ns3/random-variable-stream.h>
 #include <ns3/antenna-array-model.h>
+#include <ns3/mmwave-link-table.h>
+#include <ns3/mmwave-beamforming-matrix.h>
 
 
 
@@ -82,6 +84,18 @@ struct BeamformingParams : public SimpleRefCount<BeamformingParams>
 	complexVector_t* 	m_beam; // product of beamforming vectors and spatial matrices
 };
 
+/**
+* \store the matrix files of one antenna configuration, shared by all the MmWaveBeamforming instances
+*/
+struct BeamformingMatrixSet : public SimpleRefCount<BeamformingMatrixSet>
+{
+	BeamformingMatrixFile m_smallScaleFading; // sigma vector of each instance
+	BeamformingMatrixFile m_enbAntenna; // txW of each instance
+	BeamformingMatrixFile m_ueAntenna; // rxW of each instance
+	BeamformingMatrixFile m_enbSpatial; // txE of each instance
+	BeamformingMatrixFile m_ueSpatial; // rxE of each instance
+};
+
 /**
 * \ingroup mmWave
 * \MmWaveBeamforming models the beamforming gain and fading distortion in frequency and time for the mmWave channel
@@ -126,31 +140,24 @@ public:
 
 private:
 	/**
-	* \breif Get complex number from a string
-	* \param strCmplx a string store complex bumber i.e. 3+2i,
-	* \return a complex number of the string
-	*/
-	std::complex<double> ParseComplex (std::string strCmplx);
-	/**
-	* \breif Load file which store small scale fading sigma vector
+	* \breif Get the directory of the matrix files of the antenna configuration,
+	* 		 i.e., the <enbAntenna>x<ueAntenna> sub-directory of MatrixDirectory if it exists
 	*/
-	void LoadSmallScaleFading ();
+	std::string GetMatrixDirectory () const;
 	/**
-	* \breif Load file which store antenna weights for enb
+	* \breif Get the matrix files of the antenna configuration, loading them on the first call
 	*/
-	void LoadEnbAntenna ();
-	/**
-	* \breif Load file which store antenna weights for ue
+	Ptr<BeamformingMatrixSet> GetMatrices ();
+	/**
+	* \breif Load a matrix file, preferring the binary version (.bin) to the text one (.txt)
+	* \param matrix the matrix file to be loaded
+	* \param directory the directory of the file
+	* \param name the name of the file without extension
+	* \param rowsPerInstance the number of rows of each instance
+	* \param complex true if the values are complex
 	*/
-	void LoadUeAntenna ();
-	/**
-	* \breif Load file which store spatial signature matrix for  enb
-	*/
-	void LoadEnbSpatialSignature ();
-	/**
-	* \breif Load file which store spatial signature matrix for  ue
-	*/
-	void LoadUeSpatialSignature ();
+	void LoadMatrix (BeamformingMatrixFile &matrix, std::string directory, std::string name,
+			uint32_t rowsPerInstance, bool complex) const;
 	/**
 	* \breif Calculate beamforming gain and fading distortion in frequency and time
 	* \param txPsd set of values vs frequency representing the
@@ -163,6 +170,17 @@ private:
 	Ptr<SpectrumValue> DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 	                                                   Ptr<const MobilityModel> a,
 	                                                   Ptr<const MobilityModel> b) const;
+
+	/**
+	 * Same as DoCalcRxPowerSpectralDensity, applying the channel to a PSD owned by the caller
+	 * @params the transmitted PSD, which may be modified and returned
+	 * @params the mobility model of the transmitter
+	 * @params the mobility model of the receiver
+	 * @returns the received PSD
+	 */
+	Ptr<SpectrumValue> DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> rxPsd,
+			Ptr<const MobilityModel> a,
+			Ptr<const MobilityModel> b) const;
 	
 	/**
 	* \breif Store the channel matrix to channelMatrixMap
@@ -200,9 +218,10 @@ private:
 
 	/**
 	* \a map to store channel matrix
-	* key pair<NetDevice,NetDevice> a pair of pointer to NetDevice present enb and ue for downlink
+	* indexed by the identifier in m_linkIndex of the (ue, enb) link
 	*/
-	mutable std::map< key_t, Ptr<BeamformingParams> > m_channelMatrixMap;
+	mutable LinkIndex m_linkIndex;
+	mutable LinkTable< Ptr<BeamformingParams> > m_channelMatrixMap;
 
 	uint32_t m_pathNum;
 	uint32_t m_enbAntennaSize;
@@ -220,6 +239,8 @@ private:
 	double m_ueSpeed;
 	bool m_update;
 	Ptr<UniformRandomVariable> m_uniformRV;
+	std::string m_matrixDirectory;
+	Ptr<BeamformingMatrixSet> m_matrices;
 
     //Ptr<ExponentialRandomVariable> m_nextLongTermUpdate;  // next update of long term statistics in microseconds
 };
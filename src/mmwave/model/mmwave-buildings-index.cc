@@ -0,0 +1,377 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mmwave-buildings-index.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/singleton.h>
+#include <ns3/simulator.h>
+#include <ns3/building-list.h>
+#include <ns3/building.h>
+#include <algorithm>
+#include <cmath>
+
+namespace ns3{
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveBuildingsIndex");
+
+// the cells are widened by this fraction of their size when a segment is
+// mapped to them, so that rounding never drops a cell the segment touches
+static const double CELL_MARGIN = 1e-6;
+
+// bound on the number of cells per axis
+static const uint32_t MAX_CELLS_PER_AXIS = 1024;
+
+MmWaveBuildingsIndex::MmWaveBuildingsIndex ()
+	:m_valid (false),
+	 m_xMin (0),
+	 m_yMin (0),
+	 m_xMax (0),
+	 m_yMax (0),
+	 m_cellWidth (1),
+	 m_cellHeight (1),
+	 m_numColumns (0),
+	 m_numRows (0),
+	 m_query (0)
+{
+}
+
+MmWaveBuildingsIndex*
+MmWaveBuildingsIndex::Get ()
+{
+	return Singleton<MmWaveBuildingsIndex>::Get ();
+}
+
+void
+MmWaveBuildingsIndex::Invalidate ()
+{
+	m_valid = false;
+}
+
+void
+MmWaveBuildingsIndex::Update ()
+{
+	if (!m_valid || m_boxes.size () != BuildingList::GetNBuildings ())
+	{
+		if (!m_valid)
+		{
+			// the BuildingList is emptied by Simulator::Destroy
+			Simulator::ScheduleDestroy (&MmWaveBuildingsIndex::Invalidate, this);
+		}
+		Build ();
+	}
+}
+
+void
+MmWaveBuildingsIndex::Build ()
+{
+	m_valid = true;
+	m_boxes.clear ();
+	for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
+	{
+		m_boxes.push_back ((*bit)->GetBoundaries ());
+	}
+	m_visited.assign (m_boxes.size (), 0);
+	m_query = 0;
+	m_cellStart.assign (1, 0);
+	m_cellBuildings.clear ();
+	m_numColumns = 0;
+	m_numRows = 0;
+	if (m_boxes.empty ())
+	{
+		return;
+	}
+
+	m_xMin = m_boxes[0].xMin;
+	m_xMax = m_boxes[0].xMax;
+	m_yMin = m_boxes[0].yMin;
+	m_yMax = m_boxes[0].yMax;
+	for (uint32_t i = 1; i < m_boxes.size (); i++)
+	{
+		m_xMin = std::min (m_xMin, m_boxes[i].xMin);
+		m_xMax = std::max (m_xMax, m_boxes[i].xMax);
+		m_yMin = std::min (m_yMin, m_boxes[i].yMin);
+		m_yMax = std::max (m_yMax, m_boxes[i].yMax);
+	}
+
+	// about one building per cell
+	uint32_t cellsPerAxis = std::ceil (std::sqrt ((double) m_boxes.size ()));
+	cellsPerAxis = std::max (1u, std::min (cellsPerAxis, MAX_CELLS_PER_AXIS));
+	m_numColumns = m_xMax > m_xMin ? cellsPerAxis : 1;
+	m_numRows = m_yMax > m_yMin ? cellsPerAxis : 1;
+	m_cellWidth = m_xMax > m_xMin ? (m_xMax - m_xMin) / m_numColumns : 1;
+	m_cellHeight = m_yMax > m_yMin ? (m_yMax - m_yMin) / m_numRows : 1;
+
+	// count the buildings of each cell, then fill the cells
+	std::vector<uint32_t> count (m_numColumns * m_numRows, 0);
+	for (uint32_t i = 0; i < m_boxes.size (); i++)
+	{
+		for (uint32_t col = GetColumn (m_boxes[i].xMin); col <= GetColumn (m_boxes[i].xMax); col++)
+		{
+			for (uint32_t row = GetRow (m_boxes[i].yMin); row <= GetRow (m_boxes[i].yMax); row++)
+			{
+				count[row * m_numColumns + col]++;
+			}
+		}
+	}
+	m_cellStart.resize (count.size () + 1);
+	for (uint32_t cell = 0; cell < count.size (); cell++)
+	{
+		m_cellStart[cell + 1] = m_cellStart[cell] + count[cell];
+	}
+	m_cellBuildings.resize (m_cellStart.back ());
+	std::vector<uint32_t> next (m_cellStart.begin (), m_cellStart.end () - 1);
+	for (uint32_t i = 0; i < m_boxes.size (); i++)
+	{
+		for (uint32_t col = GetColumn (m_boxes[i].xMin); col <= GetColumn (m_boxes[i].xMax); col++)
+		{
+			for (uint32_t row = GetRow (m_boxes[i].yMin); row <= GetRow (m_boxes[i].yMax); row++)
+			{
+				m_cellBuildings[next[row * m_numColumns + col]++] = i;
+			}
+		}
+	}
+	NS_LOG_INFO ("Indexed " << m_boxes.size () << " buildings in " << m_numColumns << "x" << m_numRows
+			<< " cells, " << m_cellBuildings.size () << " entries");
+}
+
+uint32_t
+MmWaveBuildingsIndex::GetColumn (double x) const
+{
+	if (x <= m_xMin)
+	{
+		return 0;
+	}
+	uint32_t col = (x - m_xMin) / m_cellWidth;
+	return std::min (col, m_numColumns - 1);
+}
+
+uint32_t
+MmWaveBuildingsIndex::GetRow (double y) const
+{
+	if (y <= m_yMin)
+	{
+		return 0;
+	}
+	uint32_t row = (y - m_yMin) / m_cellHeight;
+	return std::min (row, m_numRows - 1);
+}
+
+void
+MmWaveBuildingsIndex::StartQuery ()
+{
+	m_candidates.clear ();
+	if (++m_query == 0)
+	{
+		m_visited.assign (m_visited.size (), 0);
+		m_query = 1;
+	}
+}
+
+void
+MmWaveBuildingsIndex::AddCandidates (uint32_t colLo, uint32_t colHi, uint32_t rowLo, uint32_t rowHi)
+{
+	for (uint32_t row = rowLo; row <= rowHi; row++)
+	{
+		for (uint32_t cell = row * m_numColumns + colLo; cell <= row * m_numColumns + colHi; cell++)
+		{
+			for (uint32_t k = m_cellStart[cell]; k < m_cellStart[cell + 1]; k++)
+			{
+				uint32_t building = m_cellBuildings[k];
+				if (m_visited[building] != m_query)
+				{
+					m_visited[building] = m_query;
+					m_candidates.push_back (building);
+				}
+			}
+		}
+	}
+}
+
+bool
+MmWaveBuildingsIndex::IsLineIntersectBuildings (Vector L1, Vector L2)
+{
+	Update ();
+	if (m_boxes.empty ())
+	{
+		return false;
+	}
+
+	// the footprint of a building hit by the segment is hit by the projection
+	// of the segment on the ground, so only the cells crossed by the
+	// projection are visited, one column at a time
+	double x0 = std::min (L1.x, L2.x);
+	double x1 = std::max (L1.x, L2.x);
+	double marginX = CELL_MARGIN * m_cellWidth;
+	double marginY = CELL_MARGIN * m_cellHeight;
+	if (x1 < m_xMin - marginX || x0 > m_xMax + marginX
+			|| std::max (L1.y, L2.y) < m_yMin - marginY || std::min (L1.y, L2.y) > m_yMax + marginY)
+	{
+		return false;
+	}
+
+	StartQuery ();
+	double dx = L2.x - L1.x;
+	uint32_t colLo = GetColumn (x0 - marginX);
+	uint32_t colHi = GetColumn (x1 + marginX);
+	for (uint32_t col = colLo; col <= colHi; col++)
+	{
+		double yLo;
+		double yHi;
+		if (dx == 0)
+		{
+			yLo = std::min (L1.y, L2.y);
+			yHi = std::max (L1.y, L2.y);
+		}
+		else
+		{
+			// the part of the segment over the column
+			double cx0 = std::max (x0, m_xMin + col * m_cellWidth - marginX);
+			double cx1 = std::min (x1, m_xMin + (col + 1) * m_cellWidth + marginX);
+			double y0 = L1.y + (cx0 - L1.x) * (L2.y - L1.y) / dx;
+			double y1 = L1.y + (cx1 - L1.x) * (L2.y - L1.y) / dx;
+			yLo = std::min (y0, y1);
+			yHi = std::max (y0, y1);
+		}
+		if (yHi < m_yMin - marginY || yLo > m_yMax + marginY)
+		{
+			continue;
+		}
+		AddCandidates (col, col, GetRow (yLo - marginY), GetRow (yHi + marginY));
+	}
+
+	for (uint32_t i = 0; i < m_candidates.size (); i++)
+	{
+		if (IsLineIntersectBox (L1, L2, m_boxes[m_candidates[i]]))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void
+MmWaveBuildingsIndex::IsLineIntersectBuildings (const std::vector<Vector> &L1, const std::vector<Vector> &L2,
+		std::vector<bool> &intersect)
+{
+	NS_ASSERT (L1.size () == L2.size ());
+	intersect.resize (L1.size ());
+	for (uint32_t i = 0; i < L1.size (); i++)
+	{
+		intersect[i] = IsLineIntersectBuildings (L1[i], L2[i]);
+	}
+}
+
+bool
+MmWaveBuildingsIndex::IsLinkObstructed (Vector a, Vector b)
+{
+	Update ();
+	double angle = OrientLink (a, b);
+	if (m_boxes.empty () || angle >= M_PI/2)
+	{
+		return false;
+	}
+
+	// a building can block the oriented link only if it starts before b on
+	// the x axis and overlaps the y range between the two ends
+	double yLo = std::min (a.y, b.y);
+	double yHi = std::max (a.y, b.y);
+	if (b.x < m_xMin || yHi < m_yMin || yLo > m_yMax)
+	{
+		return false;
+	}
+
+	StartQuery ();
+	AddCandidates (0, GetColumn (b.x), GetRow (yLo), GetRow (yHi));
+	for (uint32_t i = 0; i < m_candidates.size (); i++)
+	{
+		if (IsLinkObstructedByBox (a, b, angle, m_boxes[m_candidates[i]]))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+MmWaveBuildingsIndex::IsLineIntersectBox (const Vector &L1, const Vector &L2, const Box &boundaries)
+{
+	Vector boxSize (0.5*(boundaries.xMax - boundaries.xMin),
+			0.5*(boundaries.yMax - boundaries.yMin),
+			0.5*(boundaries.zMax - boundaries.zMin));
+	Vector boxCenter (boundaries.xMin + boxSize.x,
+			boundaries.yMin + boxSize.y,
+			boundaries.zMin + boxSize.z);
+
+	// Put line in box space
+	Vector LB1 (L1.x-boxCenter.x, L1.y-boxCenter.y, L1.z-boxCenter.z);
+	Vector LB2 (L2.x-boxCenter.x, L2.y-boxCenter.y, L2.z-boxCenter.z);
+
+	// Get line midpoint and extent
+	Vector LMid (0.5*(LB1.x+LB2.x), 0.5*(LB1.y+LB2.y), 0.5*(LB1.z+LB2.z));
+	Vector L (LB1.x - LMid.x, LB1.y - LMid.y, LB1.z - LMid.z);
+	Vector LExt ( std::abs(L.x), std::abs(L.y), std::abs(L.z) );
+
+	// Use Separating Axis Test
+	// Separation vector from box center to line center is LMid, since the line is in box space
+	if ( std::abs( LMid.x ) > boxSize.x + LExt.x ) return false;
+	if ( std::abs( LMid.y ) > boxSize.y + LExt.y ) return false;
+	if ( std::abs( LMid.z ) > boxSize.z + LExt.z ) return false;
+	// Crossproducts of line and each axis
+	if ( std::abs( LMid.y * L.z - LMid.z * L.y)  >  (boxSize.y * LExt.z + boxSize.z * LExt.y) ) return false;
+	if ( std::abs( LMid.x * L.z - LMid.z * L.x)  >  (boxSize.x * LExt.z + boxSize.z * LExt.x) ) return false;
+	if ( std::abs( LMid.x * L.y - LMid.y * L.x)  >  (boxSize.x * LExt.y + boxSize.y * LExt.x) ) return false;
+
+	// No separating axis, the line intersects
+	return true;
+}
+
+double
+MmWaveBuildingsIndex::OrientLink (Vector &locationA, Vector &locationB)
+{
+	double angle = std::atan2 (locationB.y - locationA.y, locationB.x - locationA.x);
+	if (angle >= M_PI/2 || angle < -M_PI/2)
+	{
+		std::swap (locationA, locationB);
+		angle = std::atan2 (locationB.y - locationA.y, locationB.x - locationA.x);
+	}
+	return angle;
+}
+
+bool
+MmWaveBuildingsIndex::IsLinkObstructedByBox (const Vector &locationA, const Vector &locationB, double angle,
+		const Box &boundaries)
+{
+	if (angle >=0 && angle < M_PI/2 )
+	{
+		double phi1 = std::atan2 (boundaries.yMin - locationA.y, boundaries.xMax - locationA.x);
+		double phi2 = std::atan2 (boundaries.yMax - locationA.y, boundaries.xMin - locationA.x);
+		return angle > phi1 && angle < phi2 && locationB.x > boundaries.xMin && locationB.y > boundaries.yMin;
+	}
+	else if (angle >= -M_PI/2 && angle < 0)
+	{
+		double phi1 = std::atan2 (boundaries.yMin - locationA.y, boundaries.xMin - locationA.x);
+		double phi2 = std::atan2 (boundaries.yMax - locationA.y, boundaries.xMax - locationA.x);
+		return angle > phi1 && angle < phi2 && locationB.x > boundaries.xMin && locationB.y < boundaries.yMax;
+	}
+	return false;
+}
+
+}  //namespace ns3
@@ -0,0 +1,134 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MMWAVE_BUILDINGS_INDEX_H_
+#define MMWAVE_BUILDINGS_INDEX_H_
+
+#include <ns3/vector.h>
+#include <ns3/box.h>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3{
+
+/**
+ * \brief Uniform 2D grid over the footprints of the buildings in the
+ * BuildingList, shared by the propagation loss models which decide whether
+ * a link is blocked by a building.
+ *
+ * Every building is registered in the cells its footprint overlaps. A query
+ * visits only the cells which a blocking building must overlap, and applies
+ * to the buildings found there the same per-building test as the linear
+ * scan over the BuildingList, so the decision is identical.
+ *
+ * The grid is built at the first query and rebuilt when the number of
+ * buildings changes or after Simulator::Destroy. A building whose boundaries
+ * are changed after the first query requires a call to Invalidate.
+ */
+class MmWaveBuildingsIndex
+{
+public:
+	MmWaveBuildingsIndex ();
+
+	/**
+	 * @returns the index of the buildings in the BuildingList
+	 */
+	static MmWaveBuildingsIndex* Get ();
+
+	/**
+	 * Drop the grid, which is built again at the next query
+	 */
+	void Invalidate ();
+
+	/**
+	 * Check if the segment between two points intersects a building
+	 * @params first end of the segment
+	 * @params second end of the segment
+	 */
+	bool IsLineIntersectBuildings (Vector L1, Vector L2);
+
+	/**
+	 * Check a batch of segments against the buildings
+	 * @params first ends of the segments
+	 * @params second ends of the segments
+	 * @params set to whether each segment intersects a building
+	 */
+	void IsLineIntersectBuildings (const std::vector<Vector> &L1, const std::vector<Vector> &L2,
+			std::vector<bool> &intersect);
+
+	/**
+	 * Check if the link between two nodes is blocked according to the angular
+	 * test of BuildingsObstaclePropagationLossModel and MmWaveLosTracker
+	 * @params position of the first node
+	 * @params position of the second node
+	 */
+	bool IsLinkObstructed (Vector a, Vector b);
+
+	/**
+	 * Separating axis test of a segment against a box
+	 */
+	static bool IsLineIntersectBox (const Vector &L1, const Vector &L2, const Box &boundaries);
+
+	/**
+	 * Angular test of a link against a building, with the link oriented as
+	 * returned by OrientLink
+	 */
+	static bool IsLinkObstructedByBox (const Vector &locationA, const Vector &locationB, double angle,
+			const Box &boundaries);
+
+	/**
+	 * Order the ends of a link so that the azimuth from the first to the
+	 * second is in [-pi/2, pi/2]
+	 * @returns the azimuth of the oriented link
+	 */
+	static double OrientLink (Vector &locationA, Vector &locationB);
+
+private:
+	void Update ();
+	void Build ();
+	uint32_t GetColumn (double x) const;
+	uint32_t GetRow (double y) const;
+	void StartQuery ();
+	/**
+	 * Collect the buildings registered in the cells of a range, each one once
+	 */
+	void AddCandidates (uint32_t colLo, uint32_t colHi, uint32_t rowLo, uint32_t rowHi);
+
+	bool m_valid;
+	std::vector<Box> m_boxes;				// boundaries of the buildings, in BuildingList order
+	double m_xMin;
+	double m_yMin;
+	double m_xMax;
+	double m_yMax;
+	double m_cellWidth;
+	double m_cellHeight;
+	uint32_t m_numColumns;
+	uint32_t m_numRows;
+	std::vector<uint32_t> m_cellStart;		// first entry of each cell in m_cellBuildings
+	std::vector<uint32_t> m_cellBuildings;	// buildings of each cell, cell after cell
+	std::vector<uint32_t> m_visited;		// query in which each building was last collected
+	uint32_t m_query;
+	std::vector<uint32_t> m_candidates;
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_BUILDINGS_INDEX_H_ */
@@ -146,9 +146,16 @@ Ptr<SpectrumValue>
 MmWaveChannelMatrix::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
                                                    Ptr<const MobilityModel> a,
                                                    Ptr<const MobilityModel> b) const
+{
+	return DoCalcRxPowerSpectralDensityInPlace (Copy (txPsd), a, b);
+}
+
+Ptr<SpectrumValue>
+MmWaveChannelMatrix::DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> rxPsd,
+                                                   Ptr<const MobilityModel> a,
+                                                   Ptr<const MobilityModel> b) const
 {
 	NS_LOG_FUNCTION (this);
-	Ptr<SpectrumValue> rxPsd = Copy (txPsd);
 	Ptr<AntennaArrayModel> txAntennaArray, rxAntennaArray;
 
 	Ptr<NetDevice> txDevice = a->GetObject<Node> ()->GetDevice (0);
@@ -429,7 +436,7 @@ MmWaveChannelMatrix::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPs
 
 	//NS_LOG_UNCOND ("TxAngle("<<txAngles.phi*180/M_PI<<") RxAngle("<<rxAngles.phi*180/M_PI
 	//		<<") Speed["<<relativeSpeed<<"]");
-	NS_LOG_UNCOND ("Gain("<<10*Log10((*bfPsd)/(*txPsd))<<"dB)");
+	NS_LOG_UNCOND ("Gain("<<10*Log10((*bfPsd)/(*rxPsd))<<"dB)");
 	return bfPsd;
 
 
@@ -101,6 +101,17 @@ private:
 														Ptr<const MobilityModel> a,
 														Ptr<const MobilityModel> b) const;
 
+	/**
+	 * Same as DoCalcRxPowerSpectralDensity, applying the channel to a PSD owned by the caller
+	 * @params the transmitted PSD, which may be modified and returned
+	 * @params the mobility model of the transmitter
+	 * @params the mobility model of the receiver
+	 * @returns the received PSD
+	 */
+	Ptr<SpectrumValue> DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> rxPsd,
+			Ptr<const MobilityModel> a,
+			Ptr<const MobilityModel> b) const;
+
 	complex2DVector_t GenSpatialMatrix (std::vector<uint16_t> cluster, Angles angle, uint8_t* antennaNum) const;
 	complexVector_t GenSinglePath (double hAngle, double vAngle, uint8_t* antennaNum) const;
 	//complexVector_t CalcBeamformingVector (complex2DVector_t SpatialMatrix) const;
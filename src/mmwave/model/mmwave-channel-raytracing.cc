@@ -41,6 +41,7 @@
 #include <ns3/mmwave-ue-phy.h>
 #include <ns3/mmwave-enb-phy.h>
 #include <ns3/double.h>
+#include <ns3/string.h>
 #include <algorithm>
 #include <fstream>
 
@@ -52,22 +53,10 @@ NS_LOG_COMPONENT_DEFINE ("MmWaveChannelRaytracing");
 NS_OBJECT_ENSURE_REGISTERED (MmWaveChannelRaytracing);
 
 
-doubleVector_t g_path; //number of multipath
-double2DVector_t g_delay; //delay spread in ns
-double2DVector_t g_pathloss;	//pathloss in DB
-double2DVector_t g_phase;	//???what is this
-double2DVector_t g_aodElevation;	//degree
-double2DVector_t g_aodAzimuth;	//degree
-double2DVector_t g_aoaElevation;	//degree
-double2DVector_t g_aoaAzimuth;	//degree
-
-
 MmWaveChannelRaytracing::MmWaveChannelRaytracing ()
 	:m_antennaSeparation(0.5)
 {
 	m_uniformRv = CreateObject<UniformRandomVariable> ();
-	LoadTraces();
-
 }
 
 TypeId
@@ -85,6 +74,18 @@ MmWaveChannelRaytracing::GetTypeId (void)
 			   DoubleValue (1.0),
 			   MakeDoubleAccessor (&MmWaveChannelRaytracing::m_speed),
 			   MakeDoubleChecker<double> ())
+	.AddAttribute ("SteeringVectorResolution",
+			   "Quantization step (degrees) of the angles used to look up the steering vectors "
+			   "in a precomputed table, 0 to evaluate them exactly for every path",
+			   DoubleValue (0.0),
+			   MakeDoubleAccessor (&MmWaveChannelRaytracing::m_steeringResolution),
+			   MakeDoubleChecker<double> (0.0, 180.0))
+	.AddAttribute ("TraceFile",
+			   "The ray-tracing trace file, either in the text format or in the binary format "
+			   "produced by the mmwave-raytracing-trace-converter example (which is memory mapped)",
+			   StringValue ("src/mmwave/model/Raytracing/traces10cm.txt"),
+			   MakeStringAccessor (&MmWaveChannelRaytracing::m_traceFile),
+			   MakeStringChecker ())
 	;
 	return tid;
 }
@@ -113,92 +114,32 @@ MmWaveChannelRaytracing::GetConfigurationParameters (void) const
 }
 
 void
-MmWaveChannelRaytracing::LoadTraces()
+MmWaveChannelRaytracing::NotifyConstructionCompleted ()
 {
-	std::string filename = "src/mmwave/model/Raytracing/traces10cm.txt";
-	NS_LOG_FUNCTION (this << "Loading Raytracing file " << filename);
-	std::ifstream singlefile;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " Raytracing file not found");
-    std::string line;
-    std::string token;
-    uint16_t counter = 0;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	if(counter == 8)
-    	{
-    		counter = 0;
-    	}
-    	doubleVector_t path;
-        std::istringstream stream(line);
-        while( getline(stream,token,',') ) //Parse each comma separated string in a line
-        {
-            double sigma = 0.00;
-            std::stringstream stream( token );
-            stream>>sigma;
-        	path.push_back(sigma);
-		}
+	SpectrumPropagationLossModel::NotifyConstructionCompleted ();
+	LoadTraces ();
+}
 
-		switch (counter)
-		{
-		case 0:
-			g_path.push_back (path.at (0));
-			break;
-		case 1:
-			g_delay.push_back (path);
-			break;
-		case 2:
-			g_pathloss.push_back (path);
-			break;
-		case 3:
-			g_phase.push_back (path);
-			break;
-		case 4:
-			g_aodElevation.push_back (path);
-			break;
-		case 5:
-			g_aodAzimuth.push_back (path);
-			break;
-		case 6:
-			g_aoaElevation.push_back (path);
-			break;
-		case 7:
-			g_aoaAzimuth.push_back (path);
-			break;
-		default:
-			NS_FATAL_ERROR("Never call this");
-			break;
-		}
-		counter++;
+void
+MmWaveChannelRaytracing::LoadTraces()
+{
+	NS_LOG_FUNCTION (this << "Loading Raytracing file " << m_traceFile);
+	bool loaded = m_traces.Load (m_traceFile);
+	NS_ASSERT_MSG (loaded, " Raytracing file not found");
+	// the trace index of a signal is checked against GetNumTraces () - 1
+	if (m_traces.GetNumTraces () == 0)
+	{
+		NS_FATAL_ERROR ("Raytracing file " << m_traceFile << " contains no trace");
 	}
-
-	/*NS_LOG_UNCOND(g_path.size());
-	NS_LOG_UNCOND(g_delay.size());
-	NS_LOG_UNCOND(g_pathloss.size());
-	NS_LOG_UNCOND(g_phase.size());
-	NS_LOG_UNCOND(g_aodElevation.size());
-	NS_LOG_UNCOND(g_aodAzimuth.size());
-	NS_LOG_UNCOND(g_aoaElevation.size());
-	NS_LOG_UNCOND(g_aoaAzimuth.size());*/
-
-
-
+	NS_LOG_INFO (this << " File: " << m_traceFile << (m_traces.IsMapped () ? " (mapped)" : "")
+			<< " traces: " << m_traces.GetNumTraces ());
 }
 
 
 void
 MmWaveChannelRaytracing::ConnectDevices (Ptr<NetDevice> dev1, Ptr<NetDevice> dev2)
 {
-	key_t key = std::make_pair(dev1,dev2);
-
-	std::map< key_t, int >::iterator iter = m_connectedPair.find(key);
-	if (iter != m_connectedPair.end ())
-	{
-		m_connectedPair.erase (iter);
-	}
-	m_connectedPair.insert(std::make_pair(key,1));
+	m_connectedPair[m_linkIndex.GetLinkId (dev1, dev2)] = 1;
 }
 
 void
@@ -242,9 +183,16 @@ Ptr<SpectrumValue>
 MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
                                                    Ptr<const MobilityModel> a,
                                                    Ptr<const MobilityModel> b) const
+{
+	return DoCalcRxPowerSpectralDensityInPlace (Copy (txPsd), a, b);
+}
+
+Ptr<SpectrumValue>
+MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> rxPsd,
+                                                   Ptr<const MobilityModel> a,
+                                                   Ptr<const MobilityModel> b) const
 {
 	NS_LOG_FUNCTION (this);
-	Ptr<SpectrumValue> rxPsd = Copy (txPsd);
 	Ptr<AntennaArrayModel> txAntennaArray, rxAntennaArray;
 
 	Ptr<NetDevice> txDevice = a->GetObject<Node> ()->GetDevice (0);
@@ -343,69 +291,69 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 	}
 
 	Ptr<mmWaveBeamFormingTraces> bfParams = Create<mmWaveBeamFormingTraces> ();
-	key_t key = std::make_pair(txDevice,rxDevice);
+	uint32_t linkId = m_linkIndex.GetLinkId (txDevice, rxDevice);
 
 	double time = Simulator::Now().GetSeconds();
 	uint16_t traceIndex = (m_startDistance+time*m_speed)*100;
 	static uint16_t currentIndex = m_startDistance*100;
-	if(traceIndex > 26050)
+	if(traceIndex >= m_traces.GetNumTraces ())
 	{
-		NS_FATAL_ERROR ("The maximum trace index is 26050");
+		NS_FATAL_ERROR ("The maximum trace index is " << m_traces.GetNumTraces () - 1);
 	}
 	if(traceIndex != currentIndex)
 	{
 		currentIndex = traceIndex;
-		m_channelMatrixMap.clear();
+		m_channelMatrixMap.Clear ();
 	}
 
-	std::map< key_t, Ptr<TraceParams> >::iterator it = m_channelMatrixMap.find (key);
-	if (it == m_channelMatrixMap.end ())
+	Ptr<TraceParams> *it = m_channelMatrixMap.Find (linkId);
+	if (it == 0)
 	{
 
-		complex2DVector_t txSpatialMatrix;
-		complex2DVector_t rxSpatialMatrix;
+		Ptr<TraceParams> channel = Create<TraceParams> ();
 		if(dl)
 		{
-			txSpatialMatrix = GenSpatialMatrix (traceIndex,txAntennaNum, true);
-			rxSpatialMatrix = GenSpatialMatrix (traceIndex,rxAntennaNum, false);
+			GenSpatialMatrix (traceIndex,txAntennaNum, true, channel->m_txSpatialMatrix);
+			GenSpatialMatrix (traceIndex,rxAntennaNum, false, channel->m_rxSpatialMatrix);
 		}
 		else
 		{
-			txSpatialMatrix = GenSpatialMatrix (traceIndex,txAntennaNum, false);
-			rxSpatialMatrix = GenSpatialMatrix (traceIndex,rxAntennaNum, true);
+			GenSpatialMatrix (traceIndex,txAntennaNum, false, channel->m_txSpatialMatrix);
+			GenSpatialMatrix (traceIndex,rxAntennaNum, true, channel->m_rxSpatialMatrix);
 		}
-		doubleVector_t dopplerShift;
-		for (unsigned int i = 0; i < g_path.at(traceIndex); i++)
+		uint32_t pathNum = m_traces.GetNumPaths (traceIndex);
+		channel->m_doppler.reserve (pathNum);
+		for (unsigned int i = 0; i < pathNum; i++)
 		{
-			dopplerShift.push_back(m_uniformRv->GetValue (0,1));
+			channel->m_doppler.push_back(m_uniformRv->GetValue (0,1));
 		}
 
-		Ptr<TraceParams> channel = Create<TraceParams> ();
-
-		channel->m_txSpatialMatrix = txSpatialMatrix;
-		channel->m_rxSpatialMatrix = rxSpatialMatrix;
-		channel->m_powerFraction = g_pathloss.at (traceIndex);
-		channel->m_delaySpread = g_delay.at (traceIndex);
-		channel->m_doppler = dopplerShift;
-
-
-		m_channelMatrixMap.insert(std::make_pair(key,channel));
+		const double *pathloss = m_traces.GetRow (traceIndex, RaytracingTrace::PATHLOSS);
+		const double *delay = m_traces.GetRow (traceIndex, RaytracingTrace::DELAY);
+		channel->m_powerFraction.assign (pathloss,
+				pathloss + m_traces.GetRowLength (traceIndex, RaytracingTrace::PATHLOSS));
+		channel->m_delaySpread.assign (delay,
+				delay + m_traces.GetRowLength (traceIndex, RaytracingTrace::DELAY));
 
-		key_t reverseKey = std::make_pair(rxDevice,txDevice);
-		Ptr<TraceParams> reverseChannel = Create<TraceParams> ();
-		reverseChannel->m_txSpatialMatrix = rxSpatialMatrix;
-		reverseChannel->m_rxSpatialMatrix = txSpatialMatrix;
-		reverseChannel->m_powerFraction = g_pathloss.at (traceIndex);;
-		reverseChannel->m_delaySpread = g_delay.at (traceIndex);
-		reverseChannel->m_doppler = dopplerShift;
+		m_channelMatrixMap[linkId] = channel;
 
-		m_channelMatrixMap.insert(std::make_pair(reverseKey,reverseChannel));
+		uint32_t reverseLinkId = LinkIndex::GetReverseLinkId (linkId);
+		if (m_channelMatrixMap.Find (reverseLinkId) == 0)
+		{
+			Ptr<TraceParams> reverseChannel = Create<TraceParams> ();
+			reverseChannel->m_txSpatialMatrix = channel->m_rxSpatialMatrix;
+			reverseChannel->m_rxSpatialMatrix = channel->m_txSpatialMatrix;
+			reverseChannel->m_powerFraction = channel->m_powerFraction;
+			reverseChannel->m_delaySpread = channel->m_delaySpread;
+			reverseChannel->m_doppler = channel->m_doppler;
+			m_channelMatrixMap[reverseLinkId] = reverseChannel;
+		}
 
 		bfParams->m_channelParams = channel;
 	}
 	else
 	{
-		bfParams->m_channelParams = (*it).second;
+		bfParams->m_channelParams = *it;
 	}
 
 	//	calculate antenna weights, better method should be implemented
@@ -413,11 +361,17 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 	bfParams->m_rxW = rxAntennaArray->GetBeamformingVector();
 
 
-	std::map< key_t, int >::iterator it1 = m_connectedPair.find (key);
-	if(it1 != m_connectedPair.end ())
+	if(m_connectedPair.Find (linkId) != 0)
 	{
-		bfParams->m_txW = CalcBeamformingVector(bfParams->m_channelParams->m_txSpatialMatrix, bfParams->m_channelParams->m_powerFraction);
-		bfParams->m_rxW = CalcBeamformingVector(bfParams->m_channelParams->m_rxSpatialMatrix, bfParams->m_channelParams->m_powerFraction);
+		// the weights only depend on the channel realization, compute them on its first use
+		Ptr<TraceParams> params = bfParams->m_channelParams;
+		if (params->m_txW.empty ())
+		{
+			CalcBeamformingVector (params->m_txSpatialMatrix, params->m_powerFraction, params->m_txW);
+			CalcBeamformingVector (params->m_rxSpatialMatrix, params->m_powerFraction, params->m_rxW);
+		}
+		bfParams->m_txW = params->m_txW;
+		bfParams->m_rxW = params->m_rxW;
 		txAntennaArray->SetBeamformingVector(bfParams->m_txW,rxDevice);
 		rxAntennaArray->SetBeamformingVector(bfParams->m_rxW,txDevice);
 	}
@@ -445,47 +399,56 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 
 	//NS_LOG_UNCOND ("TxAngle("<<txAngles.phi*180/M_PI<<") RxAngle("<<rxAngles.phi*180/M_PI
 	//		<<") Speed["<<relativeSpeed<<"]");
-	//NS_LOG_UNCOND ("Gain("<<10*Log10((*bfPsd)/(*txPsd))<<"dB)");
+	//NS_LOG_UNCOND ("Gain("<<10*Log10((*bfPsd)/(*rxPsd))<<"dB)");
 	return bfPsd;
 
 
 }
 
 
-complexVector_t
-MmWaveChannelRaytracing::CalcBeamformingVector(complex2DVector_t spatialMatrix, doubleVector_t powerFraction) const
+void
+MmWaveChannelRaytracing::CalcBeamformingVector (const complex2DVector_t &spatialMatrix,
+		const doubleVector_t &powerFraction, complexVector_t &antennaWeights) const
 {
-	complexVector_t antennaWeights;
 	uint16_t antennaNum = spatialMatrix.at (0).size ();
+	antennaWeights.resize (antennaNum);
 	for (int i = 0; i< antennaNum; i++)
 	{
-		antennaWeights.push_back(spatialMatrix.at (0).at (i)/sqrt(antennaNum));
+		antennaWeights[i] = spatialMatrix[0][i]/sqrt(antennaNum);
 	}
 
-	for(int iter = 0; iter<10; iter++)
+	m_pathPowerLinear.resize (spatialMatrix.size ());
+	for(unsigned pathIndex = 0; pathIndex<spatialMatrix.size (); pathIndex++)
 	{
-		complexVector_t antennaWeights_New;
+		m_pathPowerLinear[pathIndex] = std::pow (10.0, (powerFraction.at (pathIndex)) / 10.0);
+	}
 
+	complexVector_t &antennaWeights_New = m_weightsScratch;
+	antennaWeights_New.resize (antennaNum);
+	for(int iter = 0; iter<10; iter++)
+	{
 		for(unsigned pathIndex = 0; pathIndex<spatialMatrix.size (); pathIndex++)
 		{
+			const complexVector_t &path = spatialMatrix[pathIndex];
 			std::complex<double> sum;
 			for (int i = 0; i< antennaNum; i++)
 			{
-				sum += std::conj(spatialMatrix.at (pathIndex).at (i))*antennaWeights.at (i);
+				sum += std::conj(path[i])*antennaWeights[i];
 			}
 
-			for (int i = 0; i< antennaNum; i++)
+			double pathPowerLinear = m_pathPowerLinear[pathIndex];
+			if(pathIndex ==0)
 			{
-                double pathPowerLinear = std::pow (10.0, (powerFraction. at(pathIndex)) / 10.0);
-
-
-				if(pathIndex ==0)
+				for (int i = 0; i< antennaNum; i++)
 				{
-					antennaWeights_New.push_back(pathPowerLinear*spatialMatrix.at (pathIndex).at (i)*sum);
+					antennaWeights_New[i] = pathPowerLinear*path[i]*sum;
 				}
-				else
+			}
+			else
+			{
+				for (int i = 0; i< antennaNum; i++)
 				{
-					antennaWeights_New.at (i) += pathPowerLinear*spatialMatrix.at (pathIndex).at (i)*sum;
+					antennaWeights_New[i] += pathPowerLinear*path[i]*sum;
 				}
 			}
 		}
@@ -493,54 +456,62 @@ MmWaveChannelRaytracing::CalcBeamformingVector(complex2DVector_t spatialMatrix,
 		double weightSum = 0;
 		for (int i = 0; i< antennaNum; i++)
 		{
-			weightSum += pow (std::abs(antennaWeights_New. at(i)),2);
+			weightSum += pow (std::abs(antennaWeights_New[i]),2);
 		}
 		for (int i = 0; i< antennaNum; i++)
 		{
-			antennaWeights_New. at(i) = antennaWeights_New. at(i)/sqrt(weightSum);
+			antennaWeights[i] = antennaWeights_New[i]/sqrt(weightSum);
 		}
-		antennaWeights = antennaWeights_New;
 	}
-	return antennaWeights;
 }
 
 
 
-complex2DVector_t
-MmWaveChannelRaytracing::GenSpatialMatrix (uint64_t traceIndex, uint8_t* antennaNum, bool bs) const
+void
+MmWaveChannelRaytracing::GenSpatialMatrix (uint64_t traceIndex, uint8_t* antennaNum, bool bs,
+		complex2DVector_t &spatialMatrix) const
 {
-	complex2DVector_t spatialMatrix;
-	uint16_t pathNum = g_path.at (traceIndex);
+	uint32_t pathNum = m_traces.GetNumPaths (traceIndex);
+	NS_ASSERT (m_traces.GetRowLength (traceIndex, RaytracingTrace::AOD_AZIMUTH) >= pathNum
+			&& m_traces.GetRowLength (traceIndex, RaytracingTrace::AOA_AZIMUTH) >= pathNum);
+	// the angles are read in place from the trace storage
+	const double *azimuth = m_traces.GetRow (traceIndex,
+			bs ? RaytracingTrace::AOD_AZIMUTH : RaytracingTrace::AOA_AZIMUTH);
+	const double *elevation = m_traces.GetRow (traceIndex,
+			bs ? RaytracingTrace::AOD_ELEVATION : RaytracingTrace::AOA_ELEVATION);
+	spatialMatrix.resize (pathNum);
 	for(unsigned int pathIndex = 0; pathIndex < pathNum; pathIndex++)
 	{
-		double azimuthAngle;
-		double verticalAngle;
-		if(bs)
-		{
-			azimuthAngle = g_aodAzimuth.at (traceIndex).at (pathIndex);
-			verticalAngle = g_aodElevation.at (traceIndex).at (pathIndex);
-		}
-		else
-		{
-			azimuthAngle = g_aoaAzimuth.at (traceIndex).at (pathIndex);
-			verticalAngle = g_aoaElevation.at (traceIndex).at (pathIndex);
-		}
-		complexVector_t singlePath;
-		singlePath = GenSinglePath (azimuthAngle*M_PI/180, verticalAngle*M_PI/180, antennaNum);
-		spatialMatrix.push_back(singlePath);
+		double azimuthAngle = azimuth[pathIndex];
+		double verticalAngle = elevation[pathIndex];
+		GenSinglePath (azimuthAngle*M_PI/180, verticalAngle*M_PI/180, antennaNum, spatialMatrix[pathIndex]);
 	}
-
-	return spatialMatrix;
 }
 
 
-complexVector_t
-MmWaveChannelRaytracing::GenSinglePath (double hAngle, double vAngle, uint8_t* antennaNum) const
+void
+MmWaveChannelRaytracing::GenSinglePath (double hAngle, double vAngle, uint8_t* antennaNum,
+		complexVector_t &singlePath) const
 {
 	NS_LOG_FUNCTION (this);
-	complexVector_t singlePath;
 	uint16_t vSize = antennaNum[0];
 	uint16_t hSize = antennaNum[1];
+	singlePath.resize (vSize*hSize);
+
+	if (m_steeringResolution > 0)
+	{
+		// the steering vector of the planar array is the product of the vertical and horizontal ones
+		const complexVector_t &hPhase = GetSteeringPhase (hSize, hAngle);
+		const complexVector_t &vPhase = GetSteeringPhase (vSize, vAngle);
+		for (int vIndex = 0; vIndex < vSize; vIndex++)
+		{
+			for (int hIndex =0; hIndex < hSize; hIndex++)
+			{
+				singlePath[vIndex*hSize+hIndex] = hPhase[hIndex]*vPhase[vIndex];
+			}
+		}
+		return;
+	}
 
 	for (int vIndex = 0; vIndex < vSize; vIndex++)
 	{
@@ -548,10 +519,39 @@ MmWaveChannelRaytracing::GenSinglePath (double hAngle, double vAngle, uint8_t* a
 		{
 			double w = (-2)*M_PI*hIndex*m_antennaSeparation*cos(hAngle)
 										+ (-2)*M_PI*vIndex*m_antennaSeparation*cos(vAngle);
-			singlePath.push_back (std::complex<double> (cos (w), sin (w)));
+			singlePath[vIndex*hSize+hIndex] = std::complex<double> (cos (w), sin (w));
+		}
+	}
+}
+
+const complexVector_t&
+MmWaveChannelRaytracing::GetSteeringPhase (uint16_t size, double angle) const
+{
+	// only cos(angle) matters, so the angle is folded in [0, 180] degrees before quantization
+	double degree = std::fmod (std::abs (angle)*180/M_PI, 360.0);
+	if (degree > 180)
+	{
+		degree = 360 - degree;
+	}
+	uint32_t bin = std::floor (degree/m_steeringResolution + 0.5);
+
+	std::vector<complexVector_t> &table = m_steeringTables[size];
+	if (table.empty ())
+	{
+		table.resize (std::ceil (180/m_steeringResolution) + 1);
+	}
+	complexVector_t &phase = table.at (bin);
+	if (phase.empty ())
+	{
+		double quantized = bin*m_steeringResolution*M_PI/180;
+		phase.resize (size);
+		for (uint16_t index = 0; index < size; index++)
+		{
+			double w = (-2)*M_PI*index*m_antennaSeparation*cos(quantized);
+			phase[index] = std::complex<double> (cos (w), sin (w));
 		}
 	}
-	return singlePath;
+	return phase;
 }
 
 Ptr<SpectrumValue>
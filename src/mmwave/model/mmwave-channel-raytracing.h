@@ -42,6 +42,8 @@
 #include <ns3/net-device-container.h>
 #include <ns3/random-variable-stream.h>
 #include "mmwave-phy-mac-common.h"
+#include "mmwave-link-table.h"
+#include "mmwave-raytracing-trace.h"
 
 
 
@@ -62,6 +64,8 @@ struct TraceParams : public SimpleRefCount<TraceParams>
 	doubleVector_t 		m_powerFraction; // store subpath power fraction
 	doubleVector_t 		m_delaySpread; // store delay spread
 	doubleVector_t 		m_doppler; // store doppler
+	complexVector_t 	m_txW; // tx weights of the connected pair, computed on the first use
+	complexVector_t 	m_rxW; // rx weights of the connected pair, computed on the first use
 
 
 
@@ -98,23 +102,58 @@ public:
 
 private:
 
+	virtual void NotifyConstructionCompleted (void);
+
 	Ptr<SpectrumValue> DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 														Ptr<const MobilityModel> a,
 														Ptr<const MobilityModel> b) const;
 
-	complex2DVector_t GenSpatialMatrix (uint64_t traceIndex, uint8_t* antennaNum, bool bs) const;
-	complexVector_t GenSinglePath (double hAngle, double vAngle, uint8_t* antennaNum) const;
-	complexVector_t CalcBeamformingVector (complex2DVector_t SpatialMatrix, doubleVector_t powerFraction) const;
+	/**
+	 * Same as DoCalcRxPowerSpectralDensity, applying the channel to a PSD owned by the caller
+	 * @params the transmitted PSD, which may be modified and returned
+	 * @params the mobility model of the transmitter
+	 * @params the mobility model of the receiver
+	 * @returns the received PSD
+	 */
+	Ptr<SpectrumValue> DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> rxPsd,
+			Ptr<const MobilityModel> a,
+			Ptr<const MobilityModel> b) const;
+
+	/**
+	 * Generate the steering vectors of all the paths of a trace
+	 * @params the trace index
+	 * @params the size of the antenna array (vertical, horizontal)
+	 * @params true to use the departure angles, false to use the arrival angles
+	 * @params the output matrix, one steering vector per path
+	 */
+	void GenSpatialMatrix (uint64_t traceIndex, uint8_t* antennaNum, bool bs,
+			complex2DVector_t &spatialMatrix) const;
+	void GenSinglePath (double hAngle, double vAngle, uint8_t* antennaNum,
+			complexVector_t &singlePath) const;
+	/**
+	 * Get the phases of a linear array of the given size, for the angle quantized
+	 * with the SteeringVectorResolution step. The entries are computed on the first use.
+	 */
+	const complexVector_t& GetSteeringPhase (uint16_t size, double angle) const;
+	void CalcBeamformingVector (const complex2DVector_t &spatialMatrix,
+			const doubleVector_t &powerFraction, complexVector_t &antennaWeights) const;
 	Ptr<SpectrumValue> GetChannelGain (Ptr<const SpectrumValue> txPsd, Ptr<mmWaveBeamFormingTraces> bfParams, double speed) const;
 	double GetSystemBandwidth () const;
 
-	mutable std::map< key_t, int > m_connectedPair;
-	mutable std::map< key_t, Ptr<TraceParams> > m_channelMatrixMap;
+	mutable LinkIndex m_linkIndex;
+	mutable LinkTable<int> m_connectedPair;
+	mutable LinkTable< Ptr<TraceParams> > m_channelMatrixMap;
 	double m_antennaSeparation; //the ratio of the distance between 2 antennas over wave length
 	Ptr<UniformRandomVariable> m_uniformRv;
 	Ptr<MmWavePhyMacCommon> m_phyMacConfig;
 	uint16_t m_startDistance;
 	double m_speed;
+	std::string m_traceFile;
+	RaytracingTrace m_traces;
+	double m_steeringResolution;
+	mutable std::map<uint16_t, std::vector<complexVector_t> > m_steeringTables; // indexed by array size
+	mutable doubleVector_t m_pathPowerLinear;
+	mutable complexVector_t m_weightsScratch;
 };
 
 
@@ -0,0 +1,336 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+
+#include "mmwave-channel-tensor.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <algorithm>
+#include <cmath>
+
+namespace ns3{
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveChannelTensor");
+
+// number of lanes the kernels are unrolled on, i.e., 4 doubles for a 256 bit register
+#define TENSOR_LANES 4
+
+ChannelTensor::ChannelTensor ()
+	: m_rxSize (0),
+	  m_txSize (0),
+	  m_numCluster (0),
+	  m_stride (0)
+{
+}
+
+void
+ChannelTensor::Resize (uint16_t rxSize, uint16_t txSize, uint16_t numCluster)
+{
+	m_rxSize = rxSize;
+	m_txSize = txSize;
+	m_numCluster = numCluster;
+	m_stride = (numCluster + TENSOR_LANES - 1) / TENSOR_LANES * TENSOR_LANES;
+	std::size_t size = static_cast<std::size_t> (rxSize) * txSize * m_stride;
+	m_re.assign (size, 0.0);
+	m_im.assign (size, 0.0);
+}
+
+void
+ChannelTensor::Clear ()
+{
+	m_rxSize = 0;
+	m_txSize = 0;
+	m_numCluster = 0;
+	m_stride = 0;
+	m_re.clear ();
+	m_im.clear ();
+}
+
+void
+ChannelTensor::Scale (uint16_t u, uint16_t s, uint16_t firstCluster, double factor)
+{
+	std::size_t base = Index (u, s, 0);
+	for (uint16_t n = firstCluster; n < m_numCluster; n++)
+	{
+		m_re[base + n] *= factor;
+		m_im[base + n] *= factor;
+	}
+}
+
+void
+ChannelTensor::TxCovariance (complexVector_t &txQ) const
+{
+	NS_ASSERT_MSG (!IsEmpty (), "the channel has not been generated");
+	txQ.assign (static_cast<std::size_t> (m_txSize) * m_txSize, std::complex<double> (0, 0));
+
+	const double *re = m_re.data ();
+	const double *im = m_im.data ();
+	std::size_t rowStride = static_cast<std::size_t> (m_txSize) * m_stride;
+
+	// Q is Hermitian, only the upper triangle is accumulated
+	for (uint16_t t1 = 0; t1 < m_txSize; t1++)
+	{
+		for (uint16_t t2 = t1; t2 < m_txSize; t2++)
+		{
+			double accRe[TENSOR_LANES] = {0, 0, 0, 0};
+			double accIm[TENSOR_LANES] = {0, 0, 0, 0};
+			for (uint16_t r = 0; r < m_rxSize; r++)
+			{
+				const double *aRe = re + r * rowStride + t1 * m_stride;
+				const double *aIm = im + r * rowStride + t1 * m_stride;
+				const double *bRe = re + r * rowStride + t2 * m_stride;
+				const double *bIm = im + r * rowStride + t2 * m_stride;
+				for (uint16_t c = 0; c < m_stride; c += TENSOR_LANES)
+				{
+					for (uint16_t l = 0; l < TENSOR_LANES; l++)
+					{
+						// conj(a)*b
+						accRe[l] += aRe[c + l] * bRe[c + l] + aIm[c + l] * bIm[c + l];
+						accIm[l] += aRe[c + l] * bIm[c + l] - aIm[c + l] * bRe[c + l];
+					}
+				}
+			}
+			std::complex<double> sum (accRe[0] + accRe[1] + accRe[2] + accRe[3],
+					accIm[0] + accIm[1] + accIm[2] + accIm[3]);
+			txQ[t1 * m_txSize + t2] = sum;
+			txQ[t2 * m_txSize + t1] = std::conj (sum);
+		}
+	}
+}
+
+void
+ChannelTensor::RxCovariance (complexVector_t &rxQ) const
+{
+	NS_ASSERT_MSG (!IsEmpty (), "the channel has not been generated");
+	rxQ.assign (static_cast<std::size_t> (m_rxSize) * m_rxSize, std::complex<double> (0, 0));
+
+	const double *re = m_re.data ();
+	const double *im = m_im.data ();
+	// the rows of a receive element are contiguous, so the sum over the transmit
+	// elements and the clusters is a single dot product of length txSize*stride
+	std::size_t rowStride = static_cast<std::size_t> (m_txSize) * m_stride;
+
+	for (uint16_t r1 = 0; r1 < m_rxSize; r1++)
+	{
+		for (uint16_t r2 = r1; r2 < m_rxSize; r2++)
+		{
+			double accRe[TENSOR_LANES] = {0, 0, 0, 0};
+			double accIm[TENSOR_LANES] = {0, 0, 0, 0};
+			const double *aRe = re + r1 * rowStride;
+			const double *aIm = im + r1 * rowStride;
+			const double *bRe = re + r2 * rowStride;
+			const double *bIm = im + r2 * rowStride;
+			for (std::size_t i = 0; i < rowStride; i += TENSOR_LANES)
+			{
+				for (uint16_t l = 0; l < TENSOR_LANES; l++)
+				{
+					// a*conj(b)
+					accRe[l] += aRe[i + l] * bRe[i + l] + aIm[i + l] * bIm[i + l];
+					accIm[l] += aIm[i + l] * bRe[i + l] - aRe[i + l] * bIm[i + l];
+				}
+			}
+			std::complex<double> sum (accRe[0] + accRe[1] + accRe[2] + accRe[3],
+					accIm[0] + accIm[1] + accIm[2] + accIm[3]);
+			rxQ[r1 * m_rxSize + r2] = sum;
+			rxQ[r2 * m_rxSize + r1] = std::conj (sum);
+		}
+	}
+}
+
+void
+ChannelTensor::ClusterGain (const complexVector_t &txW, const complexVector_t &rxW,
+		complexVector_t &gain) const
+{
+	NS_ASSERT_MSG (txW.size () == m_txSize, "the tx antenna size of channel and antenna weights should be the same");
+	NS_ASSERT_MSG (rxW.size () == m_rxSize, "the rx antenna size of channel and antenna weights should be the same");
+
+	alignedDoubleVector_t gainRe (m_stride, 0.0);
+	alignedDoubleVector_t gainIm (m_stride, 0.0);
+	alignedDoubleVector_t rxSumRe (m_stride);
+	alignedDoubleVector_t rxSumIm (m_stride);
+	std::size_t rowStride = static_cast<std::size_t> (m_txSize) * m_stride;
+
+	for (uint16_t s = 0; s < m_txSize; s++)
+	{
+		std::fill (rxSumRe.begin (), rxSumRe.end (), 0.0);
+		std::fill (rxSumIm.begin (), rxSumIm.end (), 0.0);
+		for (uint16_t u = 0; u < m_rxSize; u++)
+		{
+			// conj(rxW[u])*H[u][s][n], vectorized over the clusters
+			double wRe = rxW[u].real ();
+			double wIm = -rxW[u].imag ();
+			const double *hRe = m_re.data () + u * rowStride + s * m_stride;
+			const double *hIm = m_im.data () + u * rowStride + s * m_stride;
+			for (uint16_t c = 0; c < m_stride; c++)
+			{
+				rxSumRe[c] += wRe * hRe[c] - wIm * hIm[c];
+				rxSumIm[c] += wRe * hIm[c] + wIm * hRe[c];
+			}
+		}
+		double wRe = txW[s].real ();
+		double wIm = txW[s].imag ();
+		for (uint16_t c = 0; c < m_stride; c++)
+		{
+			gainRe[c] += wRe * rxSumRe[c] - wIm * rxSumIm[c];
+			gainIm[c] += wRe * rxSumIm[c] + wIm * rxSumRe[c];
+		}
+	}
+
+	gain.resize (m_numCluster);
+	for (uint16_t c = 0; c < m_numCluster; c++)
+	{
+		gain[c] = std::complex<double> (gainRe[c], gainIm[c]);
+	}
+}
+
+CovarianceEigenSolver::CovarianceEigenSolver ()
+	: m_maxIterations (10),
+	  m_tolerance (1e-10)
+{
+}
+
+void
+CovarianceEigenSolver::SetMaxIterations (uint16_t maxIterations)
+{
+	m_maxIterations = maxIterations;
+}
+
+void
+CovarianceEigenSolver::SetTolerance (double tolerance)
+{
+	m_tolerance = tolerance;
+}
+
+uint16_t
+CovarianceEigenSolver::Solve (const complexVector_t &Q, uint16_t size,
+		const complexVector_t &initial, complexVector_t &result)
+{
+	NS_ASSERT_MSG (Q.size () == static_cast<std::size_t> (size) * size, "the correlation matrix is not square");
+
+	// the row stride is padded so that every row of the planes is aligned
+	uint16_t stride = (size + TENSOR_LANES - 1) / TENSOR_LANES * TENSOR_LANES;
+	m_qRe.assign (static_cast<std::size_t> (stride) * stride, 0.0);
+	m_qIm.assign (static_cast<std::size_t> (stride) * stride, 0.0);
+	for (uint16_t row = 0; row < size; row++)
+	{
+		for (uint16_t col = 0; col < size; col++)
+		{
+			m_qRe[row * stride + col] = Q[row * size + col].real ();
+			m_qIm[row * stride + col] = Q[row * size + col].imag ();
+		}
+	}
+
+	m_xRe.assign (stride, 0.0);
+	m_xIm.assign (stride, 0.0);
+	m_yRe.assign (stride, 0.0);
+	m_yIm.assign (stride, 0.0);
+
+	double initialNorm = 0;
+	if (initial.size () == size)
+	{
+		for (uint16_t i = 0; i < size; i++)
+		{
+			initialNorm += std::norm (initial[i]);
+		}
+	}
+	if (initialNorm > 0)
+	{
+		double scale = 1 / std::sqrt (initialNorm);
+		for (uint16_t i = 0; i < size; i++)
+		{
+			m_xRe[i] = initial[i].real () * scale;
+			m_xIm[i] = initial[i].imag () * scale;
+		}
+	}
+	else
+	{
+		for (uint16_t i = 0; i < size; i++)
+		{
+			m_xRe[i] = Q[i].real ();
+			m_xIm[i] = Q[i].imag ();
+		}
+	}
+
+	uint16_t iter = 0;
+	double diff = 1;
+	while (iter < m_maxIterations && diff > m_tolerance)
+	{
+		// y = Q x, 4 rows at a time
+		for (uint16_t row = 0; row < stride; row += TENSOR_LANES)
+		{
+			double accRe[TENSOR_LANES] = {0, 0, 0, 0};
+			double accIm[TENSOR_LANES] = {0, 0, 0, 0};
+			for (uint16_t col = 0; col < stride; col++)
+			{
+				double xRe = m_xRe[col];
+				double xIm = m_xIm[col];
+				for (uint16_t l = 0; l < TENSOR_LANES; l++)
+				{
+					double qRe = m_qRe[(row + l) * stride + col];
+					double qIm = m_qIm[(row + l) * stride + col];
+					accRe[l] += qRe * xRe - qIm * xIm;
+					accIm[l] += qRe * xIm + qIm * xRe;
+				}
+			}
+			for (uint16_t l = 0; l < TENSOR_LANES; l++)
+			{
+				m_yRe[row + l] = accRe[l];
+				m_yIm[row + l] = accIm[l];
+			}
+		}
+
+		double weightSum = 0;
+		for (uint16_t i = 0; i < stride; i++)
+		{
+			weightSum += m_yRe[i] * m_yRe[i] + m_yIm[i] * m_yIm[i];
+		}
+		if (weightSum == 0)
+		{
+			// Q x = 0, x cannot be improved
+			break;
+		}
+		double scale = 1 / std::sqrt (weightSum);
+		diff = 0;
+		for (uint16_t i = 0; i < stride; i++)
+		{
+			m_yRe[i] *= scale;
+			m_yIm[i] *= scale;
+			double dRe = m_yRe[i] - m_xRe[i];
+			double dIm = m_yIm[i] - m_xIm[i];
+			diff += dRe * dRe + dIm * dIm;
+		}
+		m_xRe.swap (m_yRe);
+		m_xIm.swap (m_yIm);
+		iter++;
+	}
+
+	result.resize (size);
+	for (uint16_t i = 0; i < size; i++)
+	{
+		result[i] = std::complex<double> (m_xRe[i], m_xIm[i]);
+	}
+	return iter;
+}
+
+}  //namespace ns3
@@ -0,0 +1,231 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+
+#ifndef MMWAVE_CHANNEL_TENSOR_H_
+#define MMWAVE_CHANNEL_TENSOR_H_
+
+#include <complex>
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include <stdint.h>
+
+namespace ns3{
+
+typedef std::vector< std::complex<double> > complexVector_t;
+
+/**
+ * Minimal allocator returning memory aligned to Align bytes, so that the
+ * planes of a ChannelTensor can be loaded with aligned SIMD instructions
+ */
+template <class T, std::size_t Align>
+struct AlignedAllocator
+{
+	typedef T value_type;
+
+	template <class U>
+	struct rebind
+	{
+		typedef AlignedAllocator<U, Align> other;
+	};
+
+	AlignedAllocator () {}
+	template <class U>
+	AlignedAllocator (const AlignedAllocator<U, Align> &) {}
+
+	T* allocate (std::size_t n)
+	{
+		void *p = 0;
+		if (posix_memalign (&p, Align, n * sizeof (T)) != 0)
+		{
+			throw std::bad_alloc ();
+		}
+		return static_cast<T*> (p);
+	}
+
+	void deallocate (T *p, std::size_t)
+	{
+		free (p);
+	}
+
+	template <class U>
+	bool operator== (const AlignedAllocator<U, Align> &) const
+	{
+		return true;
+	}
+	template <class U>
+	bool operator!= (const AlignedAllocator<U, Align> &) const
+	{
+		return false;
+	}
+};
+
+typedef std::vector<double, AlignedAllocator<double, 32> > alignedDoubleVector_t;
+
+/**
+ * \brief Flat storage for the channel matrix H[u][s][n] of TR 38.900, where u is the
+ * receive element, s the transmit element and n the cluster.
+ *
+ * The real and imaginary parts are kept in two separate planes. In each plane the
+ * clusters of an (u,s) pair are contiguous and the row stride is padded with zeros
+ * to a multiple of 4 doubles, so that every row starts on a 32-byte boundary and
+ * the kernels below can be unrolled on 4 lanes without a scalar tail.
+ */
+class ChannelTensor
+{
+public:
+	ChannelTensor ();
+
+	/**
+	 * Allocate a zero-filled tensor
+	 * @params the number of receive elements
+	 * @params the number of transmit elements
+	 * @params the number of clusters
+	 */
+	void Resize (uint16_t rxSize, uint16_t txSize, uint16_t numCluster);
+
+	/**
+	 * Release the coefficients (used to trigger the spatially consistent update)
+	 */
+	void Clear ();
+
+	bool IsEmpty () const
+	{
+		return m_re.empty ();
+	}
+
+	uint16_t GetRxSize () const
+	{
+		return m_rxSize;
+	}
+	uint16_t GetTxSize () const
+	{
+		return m_txSize;
+	}
+	uint16_t GetNumCluster () const
+	{
+		return m_numCluster;
+	}
+
+	std::complex<double> Get (uint16_t u, uint16_t s, uint16_t n) const
+	{
+		std::size_t i = Index (u, s, n);
+		return std::complex<double> (m_re[i], m_im[i]);
+	}
+
+	void Set (uint16_t u, uint16_t s, uint16_t n, std::complex<double> value)
+	{
+		std::size_t i = Index (u, s, n);
+		m_re[i] = value.real ();
+		m_im[i] = value.imag ();
+	}
+
+	/**
+	 * Multiply all the clusters of (u,s) starting from firstCluster by a real factor
+	 */
+	void Scale (uint16_t u, uint16_t s, uint16_t firstCluster, double factor);
+
+	/**
+	 * Compute the transmitter side spatial correlation matrix Q = H^H H, summed over
+	 * the receive elements and the clusters
+	 * @params the output txSize x txSize matrix, row-major
+	 */
+	void TxCovariance (complexVector_t &txQ) const;
+
+	/**
+	 * Compute the receiver side spatial correlation matrix Q = H H^H, summed over
+	 * the transmit elements and the clusters
+	 * @params the output rxSize x rxSize matrix, row-major
+	 */
+	void RxCovariance (complexVector_t &rxQ) const;
+
+	/**
+	 * Compute the per-cluster beamforming gain rxW^H H_n txW
+	 * @params the tx antenna weights
+	 * @params the rx antenna weights
+	 * @params the output vector, one entry per cluster
+	 */
+	void ClusterGain (const complexVector_t &txW, const complexVector_t &rxW,
+			complexVector_t &gain) const;
+
+private:
+	std::size_t Index (uint16_t u, uint16_t s, uint16_t n) const
+	{
+		return (static_cast<std::size_t> (u) * m_txSize + s) * m_stride + n;
+	}
+
+	uint16_t m_rxSize;
+	uint16_t m_txSize;
+	uint16_t m_numCluster;
+	uint16_t m_stride; // m_numCluster rounded up to a multiple of 4
+	alignedDoubleVector_t m_re;
+	alignedDoubleVector_t m_im;
+};
+
+/**
+ * \brief Dominant eigenvector solver for the Hermitian spatial correlation matrices
+ * computed by ChannelTensor.
+ *
+ * It runs the power method with a matrix-vector product blocked on 4 rows, so that
+ * every element of the iterate is loaded once per block, on split real/imaginary
+ * buffers that are kept across calls. The iteration can be warm-started from the
+ * weights of the previous realization of the same link, which for a spatially
+ * consistent update are usually already close to the new dominant eigenvector.
+ */
+class CovarianceEigenSolver
+{
+public:
+	CovarianceEigenSolver ();
+
+	void SetMaxIterations (uint16_t maxIterations);
+	void SetTolerance (double tolerance);
+
+	/**
+	 * Compute the normalized dominant eigenvector of Q
+	 * @params the size x size Hermitian matrix, row-major
+	 * @params the size of the matrix
+	 * @params the starting point, used only if it has the right size and is not zero,
+	 * otherwise the first row of Q is used
+	 * @params the output eigenvector
+	 * @returns the number of iterations performed
+	 */
+	uint16_t Solve (const complexVector_t &Q, uint16_t size,
+			const complexVector_t &initial, complexVector_t &result);
+
+private:
+	uint16_t m_maxIterations;
+	double m_tolerance;
+	alignedDoubleVector_t m_qRe;
+	alignedDoubleVector_t m_qIm;
+	alignedDoubleVector_t m_xRe;
+	alignedDoubleVector_t m_xIm;
+	alignedDoubleVector_t m_yRe;
+	alignedDoubleVector_t m_yIm;
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_CHANNEL_TENSOR_H_ */
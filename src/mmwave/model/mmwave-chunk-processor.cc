@@ -69,7 +69,14 @@ namespace ns3 {
         {
             m_sumValues = Create<SpectrumValue> (sinr.GetSpectrumModel ());
         }
-        (*m_sumValues) += sinr * duration.GetSeconds ();
+        // accumulate sinr * duration without building a temporary SpectrumValue
+        NS_ASSERT (m_sumValues->GetSpectrumModel () == sinr.GetSpectrumModel ());
+        double seconds = duration.GetSeconds ();
+        Values::const_iterator sinrIt = sinr.ConstValuesBegin ();
+        for (Values::iterator sumIt = m_sumValues->ValuesBegin (); sumIt != m_sumValues->ValuesEnd (); ++sumIt, ++sinrIt)
+        {
+            *sumIt += *sinrIt * seconds;
+        }
         m_totDuration += duration;
     }
 
@@ -85,6 +85,8 @@ MmWaveEnbPhy::MmWaveEnbPhy (Ptr<MmWaveSpectrumPhy> dlPhy, Ptr<MmWaveSpectrumPhy>
     :MmWavePhy (dlPhy, ulPhy),
 	m_prevSlot (0),
   m_prevSlotDir (SlotAllocInfo::NA),
+  m_sinrEstimateNoiseFigure (0),
+  m_reuseStaticLinkSinr (false),
   m_currSymStart (0)
 {
 	m_enbCphySapProvider = new MemberLteEnbCphySapProvider<MmWaveEnbPhy> (this);
@@ -124,6 +126,14 @@ MmWaveEnbPhy::GetTypeId (void)
 	               DoubleValue (25.6),
 	               MakeDoubleAccessor (&MmWaveEnbPhy::m_ueUpdateSinrPeriod),
 	               MakeDoubleChecker<double> ())
+	.AddAttribute ("ReuseStaticLinkSinr",
+	               "If true, the periodic SINR estimate reuses the received PSD of a link when both its ends "
+	               "did not move and the tx power did not change since the previous estimate, instead of "
+	               "computing the pathloss and the channel again. Only valid if the channel of a link changes "
+	               "only when its ends move",
+	               BooleanValue (false),
+	               MakeBooleanAccessor (&MmWaveEnbPhy::m_reuseStaticLinkSinr),
+	               MakeBooleanChecker())
 	.AddAttribute("Transient",
 				  "Transient period (in microseconds) in which just collect SINR values without filtering the sample",
 				  IntegerValue (320000),
@@ -560,6 +570,7 @@ void
 MmWaveEnbPhy::SetSubChannels (std::vector<int> mask )
 {
 	m_listOfSubchannels = mask;
+	m_ueTxPsdTemplates.clear ();
 	Ptr<SpectrumValue> txPsd = CreateTxPowerSpectralDensity ();
 	NS_ASSERT (txPsd);
 	m_downlinkSpectrumPhy->SetTxPowerSpectralDensity (txPsd);
@@ -577,6 +588,30 @@ MmWaveEnbPhy::GetUlSpectrumPhy () const
   return m_uplinkSpectrumPhy;
 }
 
+Ptr<const SpectrumValue>
+MmWaveEnbPhy::GetSinrEstimateNoisePsd ()
+{
+	if (m_sinrEstimateNoisePsd == 0 || m_sinrEstimateNoiseFigure != m_noiseFigure)
+	{
+		m_sinrEstimateNoisePsd = MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, m_noiseFigure);
+		m_sinrEstimateNoiseFigure = m_noiseFigure;
+	}
+	return m_sinrEstimateNoisePsd;
+}
+
+Ptr<const SpectrumValue>
+MmWaveEnbPhy::GetUeTxPsdTemplate (double txPower)
+{
+	std::map<double, Ptr<SpectrumValue> >::iterator it = m_ueTxPsdTemplates.find (txPower);
+	if (it == m_ueTxPsdTemplates.end ())
+	{
+		// it is the eNB that dictates the conf, m_listOfSubchannels contains all the subch
+		Ptr<SpectrumValue> txPsd = MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_phyMacConfig, txPower, m_listOfSubchannels);
+		it = m_ueTxPsdTemplates.insert (std::make_pair (txPower, txPsd)).first;
+	}
+	return it->second;
+}
+
 void
 MmWaveEnbPhy::CallPathloss()
 {
@@ -586,35 +621,13 @@ MmWaveEnbPhy::CallPathloss()
 	Ptr<SpectrumValue> noisePsd = MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, m_noiseFigure);
 	Ptr<SpectrumValue> totalReceivedPsd = Create <SpectrumValue> (SpectrumValue(noisePsd->GetSpectrumModel()));
 
-	for(std::map<uint64_t, Ptr<NetDevice> >::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
+	for(std::map<uint64_t, AttachedUeInfo>::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
 	{
-		// distinguish between MC and MmWaveNetDevice
-		Ptr<MmWaveUeNetDevice> ueNetDevice = DynamicCast<MmWaveUeNetDevice> (ue->second);
-		Ptr<McUeNetDevice> mcUeDev = DynamicCast<McUeNetDevice> (ue->second);
-		Ptr<MmWaveIabNetDevice> iabDev = DynamicCast<MmWaveIabNetDevice> (ue->second);
-		Ptr<MmWaveUePhy> uePhy;
+		// the kind of device (UE, MC UE or IAB) was resolved in AddUePhy
+		const AttachedUeInfo &ueInfo = ue->second;
+		Ptr<MmWaveUePhy> uePhy = GetAttachedUePhy (ueInfo);
 		// get tx power
-		double ueTxPower = 0;
-		if(ueNetDevice != 0) 
-		{
-			uePhy = ueNetDevice->GetPhy();
-			ueTxPower = uePhy->GetTxPower();
-		}
-		else if (mcUeDev != 0) // it may be a MC device
-		{
-			
-			uePhy = mcUeDev->GetMmWavePhy ();
-			ueTxPower = uePhy->GetTxPower();	
-		}
-		else if (iabDev != 0)
-		{
-			uePhy = iabDev->GetBackhaulPhy();
-			ueTxPower = uePhy->GetTxPower();
-		}
-		else
-		{
-			NS_FATAL_ERROR("Unrecognized device");
-		}
+		double ueTxPower = uePhy->GetTxPower();
 		NS_LOG_LOGIC("UE Tx power = " << ueTxPower);
 	    double powerTxW = std::pow (10., (ueTxPower - 30) / 10);
 	    double txPowerDensity = 0;
@@ -630,14 +643,14 @@ MmWaveEnbPhy::CallPathloss()
 		// get this node and remote node mobility
 		Ptr<MobilityModel> enbMob = m_netDevice->GetNode()->GetObject<MobilityModel>(); 
 		NS_LOG_LOGIC("eNB mobility " << enbMob->GetPosition());
-		Ptr<MobilityModel> ueMob = ue->second->GetNode()->GetObject<MobilityModel>();
+		Ptr<MobilityModel> ueMob = ueInfo.m_device->GetNode()->GetObject<MobilityModel>();
 		NS_LOG_DEBUG("UE mobility " << ueMob->GetPosition());
 		
 		// compute rx psd
 
 		// adjuts beamforming of antenna model wrt user
 		Ptr<AntennaArrayModel> rxAntennaArray = DynamicCast<AntennaArrayModel> (GetDlSpectrumPhy ()->GetRxAntenna());
-		rxAntennaArray->ChangeBeamformingVector (ue->second);									// TODO check if this is the correct antenna
+		rxAntennaArray->ChangeBeamformingVector (ueInfo.m_device);									// TODO check if this is the correct antenna
 		Ptr<AntennaArrayModel> txAntennaArray = DynamicCast<AntennaArrayModel> (uePhy->GetDlSpectrumPhy ()->GetRxAntenna());
 																						// Dl, since the Ul is not actually used (TDD device)
 		txAntennaArray->ChangeBeamformingVector (m_netDevice);									// TODO check if this is the correct antenna
@@ -673,53 +686,31 @@ MmWaveEnbPhy::CallPathloss()
 		Ptr<SpectrumValue> rxPsd = txPsd->Copy();
 		*(rxPsd) *= pathGainLinear;              
 
-		Ptr<MmWaveBeamforming> beamforming = DynamicCast<MmWaveBeamforming> (m_spectrumPropagationLossModel);
-		//beamforming->SetBeamformingVector(ue->second, m_netDevice);
-		Ptr<MmWaveChannelMatrix> channelMatrix = DynamicCast<MmWaveChannelMatrix> (m_spectrumPropagationLossModel);
-		Ptr<MmWaveChannelRaytracing> rayTracing = DynamicCast<MmWaveChannelRaytracing> (m_spectrumPropagationLossModel);
-		if (beamforming != 0)
+		switch (m_spectrumPropagationLossModelKind)
 		{
-			rxPsd = beamforming->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		case BEAMFORMING_MODEL:
+			rxPsd = StaticCast<MmWaveBeamforming> (m_spectrumPropagationLossModel)->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
 			NS_LOG_LOGIC("RxPsd " << *rxPsd);
-		}
-		else if (channelMatrix != 0)
-		{
-			rxPsd = channelMatrix->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+			break;
+		case CHANNEL_MATRIX_MODEL:
+			rxPsd = StaticCast<MmWaveChannelMatrix> (m_spectrumPropagationLossModel)->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
 			NS_LOG_LOGIC("RxPsd " << *rxPsd);
-		}
-		else if (rayTracing != 0)
-		{
-			rxPsd = rayTracing->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+			break;
+		case RAYTRACING_MODEL:
+			rxPsd = StaticCast<MmWaveChannelRaytracing> (m_spectrumPropagationLossModel)->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
 			NS_LOG_LOGIC("RxPsd " << *rxPsd);
+			break;
+		default:
+			break;
 		}
 		m_rxPsdMap[ue->first] = rxPsd;
 		*totalReceivedPsd += *rxPsd;
 
 		// set back the bf vector to the main eNB
-		if(ueNetDevice != 0) 
-		{														// target not set yet
-			if((ueNetDevice->GetTargetEnb() != m_netDevice) && (ueNetDevice->GetTargetEnb() != 0))
-			{
-				txAntennaArray->ChangeBeamformingVector(ueNetDevice->GetTargetEnb());
-			}
-		}
-		else if (mcUeDev != 0) // it may be a MC device
-		{															// target not set yet
-			if((mcUeDev->GetMmWaveTargetEnb() != m_netDevice) && (mcUeDev->GetMmWaveTargetEnb() != 0))
-			{
-				txAntennaArray->ChangeBeamformingVector(mcUeDev->GetMmWaveTargetEnb());
-			}	
-		}
-		else if (iabDev !=0) // it may be an IAB backhaul
+		Ptr<NetDevice> targetEnb = GetAttachedUeTargetEnb (ueInfo);
+		if((targetEnb != m_netDevice) && (targetEnb != 0))	// target not set yet
 		{
-			if((iabDev->GetBackhaulTargetEnb() != m_netDevice) && (iabDev->GetBackhaulTargetEnb() != 0))
-			{
-				txAntennaArray->ChangeBeamformingVector(iabDev->GetBackhaulTargetEnb());
-			}
-		}
-		else
-		{
-			NS_FATAL_ERROR("Unrecognized device");
+			txAntennaArray->ChangeBeamformingVector(targetEnb);
 		}
 
 	}
@@ -741,169 +732,162 @@ MmWaveEnbPhy::CallPathloss()
 
 
 
+Ptr<SpectrumValue>
+MmWaveEnbPhy::ComputeUeRxPsd (double ueTxPower, Ptr<MobilityModel> ueMob, Ptr<MobilityModel> enbMob,
+		Ptr<AntennaArrayModel> txAntennaArray, Ptr<AntennaArrayModel> rxAntennaArray)
+{
+	Ptr<const SpectrumValue> txPsd = GetUeTxPsdTemplate (ueTxPower);
+	NS_LOG_LOGIC("TxPsd " << *txPsd);
+
+	double pathLossDb = 0;
+	if (txAntennaArray != 0)
+	{
+	  Angles txAngles (enbMob->GetPosition (), ueMob->GetPosition ());
+	  double txAntennaGain = txAntennaArray->GetGainDb (txAngles);
+	  NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+	  pathLossDb -= txAntennaGain;
+	}
+	if (rxAntennaArray != 0)
+	{
+	  Angles rxAngles (ueMob->GetPosition (), enbMob->GetPosition ());
+	  double rxAntennaGain = rxAntennaArray->GetGainDb (rxAngles);
+	  NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+	  pathLossDb -= rxAntennaGain;
+	}
+	if (m_propagationLoss)
+	{
+		if (m_losTracker != 0) // if I am using the PL propagation model with Aditya's traces
+		{
+			m_losTracker->UpdateLosNlosState(ueMob,enbMob); // update the maps to keep trak of the real PL values, before computing the PL
+		}
+	  double propagationGainDb = m_propagationLoss->CalcRxPower (0, ueMob, enbMob);
+	  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+	  pathLossDb -= propagationGainDb;
+	}                    
+	//NS_LOG_DEBUG ("total pathLoss = " << pathLossDb << " dB");    
+
+	double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+	Ptr<SpectrumValue> rxPsd = txPsd->Copy();
+	*(rxPsd) *= pathGainLinear;              
+
+	switch (m_spectrumPropagationLossModelKind)
+	{
+	case BEAMFORMING_MODEL:
+		rxPsd = StaticCast<MmWaveBeamforming> (m_spectrumPropagationLossModel)->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		NS_LOG_LOGIC("RxPsd " << *rxPsd);
+		break;
+	case CHANNEL_MATRIX_MODEL:
+		rxPsd = StaticCast<MmWaveChannelMatrix> (m_spectrumPropagationLossModel)->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		NS_LOG_LOGIC("RxPsd " << *rxPsd);
+		break;
+	case RAYTRACING_MODEL:
+		rxPsd = StaticCast<MmWaveChannelRaytracing> (m_spectrumPropagationLossModel)->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		NS_LOG_LOGIC("RxPsd " << *rxPsd);
+		break;
+	case CHANNEL_3GPP_MODEL:
+		rxPsd = StaticCast<MmWave3gppChannel> (m_spectrumPropagationLossModel)->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		NS_LOG_LOGIC("RxPsd " << *rxPsd);
+		break;
+	default:
+		break;
+	}
+	return rxPsd;
+}
+
 void
 MmWaveEnbPhy::UpdateUeSinrEstimate()
 {
 
 	m_sinrMap.clear();
-	m_rxPsdMap.clear();
-	
+	// the devices are never detached, so every entry of m_rxPsdMap is
+	// overwritten below and the map does not need to be rebuilt
+
+	// the noise PSD and the tx PSD of the devices only depend on the
+	// configuration, they are reused across the updates
+	Ptr<const SpectrumValue> noisePsd = GetSinrEstimateNoisePsd ();
+	// the total received PSD is only used to log the interference
+	bool logInterference = g_log.IsEnabled (LOG_LOGIC);
+	Ptr<SpectrumValue> totalReceivedPsd;
+	if (logInterference)
+	{
+		totalReceivedPsd = Create <SpectrumValue> (SpectrumValue(noisePsd->GetSpectrumModel()));
+	}
 
-	Ptr<SpectrumValue> noisePsd = MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, m_noiseFigure);
-	Ptr<SpectrumValue> totalReceivedPsd = Create <SpectrumValue> (SpectrumValue(noisePsd->GetSpectrumModel()));
+	// get this node mobility
+	Ptr<MobilityModel> enbMob = m_netDevice->GetNode()->GetObject<MobilityModel>(); 
+	NS_LOG_LOGIC("eNB mobility " << enbMob->GetPosition());
+	Vector enbPosition = enbMob->GetPosition ();
+	Ptr<AntennaArrayModel> rxAntennaArray = DynamicCast<AntennaArrayModel> (GetDlSpectrumPhy ()->GetRxAntenna());
 
-	for(std::map<uint64_t, Ptr<NetDevice> >::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
+	for(std::map<uint64_t, AttachedUeInfo>::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
 	{
-		// distinguish between MC and MmWaveNetDevice
-		Ptr<MmWaveUeNetDevice> ueNetDevice = DynamicCast<MmWaveUeNetDevice> (ue->second);
-		Ptr<McUeNetDevice> mcUeDev = DynamicCast<McUeNetDevice> (ue->second);
-		Ptr<MmWaveIabNetDevice> iabDev = DynamicCast<MmWaveIabNetDevice> (ue->second);
-		Ptr<MmWaveUePhy> uePhy;
+		// the kind of device (UE, MC UE or IAB) was resolved in AddUePhy
+		const AttachedUeInfo &ueInfo = ue->second;
+		Ptr<MmWaveUePhy> uePhy = GetAttachedUePhy (ueInfo);
 		// get tx power
-		double ueTxPower = 0;
-		if(ueNetDevice != 0) 
-		{
-			uePhy = ueNetDevice->GetPhy();
-			ueTxPower = uePhy->GetTxPower();
-		}
-		else if (mcUeDev != 0) // it may be a MC device
-		{
-			
-			uePhy = mcUeDev->GetMmWavePhy ();
-			ueTxPower = uePhy->GetTxPower();	
-		}
-		else if (iabDev != 0)
-		{
-			uePhy = iabDev->GetBackhaulPhy();
-			ueTxPower = uePhy->GetTxPower();
-		}
-		else
-		{
-			NS_FATAL_ERROR("Unrecognized device");
-		}
+		double ueTxPower = uePhy->GetTxPower();
 		NS_LOG_LOGIC("UE Tx power = " << ueTxPower);
-	    double powerTxW = std::pow (10., (ueTxPower - 30) / 10);
-	    double txPowerDensity = 0;
-    	txPowerDensity = (powerTxW / (m_phyMacConfig->GetSystemBandwidth()));
-	    NS_LOG_LOGIC("Linear UE Tx power = " << powerTxW);
-	    NS_LOG_LOGIC("System bandwidth = " << m_phyMacConfig->GetSystemBandwidth());
-	    NS_LOG_LOGIC("txPowerDensity = " << txPowerDensity);
-		// create tx psd
-		Ptr<SpectrumValue> txPsd =						// it is the eNB that dictates the conf, m_listOfSubchannels contains all the subch
-			MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_phyMacConfig, ueTxPower, m_listOfSubchannels);
-		NS_LOG_LOGIC("TxPsd " << *txPsd);
 
-		// get this node and remote node mobility
-		Ptr<MobilityModel> enbMob = m_netDevice->GetNode()->GetObject<MobilityModel>(); 
-		NS_LOG_LOGIC("eNB mobility " << enbMob->GetPosition());
-		Ptr<MobilityModel> ueMob = ue->second->GetNode()->GetObject<MobilityModel>();
+		// get remote node mobility
+		Ptr<MobilityModel> ueMob = ueInfo.m_device->GetNode()->GetObject<MobilityModel>();
 		NS_LOG_DEBUG("UE mobility " << ueMob->GetPosition());
-		
-		// compute rx psd
+		Vector uePosition = ueMob->GetPosition ();
 
 		// adjuts beamforming of antenna model wrt user
-		Ptr<AntennaArrayModel> rxAntennaArray = DynamicCast<AntennaArrayModel> (GetDlSpectrumPhy ()->GetRxAntenna());
-		rxAntennaArray->ChangeBeamformingVector (ue->second);									// TODO check if this is the correct antenna
+		rxAntennaArray->ChangeBeamformingVector (ueInfo.m_device);									// TODO check if this is the correct antenna
 		Ptr<AntennaArrayModel> txAntennaArray = DynamicCast<AntennaArrayModel> (uePhy->GetDlSpectrumPhy ()->GetRxAntenna());
 																						// Dl, since the Ul is not actually used (TDD device)
 		txAntennaArray->ChangeBeamformingVector (m_netDevice);									// TODO check if this is the correct antenna
-		
-		double pathLossDb = 0;
-		if (txAntennaArray != 0)
-		{
-		  Angles txAngles (enbMob->GetPosition (), ueMob->GetPosition ());
-		  double txAntennaGain = txAntennaArray->GetGainDb (txAngles);
-		  NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-		  pathLossDb -= txAntennaGain;
-		}
-		if (rxAntennaArray != 0)
-		{
-		  Angles rxAngles (ueMob->GetPosition (), enbMob->GetPosition ());
-		  double rxAntennaGain = rxAntennaArray->GetGainDb (rxAngles);
-		  NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-		  pathLossDb -= rxAntennaGain;
-		}
-		if (m_propagationLoss)
-		{
-			if (m_losTracker != 0) // if I am using the PL propagation model with Aditya's traces
-			{
-				m_losTracker->UpdateLosNlosState(ueMob,enbMob); // update the maps to keep trak of the real PL values, before computing the PL
-			}
-		  double propagationGainDb = m_propagationLoss->CalcRxPower (0, ueMob, enbMob);
-		  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-		  pathLossDb -= propagationGainDb;
-		}                    
-		//NS_LOG_DEBUG ("total pathLoss = " << pathLossDb << " dB");    
-
-		double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-		Ptr<SpectrumValue> rxPsd = txPsd->Copy();
-		*(rxPsd) *= pathGainLinear;              
 
-		Ptr<MmWaveBeamforming> beamforming = DynamicCast<MmWaveBeamforming> (m_spectrumPropagationLossModel);
-		//beamforming->SetBeamformingVector(ue->second, m_netDevice);
-		Ptr<MmWaveChannelMatrix> channelMatrix = DynamicCast<MmWaveChannelMatrix> (m_spectrumPropagationLossModel);
-		Ptr<MmWaveChannelRaytracing> rayTracing = DynamicCast<MmWaveChannelRaytracing> (m_spectrumPropagationLossModel);
-		Ptr<MmWave3gppChannel> mmWave3gpp = DynamicCast<MmWave3gppChannel> (m_spectrumPropagationLossModel);
-		if (beamforming != 0)
+		SinrEstimateLink &link = m_sinrEstimateLinks[ue->first];
+		Ptr<SpectrumValue> rxPsd;
+		if (m_reuseStaticLinkSinr && link.m_rxPsd != 0 && link.m_txPower == ueTxPower
+				&& link.m_uePosition.x == uePosition.x && link.m_uePosition.y == uePosition.y && link.m_uePosition.z == uePosition.z
+				&& link.m_enbPosition.x == enbPosition.x && link.m_enbPosition.y == enbPosition.y && link.m_enbPosition.z == enbPosition.z)
 		{
-			rxPsd = beamforming->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
+			// neither end moved since the last update
+			rxPsd = link.m_rxPsd;
 		}
-		else if (channelMatrix != 0)
+		else
 		{
-			rxPsd = channelMatrix->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
+			rxPsd = ComputeUeRxPsd (ueTxPower, ueMob, enbMob, txAntennaArray, rxAntennaArray);
+			link.m_rxPsd = rxPsd;
+			link.m_txPower = ueTxPower;
+			link.m_uePosition = uePosition;
+			link.m_enbPosition = enbPosition;
 		}
-		else if (rayTracing != 0)
+		m_rxPsdMap[ue->first] = rxPsd;
+		if (logInterference)
 		{
-			rxPsd = rayTracing->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
+			*totalReceivedPsd += *rxPsd;
 		}
-		else if (mmWave3gpp != 0)
-		{
-			rxPsd = mmWave3gpp->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
-		}	
-		m_rxPsdMap[ue->first] = rxPsd;
-		*totalReceivedPsd += *rxPsd;
 
 		// set back the bf vector to the main eNB
-		if(ueNetDevice != 0) 
-		{														// target not set yet
-			if((ueNetDevice->GetTargetEnb() != m_netDevice) && (ueNetDevice->GetTargetEnb() != 0))
-			{
-				txAntennaArray->ChangeBeamformingVector(ueNetDevice->GetTargetEnb());
-			}
-		}
-		else if (mcUeDev != 0) // it may be a MC device
-		{															// target not set yet
-			if((mcUeDev->GetMmWaveTargetEnb() != m_netDevice) && (mcUeDev->GetMmWaveTargetEnb() != 0))
-			{
-				txAntennaArray->ChangeBeamformingVector(mcUeDev->GetMmWaveTargetEnb());
-			}	
-		}
-		else if (iabDev !=0) // it may be an IAB backhaul
+		Ptr<NetDevice> targetEnb = GetAttachedUeTargetEnb (ueInfo);
+		if((targetEnb != m_netDevice) && (targetEnb != 0))	// target not set yet
 		{
-			if((iabDev->GetBackhaulTargetEnb() != m_netDevice) && (iabDev->GetBackhaulTargetEnb() != 0))
-			{
-				txAntennaArray->ChangeBeamformingVector(iabDev->GetBackhaulTargetEnb());
-			}
-		}
-		else
-		{
-			NS_FATAL_ERROR("Unrecognized device");
+			txAntennaArray->ChangeBeamformingVector(targetEnb);
 		}
 
 	}
 
 	for(std::map<uint64_t, Ptr<SpectrumValue> >::iterator ue = m_rxPsdMap.begin(); ue != m_rxPsdMap.end(); ++ue)
 	{
-		SpectrumValue interference = *totalReceivedPsd - *(ue->second);
-		NS_LOG_LOGIC("interference " << interference);
-		SpectrumValue sinr = *(ue->second)/(*noisePsd); // + interference); 
-		// we consider the SNR only!
-		NS_LOG_LOGIC("sinr " << sinr);
-		double sinrAvg = Sum(sinr)/(sinr.GetSpectrumModel()->GetNumBands());
+		if (logInterference)
+		{
+			SpectrumValue interference = *totalReceivedPsd - *(ue->second);
+			NS_LOG_LOGIC("interference " << interference);
+			NS_LOG_LOGIC("sinr " << *(ue->second)/(*noisePsd));
+		}
+		// we consider the SNR only! It is averaged in a single pass over the
+		// received and the noise PSDs, in the same order as Sum (rxPsd / noisePsd)
+		double sinrSum = 0;
+		Values::const_iterator noiseIt = noisePsd->ConstValuesBegin ();
+		for (Values::const_iterator rxIt = ue->second->ConstValuesBegin (); rxIt != ue->second->ConstValuesEnd (); ++rxIt, ++noiseIt)
+		{
+			sinrSum += (*rxIt) / (*noiseIt);
+		}
+		double sinrAvg = sinrSum/(ue->second->GetSpectrumModel()->GetNumBands());
 		NS_LOG_DEBUG("Time " << Simulator::Now().GetSeconds() << " CellId " << m_cellId << " UE " << ue->first << "Average SINR " << 10*std::log10(sinrAvg));
 
 		if(m_noiseAndFilter)
@@ -1113,25 +1097,9 @@ MmWaveEnbPhy::UpdateUeSinrEstimate()
 	if(m_roundFromLastUeSinrUpdate >= (m_ueUpdateSinrPeriod/m_updateSinrPeriod))
 	{
 		m_roundFromLastUeSinrUpdate = 0;
-		for(std::map<uint64_t, Ptr<NetDevice> >::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
+		for(std::map<uint64_t, AttachedUeInfo>::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
 		{
-			// distinguish between MC and MmWaveNetDevice
-			Ptr<MmWaveUeNetDevice> ueNetDevice = DynamicCast<MmWaveUeNetDevice> (ue->second);
-			Ptr<McUeNetDevice> mcUeDev = DynamicCast<McUeNetDevice> (ue->second);
-			Ptr<MmWaveIabNetDevice> iabDev = DynamicCast<MmWaveIabNetDevice> (ue->second);
-			Ptr<MmWaveUePhy> uePhy;
-			if(ueNetDevice != 0) 
-			{
-				uePhy = ueNetDevice->GetPhy();
-			}
-			else if (mcUeDev != 0) // it may be a MC device
-			{
-				uePhy = mcUeDev->GetMmWavePhy ();
-			}
-			else if (iabDev != 0)
-			{
-				uePhy = iabDev->GetBackhaulPhy();
-			}
+			Ptr<MmWaveUePhy> uePhy = GetAttachedUePhy (ue->second);
 			uePhy->UpdateSinrEstimate(m_cellId, m_sinrMap.find(ue->first)->second);
 		}
 	}
@@ -1358,17 +1326,13 @@ MmWaveEnbPhy::StartSubFrame (void)
 
 		for (uint8_t i = 0; i < m_deviceMap.size (); i++)
 		{
-			Ptr<MmWaveUeNetDevice> ueDev = DynamicCast<MmWaveUeNetDevice> (m_deviceMap.at (i));
-			Ptr<McUeNetDevice> mcUeDev = DynamicCast<McUeNetDevice> (m_deviceMap.at (i));
-			Ptr<MmWaveIabNetDevice> iabDev = DynamicCast<MmWaveIabNetDevice> (m_deviceMap.at (i));
-			uint64_t ueRnti = (ueDev != 0) ? (ueDev->GetPhy ()->GetRnti ()) : 
-											 (mcUeDev != 0 ? (mcUeDev->GetMmWavePhy()->GetRnti ()) : (iabDev->GetBackhaulPhy()->GetRnti()));
+			uint64_t ueRnti = GetAttachedUePhy (m_deviceMap.at (i))->GetRnti ();
 			//NS_LOG_DEBUG ("Scheduled rnti:"<<rnti <<" ue rnti:"<< ueRnti);
 			if (currSlot.m_rnti == ueRnti)
 			{
 				//NS_LOG_DEBUG ("Change Beamforming Vector");
 				Ptr<AntennaArrayModel> antennaArray = DynamicCast<AntennaArrayModel> (GetDlSpectrumPhy ()->GetRxAntenna());
-				antennaArray->ChangeBeamformingVector (m_deviceMap.at (i));
+				antennaArray->ChangeBeamformingVector (m_deviceMap.at (i).m_device);
 				break;
 			}
 		}
@@ -1466,29 +1430,14 @@ MmWaveEnbPhy::SendDataChannels (Ptr<PacketBurst> pb, Time slotPrd, SlotAllocInfo
 		//uint16_t rnti = ueRbIt->first;
 		for (uint8_t i = 0; i < m_deviceMap.size (); i++)
 		{
-			uint64_t ueRnti = 0;
-			Ptr<MmWaveUeNetDevice> ueDev = m_deviceMap.at(i)->GetObject<MmWaveUeNetDevice> ();
-			Ptr<McUeNetDevice> ueMcDev = m_deviceMap.at(i)->GetObject<McUeNetDevice> ();
-			Ptr<MmWaveIabNetDevice> iabDev = m_deviceMap.at(i)->GetObject<MmWaveIabNetDevice> ();
-			if (ueDev != 0) 
-			{
-				ueRnti = ueDev->GetPhy ()-> GetRnti ();
-			}
-			else if(ueMcDev != 0)
-			{
-				ueRnti = ueMcDev->GetMmWavePhy () -> GetRnti ();
-			} 
-			else if(iabDev != 0)
-			{
-				ueRnti = iabDev->GetBackhaulPhy () -> GetRnti ();
-			}
+			uint64_t ueRnti = GetAttachedUePhy (m_deviceMap.at (i))->GetRnti ();
 
 			//NS_LOG_DEBUG ("Scheduled rnti:"<<rnti <<" ue rnti:"<< ueRnti);
 			if (slotInfo.m_dci.m_rnti == ueRnti)
 			{
 				//NS_LOG_DEBUG ("Change Beamforming Vector");
 				Ptr<AntennaArrayModel> antennaArray = DynamicCast<AntennaArrayModel> (GetDlSpectrumPhy ()->GetRxAntenna());
-				antennaArray->ChangeBeamformingVector (m_deviceMap.at (i));
+				antennaArray->ChangeBeamformingVector (m_deviceMap.at (i).m_device);
 				break;
 			}
 
@@ -1518,6 +1467,40 @@ MmWaveEnbPhy::SendCtrlChannels(std::list<Ptr<MmWaveControlMessage> > ctrlMsgs, T
 	m_downlinkSpectrumPhy->StartTxDlControlFrames (ctrlMsgs, slotPrd);
 }
 
+Ptr<MmWaveUePhy>
+MmWaveEnbPhy::GetAttachedUePhy (const AttachedUeInfo &ue) const
+{
+	switch (ue.m_type)
+	{
+	case UE:
+		return ue.m_ueDevice->GetPhy ();
+	case MCUE:
+		return ue.m_mcUeDevice->GetMmWavePhy ();
+	case IAB:
+		return ue.m_iabDevice->GetBackhaulPhy ();
+	default:
+		NS_FATAL_ERROR("Unrecognized device");
+		return 0;
+	}
+}
+
+Ptr<NetDevice>
+MmWaveEnbPhy::GetAttachedUeTargetEnb (const AttachedUeInfo &ue) const
+{
+	switch (ue.m_type)
+	{
+	case UE:
+		return ue.m_ueDevice->GetTargetEnb ();
+	case MCUE:
+		return ue.m_mcUeDevice->GetMmWaveTargetEnb ();
+	case IAB:
+		return ue.m_iabDevice->GetBackhaulTargetEnb ();
+	default:
+		NS_FATAL_ERROR("Unrecognized device");
+		return 0;
+	}
+}
+
 bool
 MmWaveEnbPhy::AddUePhy (uint64_t imsi, Ptr<NetDevice> ueDevice)
 {
@@ -1528,8 +1511,28 @@ MmWaveEnbPhy::AddUePhy (uint64_t imsi, Ptr<NetDevice> ueDevice)
 	if (it == m_ueAttached.end ())
 	{
 		m_ueAttached.insert(imsi);
-		m_deviceMap.push_back(ueDevice);
-		m_ueAttachedImsiMap[imsi] = ueDevice;
+		// resolve the kind of device once, so that the per-slot beam steering
+		// and the periodic SINR updates do not have to cast it again
+		AttachedUeInfo ueInfo;
+		ueInfo.m_device = ueDevice;
+		if ((ueInfo.m_ueDevice = DynamicCast<MmWaveUeNetDevice> (ueDevice)) != 0)
+		{
+			ueInfo.m_type = UE;
+		}
+		else if ((ueInfo.m_mcUeDevice = DynamicCast<McUeNetDevice> (ueDevice)) != 0)
+		{
+			ueInfo.m_type = MCUE;
+		}
+		else if ((ueInfo.m_iabDevice = DynamicCast<MmWaveIabNetDevice> (ueDevice)) != 0)
+		{
+			ueInfo.m_type = IAB;
+		}
+		else
+		{
+			NS_FATAL_ERROR("Unrecognized device");
+		}
+		m_deviceMap.push_back(ueInfo);
+		m_ueAttachedImsiMap[imsi] = ueInfo;
 		return (true);
 	}
 	else
@@ -43,6 +43,7 @@
 #include <ns3/lte-enb-phy-sap.h>
 #include <ns3/lte-enb-cphy-sap.h>
 #include <ns3/mmwave-harq-phy.h>
+#include <ns3/vector.h>
 
 namespace ns3{
 
@@ -52,6 +53,10 @@ class PacketBurst;
 class MmWaveNetDevice;
 class MmWaveUePhy;
 class MmWaveEnbMac;
+class MmWaveUeNetDevice;
+class McUeNetDevice;
+class MmWaveIabNetDevice;
+class AntennaArrayModel;
 
 class MmWaveEnbPhy : public MmWavePhy
 {
@@ -153,6 +158,61 @@ private:
     void QueueUlTbAlloc (TbAllocInfo tbAllocInfo);
     std::list<TbAllocInfo> DequeueUlTbAlloc ();
 
+    /**
+     * A device attached to this eNB, with its kind and its typed pointer
+     * resolved once when it attaches to the eNB
+     */
+    struct AttachedUeInfo
+    {
+      Ptr<NetDevice> m_device;
+      DeviceType_t m_type;  // UE, MCUE or IAB
+      Ptr<MmWaveUeNetDevice> m_ueDevice;
+      Ptr<McUeNetDevice> m_mcUeDevice;
+      Ptr<MmWaveIabNetDevice> m_iabDevice;
+    };
+    /**
+     * \return the PHY the attached device uses toward this eNB
+     */
+    Ptr<MmWaveUePhy> GetAttachedUePhy (const AttachedUeInfo &ue) const;
+    /**
+     * \return the eNB the attached device is currently targeting
+     */
+    Ptr<NetDevice> GetAttachedUeTargetEnb (const AttachedUeInfo &ue) const;
+
+    /**
+     * State of the link with an attached device kept between two calls of
+     * UpdateUeSinrEstimate
+     */
+    struct SinrEstimateLink
+    {
+      Ptr<SpectrumValue> m_rxPsd;  // received PSD computed at the last update
+      double m_txPower;
+      Vector m_uePosition;
+      Vector m_enbPosition;
+    };
+    /**
+     * \return the noise PSD used by UpdateUeSinrEstimate, created again only
+     * if the noise figure changed
+     */
+    Ptr<const SpectrumValue> GetSinrEstimateNoisePsd ();
+    /**
+     * \return the PSD of a device transmitting with the given power over
+     * m_listOfSubchannels, shared by all the devices with the same power
+     */
+    Ptr<const SpectrumValue> GetUeTxPsdTemplate (double txPower);
+    /**
+     * Compute the PSD received from an attached device, including the antenna
+     * gains, the pathloss and the spectrum propagation loss model
+     * @params the tx power of the device
+     * @params the mobility of the device
+     * @params the mobility of this eNB
+     * @params the antenna of the device, pointed to this eNB
+     * @params the antenna of this eNB, pointed to the device
+     * @returns the received PSD
+     */
+    Ptr<SpectrumValue> ComputeUeRxPsd (double ueTxPower, Ptr<MobilityModel> ueMob, Ptr<MobilityModel> enbMob,
+                                       Ptr<AntennaArrayModel> txAntennaArray, Ptr<AntennaArrayModel> rxAntennaArray);
+
     uint8_t m_currSfNumSlots;
 
     uint32_t m_numRbg;
@@ -165,7 +225,7 @@ private:
 
     SlotAllocInfo::TddMode m_prevSlotDir;
 
-    std::vector< Ptr<NetDevice> > m_deviceMap;
+    std::vector<AttachedUeInfo> m_deviceMap;
 
     MmWaveEnbPhySapUser* m_phySapUser;
 
@@ -173,9 +233,14 @@ private:
     LteEnbCphySapUser* m_enbCphySapUser;
     LteRrcSap::SystemInformationBlockType1 m_sib1;
     std::set <uint16_t> m_ueAttachedRnti;
-    std::map <uint64_t, Ptr<NetDevice> > m_ueAttachedImsiMap;
+    std::map <uint64_t, AttachedUeInfo> m_ueAttachedImsiMap;
     std::map <uint64_t, double > m_sinrMap;
     std::map <uint64_t, Ptr<SpectrumValue> > m_rxPsdMap;
+    Ptr<SpectrumValue> m_sinrEstimateNoisePsd;
+    double m_sinrEstimateNoiseFigure;  // noise figure of m_sinrEstimateNoisePsd
+    std::map <double, Ptr<SpectrumValue> > m_ueTxPsdTemplates;  // indexed by tx power
+    std::map <uint64_t, SinrEstimateLink> m_sinrEstimateLinks;
+    bool m_reuseStaticLinkSinr;  // reuse the received PSD of the links whose ends did not move
 	std::map <pairDevices_t , std::vector<double> > m_sinrVector; // array containing all SINR values for a specific pair (UE-eNB)
 	std::map <pairDevices_t , std::vector<double> > m_sinrVectorToFilter; // array containing the  SINR values that must be filtered
 	std::map <pairDevices_t , std::vector<double> > m_sinrVectorNoisy; // array containing the  noisy SINR values that must be filteredF
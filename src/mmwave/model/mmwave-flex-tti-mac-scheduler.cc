@@ -169,28 +169,14 @@ namespace ns3 {
 	m_scheduler->DoSchedSetMcs (mcs);
     }
 
-    const unsigned MmWaveFlexTtiMacScheduler::m_macHdrSize = 0;
-    const unsigned MmWaveFlexTtiMacScheduler::m_subHdrSize = 4;
-    const unsigned MmWaveFlexTtiMacScheduler::m_rlcHdrSize = 3;
-
-    const double MmWaveFlexTtiMacScheduler::m_berDl = 0.001;  // TODO: Seems not used in the current code.
 
     MmWaveFlexTtiMacScheduler::MmWaveFlexTtiMacScheduler ()
         :m_nextRnti (0),
-  	 m_subframeNo (0),
-  	 m_tbUid (0),
-  	 m_macSchedSapUser (0),
-	 m_macCschedSapUser (0),
-	 m_maxSchedulingDelay (1),
-	 m_iabScheduler (false),
-	 m_split (true)
+  	 m_subframeNo (0)
     {
 	NS_LOG_FUNCTION (this);
 	m_macSchedSapProvider = new MmWaveFlexTtiMacSchedSapProvider (this);
 	m_macCschedSapProvider = new MmWaveFlexTtiMacCschedSapProvider (this);
-        // Specific Sap Provider defined for the backhaul usage. It uses UeMac's CschedSapProvider
-	m_iabBackahulSapProvider = new MemberMmWaveUeMacCschedSapProvider<MmWaveFlexTtiMacScheduler> (this);
-	m_iabBusySubframeAllocation.clear();
     }
 
     MmWaveFlexTtiMacScheduler::~MmWaveFlexTtiMacScheduler ()
@@ -202,25 +188,16 @@ namespace ns3 {
     MmWaveFlexTtiMacScheduler::DoDispose (void)
     {
 	NS_LOG_FUNCTION (this);
-	m_wbCqiRxed.clear();
-        m_dlHarqProcessesDciInfoMap.clear ();
-        m_dlHarqProcessesTimer.clear ();
-        m_dlHarqProcessesRlcPduMap.clear ();
-        m_dlHarqInfoList.clear ();
-        m_ulHarqCurrentProcessId.clear ();
-        m_ulHarqProcessesStatus.clear ();
-        m_ulHarqProcessesTimer.clear ();
-        m_ulHarqProcessesDciInfoMap.clear ();
-        m_iabBusySubframeAllocation.clear();
         delete m_macCschedSapProvider;
         delete m_macSchedSapProvider;
+	MmWaveFlexTtiSchedulerBase::DoDispose ();
     }
 
     TypeId
     MmWaveFlexTtiMacScheduler::GetTypeId (void)
     {
         static TypeId tid = TypeId ("ns3::MmWaveFlexTtiMacScheduler")
-	    .SetParent<MmWaveMacScheduler> ()
+	    .SetParent<MmWaveFlexTtiSchedulerBase> ()
 	    .AddConstructor<MmWaveFlexTtiMacScheduler> ()
 	    .AddAttribute ("CqiTimerThreshold",
 			    "The number of TTIs a CQI is valid (default 1000 - 1 sec.)",
@@ -286,149 +263,6 @@ namespace ns3 {
         return tid;
     }
 
-    /*
-     * Called by "InstallSingleIabDevice" and "InstallSingleEnbDevice" in "mmwave-helper.cc";
-     */
-    void
-    MmWaveFlexTtiMacScheduler::SetMacSchedSapUser (MmWaveMacSchedSapUser* sap)
-    {
-	m_macSchedSapUser = sap;  // Pointer to the primitives from "Scheduler" module to "Subframe" module in MAC
-    }
-
-    void
-    MmWaveFlexTtiMacScheduler::SetMacCschedSapUser (MmWaveMacCschedSapUser* sap)
-    {
-	m_macCschedSapUser = sap;  // Pointer to the primitives from "Scheduler" module to "Control" module in MAC
-    }
-
-    void
-    MmWaveFlexTtiMacScheduler::SetIabScheduler(bool iabScheduler)
-    {
-	m_iabScheduler = iabScheduler;
-    }
-
-    MmWaveMacSchedSapProvider*
-    MmWaveFlexTtiMacScheduler::GetMacSchedSapProvider ()
-    {
-	return m_macSchedSapProvider;
-    }
-
-    MmWaveMacCschedSapProvider*
-    MmWaveFlexTtiMacScheduler::GetMacCschedSapProvider ()
-    {
-	return m_macCschedSapProvider;
-    }
-
-    // IAB methods
-    void
-    MmWaveFlexTtiMacScheduler::SetMmWaveUeMacCschedSapProvider(MmWaveUeMacCschedSapProvider* sap)
-    {
-	m_iabBackahulSapProvider = sap;
-    }
-
-    MmWaveUeMacCschedSapProvider*
-    MmWaveFlexTtiMacScheduler::GetMmWaveUeMacCschedSapProvider()
-    {
-	return m_iabBackahulSapProvider;
-    }
-
-    std::string
-    MmWaveFlexTtiMacScheduler::PrintSubframeAllocationMask(std::vector<bool> mask)
-    {
-	std::stringstream strStream;
-	for(auto bit : mask)
-	    strStream << bit << " ";
-	return strStream.str();
-    }
-
-    /*
-     * ================================================================================
-     * IAB Method: "mmwave-ue-mac" call this function to tell the current IAB scheduler
-     * the scheduling result of its previous hop. And update the "busy" region in the 
-     * specific subframe corresponding to the received DCI (i.e., "info").
-     * ================================================================================
-     */
-    void
-    MmWaveFlexTtiMacScheduler::DoIabBackhaulSchedNotify(const struct MmWaveUeMacCschedSapProvider::IabBackhaulSchedInfo& info)
-    {
-	/*
-	 * MmWaveUeMacCschedSapProvider defines all primitives from "Control" to "Scheduler". 
-	 * As in an IAB node, the Ue stack functions the backhaul role, the scheduling information of IAB backhaul is transferred
-	 * through the Sap defined in the mmWave UE MAC.
-	 */
-	NS_LOG_FUNCTION(this << info.m_dciInfoElementTdma.m_rnti);  // The DCI's m_rnti identifies which "UE" should receive this DCI.
-	NS_ASSERT_MSG(m_iabScheduler, "Received DCI info for backhaul on a non IAB scheduler");  // This "Scheduler" must be an IAB one. 
-	NS_LOG_DEBUG("MmWaveFlexTtiMacScheduler received DCIs for the backhaul link");
-	// signal that the resources are busy
-	// In the default setting for mmWave module, 1 frame contains 10 subframes, each of which contains 24 symbols (or slots). 
-	NS_LOG_DEBUG("input info  frame " << info.m_sfnSf.m_frameNum << " subframe " << (uint16_t)info.m_sfnSf.m_sfNum <<  " slot/symbol " << (uint16_t)info.m_sfnSf.m_slotNum);
-
-	uint32_t subframe = info.m_sfnSf.m_sfNum;  // which subframe in the current frame of the received DCI
-	uint32_t frame = info.m_sfnSf.m_frameNum;  // the current frame number of the received DCI
-
-	// Get the already stored SfIabAllocInfo for this subframe index.
-	SfIabAllocInfo currentInfo = m_iabBusySubframeAllocation.at(subframe);
-	SfIabAllocInfo newInfo(m_phyMacConfig->GetSymbolsPerSubframe ());  // Each subframe contains 24 slots in the default setting.
-	NS_LOG_DEBUG("currentInfo frame " << currentInfo.m_sfnSf.m_frameNum << " subframe " << (uint16_t)currentInfo.m_sfnSf.m_sfNum);
-
-	if(currentInfo.m_sfnSf.m_frameNum == frame)
-	{
-	    // another DCI has already been registered for this subframe, and the already stored "currentInfo" will be used to update the "newInfo".
-	    newInfo = currentInfo;
-	    NS_LOG_DEBUG("This frame/subframe had already a DCI stored with mask " << PrintSubframeAllocationMask(newInfo.m_symAllocationMask));
-	    // TODOIAB plot relevant info
-	    // newInfo.m_dlSymStart << " m_dlNumSymAlloc " << newInfo.m_dlNumSymAlloc << " m_ulSymStart " <<
-	    // newInfo.m_ulSymStart << " m_ulSymStart " << newInfo.m_ulNumSymAlloc);
-	}
-	else
-	{
-	    // The received DCI aims for the first time scheduling of this subframe.	
-	    newInfo.m_sfnSf = info.m_sfnSf;
-	}
-
-	uint32_t firstAllocatedIdx = info.m_dciInfoElementTdma.m_symStart;
-	uint32_t nextFreeIdx = firstAllocatedIdx + info.m_dciInfoElementTdma.m_numSym;  // Reflects the continuous slots/symbols allocation.
-	// _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ 24 slots
-	//       |-----------------------| |
-	//       m_symStart  |             nextFreeIdx
-	//                   m_numSym
-
-	// check if it (i.e., the allocation in the DCI) overlaps with already busy regions
-	for(uint32_t index = firstAllocatedIdx; index < nextFreeIdx; index++)
-	{
-	    // A slot within a subframe cannot be allocated by more than one DCIs. Only update the allocation when a slot has not been allocated before. 
-	    NS_ASSERT_MSG(newInfo.m_symAllocationMask.at(index) == 0, "DCI signals that a symbol is scheduled for IAB, but it was already scheduled");
-	    newInfo.m_symAllocationMask.at(index) = 1;
-	}	
-	NS_LOG_DEBUG("This frame/subframe has updated the newInfo  with mask " << PrintSubframeAllocationMask(newInfo.m_symAllocationMask));
-
-	// if(info.m_dciInfoElementTdma.m_format == DciInfoElementTdma::DL_dci)
-	// {
-	// 	// downlink DCI
-	// 	if(newInfo.m_dlSymStart != 0 || newInfo.m_dlNumSymAlloc > 0)
-	// 	{
-	// 		NS_FATAL_ERROR("Trying to overwrite DL information on a SfIabAllocInfo");
-	// 	}
-	// 	newInfo.m_dlSymStart = info.m_dciInfoElementTdma.m_symStart;
-	// 	newInfo.m_dlNumSymAlloc = info.m_dciInfoElementTdma.m_numSym;
-	// 	NS_LOG_DEBUG("DL Num symbols used " << (uint16_t)info.m_dciInfoElementTdma.m_numSym << " from symbol "
-	// 				<< (uint16_t)info.m_dciInfoElementTdma.m_symStart);
-	// }
-	// else
-	// {
-	// 	// uplink DCI
-	// 	if(newInfo.m_ulSymStart != 0 || newInfo.m_ulNumSymAlloc > 0)
-	// 	{
-	// 		NS_FATAL_ERROR("Trying to overwrite UL information on a SfIabAllocInfo");
-	// 	}
-	// 	newInfo.m_ulSymStart = info.m_dciInfoElementTdma.m_symStart;
-	// 	newInfo.m_ulNumSymAlloc = info.m_dciInfoElementTdma.m_numSym;
-	// 	NS_LOG_DEBUG("UL Num symbols used " << (uint16_t)info.m_dciInfoElementTdma.m_numSym << " from symbol "
-	// 				<< (uint16_t)info.m_dciInfoElementTdma.m_symStart);	
-	// }
-	m_iabBusySubframeAllocation.at(subframe) = newInfo;  // Update the IAB allocation info vector.
-    }
-
     /*
      * ============================================================
      * Called by "mmwave-helper" when installing single IAB or Enb.
@@ -437,344 +271,10 @@ namespace ns3 {
     void
     MmWaveFlexTtiMacScheduler::ConfigureCommonParameters (Ptr<MmWavePhyMacCommon> config)
     {
-	m_phyMacConfig = config;
-	m_amc = CreateObject <MmWaveAmc> (m_phyMacConfig);
-	m_numRbg = m_phyMacConfig->GetNumRb () / m_phyMacConfig->GetNumRbPerRbg ();  // By default, in TDMA, m_numRbg = 1;
-	m_numHarqProcess = m_phyMacConfig->GetNumHarqProcess ();
-	m_harqTimeout = m_phyMacConfig->GetHarqTimeout ();
+	MmWaveFlexTtiSchedulerBase::ConfigureCommonParameters (config);
 	NS_LOG_UNCOND("Number of Harq processes " << (uint32_t)m_numHarqProcess << " Harq time out " << (uint32_t)m_harqTimeout);
-	m_numDataSymbols = m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetDlCtrlSymbols () - m_phyMacConfig->GetUlCtrlSymbols ();  // Dl ctrl, Ul ctrl, and data symbols
-	NS_ASSERT_MSG (m_phyMacConfig->GetNumRb () == 1, "System must be configured with numRb=1 for TDMA mode");
-
-	// Initialize the uplink and downlink subframe allocation information.
-	for (unsigned i = 0; i < m_phyMacConfig->GetUlSchedDelay(); i++)  // By default, it is 1.
-	{
-	    m_ulSfAllocInfo.push_back (SfAllocInfo (SfnSf (0, i, 0)));
-	}
-
-	for (unsigned i = 0; i < m_phyMacConfig->GetSubframesPerFrame(); i++)
-	{
-	    m_iabBusySubframeAllocation.push_back(SfIabAllocInfo(SfnSf (0, i, 0), false, m_phyMacConfig->GetSymbolsPerSubframe ()));
-	}
-    }
-
-    /*
-     * =========================================================
-     * Complete the downlink RLC buffer request.
-     * Enb MAC send "params" to the current scheduler.
-     * =========================================================
-     */
-    void
-    MmWaveFlexTtiMacScheduler::DoSchedDlRlcBufferReq (const struct MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters& params)
-    {
-        NS_LOG_FUNCTION (this << params.m_rnti << (uint32_t) params.m_logicalChannelIdentity);
-        // API generated by RLC for updating RLC parameters on a LC (tx and retx queues)
-        std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it = m_rlcBufferReq.begin ();
-        bool newLc = true;  // Boolean varibale for identifying a new logical channel.
-        // Iterate through the vector of UE's RLC information to remove all existing entries belongs to the (UE,LC) of input "params".
-        while (it != m_rlcBufferReq.end ())
-        {
-            if (((*it).m_rnti == params.m_rnti) && ((*it).m_logicalChannelIdentity == params.m_logicalChannelIdentity))
-            {
-                it = m_rlcBufferReq.erase (it);  // Remove the old entry of this (UE,LC). 
-                newLc = false;                   // It is not a new logical channel.
-            }
-            else
-            {
-                ++it;
-            }
-        }
-        // Due to the above operation, after a buffer request is scheduled and executed, there is only one entry of this (UE,LC) in the list.
-        // Add the new parameters at the end of the list "m_rlcBufferReq". 
-        m_rlcBufferReq.insert (it, params);
-        NS_LOG_DEBUG ("BSR for RNTI " << params.m_rnti << " LC " << (uint16_t)params.m_logicalChannelIdentity 
-		      << " RLC tx size " << params.m_rlcTransmissionQueueSize << " RLC retx size " << params.m_rlcRetransmissionQueueSize 
-		      << " RLC stat size " <<  params.m_rlcStatusPduSize);
-        // Initialize statistics of the flow in case of new flows. In the simulation, a new (UE,LC) corresponds to a new flow.
-        if (newLc == true)
-        {
-            m_wbCqiRxed.insert (std::pair<uint16_t, uint8_t > (params.m_rnti, 1));	// Only codeword 0 at this stage (SISO)
-  	    // Cqi is initialized to 1 (i.e., the lowest value for transmitting a signal).
-            m_wbCqiTimers.insert (std::pair<uint16_t, uint32_t > (params.m_rnti, m_cqiTimersThreshold));
-        }
-    }
-
-    /*
-     * =============================================================================================
-     * Phy indicate to the enb mac about a subframe, and enb mac sends the cqi message to scheduler.
-     * =============================================================================================
-     */
-    void
-    MmWaveFlexTtiMacScheduler::DoSchedDlCqiInfoReq (const struct MmWaveMacSchedSapProvider::SchedDlCqiInfoReqParameters& params)
-    {
-        NS_LOG_FUNCTION (this);
-
-        std::map <uint16_t,uint8_t>::iterator it;
-        for (unsigned int i = 0; i < params.m_cqiList.size (); i++)
-        {
-            if ( params.m_cqiList.at (i).m_cqiType == DlCqiInfo::WB )
-            {
-                // wideband CQI reporting
-                std::map <uint16_t,uint8_t>::iterator it;
-                uint16_t rnti = params.m_cqiList.at (i).m_rnti;
-                it = m_wbCqiRxed.find (rnti);
-                if (it == m_wbCqiRxed.end ())
-                {
-                    // create the new entry, the cqi from this enb/iab to the ue (rnti)
-                    m_wbCqiRxed.insert ( std::pair<uint16_t, uint8_t > (rnti, params.m_cqiList.at (i).m_wbCqi) ); // only codeword 0 at this stage (SISO)
-                    // generate correspondent timer
-                    m_wbCqiTimers.insert ( std::pair<uint16_t, uint32_t > (rnti, m_cqiTimersThreshold));
-                }
-                else
-                {
-                    // update the CQI value
-                    (*it).second = params.m_cqiList.at (i).m_wbCqi;
-                    // update correspondent timer
-                    std::map <uint16_t,uint32_t>::iterator itTimers;
-                    itTimers = m_wbCqiTimers.find (rnti);
-                    (*itTimers).second = m_cqiTimersThreshold;
-                }
-            }
-            else if ( params.m_cqiList.at (i).m_cqiType == DlCqiInfo::SB )
-            {
-                // subband CQI reporting high layer configured
-                // Not used by RR Scheduler
-            }
-            else
-            {
-                NS_LOG_ERROR (this << " CQI type unknown");
-            }
-        }
-    }
-
-
-    void
-    MmWaveFlexTtiMacScheduler::DoSchedUlCqiInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters& params)
-    {
-        NS_LOG_FUNCTION (this);
-
-        unsigned frameNum = params.m_sfnSf.m_frameNum;
-        unsigned subframeNum =  params.m_sfnSf.m_sfNum;
-        unsigned startSymIdx =  params.m_sfnSf.m_slotNum;
-
-        switch (params.m_ulCqi.m_type)
-        {
-            case UlCqiInfo::PUSCH:
-	    {
-	        std::map <uint32_t, struct AllocMapElem>::iterator itMap;
-	        std::map <uint16_t, struct UlCqiMapElem>::iterator itCqi;
-	        itMap = m_ulAllocationMap.find (params.m_sfnSf.Encode ());
-	        if (itMap == m_ulAllocationMap.end ())
-	        {
-	            NS_LOG_DEBUG (this << " UL CQI Does not find info on allocation, size : " << m_ulAllocationMap.size ());
-		    return;
-	        }
-                NS_ASSERT_MSG (itMap->second.m_rntiPerChunk.size () == m_phyMacConfig->GetTotalNumChunk (), "SINR chunk map must cover full BW in TDMA mode");
-	        for (unsigned i = 0; i < itMap->second.m_rntiPerChunk.size (); i++)
-	        {
-	            // convert from fixed point notation Sxxxxxxxxxxx.xxx to double
-		    // double sinr = LteFfConverter::fpS11dot3toDouble (params.m_ulCqi.m_sinr.at (i));
-		    itCqi = m_ueUlCqi.find (itMap->second.m_rntiPerChunk.at (i));
-		    if (itCqi == m_ueUlCqi.end ())
-		    {
-		        // create a new entry
-		        std::vector <double> newCqi;
-		        for (unsigned j = 0; j < m_phyMacConfig->GetTotalNumChunk (); j++)
-		        {
-		            unsigned chunkInd = i;
-			    if (chunkInd == j)
-			    {
-			        newCqi.push_back (params.m_ulCqi.m_sinr.at (i));
-			        NS_LOG_INFO ("UL CQI report for RNTI " << itMap->second.m_rntiPerChunk.at (i) << " chunk " << i << " SINR " << params.m_ulCqi.m_sinr.at (i) << \
-					     " frame " << frameNum << " subframe " << subframeNum << " startSym " << startSymIdx);
-			    }
-			    else
-			    {
-			        // initialize with NO_SINR value.
-			        newCqi.push_back (30.0);
-			    }
-		        }
-		        m_ueUlCqi.insert (std::pair <uint16_t, struct UlCqiMapElem> (itMap->second.m_rntiPerChunk.at (i),
-					    UlCqiMapElem (newCqi, itMap->second.m_numSym, itMap->second.m_tbSize)) );
-		        // generate correspondent timer
-		        m_ueCqiTimers.insert (std::pair <uint16_t, uint32_t > (itMap->second.m_rntiPerChunk.at (i), m_cqiTimersThreshold));
-		    }
-		    else
-		    {
-		        // update the value
-		        (*itCqi).second.m_ueUlCqi.at (i) = params.m_ulCqi.m_sinr.at (i);
-		        (*itCqi).second.m_numSym = itMap->second.m_numSym;
-		        (*itCqi).second.m_tbSize = itMap->second.m_tbSize;
-		        // update correspondent timer
-		        std::map <uint16_t, uint32_t>::iterator itTimers;
-		        itTimers = m_ueCqiTimers.find (itMap->second.m_rntiPerChunk.at (i));
-		        (*itTimers).second = m_cqiTimersThreshold;
-
-		        NS_LOG_INFO ("UL CQI report for RNTI " << itMap->second.m_rntiPerChunk.at (i) << " chunk " << i << " SINR " << params.m_ulCqi.m_sinr.at (i) << \
-				     " frame " << frameNum << " subframe " << subframeNum << " startSym " << startSymIdx);
-
-		    }
-
-	        }
-	        // remove obsolete info on allocation
-	        m_ulAllocationMap.erase (itMap);
-	    }
-	    break;
-	    default:
-	        NS_FATAL_ERROR ("Unknown type of UL-CQI");
-        }
-        return;
-    }
-
-
-    void
-    MmWaveFlexTtiMacScheduler::RefreshHarqProcesses ()
-    {
-        NS_LOG_FUNCTION (this);
-
-        // DL Harq processes
-        std::map <uint16_t, DlHarqProcessesTimer_t>::iterator itTimers;  // "first" is UE's RNTI, "second" is a vector of DL HARQ Processes Timers
-        for (itTimers = m_dlHarqProcessesTimer.begin (); itTimers != m_dlHarqProcessesTimer.end (); itTimers++)
-        {
-            for (uint16_t i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
-            {
-                if ((*itTimers).second.at (i) == m_phyMacConfig->GetHarqTimeout ())
-                { // Time out, reset HARQ process
-                    NS_LOG_INFO (this << " Reset HARQ proc " << i << " for RNTI " << (*itTimers).first);
-                    std::map <uint16_t, DlHarqProcessesStatus_t>::iterator itStat = m_dlHarqProcessesStatus.find ((*itTimers).first);
-                    if (itStat == m_dlHarqProcessesStatus.end ())
-                    {
-                        NS_FATAL_ERROR ("No Process Id Status found for this RNTI " << (*itTimers).first);
-                    }
-		    (*itStat).second.at (i) = 0;
-		    (*itTimers).second.at (i) = 0;
-                }
-                else
-                {
-                    (*itTimers).second.at (i)++;
-                }
-            }
-        }
-
-    // UL Harq processes
-    std::map <uint16_t, UlHarqProcessesTimer_t>::iterator itTimers2;
-    for (itTimers2 = m_ulHarqProcessesTimer.begin (); itTimers2 != m_ulHarqProcessesTimer.end (); itTimers2++)
-    {
-        for (uint16_t i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
-        {
-            if ((*itTimers2).second.at (i) == m_phyMacConfig->GetHarqTimeout ())
-            { // Time out, reset HARQ process
-                NS_LOG_INFO (this << " Reset HARQ proc " << i << " for RNTI " << (*itTimers2).first);
-                std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_ulHarqProcessesStatus.find ((*itTimers2).first);
-                if (itStat == m_ulHarqProcessesStatus.end ())
-                {
-                    NS_FATAL_ERROR ("No Process Id Status found for this RNTI " << (*itTimers2).first);
-                }
-                (*itStat).second.at (i) = 0;
-                (*itTimers2).second.at (i) = 0;
-            }
-            else
-            {
-                (*itTimers2).second.at (i)++;
-            }
-        }
-    }
-}
-
-uint8_t
-MmWaveFlexTtiMacScheduler::UpdateDlHarqProcessId (uint16_t rnti)
-{
-    NS_LOG_FUNCTION (this << rnti);
-
-    if (m_harqOn == false)
-    {
-        uint8_t tbUid = m_tbUid;
-        m_tbUid = (m_tbUid+1) % m_phyMacConfig->GetNumHarqProcess ();
-        return tbUid;
-    }
-
-//    std::map <uint16_t, uint8_t>::iterator it = m_dlHarqCurrentProcessId.find (rnti);
-//    if (it == m_dlHarqCurrentProcessId.end ())
-//    {
-//        NS_FATAL_ERROR ("No Process Id found for this RNTI " << rnti);
-//    }
-    std::map <uint16_t, DlHarqProcessesStatus_t>::iterator itStat = m_dlHarqProcessesStatus.find (rnti);
-    if (itStat == m_dlHarqProcessesStatus.end ())
-    {
-        NS_FATAL_ERROR ("No Process Id Statusfound for this RNTI " << rnti);
-    }
-
-    // search for available process ID, if none available return numHarqProcess
-    // The "DlHarqProcessesStatus_t" records the usage of each harq process. "0" is available, "1" is not available.
-    uint8_t harqId = m_phyMacConfig->GetNumHarqProcess ();
-    for (unsigned i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
-    {
-        if(itStat->second[i] == 0)
-        {
-            itStat->second[i] = 1;
-            harqId = i;
-            break;
-        }
-    }
-    return harqId;
-
-//    uint8_t i = (*it).second;
-//    do
-//    {
-//        i = (i + 1) % m_phyMacConfig->GetNumHarqProcess ();
-//    }
-//    while ( ((*itStat).second.at (i) != 0)&&(i != (*it).second));
-//    if ((*itStat).second.at (i) == 0)
-//    {
-//        (*it).second = i;
-//        (*itStat).second.at (i) = 1;
-//    }
-//    else
-//    {
-//        return (m_phyMacConfig->GetNumHarqProcess () + 1); // return a not valid harq proc id
-//    }
-//
-//    return ((*it).second);
-}
-
-uint8_t
-MmWaveFlexTtiMacScheduler::UpdateUlHarqProcessId (uint16_t rnti)
-{
-    NS_LOG_FUNCTION (this << rnti);
-
-    if (m_harqOn == false)
-    {
-        uint8_t tbUid = m_tbUid;
-        m_tbUid = (m_tbUid+1) % m_phyMacConfig->GetNumHarqProcess ();
-        return tbUid;
     }
 
-//    std::map <uint16_t, uint8_t>::iterator it = m_ulHarqCurrentProcessId.find (rnti);
-//    if (it == m_ulHarqCurrentProcessId.end ())
-//    {
-//        NS_FATAL_ERROR ("No Process Id found for this RNTI " << rnti);
-//    }
-    std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_ulHarqProcessesStatus.find (rnti);
-    if (itStat == m_ulHarqProcessesStatus.end ())
-    {
-        NS_FATAL_ERROR ("No Process Id Statusfound for this RNTI " << rnti);
-    }
-
-    // search for available process ID, if none available return numHarqProcess+1
-    uint8_t harqId = m_phyMacConfig->GetNumHarqProcess ();
-    for (unsigned i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
-    {
-        if(itStat->second[i] == 0)
-        {
-            itStat->second[i] = 1;
-            harqId = i;
-            break;
-        }
-    }
-    return harqId;
-}
-
-
 /*
  * ============================================================================
  * Calculate the minimum Transmit Block size in terms of number of OFDM symbols 
@@ -834,632 +334,56 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
     return (unsigned)numSymHigh;
 }
 
-    /* 
-     * =====================
-     *   IAB Functionality
-     * =====================  
-     */
-    uint16_t
-    MmWaveFlexTtiMacScheduler::GetNumIabRnti()
-    {
-        uint16_t numIabDevs = 0;
-        // cycle through the list of BSRs, and check which RNTIs are for IAB devs
-        for(auto itRlcBuf : m_rlcBufferReq)
-        {
-            uint16_t rnti = itRlcBuf.m_rnti;
-            NS_LOG_INFO(this << " count rnti " << rnti);
-            // get IAB info
-	    auto iabInfoIt = m_rntiIabInfoMap.find(rnti);
-	    if(iabInfoIt == m_rntiIabInfoMap.end() || !iabInfoIt->second.first)
-	    {
-			// do nothing, as iabInfoIt->second.first identifies whether this device is an IAB or not.
-            }
-            else
-            {
-                if(((itRlcBuf.m_rlcTransmissionQueueSize > 0) 
-		     || (itRlcBuf.m_rlcRetransmissionQueueSize > 0) 
-		     || (itRlcBuf.m_rlcStatusPduSize > 0)))
-                {
-                    numIabDevs++;
-                }
-            }
-            NS_LOG_INFO(this << " numIabDevs " << numIabDevs);
-        }
-        return numIabDevs;
-    }
-
-    /*
-     * ====================================================================
-     * Get the available symbols in the current subframe for IAB scheduler.
-     * ====================================================================
-     */
-    int
-    MmWaveFlexTtiMacScheduler::UpdateBusySymbolsForIab(uint8_t sfNum, uint8_t symIdx, int symAvail)
-    {
-        // get the resources which are already set as busy for this subframe
-        // ----------------------------------------------
-        // Do not allow incontinuous resource allocation.
-        // ----------------------------------------------
-        if(m_iabScheduler && !m_split)
-        {
-            SfIabAllocInfo busyResources = m_iabBusySubframeAllocation.at(sfNum);  // Get the subframe allocation info of "sfNum"
-	    NS_LOG_DEBUG("Before check for IAB resources: symIdx " << (uint16_t)symIdx << " symAvail " << symAvail);
-	    if(busyResources.m_valid)
-	    {
-	        busyResources.m_valid = false; // signal that this SfIabAllocInfo has been used for a prev slot
-	        NS_LOG_DEBUG("This subframe has a DCI stored, with " <<
-			     " frame " << busyResources.m_sfnSf.m_frameNum << 
-			     " subframe " << (uint16_t)busyResources.m_sfnSf.m_sfNum <<
-			     PrintSubframeAllocationMask(busyResources.m_symAllocationMask));
-
-	        // " m_dlSymStart " << busyResources.m_dlSymStart << 
-	        // " m_dlNumSymAlloc " << busyResources.m_dlNumSymAlloc << 
-	        // " m_ulSymStart " << busyResources.m_ulSymStart << 
-	        // " m_ulSymStart " << busyResources.m_ulNumSymAlloc);	
-			
-	        // NS_ASSERT_MSG(busyResources.m_sfnSf.m_sfNum == sfNum && 
-	        // 		busyResources.m_sfnSf.m_frameNum == frameNum,
-	        // 		"Mismatch between scheduled resource and SfIabAllocInfo");
-
-	        // TODOIAB -> do smth better, since UL resources may be allocated after DL/UL
-	        // resources of other users, so some previous symbols can be used
-
-	        // get the max between DL and UL sym (usually UL if both present)
-	        // if(busyResources.m_dlSymStart > busyResources.m_ulSymStart)
-	        // {
-	        //     // set the symIdx value to the first free available index
-	        //     symIdx = busyResources.m_dlSymStart + busyResources.m_dlNumSymAlloc;
-	        // 	   // subtract the DL and UL symbols from the available ones
-	        //     // symAvail -= (busyResources.m_dlNumSymAlloc + busyResources.m_ulNumSymAlloc);
-	        // }
-	        // else
-	        // {
-	        // 	   // set the symIdx value to the first free available index
-	        //     symIdx = busyResources.m_ulSymStart + busyResources.m_ulNumSymAlloc;
-                //     // subtract the DL and UL symbols from the available ones
-                //     // symAvail -= (busyResources.m_dlNumSymAlloc + busyResources.m_ulNumSymAlloc);
-                // }
-	        // symAvail = m_phyMacConfig->GetSymbolsPerSubframe () - 1 - symIdx;
-	    }
-	    m_iabBusySubframeAllocation.at(sfNum) = busyResources;  // In the current implementation, nothing modified, unless m_valid is true.
-	    NS_LOG_DEBUG("After check for IAB resources: symIdx " << (uint16_t)symIdx << " symAvail " << symAvail);
-        }
-        // ---------------------------------------
-        // Allow incontinuous resource allocation.
-        // ---------------------------------------
-        else if(m_iabScheduler && m_split)
-        {
-	    NS_LOG_LOGIC("Before check for IAB resources: symIdx " << (uint16_t)symIdx << " symAvail " << symAvail);
-	    SfIabAllocInfo busyResources = m_iabBusySubframeAllocation.at(sfNum);
-	    if(busyResources.m_valid)
-            {
-                m_busyResourcesSchedSubframe = busyResources;
-                // count the number of symbols which are busy
-                int numBusySymbols = 0;
-                for(auto symbolIter : m_busyResourcesSchedSubframe.m_symAllocationMask)
-                {
-                    numBusySymbols += symbolIter;  // If a symbol/slot is busy (already allocated), it is "1"; otherwise, "0".
-                }
-                symAvail -= numBusySymbols;  // The number of available free to use symbols
-                NS_LOG_DEBUG("This subframe has a DCI stored, with " << 
-			     " frame " << busyResources.m_sfnSf.m_frameNum << 
-			     " subframe " << (uint16_t)busyResources.m_sfnSf.m_sfNum << " " <<
-			     PrintSubframeAllocationMask(busyResources.m_symAllocationMask) << 
-			     " total number of busy symbols " << numBusySymbols <<
-			     " symAvail " << symAvail);
-            }
-            else
-	    {
-                m_busyResourcesSchedSubframe.m_valid = false;
-	    }
-	    m_iabBusySubframeAllocation.at(sfNum).m_valid = false;
-        }
-        return symAvail;
-    }
-
-
-    /*
-     * ================================
-     * Complete the scheduling process.
-     * ================================
-     */
-    void
-    MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params)
-    {
-        NS_LOG_DEBUG("m_rntiIabInfoMap size " << m_rntiIabInfoMap.size());
-
-        MmWaveMacSchedSapUser::SchedConfigIndParameters ret;
-        // ----------------------------------------------------------------------------
-        // Determine the Frame and Subframe for this specific schedule trigger request.
-        // ----------------------------------------------------------------------------
-        SfnSf dlSfn = params.m_sfnSf;  // Downlink frame and subframe number
-        SfnSf ulSfn = params.m_sfnSf;  // Uplink frame and subframe number
-        // downlink
-        if ((int)(dlSfn.m_sfNum + m_maxSchedulingDelay) >=  (int)m_phyMacConfig->GetSubframesPerFrame ())
-        {
-	    // As the scheduling message arrives at the most outside UE after "m_maxSchedulingDelay" subframe time,
-	    // the scheduling of a specific subframe actually happens ahead of time.
-	    // Update the frame number in case the to be scheduled subframe is in the next frame.
-            dlSfn.m_frameNum++;
-        }
-        dlSfn.m_sfNum = (uint8_t)((int)(dlSfn.m_sfNum + m_maxSchedulingDelay)) % m_phyMacConfig->GetSubframesPerFrame ();
-        ret.m_sfnSf = dlSfn;
-        ret.m_sfAllocInfo.m_sfnSf = ret.m_sfnSf;
-        // uplink
-        if (ulSfn.m_sfNum + m_maxSchedulingDelay >=  m_phyMacConfig->GetSubframesPerFrame ())
-        {
-            ulSfn.m_frameNum++;
-        }
-        ulSfn.m_sfNum = (ulSfn.m_sfNum + m_maxSchedulingDelay) % m_phyMacConfig->GetSubframesPerFrame ();
-        // Determine the frame number and subframe number based on the information from downlink.
-        uint16_t frameNum = ret.m_sfnSf.m_frameNum;
-        uint8_t sfNum = ret.m_sfnSf.m_sfNum;
-        //uint8_t slotNum = params.m_sfnSf.m_slotNum;
-        NS_LOG_DEBUG ("Scheduling DL frame "<< (unsigned)frameNum << " subframe " << (unsigned)sfNum
-		      << " UL frame " << (unsigned)ulSfn.m_frameNum << " subframe " << (unsigned)ulSfn.m_sfNum);
-        // TODO: <TODOIAB> In this version, we only consider the same subframe for UL & DL
-        NS_ASSERT_MSG(sfNum == ulSfn.m_sfNum, "different subframes for DL and UL " << (uint32_t)sfNum << " " << (uint32_t)ulSfn.m_sfNum); 
-
-        // IAB find the number of IAB devs that have requested resources via BSRs
-        // uint16_t numIabDevs = GetNumIabRnti();
-        // NS_LOG_DEBUG(this << " numIabDevs " << numIabDevs);
-
-        // --------------------------------------------------------------------------------
-        // Add slot for DL control symbol. 
-        // It is specified at the first slot of a subframe.
-        // Along a multi-hop path, each node will independently add the DL control symbol
-        // at the same slot of a specific subframe. A duplicated task!!! 
-        // --------------------------------------------------------------------------------
-        SlotAllocInfo dlCtrlSlot (0, SlotAllocInfo::DL_slotAllocInfo, SlotAllocInfo::CTRL, SlotAllocInfo::DIGITAL, 0);  
-        // Each slot could transmit multiple QAM symbols on different subcarriers.
-        dlCtrlSlot.m_dci.m_numSym = 1;    // 1 symbol for the control symbol for DL
-        dlCtrlSlot.m_dci.m_symStart = 0;  // The control symbol is at the beginning of the subframe.
-        ret.m_sfAllocInfo.m_slotAllocInfo.push_back (dlCtrlSlot);  // "m_slotAllocInfo" is a deque which sequentially stores the allocation of each slot in a subframe.
-        int resvCtrl = m_phyMacConfig->GetDlCtrlSymbols() + m_phyMacConfig->GetUlCtrlSymbols();  // the total number of reserved control symbols in the subframe (i.e., 2)
-        int symAvail = m_phyMacConfig->GetSymbolsPerSubframe () - resvCtrl;  // The number of available slots (OFDM symbols) in the subframe for data transmissions.
-        uint8_t slotIdx = 1; // index of the 1st unassigned slot (SlotAllocInfo), one slot could cross several symbols.
-        uint8_t symIdx = m_phyMacConfig->GetDlCtrlSymbols(); // the index of the first available OFDM symbol (i.e., slot).
-
-        // Get the resources which are already set as busy. "symIdx" does nothing. "symAvail" is updated.
-        symAvail = UpdateBusySymbolsForIab(sfNum, symIdx, symAvail);  // after this function, the stored scheduling of this subframe is "invalid";
-	
-        // process received CQIs, erase the expired entries, and update the timer of each unexpired entry
-        RefreshDlCqiMaps ();
-        RefreshUlCqiMaps ();
-
-        // Process DL HARQ feedback, if time out, reset.
-        RefreshHarqProcesses ();
-
-        // If the first availble symbol is the last one, it should be reserved for UL control symbol.
-        if ((int)symIdx >= (int)(m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ()))
-        {
-            // add slot for UL control
-	    SlotAllocInfo ulCtrlSlot (0xFF, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL, SlotAllocInfo::DIGITAL, 0);
-	    ulCtrlSlot.m_dci.m_numSym = 1;
-	    ulCtrlSlot.m_dci.m_symStart = m_phyMacConfig->GetSymbolsPerSubframe()-1;
-	    ret.m_sfAllocInfo.m_slotAllocInfo.push_back (ulCtrlSlot);
-	    m_macSchedSapUser->SchedConfigInd (ret);  // As no more slot are available for allocation, send the scheduling result to "scheduler".
-	    return;
-        }
-
-        //m_rlcBufferReq.sort (SortRlcBufferReq); 	// sort list by RNTI
-        std::map <uint16_t, struct UeSchedInfo> ueInfo;
-        std::map <uint16_t, struct UeSchedInfo>::iterator itUeInfo;
-        std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator itRlcBuf;
-
-        // retrieve past HARQ retx buffered
-        if (m_dlHarqInfoList.size () > 0 && params.m_dlHarqInfoList.size () > 0)
-        {
-            m_dlHarqInfoList.insert (m_dlHarqInfoList.end (), params.m_dlHarqInfoList.begin (), params.m_dlHarqInfoList.end ());
-	    // Add the incoming new dlHarqInfo items.
-        }
-        else if (params.m_dlHarqInfoList.size () > 0)
-        {
-            m_dlHarqInfoList = params.m_dlHarqInfoList;
-        }
-        if (m_ulHarqInfoList.size () > 0 && params.m_ulHarqInfoList.size () > 0)
-        {
-            m_ulHarqInfoList.insert (m_ulHarqInfoList.end (), params.m_ulHarqInfoList.begin (), params.m_ulHarqInfoList.end ());
-        }
-        else if (params.m_ulHarqInfoList.size () > 0)
-        {
-            m_ulHarqInfoList = params.m_ulHarqInfoList;
-        }
-
-        if (m_harqOn == false)  // Ignore HARQ feedback
-        {
-            m_dlHarqInfoList.clear ();
-        }
-        else
-        {
-            // Process DL HARQ feedback and assign slots for RETX if resources available
-            std::vector <struct DlHarqInfo> dlInfoListUntxed;  // TBs not able to be retransmitted in this sf
-            std::vector <struct UlHarqInfo> ulInfoListUntxed;
-
-            for (unsigned i = 0; i < m_dlHarqInfoList.size (); i++)
-            {
-                if (symAvail == 0)
-                {
-                    break;  // no symbols left to allocate
-                }
-                uint8_t harqId = m_dlHarqInfoList.at (i).m_harqProcessId;
-                uint16_t rnti = m_dlHarqInfoList.at (i).m_rnti;
-                itUeInfo = ueInfo.find (rnti); // at the beginning, the ueInfo map is empty
-                std::map <uint16_t, DlHarqProcessesStatus_t>::iterator itStat = m_dlHarqProcessesStatus.find (rnti);
-                if (itStat == m_dlHarqProcessesStatus.end ())
-                {
-                    NS_FATAL_ERROR ("No HARQ status info found for UE " << rnti);
-                }
-                std::map <uint16_t, DlHarqRlcPduList_t>::iterator itRlcPdu =  m_dlHarqProcessesRlcPduMap.find (rnti);
-                if (itRlcPdu == m_dlHarqProcessesRlcPduMap.end ())
-                {
-                    NS_FATAL_ERROR ("Unable to find RlcPduList in HARQ buffer for RNTI " << m_dlHarqInfoList.at (i).m_rnti);
-                }
-                if(m_dlHarqInfoList.at (i).m_harqStatus == DlHarqInfo::ACK || itStat->second.at (harqId) == 0)
-                { // acknowledgment or process timeout, reset process
-                    NS_LOG_DEBUG ("UE" << rnti << " DL harqId " << (unsigned)harqId << " HARQ-ACK received");
-                    itStat->second.at (harqId) = 0;    // release process ID
-                    for (uint16_t k = 0; k < itRlcPdu->second.size (); k++)		// clear RLC buffers
-		    {
-                        itRlcPdu->second.at (harqId).clear ();
-		    }
-                    continue;
-                }
-                else if(m_dlHarqInfoList.at (i).m_harqStatus == DlHarqInfo::NACK)
-                {
-                    std::map <uint16_t, DlHarqProcessesDciInfoList_t>::iterator itHarq = m_dlHarqProcessesDciInfoMap.find (rnti); // Updated in "DoCschedUeConfigReq()"
-                    if (itHarq == m_dlHarqProcessesDciInfoMap.end ())
-                    {
-                        NS_FATAL_ERROR ("No DCI/HARQ buffer entry found for UE " << rnti);
-                    }
-                    DciInfoElementTdma dciInfoReTx = itHarq->second.at (harqId);
-                    NS_LOG_DEBUG ("UE" << rnti << " DL harqId " << (unsigned)harqId << " HARQ-NACK received, rv " << (unsigned)dciInfoReTx.m_rv);
-                    NS_ASSERT (harqId == dciInfoReTx.m_harqProcess);
-                    //NS_ASSERT(itStat->second.at (harqId) > 0);
-                    NS_ASSERT(itStat->second.at (harqId) - 1 == dciInfoReTx.m_rv);
-		    if (dciInfoReTx.m_rv == 3) // maximum number of retx reached -> drop process
-                    {
-                        NS_LOG_UNCOND ("Max number of retransmissions reached -> drop process");
-                        itStat->second.at (harqId) = 0;
-		        for (uint16_t k = 0; k < (*itRlcPdu).second.size (); k++)
-		        {
-                            itRlcPdu->second.at (harqId).clear ();
-                        }
-                        continue;
-                    }
-
-		    // (1) Check if the CQI has decreased. If no updated value available, use the same MCS minus 1.
-		    // 			If CQI is below min threshold, drop process.
-		    // (2) Calculate new number of symbols it will take to encode at lower MCS.
-		    //			If this exceeds the total number of symbols, reTX with original parameters.
-		    // 			If exceeds remaining symbols available in this subframe (but not total symbols in SF),
-		    //			update DCI info and try scheduling in next SF.
-
-		    /*std::map <uint16_t,uint8_t>::iterator itCqi = m_wbCqiRxed.find (itRlcBuf->m_rnti);
-		    int cqi;
-		    int mcsNew;
-		    if (itCqi != m_wbCqiRxed.end ())
-		    {
-			cqi = itCqi->second;
-			if (cqi == 0)
-			{
-				NS_LOG_INFO ("CQI for reTX is below threshhold. Drop process");
-				itStat->second.at (harqId) = 0;
-				for (uint16_t k = 0; k < (*itRlcPdu).second.size (); k++)
-				{
-					itRlcPdu->second.at (harqId).clear ();
-				}
-				continue;
-			}
-			else
-			{
-				mcsNew = m_amc->GetMcsFromCqi (cqi);  // get MCS
-			}
-		    }
-		    else
-		    {
-			if(dciInfoReTx.m_mcs > 0)
-			{
-				mcsNew = dciInfoReTx.m_mcs - 1;
-			}
-			else
-			{
-				mcsNew = dciInfoReTx.m_mcs;
-			}
-		    }
-		    // compute number of symbols required
-		    unsigned numSymReq;
-		    if (mcsNew < dciInfoReTx.m_mcs)
-		    {
-			numSymReq = m_amc->GetNumSymbolsFromTbsMcs (dciInfoReTx.m_tbSize, mcsNew);
-			while (numSymReq < symAvail && mcsNew < dciInfoReTx.m_mcs);
-			{
-				mcsNew++;
-				numSymReq = m_amc->GetNumSymbolsFromTbsMcs (dciInfoReTx.m_tbSize, mcsNew);
-			}
-			mcsNew--;
-			numSymReq = m_amc->GetNumSymbolsFromTbsMcs (dciInfoReTx.m_tbSize, mcsNew);
-		    }
-		    if (numSymReq <= (m_phyMacConfig->GetSymbolsPerSubframe () - resvCtrl))
-		    {	// not enough symbols to encode TB at required MCS, attempt in later SF
-			dlInfoListUntxed.push_back (m_dlHarqInfoList.at (i));
-			continue;
-		    }*/
-		    // allocate retx if enough symbols are available
-		    if (symAvail >= dciInfoReTx.m_numSym)
-		    {
-                        if(!CheckOverlapWithBusyResources(symIdx, dciInfoReTx.m_numSym)) // TODOIAB: check if it can be allocated later)
-                    {
-			symAvail -= dciInfoReTx.m_numSym;  // reduce the number of available symbol slots in this subframe.
-			dciInfoReTx.m_symStart = symIdx;   // update the starting symbol index
-			symIdx += dciInfoReTx.m_numSym;    // update the first available symbol's index
-			NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
-			dciInfoReTx.m_rv++;                // m_rv could be thinked as times of retransmit.
-			dciInfoReTx.m_ndi = 0;             // 0 means old data
-                        itHarq->second.at (harqId) = dciInfoReTx;
-                        itStat->second.at (harqId) = itStat->second.at (harqId) + 1;  // Update the harq status of the specific harq process of this user.
-                        SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, itUeInfo->first);
-	                NS_LOG_DEBUG("itUeInfo->first " << itUeInfo->first << " dci rnti " << dciInfoReTx.m_rnti);
-                        slotInfo.m_dci = dciInfoReTx;
-                        NS_LOG_DEBUG ("UE" << dciInfoReTx.m_rnti << " gets DL slots " << (unsigned)dciInfoReTx.m_symStart << "-" << (unsigned)(dciInfoReTx.m_symStart+dciInfoReTx.m_numSym-1) <<
-					" tbs " << dciInfoReTx.m_tbSize << " harqId " << (unsigned)dciInfoReTx.m_harqProcess << " harqId " << (unsigned)dciInfoReTx.m_harqProcess <<
-				        " rv " << (unsigned)dciInfoReTx.m_rv << " in frame " << ret.m_sfnSf.m_frameNum << " subframe " << (unsigned)ret.m_sfnSf.m_sfNum << " RETX");
-                        std::map <uint16_t, DlHarqRlcPduList_t>::iterator itRlcList =  m_dlHarqProcessesRlcPduMap.find (rnti);
-			if (itRlcList == m_dlHarqProcessesRlcPduMap.end ())
-			{
-			    NS_FATAL_ERROR ("Unable to find RlcPdcList in HARQ buffer for RNTI " << rnti);
-			}
-			for (uint16_t k = 0; k < (*itRlcList).second.at(dciInfoReTx.m_harqProcess).size (); k++)
-			{
-			    slotInfo.m_rlcPduInfo.push_back ((*itRlcList).second.at (dciInfoReTx.m_harqProcess).at (k));
-			}
-			ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
-			ret.m_sfAllocInfo.m_numSymAlloc += dciInfoReTx.m_numSym;
-			if (itUeInfo == ueInfo.end())
-			{
-			    itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (rnti, UeSchedInfo () )).first;
-			}
-			itUeInfo->second.m_dlSymbolsRetx = dciInfoReTx.m_numSym;
-		    }
-		    else
-		    {
-			// find if there are other resources later
-			// we cannot split RETX!
-			int numSymNeeded = dciInfoReTx.m_numSym;
-			int numFreeSymbols = 0;
-			uint8_t tmpSymIdx = symIdx;
-
-			while(numFreeSymbols == 0 && tmpSymIdx < m_phyMacConfig->GetSymbolsPerSubframe()-1) 
-			{
-			    numFreeSymbols = GetNumFreeSymbols(tmpSymIdx, numSymNeeded); // this is equal to numSymNeeded if there is no overlap, otherwise smaller
-			    NS_LOG_LOGIC("RETX numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " tmpSymIdx " << (uint16_t)tmpSymIdx);
-			    if(numFreeSymbols < numSymNeeded)
-			    {
-				numFreeSymbols = 0;
-				tmpSymIdx = GetFirstFreeSymbol(tmpSymIdx, numSymNeeded); // get the next symIdx
-				if((int)(tmpSymIdx + numSymNeeded) > (int)m_phyMacConfig->GetSymbolsPerSubframe()-1)
-				{
-				    NS_LOG_DEBUG("No way to fit this retx in the available resources");
-				    break;
-				}
-			    }
-			}
-
-			NS_LOG_LOGIC("RETX numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " tmpSymIdx " << (uint16_t)tmpSymIdx);
-			if(numFreeSymbols >= numSymNeeded && (int)(tmpSymIdx + numSymNeeded) < (int)(m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ()))
-			{
-			    NS_LOG_LOGIC("Found resources for DL HARQ RETX");
-			    symAvail -= dciInfoReTx.m_numSym;
-			    dciInfoReTx.m_symStart = tmpSymIdx;
-
-			    NS_LOG_LOGIC("Before updating " << PrintSubframeAllocationMask(m_busyResourcesSchedSubframe.m_symAllocationMask));
-
-			    // update resource mask
-			    UpdateResourceMask(tmpSymIdx, dciInfoReTx.m_numSym);
-
-    			    NS_LOG_LOGIC("After updating " << PrintSubframeAllocationMask(m_busyResourcesSchedSubframe.m_symAllocationMask));
-
-			    // symIdx += dciInfoReTx.m_numSym;
-			    NS_ASSERT (tmpSymIdx + dciInfoReTx.m_numSym < m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
-			    dciInfoReTx.m_rv++;  // the symbols in the dci has been retransmitted one more time.
-			    dciInfoReTx.m_ndi = 0;
-			    itHarq->second.at (harqId) = dciInfoReTx;
-			    itStat->second.at (harqId) = itStat->second.at (harqId) + 1;
-			    SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, itUeInfo->first);
-			    NS_LOG_LOGIC("itUeInfo->first " << itUeInfo->first << " dci rnti " << dciInfoReTx.m_rnti);
-			    slotInfo.m_dci = dciInfoReTx;
-			    NS_LOG_DEBUG ("UE" << dciInfoReTx.m_rnti << " gets DL slots " << (unsigned)dciInfoReTx.m_symStart << "-" 
-					    << (unsigned)(dciInfoReTx.m_symStart+dciInfoReTx.m_numSym-1) << " tbs " << dciInfoReTx.m_tbSize 
-					    << " harqId " << (unsigned)dciInfoReTx.m_harqProcess << " harqId " << (unsigned)dciInfoReTx.m_harqProcess 
-					    << " rv " << (unsigned)dciInfoReTx.m_rv << " in frame " << ret.m_sfnSf.m_frameNum << " subframe " 
-					    << (unsigned)ret.m_sfnSf.m_sfNum << " RETX");
-			    std::map <uint16_t, DlHarqRlcPduList_t>::iterator itRlcList =  m_dlHarqProcessesRlcPduMap.find (rnti);
-			    if (itRlcList == m_dlHarqProcessesRlcPduMap.end ())
-			    {
-				NS_FATAL_ERROR ("Unable to find RlcPdcList in HARQ buffer for RNTI " << rnti);
-			    }
-			    for (uint16_t k = 0; k < (*itRlcList).second.at(dciInfoReTx.m_harqProcess).size (); k++)
-			    {
-				slotInfo.m_rlcPduInfo.push_back ((*itRlcList).second.at (dciInfoReTx.m_harqProcess).at (k));
-			    }
-			    ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
-			    ret.m_sfAllocInfo.m_numSymAlloc += dciInfoReTx.m_numSym;
-			    if (itUeInfo == ueInfo.end())
-			    {
-				itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (rnti, UeSchedInfo () )).first;
-			    }
-			    itUeInfo->second.m_dlSymbolsRetx = dciInfoReTx.m_numSym;
-			}
-			else
-			{
-			    NS_LOG_DEBUG ("No resource for this retx (even later) -> buffer it");
-			    dlInfoListUntxed.push_back (m_dlHarqInfoList.at (i));
-			}
-		    }
-		}
-		else
-		{
-		    NS_LOG_DEBUG ("No resource for this retx -> buffer it");
-		    dlInfoListUntxed.push_back (m_dlHarqInfoList.at (i));
-		}
-	    }
-	}
-
-	m_dlHarqInfoList.clear ();
-	m_dlHarqInfoList = dlInfoListUntxed;
-
-	// Process UL HARQ feedback
-	for (uint16_t i = 0; i < m_ulHarqInfoList.size (); i++)
-	{
-	    if (symAvail == 0)
-	    {
-		break;	// no symbols left to allocate
-	    }
-	    UlHarqInfo harqInfo = m_ulHarqInfoList.at (i);
-	    uint8_t harqId = harqInfo.m_harqProcessId;
-	    uint16_t rnti = harqInfo.m_rnti;
-	    itUeInfo = ueInfo.find (rnti);
-	    std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_ulHarqProcessesStatus.find (rnti);
-	    if (itStat == m_ulHarqProcessesStatus.end ())
-	    {
-		NS_LOG_ERROR ("No info found in HARQ buffer for UE (might have changed eNB) " << rnti);
-	    }
-	    if (harqInfo.m_receptionStatus == UlHarqInfo::Ok || itStat->second.at (harqId) == 0)
-	    {
-		//NS_LOG_DEBUG ("UE" << rnti << " UL harqId " << (unsigned)harqInfo.m_harqProcessId << " HARQ-ACK received");
-		if (itStat != m_ulHarqProcessesStatus.end ())
-		{
-	            itStat->second.at (harqId) = 0;  // release process ID
-		}
-	    }
-	    else if (harqInfo.m_receptionStatus == UlHarqInfo::NotOk)
-	    {
-		std::map <uint16_t, UlHarqProcessesDciInfoList_t>::iterator itHarq = m_ulHarqProcessesDciInfoMap.find (rnti);
-		if (itHarq == m_ulHarqProcessesDciInfoMap.end ())
-		{
-	            NS_LOG_ERROR ("No info found in UL-HARQ buffer for UE (might have changed eNB) " << rnti);
-		}
-		// retx correspondent block: retrieve the UL-DCI
-		DciInfoElementTdma dciInfoReTx = itHarq->second.at (harqId);  // It has 8 processes in the default setting.
-		NS_LOG_DEBUG ("UE" << rnti << " UL harqId " << (unsigned)harqId << " TX not ok, rv" << (unsigned)dciInfoReTx.m_rv);
-		//NS_LOG_DEBUG ("UE" << rnti << " UL harqId " << (unsigned)harqInfo.m_harqProcessId << " HARQ-NACK received, rv " << (unsigned)dciInfoReTx.m_rv);
-		NS_ASSERT (harqId == dciInfoReTx.m_harqProcess);
-		NS_ASSERT(itStat->second.at (harqId) > 0);  // It must be retransmitted at least once already.
-		NS_ASSERT(itStat->second.at (harqId)-1 == dciInfoReTx.m_rv);  // First attempt: status == 1, m_rv == 0.
-		if (dciInfoReTx.m_rv == 3)
-		{
-		    NS_LOG_INFO ("Max number of retransmissions reached (UL)-> drop process");
-		    itStat->second.at (harqId) = 0;
-		    continue;
-		}
+    /*
+     * ================================
+     * Complete the scheduling process.
+     * ================================
+     */
+    void
+    MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params)
+    {
+	RrRanking ranking (this);
+	MmWaveFlexTtiSchedulerBase::DoSchedTriggerReq (params, ranking);
+    }
 
-		NS_LOG_DEBUG("Num sym needed " << dciInfoReTx.m_numSym << " symIdx " << (uint16_t)symIdx);
-		if (symAvail >= dciInfoReTx.m_numSym)
-		{
-		    if(!CheckOverlapWithBusyResources(symIdx, dciInfoReTx.m_numSym)) // TODOIAB: check if it can be allocated later
-		    {
-			symAvail -= dciInfoReTx.m_numSym;
-			dciInfoReTx.m_symStart = symIdx;
-			symIdx += dciInfoReTx.m_numSym;
-			NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
-			dciInfoReTx.m_rv++;     // Another retransmission, so that m_rv is increased by 1.
-			dciInfoReTx.m_ndi = 0;  // Not new data.
-			itStat->second.at (harqId) = itStat->second.at (harqId) + 1;
-			itHarq->second.at (harqId) = dciInfoReTx;  // Update the corresponding dci info in the uplink harq buffer
-			SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, rnti);
-			slotInfo.m_dci = dciInfoReTx;
-		        NS_LOG_DEBUG ("UE" << dciInfoReTx.m_rnti << " gets UL slots " << (unsigned)dciInfoReTx.m_symStart << "-" 
-					<< (unsigned)(dciInfoReTx.m_symStart+dciInfoReTx.m_numSym-1) << " tbs " << dciInfoReTx.m_tbSize 
-					<< " harqId " << (unsigned)dciInfoReTx.m_harqProcess << " rv " << (unsigned)dciInfoReTx.m_rv 
-					<< " in frame " << ulSfn.m_frameNum << " subframe " << (unsigned)ulSfn.m_sfNum << " RETX");
-			ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
-			ret.m_sfAllocInfo.m_numSymAlloc += dciInfoReTx.m_numSym;
-			if (itUeInfo == ueInfo.end())
-			{
-			    itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (rnti, UeSchedInfo () )).first;
-			}
-			itUeInfo->second.m_ulSymbolsRetx = dciInfoReTx.m_numSym;  // The # of symbols used for this ul retransmission.
-		    }
-		    else  // The first available period of slots are not enough for the retransmission, try to test the next available slot period.
-		    { 
-			// find if there are other resources later
-			// we cannot split RETX!
-			int numSymNeeded = dciInfoReTx.m_numSym;
-			int numFreeSymbols = 0;
-			uint8_t tmpSymIdx = symIdx;
-
-			while(numFreeSymbols == 0 && tmpSymIdx < m_phyMacConfig->GetSymbolsPerSubframe()-1) 
-			{
-			    numFreeSymbols = GetNumFreeSymbols(tmpSymIdx, numSymNeeded); // this is equal to numSymNeeded if there is no overlap, otherwise smaller
-			    NS_LOG_LOGIC("UL RETX numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " tmpSymIdx " << (uint16_t)tmpSymIdx);
-			    if(numFreeSymbols < numSymNeeded)  // The # of available consecutive slots are not enough for retranmission.
-			    {
-				numFreeSymbols = 0;
-				tmpSymIdx = GetFirstFreeSymbol(tmpSymIdx, numSymNeeded); // get the next symIdx
-				if((int)(tmpSymIdx + numSymNeeded) >  (int)m_phyMacConfig->GetSymbolsPerSubframe()-1)
-				{	
-				    NS_LOG_DEBUG("No way to fit this retx in the available resources");
-				    break;
-				}
-			    }
-			}
+    MmWaveFlexTtiMacScheduler::RrRanking::RrRanking (MmWaveFlexTtiMacScheduler* scheduler)
+	: m_scheduler (scheduler)
+    {
+    }
 
-			NS_LOG_LOGIC("UL RETX numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " tmpSymIdx " << (uint16_t)tmpSymIdx);
-			if(numFreeSymbols >= numSymNeeded 
-					&& (int)(tmpSymIdx + numSymNeeded) < (int)(m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ()))
-			{  // There are enough available consecutive slots for this retranmission.
-			    symAvail -= dciInfoReTx.m_numSym;
-			    dciInfoReTx.m_symStart = tmpSymIdx;
-
-			    NS_LOG_LOGIC("Before updating " << PrintSubframeAllocationMask(m_busyResourcesSchedSubframe.m_symAllocationMask));
-
-			    // update resource mask
-			    UpdateResourceMask(tmpSymIdx, dciInfoReTx.m_numSym);
-
-			    NS_LOG_LOGIC("After updating " << PrintSubframeAllocationMask(m_busyResourcesSchedSubframe.m_symAllocationMask));
-
-			    // symIdx += dciInfoReTx.m_numSym;
-			    NS_ASSERT (tmpSymIdx + dciInfoReTx.m_numSym <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
-			    dciInfoReTx.m_rv++;
-			    dciInfoReTx.m_ndi = 0;
-			    itStat->second.at (harqId) = itStat->second.at (harqId) + 1;
-			    itHarq->second.at (harqId) = dciInfoReTx;
-			    SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, rnti);
-			    slotInfo.m_dci = dciInfoReTx;
-			    NS_LOG_DEBUG ("UE" << dciInfoReTx.m_rnti << " gets UL slots " << (unsigned)dciInfoReTx.m_symStart << "-" 
-					    << (unsigned)(dciInfoReTx.m_symStart+dciInfoReTx.m_numSym-1) << " tbs " << dciInfoReTx.m_tbSize 
-					    << " harqId " << (unsigned)dciInfoReTx.m_harqProcess << " rv " << (unsigned)dciInfoReTx.m_rv 
-					    << " in frame " << ulSfn.m_frameNum << " subframe " << (unsigned)ulSfn.m_sfNum << " RETX");
-			    ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
-			    ret.m_sfAllocInfo.m_numSymAlloc += dciInfoReTx.m_numSym;
-			    if (itUeInfo == ueInfo.end())
-			    {
-				itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (rnti, UeSchedInfo () )).first;
-			    }
-			    itUeInfo->second.m_ulSymbolsRetx = dciInfoReTx.m_numSym;
-			}
-			else
-			{
-			    NS_LOG_DEBUG ("No resource for this UL retx (even later) -> buffer it");
-			    ulInfoListUntxed.push_back (m_ulHarqInfoList.at (i));
-			}
-		    }
-		}
-		else
-		{
-		    NS_LOG_DEBUG ("No resource for this retx -> buffer it");
-		    ulInfoListUntxed.push_back (m_ulHarqInfoList.at (i));
-		}
-	    }
+    void
+    MmWaveFlexTtiMacScheduler::RrRanking::NotifyRetx (const HarqRetx &retx)
+    {
+	// at the beginning, the ueInfo map is empty
+	UeSchedInfo &ueSchedInfo = m_ueInfo[retx.m_rnti];
+	if (retx.m_uplink)
+	{
+	    ueSchedInfo.m_ulSymbolsRetx = retx.m_numSym;  // The # of symbols used for this ul retransmission.
 	}
+	else
+	{
+	    ueSchedInfo.m_dlSymbolsRetx = retx.m_numSym;
+	}
+    }
 
-	m_ulHarqInfoList.clear ();
-	m_ulHarqInfoList = ulInfoListUntxed;
+    void
+    MmWaveFlexTtiMacScheduler::RrRanking::RankUes (SchedTriggerState &state, std::vector<UeGrant> &grants)
+    {
+	m_scheduler->RankUes (state, m_ueInfo, grants);
     }
 
-    NS_LOG_DEBUG("After HARQ allocation symAvail " << symAvail << " mask " << PrintSubframeAllocationMask(m_busyResourcesSchedSubframe.m_symAllocationMask));
+    void
+    MmWaveFlexTtiMacScheduler::RrRanking::Reset ()
+    {
+	m_ueInfo.clear ();
+    }
 
-    // ********************* END OF HARQ SECTION, START OF NEW DATA SCHEDULING ********************* //
+    void
+    MmWaveFlexTtiMacScheduler::RankUes (SchedTriggerState &state, std::map <uint16_t, struct UeSchedInfo> &ueInfo, std::vector<UeGrant> &grants)
+    {
+    int symAvail = state.m_symAvail;
+    std::map <uint16_t, struct UeSchedInfo>::iterator itUeInfo;
+    std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator itRlcBuf;
 
     // number of DL/UL flows for new transmissions (not HARQ RETX)
     int nFlowsDl = 0;
@@ -1478,10 +402,11 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
 	{
 	    itUeInfo = ueInfo.find (itRlcBuf->m_rnti);
 	    // check if it is a relay or a UE
+	    uint32_t slot = FindUeSlot (itRlcBuf->m_rnti, 0);
 	    bool isIab = false;
-	    if(m_rntiIabInfoMap.find(itRlcBuf->m_rnti) != m_rntiIabInfoMap.end())
+	    if(slot != NO_UE_SLOT && (m_ueFields[slot] & UE_IAB_INFO))
 	    {
-		isIab = m_rntiIabInfoMap.find(itRlcBuf->m_rnti)->second.first;
+		isIab = m_iabInfo[slot].first;
 	    }
             // check if Transmission Queue (new data), Retransmission Queue (old data, may not be retransmitted yet), or Status PDUs are not empty
 	    if ( (((*itRlcBuf).m_rlcTransmissionQueueSize > 0) || ((*itRlcBuf).m_rlcRetransmissionQueueSize > 0) || ((*itRlcBuf).m_rlcStatusPduSize > 0)) )
@@ -1489,11 +414,10 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
 		NS_LOG_DEBUG (this << " User " << itRlcBuf->m_rnti << " LC " << (uint16_t)itRlcBuf->m_logicalChannelIdentity << " is active, status  " 
 				<< (*itRlcBuf).m_rlcStatusPduSize << " retx " << (*itRlcBuf).m_rlcRetransmissionQueueSize 
 				<< " tx " << (*itRlcBuf).m_rlcTransmissionQueueSize << " iab " << isIab);
-		std::map <uint16_t,uint8_t>::iterator itCqi = m_wbCqiRxed.find (itRlcBuf->m_rnti);
 		uint8_t cqi = 0;
-		if (itCqi != m_wbCqiRxed.end ())
+		if (slot != NO_UE_SLOT && (m_ueFields[slot] & UE_WB_CQI))
 		{
-		    cqi = itCqi->second;
+		    cqi = m_wbCqi[slot];
 		}
 		else // no CQI available
 		{
@@ -1583,28 +507,24 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
         // get info on active UL flows
         if (symAvail > 0 && !m_dlOnly)  // remaining symbols in future UL subframe after HARQ retx sched
         {
-            // std::map <uint16_t,uint32_t>::iterator ceBsrIt;
-	    for(auto ceBsrIt : m_ceBsrRxed)
+	    // walk the BSRs in RNTI order, as the allocation order of the UEs depends on it
+	    for (uint32_t bsrRnti = 0; bsrRnti < m_ueSlot.size (); bsrRnti++)
 	    {
-		// }
-
-		// for (ceBsrIt = m_ceBsrRxed.begin (); ceBsrIt != m_ceBsrRxed.end (); ceBsrIt++)
-		// {
-	        if (ceBsrIt.second > 0)  // UL buffer size > 0
+		uint32_t slot = FindUeSlot (bsrRnti, UE_BSR);
+	        if (slot != NO_UE_SLOT && m_ceBsr[slot] > 0)  // UL buffer size > 0
 	        {
-		    std::map <uint16_t, struct UlCqiMapElem>::iterator itCqi = m_ueUlCqi.find (ceBsrIt.first);
 		    bool isIab = false;
-		    if(m_rntiIabInfoMap.find(ceBsrIt.first) != m_rntiIabInfoMap.end())
+		    if(m_ueFields[slot] & UE_IAB_INFO)
 		    {
-		        isIab = m_rntiIabInfoMap.find(ceBsrIt.first)->second.first;
+		        isIab = m_iabInfo[slot].first;
 		    }
-		    NS_LOG_DEBUG(this << " ceBsrIt UE " << ceBsrIt.first << " bf size " << ceBsrIt.second << " iab " << isIab);
+		    NS_LOG_DEBUG(this << " ceBsrIt UE " << bsrRnti << " bf size " << m_ceBsr[slot] << " iab " << isIab);
 
 		    int cqi = 0;
 		    int mcs = 0;
-		    if (itCqi == m_ueUlCqi.end ()) // no cqi info for this UE
+		    if ((m_ueFields[slot] & UE_UL_CQI) == 0) // no cqi info for this UE
 		    {
-		        NS_LOG_DEBUG (this << " UE " << ceBsrIt.first << " does not have UL-CQI");
+		        NS_LOG_DEBUG (this << " UE " << bsrRnti << " does not have UL-CQI");
 		        cqi = 1;
 		        mcs = 0;
 		    }
@@ -1620,11 +540,11 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
 //					( (-std::log (5.0 * m_berDl )) / 1.5) ));
 //			cqi += m_amc->GetCqiFromSpectralEfficiency (se1);
 			NS_ASSERT (specIt != specVals.ValuesEnd());
-			*specIt = itCqi->second.m_ueUlCqi.at (ichunk); //sinrLin;
+			*specIt = m_ulCqi[slot].at (ichunk); //sinrLin;
 			specIt++;
 		    }
 
-		    cqi = m_amc->CreateCqiFeedbackWbTdma (specVals, itCqi->second.m_numSym, itCqi->second.m_tbSize, mcs);
+		    cqi = m_amc->CreateCqiFeedbackWbTdma (specVals, m_ulCqiNumSym[slot], m_ulCqiTbSize[slot], mcs);
 //					for (unsigned i = 0; i < chunkCqi.size(); i++)
 //					{
 //						cqi += chunkCqi[i];
@@ -1650,15 +570,15 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
 					//				cqi = m_amc->GetCqiFromSpectralEfficiency (se);
 		    if (cqi == 0 && !m_fixedMcsUl) // out of range (SINR too low)
 		    {
-			NS_LOG_DEBUG ("*** RNTI " << ceBsrIt.first << " UL-CQI out of range, skipping allocation in UL");
+			NS_LOG_DEBUG ("*** RNTI " << bsrRnti << " UL-CQI out of range, skipping allocation in UL");
 			// TODOIAB use continue and not break
 			continue;  // do not allocate UE in uplink
 		    }
 		}
-		itUeInfo = ueInfo.find (ceBsrIt.first);
+		itUeInfo = ueInfo.find (bsrRnti);
 		if (itUeInfo == ueInfo.end ())
 		{
-		    itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (ceBsrIt.first, UeSchedInfo () )).first;
+		    itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (bsrRnti, UeSchedInfo () )).first;
 					
 		    nFlowsUl++;
 		    if(!isIab)
@@ -1693,7 +613,7 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
 		{
 		    itUeInfo->second.m_ulMcs = mcs;//m_amc->GetMcsFromCqi (cqi);  // get MCS
 		}
-		itUeInfo->second.m_maxUlBufSize = ceBsrIt.second + m_rlcHdrSize + m_macHdrSize + 8;
+		itUeInfo->second.m_maxUlBufSize = m_ceBsr[slot] + m_rlcHdrSize + m_macHdrSize + 8;
 	    }
 	}
     }
@@ -1705,13 +625,7 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
 
     if (ueInfo.size () == 0)
     {
-	// add slot for UL control
-	SlotAllocInfo ulCtrlSlot (0xFF, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL, SlotAllocInfo::DIGITAL, 0);
-	ulCtrlSlot.m_dci.m_numSym = 1;
-	ulCtrlSlot.m_dci.m_symStart = m_phyMacConfig->GetSymbolsPerSubframe()-1;
-	ret.m_sfAllocInfo.m_slotAllocInfo.push_back (ulCtrlSlot);
-	m_macSchedSapUser->SchedConfigInd (ret);
-	return;
+	return;  // no grant, the TTI only carries the HARQ retransmissions
     }
 
     // compute requested num slots and TB size based on MCS and DL buffer size
@@ -2005,627 +919,34 @@ MmWaveFlexTtiMacScheduler::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize,
 
     NS_LOG_DEBUG(this << " m_nextRnti " << m_nextRnti);
 
-    // create DCI elements and assign symbol indices
-    // such that all DL slots are contiguous (at beginning of subframe)
-    // and all UL slots are contiguous (at end of subframe)
+    // create the grants per UE, starting from the same UE as the symbol division
+    // the DCIs are created by the skeleton in this order
     itUeInfo = itUeInfoStart;
-
-    //ulSymIdx -= totUlSymActual; // symbols reserved for control at end of subframe before UL ctrl
-    NS_ASSERT (symIdx > 0);
     do
     {
-        UeSchedInfo &ueSchedInfo = itUeInfo->second;
+	UeSchedInfo &ueSchedInfo = itUeInfo->second;
 	if (ueSchedInfo.m_dlSymbols > 0)
 	{
-	    std::vector<SlotAllocInfo> tmpSlotAllocVector;
-	    int numSymNeeded = ueSchedInfo.m_dlSymbols;
-	    int totalTbSize = 0;
-	    NS_LOG_DEBUG("UE " << itUeInfo->first << " numSymNeeded " << numSymNeeded);
-	    do
-	    {
-		// if there is overlapping, split allocation
-		// get the number of symbols that could be allocated
-		int numFreeSymbols = GetNumFreeSymbols(symIdx, numSymNeeded); // this is equal to numSymNeeded if there is no overlap, otherwise smaller
-		if(numFreeSymbols == 0)
-		{
-		    // symIdx is inside a busy interval, get the next free symIdx and retry
-		    NS_LOG_DEBUG("symIdx is in a busy interval, get the first free symIdx and retry");
-		    symIdx = GetFirstFreeSymbol(symIdx, 0); // get the next symIdx
-		    NS_LOG_DEBUG("new symIdx " << (uint16_t)symIdx);
-		    numFreeSymbols = GetNumFreeSymbols(symIdx, numSymNeeded);
-		}
-		symAvail -= numFreeSymbols;
-		numSymNeeded -= numFreeSymbols;
-		NS_LOG_DEBUG("UE " << itUeInfo->first << " numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " symAvail " << symAvail);
-
-		// create the DCI
-		DciInfoElementTdma dci;
-		dci.m_rnti = itUeInfo->first;
-		dci.m_format = 0;
-		dci.m_symStart = symIdx;
-		dci.m_numSym = numFreeSymbols;
-		symIdx = GetFirstFreeSymbol(symIdx, numFreeSymbols); // get the next symIdx
-		NS_LOG_LOGIC("Next symIdx " << (uint16_t)symIdx);
-		dci.m_ndi = 1;
-		dci.m_mcs = ueSchedInfo.m_dlMcs;
-		dci.m_tbSize = m_amc->GetTbSizeFromMcsSymbols (dci.m_mcs, dci.m_numSym) / 8;
-		totalTbSize += dci.m_tbSize;
-		
-		NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
-		dci.m_rv = 0;
-		dci.m_harqProcess = UpdateDlHarqProcessId (itUeInfo->first);
-		NS_ASSERT (dci.m_harqProcess < m_phyMacConfig->GetNumHarqProcess ());
-		NS_LOG_DEBUG ("UE" << itUeInfo->first << " DL harqId " << (unsigned)dci.m_harqProcess << " HARQ process assigned");
-		SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, itUeInfo->first);
-		slotInfo.m_dci = dci;
-		NS_LOG_DEBUG (this << " UE " << dci.m_rnti << " gets DL slots " << (unsigned)dci.m_symStart << "-" << (unsigned)(dci.m_symStart+dci.m_numSym-1) 
-				<< " tbs " << dci.m_tbSize << " mcs " << (unsigned)dci.m_mcs << " harqId " << (unsigned)dci.m_harqProcess 
-				<< " rv " << (unsigned)dci.m_rv << " in frame " << ret.m_sfnSf.m_frameNum << " subframe " << (unsigned)ret.m_sfnSf.m_sfNum);
-
-		if (m_harqOn == true)
-		{	// store DCI for HARQ buffer
-		    std::map <uint16_t, DlHarqProcessesDciInfoList_t>::iterator itDciInfo = m_dlHarqProcessesDciInfoMap.find (dci.m_rnti);
-		    if (itDciInfo == m_dlHarqProcessesDciInfoMap.end ())
-		    {
-		        NS_FATAL_ERROR ("Unable to find RNTI entry in DCI HARQ buffer for RNTI " << dci.m_rnti);
-		    }
-		    (*itDciInfo).second.at (dci.m_harqProcess) = dci;
-		    // refresh timer
-		    std::map <uint16_t, DlHarqProcessesTimer_t>::iterator itHarqTimer =  m_dlHarqProcessesTimer.find (dci.m_rnti);
-		    if (itHarqTimer== m_dlHarqProcessesTimer.end ())
-		    {
-			NS_FATAL_ERROR ("Unable to find HARQ timer for RNTI " << (uint16_t)dci.m_rnti);
-		    }
-		    (*itHarqTimer).second.at (dci.m_harqProcess) = 0;
-		}
-
-		tmpSlotAllocVector.push_back(slotInfo);
-
-	    } while(numSymNeeded > 0);
-
-	    // distribute bytes between active RLC queues
-	    unsigned numLc = ueSchedInfo.m_rlcPduInfo.size ();
-	    unsigned bytesRem = totalTbSize;
-	    unsigned numFulfilled = 0;
-	    uint16_t avgPduSize = bytesRem / numLc;
-	    NS_LOG_DEBUG("numLc " << numLc << " bytesRem " << bytesRem << " avgPduSize " << avgPduSize);
-			
-	    // first for loop computes extra to add to average if some flows are less than average
-	    for (unsigned i = 0; i < ueSchedInfo.m_rlcPduInfo.size (); i++)
-	    {
-		if (ueSchedInfo.m_rlcPduInfo[i].m_size < avgPduSize)
-		{
-		    bytesRem -= ueSchedInfo.m_rlcPduInfo[i].m_size;
-		    numFulfilled++;
-		}
-	    }
-
-	    if (numFulfilled < ueSchedInfo.m_rlcPduInfo.size ())
-	    {
-		avgPduSize = bytesRem / (ueSchedInfo.m_rlcPduInfo.size () - numFulfilled);
-	    }
-
-	    NS_LOG_DEBUG("numFulfilled " << numFulfilled << " new avgPduSize " << avgPduSize);
-
-	    // fill the RlcPduInfo taking into account the possible split of resources
-	    for(auto slotInfo : tmpSlotAllocVector)
-	    {
-		// distribute bytes between active RLC queues and slots allocated
-		int remTbSize = slotInfo.m_dci.m_tbSize;
-	        NS_LOG_DEBUG("slotInfo starting from " << (uint16_t)slotInfo.m_dci.m_symStart << " with tbSize " << remTbSize << " num PDU " << ueSchedInfo.m_rlcPduInfo.size());
-				
-		auto pduIterator = ueSchedInfo.m_rlcPduInfo.begin();
-		while (remTbSize > 0 && pduIterator != ueSchedInfo.m_rlcPduInfo.end())
-		{
-		    NS_LOG_DEBUG("PDU with initial size " << pduIterator->m_size);
-					// allocate as many bytes for this currentTbSize					
-					if (pduIterator->m_size > avgPduSize)
-					{
-						pduIterator->m_size = avgPduSize;
-						NS_LOG_LOGIC("Clip PDU to avgPduSize");
-					}
-					// else tbSize equals RLC queue size
-					NS_ASSERT(pduIterator->m_size > 0);
-
-					NS_LOG_DEBUG("Update RLC buffer with size (plus hdr)" << std::min(remTbSize, (int)pduIterator->m_size));
-					// update RLC buffer info with expected queue size after scheduling
-					UpdateDlRlcBufferInfo (itUeInfo->first, pduIterator->m_lcid, std::min(remTbSize, (int)pduIterator->m_size) - m_subHdrSize);
-
-					if((int)pduIterator->m_size > remTbSize)
-					{
-						// max amount of bytes that can be allocated
-						slotInfo.m_rlcPduInfo.push_back (RlcPduInfo(pduIterator->m_lcid, remTbSize));
-						pduIterator->m_size -= remTbSize - m_subHdrSize - 10; // TODOIAB add the size of a subheader (+10 understand why!)
-						remTbSize = 0;
-					}
-					else
-					{
-						slotInfo.m_rlcPduInfo.push_back ((*pduIterator));
-						remTbSize -= pduIterator->m_size;
-						
-						// we need to remove this m_rlcPduInfo since it has been satisfied
-						ueSchedInfo.m_rlcPduInfo.erase(pduIterator);
-						pduIterator = ueSchedInfo.m_rlcPduInfo.begin();
-					}
-
-					NS_LOG_DEBUG("Added RLC PDU with size " << slotInfo.m_rlcPduInfo.back().m_size << " remTbSize " << remTbSize);
-
-					if (m_harqOn == true)
-					{
-						// store RLC PDU list for HARQ
-						std::map <uint16_t, DlHarqRlcPduList_t>::iterator itRlcPdu =  m_dlHarqProcessesRlcPduMap.find (itUeInfo->first);
-						if (itRlcPdu == m_dlHarqProcessesRlcPduMap.end ())
-						{
-							NS_FATAL_ERROR ("Unable to find RlcPdcList in HARQ buffer for RNTI " << itUeInfo->first);
-						}
-						(*itRlcPdu).second.at (slotInfo.m_dci.m_harqProcess).push_back (slotInfo.m_rlcPduInfo.back());
-					}
-				}
-
-				
-				// reorder/reindex slots to maintain DL before UL slot order
-				bool reordered = false;
-				// std::deque <SlotAllocInfo>::iterator itSlot = ret.m_sfAllocInfo.m_slotAllocInfo.begin ();
-				// for (unsigned islot = 0; islot < ret.m_sfAllocInfo.m_slotAllocInfo.size (); islot++)
-				// {
-				// 	if (ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_tddMode == SlotAllocInfo::UL_slotAllocInfo)
-				// 	{
-				// 		slotInfo.m_slotIdx = ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_slotIdx;
-				// 		slotInfo.m_dci.m_symStart = ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_dci.m_symStart;
-				// 		ret.m_sfAllocInfo.m_slotAllocInfo.insert (itSlot, slotInfo);
-				// 		for (unsigned jslot = islot+1; jslot < ret.m_sfAllocInfo.m_slotAllocInfo.size (); jslot++)
-				// 		{
-				// 			ret.m_sfAllocInfo.m_slotAllocInfo[jslot].m_slotIdx++;	// increase indices of UL slots
-				// 			ret.m_sfAllocInfo.m_slotAllocInfo[jslot].m_dci.m_symStart =
-				// 														ret.m_sfAllocInfo.m_slotAllocInfo[jslot-1].m_dci.m_symStart +
-				// 														ret.m_sfAllocInfo.m_slotAllocInfo[jslot-1].m_dci.m_numSym;
-				// 		}
-				// 		reordered = true;
-				// 		break;
-				// 	}
-				// 	itSlot++;
-				// }
-				if (!reordered && slotInfo.m_rlcPduInfo.size() > 0) // TODOIAB understand why a TB may be in excess with respect to the RLC size
-				{
-					ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
-				}
-				ret.m_sfAllocInfo.m_numSymAlloc += slotInfo.m_dci.m_numSym;
-			} 
-		}
-
-		// UL DCI applies to subframe i+Tsched
-		if (ueSchedInfo.m_ulSymbols > 0)
-		{
-			int numSymNeeded = ueSchedInfo.m_ulSymbols;
-			do
-			{
-				// if there is overlapping, split allocation
-				// get the number of symbols that could be allocated
-				NS_LOG_DEBUG("UE " << itUeInfo->first << " numSymNeeded " << numSymNeeded);
-				int numFreeSymbols = GetNumFreeSymbols(symIdx, numSymNeeded); // this is equal to numSymNeeded if there is no overlap, otherwise smaller
-				if(numFreeSymbols == 0)
-				{
-					// symIdx is inside a busy interval, get the next free symIdx and retry
-					NS_LOG_DEBUG("symIdx is in a busy interval, get the first free symIdx and retry (UL)");
-					symIdx = GetFirstFreeSymbol(symIdx, 0); // get the next symIdx
-					NS_LOG_DEBUG("new symIdx " << (uint16_t)symIdx);
-					numFreeSymbols = GetNumFreeSymbols(symIdx, numSymNeeded);
-				}
-
-				symAvail -= numFreeSymbols;
-				numSymNeeded -= numFreeSymbols;
-				NS_LOG_DEBUG("UE " << itUeInfo->first << " numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " symAvail " << symAvail);
-
-				DciInfoElementTdma dci;
-				dci.m_rnti = itUeInfo->first;
-				dci.m_format = 1;
-				dci.m_numSym = numFreeSymbols;
-				dci.m_symStart = symIdx;
-				symIdx = GetFirstFreeSymbol(symIdx, numFreeSymbols); // get the next free symbol
-				NS_LOG_LOGIC("Next symIdx " << (uint16_t)symIdx);
-				dci.m_mcs = ueSchedInfo.m_ulMcs;
-				dci.m_ndi = 1;
-				dci.m_tbSize = m_amc->GetTbSizeFromMcsSymbols (dci.m_mcs, dci.m_numSym) / 8;
-
-				NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
-				dci.m_harqProcess = UpdateUlHarqProcessId (itUeInfo->first);
-				NS_LOG_DEBUG ("UE" << itUeInfo->first << " UL harqId " << (unsigned)dci.m_harqProcess << " HARQ process assigned");
-				NS_ASSERT (dci.m_harqProcess < m_phyMacConfig->GetNumHarqProcess ());
-				SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, itUeInfo->first);
-				slotInfo.m_dci = dci;
-				NS_LOG_DEBUG (this << " UE" << dci.m_rnti << " gets UL slots " << (unsigned)dci.m_symStart << "-" << (unsigned)(dci.m_symStart+dci.m_numSym-1) <<
-							             " tbs " << dci.m_tbSize << " mcs " << (unsigned)dci.m_mcs << " harqId " << (unsigned)dci.m_harqProcess << " rv " << (unsigned)dci.m_rv << " in frame " << ulSfn.m_frameNum << " subframe " << (unsigned)ulSfn.m_sfNum);
-				UpdateUlRlcBufferInfo (itUeInfo->first, dci.m_tbSize - m_subHdrSize);
-				ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);  // add to front
-				ret.m_sfAllocInfo.m_numSymAlloc += dci.m_numSym;
-				std::vector<uint16_t> ueChunkMap;
-				for (unsigned i = 0; i < m_phyMacConfig->GetTotalNumChunk (); i++)
-				{
-					ueChunkMap.push_back (dci.m_rnti);
-				}
-				SfnSf slotSfn = ret.m_sfAllocInfo.m_sfnSf;
-				slotSfn.m_slotNum = dci.m_symStart;  // use the start symbol index of the slot because the absolute UL slot index depends on the future DL allocation
-				// insert into allocation map to recall previous allocations upon receiving UL-CQI
-				m_ulAllocationMap.insert ( std::pair<uint32_t, struct AllocMapElem> (slotSfn.Encode (), AllocMapElem(ueChunkMap, dci.m_numSym, dci.m_tbSize)) );
-
-				if (m_harqOn == true)
-				{
-					uint8_t harqId = dci.m_harqProcess;
-					std::map <uint16_t, UlHarqProcessesDciInfoList_t>::iterator itHarqTbInfo = m_ulHarqProcessesDciInfoMap.find (dci.m_rnti);
-					if (itHarqTbInfo == m_ulHarqProcessesDciInfoMap.end ())
-					{
-						NS_FATAL_ERROR ("Unable to find RNTI entry in UL DCI HARQ buffer for RNTI " << dci.m_rnti);
-					}
-					(*itHarqTbInfo).second.at (harqId) = dci;
-					// Update HARQ process status (RV 0)
-					std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_ulHarqProcessesStatus.find (dci.m_rnti);
-					NS_ASSERT (itStat->second[dci.m_harqProcess] > 0);
-					// refresh timer
-					std::map <uint16_t, UlHarqProcessesTimer_t>::iterator itHarqTimer =  m_ulHarqProcessesTimer.find (dci.m_rnti);
-					if (itHarqTimer== m_ulHarqProcessesTimer.end ())
-					{
-						NS_FATAL_ERROR ("Unable to find HARQ timer for RNTI " << (uint16_t)dci.m_rnti);
-					}
-					(*itHarqTimer).second.at (dci.m_harqProcess) = 0;
-				}
-			} while(numSymNeeded > 0);
-		}
-
-		// get the next user
-		itUeInfo++;
-		if (itUeInfo == ueInfo.end ())
-		{ // loop around to first RNTI in map
-			itUeInfo = ueInfo.begin ();
-		}
-	}
-	while (itUeInfo != itUeInfoStart); // break when looped back to initial RNTI
-
-	// add slot for UL control
-	SlotAllocInfo ulCtrlSlot (0xFF, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL, SlotAllocInfo::DIGITAL, 0);
-	ulCtrlSlot.m_dci.m_numSym = 1;
-	ulCtrlSlot.m_dci.m_symStart = m_phyMacConfig->GetSymbolsPerSubframe()-1;
-	ret.m_sfAllocInfo.m_slotAllocInfo.push_back (ulCtrlSlot);
-
-	// Sort the slot allocation info by "m_dci.m_symStart"
-	std::sort(ret.m_sfAllocInfo.m_slotAllocInfo.begin(), ret.m_sfAllocInfo.m_slotAllocInfo.end(), BySymIndex());
-
-	m_macSchedSapUser->SchedConfigInd (ret);
-	return;
-    }
-
-int
-MmWaveFlexTtiMacScheduler::GetNumFreeSymbols(uint8_t symIdx, int numSymNeeded)
-{
-    NS_LOG_LOGIC("symIdx " << (uint16_t)symIdx << " numSymNeeded " << numSymNeeded);
-
-    if(!m_iabScheduler || !m_busyResourcesSchedSubframe.m_valid)
-    {
-        // If this is not an Iab scheduler or the subframe has been used already.
-	return numSymNeeded;
-    }
-
-    int numFreeSymbols = 0;
-    // get the possible overlapping region
-    uint32_t loopEnd = std::min(symIdx + numSymNeeded, (int)m_busyResourcesSchedSubframe.m_symAllocationMask.size());
-    NS_LOG_LOGIC("loopEnd " << loopEnd);
-    for(uint32_t index = symIdx; index < loopEnd; ++index)
-    {
-        if(m_busyResourcesSchedSubframe.m_symAllocationMask.at(index) == 0)
-	{
-	    numFreeSymbols++;
-	}
-	else
-	{
-	    // Contiguous symbol assignment, as soon as it detects a busy symbol after free symbols, it considers the end of the search.
-	    NS_LOG_LOGIC("Symbol busy, allocated " << numFreeSymbols << " out of " << numSymNeeded);
-	    break;
-	}
-    }
-    return numFreeSymbols;
-}
-
-void
-MmWaveFlexTtiMacScheduler::UpdateResourceMask(uint8_t start, int numSymbols)
-{
-    if(!m_iabScheduler)
-    {
-        NS_FATAL_ERROR("Try to update the mask for a non IAB scheduler");
-    }
-
-    for(uint32_t index = start; index < (uint32_t)(start + numSymbols); ++index)
-    {
-        m_busyResourcesSchedSubframe.m_symAllocationMask.at(index) = 1;
-    }
-		
-}
-
-uint8_t
-MmWaveFlexTtiMacScheduler::GetFirstFreeSymbol(uint8_t symIdx, int numFreeSymbols)
-{
-    NS_LOG_LOGIC("symIdx " << (uint16_t)symIdx << " numFreeSymbols " << numFreeSymbols);
-
-    if(!m_iabScheduler || !m_busyResourcesSchedSubframe.m_valid)
-    {
-        return symIdx + numFreeSymbols;  // here first free means the next first free after numFreeSymbols.
-    }
-
-    int index;
-    for(index = symIdx + numFreeSymbols; index < (int)m_busyResourcesSchedSubframe.m_symAllocationMask.size(); ++index)
-    {
-        if(m_busyResourcesSchedSubframe.m_symAllocationMask.at(index) == 0)
-	{
-	    NS_LOG_LOGIC("Free symbol found at " << index);
-	    break;
-	}
-    }
-    return static_cast<uint8_t>(index);
-}
-
-bool
-MmWaveFlexTtiMacScheduler::CheckOverlapWithBusyResources(uint8_t symIdx, int numSymNeeded)
-{
-	NS_LOG_LOGIC("symIdx " << (uint16_t)symIdx << " numSymNeeded " << numSymNeeded);
-
-	if(!m_iabScheduler || !m_busyResourcesSchedSubframe.m_valid)
-	{
-		return false;
-	}
-
-	uint32_t loopEnd = std::min(symIdx + numSymNeeded, (int)m_busyResourcesSchedSubframe.m_symAllocationMask.size());
-	NS_LOG_LOGIC("loopEnd " << loopEnd);
-	for(uint32_t index = symIdx; index < loopEnd; ++index)
-	{
-		if(m_busyResourcesSchedSubframe.m_symAllocationMask.at(index) == 1)
-		{
-			NS_LOG_LOGIC("overlapping from symbol " << index);
-			return true;
-		}
+	    UeGrant dlGrant = { itUeInfo->first, false, ueSchedInfo.m_dlSymbols, ueSchedInfo.m_dlMcs, &ueSchedInfo.m_rlcPduInfo, true };
+	    grants.push_back (dlGrant);
 	}
-	return false;
-}
-
-
-void
-MmWaveFlexTtiMacScheduler::DoSchedUlMacCtrlInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters& params)
-{
-	NS_LOG_FUNCTION (this);
-
-	std::map <uint16_t,uint32_t>::iterator it;
-
-	for (unsigned int i = 0; i < params.m_macCeList.size (); i++)
+	// UL DCI applies to subframe i+Tsched
+	if (ueSchedInfo.m_ulSymbols > 0)
 	{
-		if ( params.m_macCeList.at (i).m_macCeType == MacCeElement::BSR )
-		{
-			// buffer status report
-			// note that this scheduler does not differentiate the
-			// allocation according to which LCGs have more/less bytes
-			// to send.
-			// Hence the BSR of different LCGs are just summed up to get
-			// a total queue size that is used for allocation purposes.
-
-			uint32_t buffer = 0;
-			for (uint8_t lcg = 0; lcg < 4; ++lcg)
-			{
-				uint8_t bsrId = params.m_macCeList.at (i).m_macCeValue.m_bufferStatus.at (lcg);
-				buffer += BsrId2BufferSize (bsrId);
-			}
-
-			uint16_t rnti = params.m_macCeList.at (i).m_rnti;
-			it = m_ceBsrRxed.find (rnti);
-			if (it == m_ceBsrRxed.end ())
-			{
-				// create the new entry
-				m_ceBsrRxed.insert ( std::pair<uint16_t, uint32_t > (rnti, buffer));
-				NS_LOG_DEBUG (this << " Insert RNTI " << rnti << " queue " << buffer);
-			}
-			else
-			{
-				// update the buffer size value
-				(*it).second = buffer;
-				NS_LOG_DEBUG (this << " Update RNTI " << rnti << " queue " << buffer);
-			}
-		}
+	    UeGrant ulGrant = { itUeInfo->first, true, ueSchedInfo.m_ulSymbols, ueSchedInfo.m_ulMcs, 0, false };
+	    grants.push_back (ulGrant);
 	}
 
-	return;
-}
-
-void
-MmWaveFlexTtiMacScheduler::DoSchedSetMcs (int mcs)
-{
-	if (mcs >= 0 && mcs <= 28)
-	{
-		m_mcsDefaultDl = mcs;
-		m_mcsDefaultUl = mcs;
+	// get the next user
+	itUeInfo++;
+	if (itUeInfo == ueInfo.end ())
+	{ // loop around to first RNTI in map
+	    itUeInfo = ueInfo.begin ();
 	}
-}
-
-bool
-MmWaveFlexTtiMacScheduler::SortRlcBufferReq (MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters i, MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters j)
-{
-  return (i.m_rnti < j.m_rnti);
-}
-
-/*
- * ==================================================================
- * Update the Downlink Cqi map. Update timer and clear expired items.
- * ==================================================================
- */
-void
-MmWaveFlexTtiMacScheduler::RefreshDlCqiMaps (void)
-{
-    NS_LOG_FUNCTION (this << m_wbCqiTimers.size ());
-    // refresh DL CQI P01 Map
-    std::map <uint16_t,uint32_t>::iterator itP10 = m_wbCqiTimers.begin ();
-    while (itP10 != m_wbCqiTimers.end ())
-    {
-        NS_LOG_INFO (this << " P10-CQI for user " << (*itP10).first << " is " << (uint32_t)(*itP10).second << " thr " << (uint32_t)m_cqiTimersThreshold);
-        if ((*itP10).second == 0)
-        {
-            // delete correspondent entries, which is expired, as timer reaches 0
-            std::map <uint16_t,uint8_t>::iterator itMap = m_wbCqiRxed.find ((*itP10).first);
-            NS_ASSERT_MSG (itMap != m_wbCqiRxed.end (), " Does not find CQI report for user " << (*itP10).first);
-            NS_LOG_INFO (this << " P10-CQI exired for user " << (*itP10).first);
-            m_wbCqiRxed.erase (itMap);
-            std::map <uint16_t,uint32_t>::iterator temp = itP10;
-            itP10++;
-            m_wbCqiTimers.erase (temp);
-        }
-        else
-        {
-            (*itP10).second--;
-            itP10++;
-        }
-    }
-    return;
-}
-
-/*
- * ================================================================
- * Update the Uplink Cqi map. Update timer and clear expired items.
- * ================================================================
- */
-void
-MmWaveFlexTtiMacScheduler::RefreshUlCqiMaps (void)
-{
-    // refresh UL CQI  Map
-    std::map <uint16_t,uint32_t>::iterator itUl = m_ueCqiTimers.begin ();
-    while (itUl != m_ueCqiTimers.end ())
-    {
-        NS_LOG_INFO (this << " UL-CQI for user " << (*itUl).first << " is " << (uint32_t)(*itUl).second << " thr " << (uint32_t)m_cqiTimersThreshold);
-        if ((*itUl).second == 0)
-        {
-            // delete correspondent entries
-            std::map <uint16_t, struct UlCqiMapElem>::iterator itMap = m_ueUlCqi.find ((*itUl).first);
-            NS_ASSERT_MSG (itMap != m_ueUlCqi.end (), " Does not find CQI report for user " << (*itUl).first);
-            NS_LOG_DEBUG (this << " UL-CQI expired for user " << (*itUl).first);
-            itMap->second.m_ueUlCqi.clear ();
-            m_ueUlCqi.erase (itMap);
-            std::map <uint16_t,uint32_t>::iterator temp = itUl;
-            itUl++;
-            m_ueCqiTimers.erase (temp);
-        }
-        else
-        {
-            (*itUl).second--;
-            itUl++;
-        }
-    }
-    return;
-}
-
-
-/*
- * ===========================================
- * Update the Downlink RLC buffer information.
- * ===========================================
- */
-void
-MmWaveFlexTtiMacScheduler::UpdateDlRlcBufferInfo (uint16_t rnti, uint8_t lcid, uint16_t size)
-{
-    NS_LOG_FUNCTION (this);
-    std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it;
-    // m_rlcBufferReq stores UE's RLC buffer information. It is a list of RLC buffer information. 
-    for (it = m_rlcBufferReq.begin (); it != m_rlcBufferReq.end (); it++)
-    {
-        // An entry of RLC buffer information is identified by the tuple of "RNTI"(UE id)+"LCID"(logical channel id).
-        if (((*it).m_rnti == rnti) && ((*it).m_logicalChannelIdentity == lcid))
-  	{
-            // "BSR" is "Buffer Status Report" (In LTE, it is sent from UE to eNodeB)
-            NS_LOG_INFO (this << " Update DL RLC BSR UE " << rnti << " LC " << (uint16_t)lcid 
-			    << " txqueue " << (*it).m_rlcTransmissionQueueSize << " retxqueue " << (*it).m_rlcRetransmissionQueueSize 
-			    << " status " << (*it).m_rlcStatusPduSize << " decrease " << size);
-            // Update queues: RLC tx order Status, ReTx, Tx
-            // Update status queue
-            if (((*it).m_rlcStatusPduSize > 0) && (size >= (*it).m_rlcStatusPduSize))
-            {
-                (*it).m_rlcStatusPduSize = 0;  // 
-            }
-            // Update retransmission queue
-            if ((*it).m_rlcRetransmissionQueueSize > 0)
-            {
-		// TODO: Figure out why a cast is needed here. Any chance of overflow? 
-                if ((*it).m_rlcRetransmissionQueueSize <= (unsigned)(size - (*it).m_rlcStatusPduSize))
-  		{
-                    (*it).m_rlcRetransmissionQueueSize = 0;
-  		}
-  		else
-  		{
-  		    (*it).m_rlcRetransmissionQueueSize -= (size - (*it).m_rlcStatusPduSize);
-  		}
-            }
-	    // Update transmission queue.
-	    // TODO: In this "if-elseif" clause, the logic behind is that if UE has retransmission to do (i.e., m_rlcRetransmissionQueueSize > 0),
-	    // it will not update its transmission queue. Because retransmission has a higher priority than transmitting new data.
-            else if ((*it).m_rlcTransmissionQueueSize > 0)
-            {
-                uint32_t rlcOverhead;
-  		if (lcid == 1)
-  		{
-                    // For SRB1 (using RLC AM) it's better to overestimate RLC overhead rather than underestimate it 
-		    // and risk unneeded segmentation which increases delay.
-		    // "SRB" is "Signaling Radio Bearer"
-                    rlcOverhead = 4;
-                }
-  		else
-  		{
-                    // minimum RLC overhead due to header
-                    rlcOverhead = 2;
-                }
-		// TODO: Why is no cast here? "size" seems to already contain the overhead due to header.
-  		if ((*it).m_rlcTransmissionQueueSize <= (size - rlcOverhead - (*it).m_rlcStatusPduSize))
-  		{
-                    (*it).m_rlcTransmissionQueueSize = 0;
-  		}
-  		else
-  		{
-                    (*it).m_rlcTransmissionQueueSize -= (size - rlcOverhead - (*it).m_rlcStatusPduSize);
-                }
-            }
-            return;
-  	}
-    }
-}
-
-void
-MmWaveFlexTtiMacScheduler::UpdateUlRlcBufferInfo (uint16_t rnti, uint16_t size)
-{
-
-  size = size - 2; // remove the minimum RLC overhead
-  std::map <uint16_t,uint32_t>::iterator it = m_ceBsrRxed.find (rnti);
-  if (it != m_ceBsrRxed.end ())
-    {
-      NS_LOG_INFO (this << " Update UL RLC BSR UE " << rnti << " size " << size << " BSR " << (*it).second);
-      if ((*it).second >= size)
-        {
-          (*it).second -= size;
-        }
-      else
-        {
-          (*it).second = 0;
-        }
     }
-  else
-    {
-      NS_LOG_ERROR (this << " Does not find BSR report info of UE " << rnti);
+    while (itUeInfo != itUeInfoStart); // break when looped back to initial RNTI
     }
 
-}
-
-
-void
-MmWaveFlexTtiMacScheduler::DoCschedCellConfigReq (const struct MmWaveMacCschedSapProvider::CschedCellConfigReqParameters& params)
-{
-  NS_LOG_FUNCTION (this);
-  // Read the subset of parameters used
-  m_cschedCellConfig = params;
-  //m_rachAllocationMap.resize (m_cschedCellConfig.m_ulBandwidth, 0);
-  MmWaveMacCschedSapUser::CschedUeConfigCnfParameters cnf;
-  cnf.m_result = SUCCESS;
-  m_macCschedSapUser->CschedUeConfigCnf (cnf);
-  return;
-}
-
 
     /*
      * Configure single UE.
@@ -2637,63 +958,8 @@ MmWaveFlexTtiMacScheduler::DoCschedCellConfigReq (const struct MmWaveMacCschedSa
     {
         NS_LOG_FUNCTION (this << " RNTI " << params.m_rnti << " txMode " << (uint16_t)params.m_transmissionMode);
 
-	// NS_LOG_UNCOND (this << " Number of dl Harq processes " << m_phyMacConfig->GetNumHarqProcess ());
-        if (m_dlHarqProcessesStatus.find (params.m_rnti) == m_dlHarqProcessesStatus.end ())
-        {
-  	    //m_dlHarqCurrentProcessId.insert (std::pair <uint16_t,uint8_t > (params.m_rnti, 0));
-  	    DlHarqProcessesStatus_t dlHarqPrcStatus;
-  	    dlHarqPrcStatus.resize (m_phyMacConfig->GetNumHarqProcess (), 0);  // There are 100 harq processes for dl.
-  	    m_dlHarqProcessesStatus.insert (std::pair <uint16_t, DlHarqProcessesStatus_t> (params.m_rnti, dlHarqPrcStatus));
-  	    DlHarqProcessesTimer_t dlHarqProcessesTimer;
-  	    dlHarqProcessesTimer.resize (m_phyMacConfig->GetNumHarqProcess (),0);
-  	    m_dlHarqProcessesTimer.insert (std::pair <uint16_t, DlHarqProcessesTimer_t> (params.m_rnti, dlHarqProcessesTimer));
-  	    DlHarqProcessesDciInfoList_t dlHarqTbInfoList;
-  	    dlHarqTbInfoList.resize (m_phyMacConfig->GetNumHarqProcess ());
-  	    m_dlHarqProcessesDciInfoMap.insert (std::pair <uint16_t, DlHarqProcessesDciInfoList_t> (params.m_rnti, dlHarqTbInfoList));
-  	    DlHarqRlcPduList_t dlHarqRlcPduList;
-  	    dlHarqRlcPduList.resize (m_phyMacConfig->GetNumHarqProcess ());
-  	    m_dlHarqProcessesRlcPduMap.insert (std::pair <uint16_t, DlHarqRlcPduList_t> (params.m_rnti, dlHarqRlcPduList));
-        }
-
-        if (m_ulHarqProcessesStatus.find (params.m_rnti) == m_ulHarqProcessesStatus.end ())
-        {
-  	    // m_ulHarqCurrentProcessId.insert (std::pair <uint16_t,uint8_t > (rnti, 0));
-  	    UlHarqProcessesStatus_t ulHarqPrcStatus;
-  	    ulHarqPrcStatus.resize (m_phyMacConfig->GetNumHarqProcess (), 0);
-  	    m_ulHarqProcessesStatus.insert (std::pair <uint16_t, UlHarqProcessesStatus_t> (params.m_rnti, ulHarqPrcStatus));
-  	    UlHarqProcessesTimer_t ulHarqProcessesTimer;
-  	    ulHarqProcessesTimer.resize (m_phyMacConfig->GetNumHarqProcess (),0);
-  	    m_ulHarqProcessesTimer.insert (std::pair <uint16_t, UlHarqProcessesTimer_t> (params.m_rnti, ulHarqProcessesTimer));
-  	    UlHarqProcessesDciInfoList_t ulHarqTbInfoList;
-  	    ulHarqTbInfoList.resize (m_phyMacConfig->GetNumHarqProcess ());
-  	    m_ulHarqProcessesDciInfoMap.insert (std::pair <uint16_t, UlHarqProcessesDciInfoList_t> (params.m_rnti, ulHarqTbInfoList));
-        }
-
-        // IAB configure if this rnti is an IAB dev or not!
-        if(params.m_reconfigureFlag)
-        {
-  	    uint32_t prevNumDevs = 0;
-  	    auto iterIab = m_rntiIabInfoMap.find(params.m_rnti);
-  	    if(iterIab != m_rntiIabInfoMap.end())
-  	    {
-  	        iterIab->second.first = params.m_ueCapabilities.m_iab;
-  	        prevNumDevs = iterIab->second.second;
-  	        iterIab->second.second = params.m_ueCapabilities.m_numIabDevsPerRnti;
-  	    }
-  	    else
-  	    {
-  	        auto pair = std::make_pair(params.m_rnti, std::make_pair(params.m_ueCapabilities.m_iab, params.m_ueCapabilities.m_numIabDevsPerRnti));
-  	        m_rntiIabInfoMap.insert(pair);
-  	    }
-  	    NS_LOG_DEBUG(this << " Reconfiguration of UE " << params.m_rnti << " iab " << params.m_ueCapabilities.m_iab
-  		         << " numDevs " << params.m_ueCapabilities.m_numIabDevsPerRnti << " prevNumDevs " << prevNumDevs);
-
-  	    if(params.m_ueCapabilities.m_numIabDevsPerRnti + 1 > (int)m_maxSchedulingDelay) // + 1 since we need at least 1 TTI without no downstream IAB nodes
-  	    {
-  	        NS_LOG_WARN(this << " !!! --- !!! Updating m_maxSchedulingDelay from " << m_maxSchedulingDelay << " to " << params.m_ueCapabilities.m_numIabDevsPerRnti + 1);
-  	        m_maxSchedulingDelay = params.m_ueCapabilities.m_numIabDevsPerRnti + 1;
-  	    }
-        }
+	CreateUeHarqProcesses (params.m_rnti);
+	ConfigureIabInfo (params);
     }
 
 void
@@ -2704,70 +970,4 @@ MmWaveFlexTtiMacScheduler::DoCschedLcConfigReq (const struct MmWaveMacCschedSapP
   return;
 }
 
-void
-MmWaveFlexTtiMacScheduler::DoCschedLcReleaseReq (const struct MmWaveMacCschedSapProvider::CschedLcReleaseReqParameters& params)
-{
-  NS_LOG_FUNCTION (this);
-    for (uint16_t i = 0; i < params.m_logicalChannelIdentity.size (); i++)
-    {
-     std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it = m_rlcBufferReq.begin ();
-      while (it!=m_rlcBufferReq.end ())
-        {
-          if (((*it).m_rnti == params.m_rnti)&&((*it).m_logicalChannelIdentity == params.m_logicalChannelIdentity.at (i)))
-            {
-              it = m_rlcBufferReq.erase (it);
-            }
-          else
-            {
-              it++;
-            }
-        }
-    }
-  return;
-}
-
-void
-MmWaveFlexTtiMacScheduler::DoCschedUeReleaseReq (const struct MmWaveMacCschedSapProvider::CschedUeReleaseReqParameters& params)
-{
-  NS_LOG_FUNCTION (this << " Release RNTI " << params.m_rnti);
-
-  //m_dlHarqCurrentProcessId.erase (params.m_rnti);
-  m_dlHarqProcessesStatus.erase  (params.m_rnti);
-  m_dlHarqProcessesTimer.erase (params.m_rnti);
-  m_dlHarqProcessesDciInfoMap.erase  (params.m_rnti);
-  m_dlHarqProcessesRlcPduMap.erase  (params.m_rnti);
-  //m_ulHarqCurrentProcessId.erase  (params.m_rnti);
-  m_ulHarqProcessesTimer.erase (params.m_rnti);
-  m_ulHarqProcessesStatus.erase  (params.m_rnti);
-  m_ulHarqProcessesDciInfoMap.erase  (params.m_rnti);
-  m_ceBsrRxed.erase (params.m_rnti);
-  std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it = m_rlcBufferReq.begin ();
-  while (it != m_rlcBufferReq.end ())
-    {
-      if ((*it).m_rnti == params.m_rnti)
-        {
-          NS_LOG_INFO (this << " Erase RNTI " << (*it).m_rnti << " LC " << (uint16_t)(*it).m_logicalChannelIdentity);
-          it = m_rlcBufferReq.erase (it);
-        }
-      else
-        {
-          it++;
-        }
-    }
-  if (m_nextRntiUl == params.m_rnti)
-    {
-      m_nextRntiUl = 0;
-    }
-
-  if (m_nextRntiDl == params.m_rnti)
-    {
-      m_nextRntiDl = 0;
-    }
-
-  return;
-}
-
-
 }
-
-
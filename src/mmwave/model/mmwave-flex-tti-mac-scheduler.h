@@ -31,59 +31,25 @@
 #define SRC_MMWAVE_MODEL_MMWAVE_RR_MAC_SCHEDULER_H_
 
 
-#include "mmwave-mac-sched-sap.h"
-#include "mmwave-mac-csched-sap.h"
-#include "mmwave-mac-scheduler.h"
-#include "mmwave-amc.h"
-#include "string"
-#include <vector>
-#include <set>
+#include "mmwave-flex-tti-scheduler-base.h"
+#include <map>
 
 namespace ns3 {
 
-    class MmWaveFlexTtiMacScheduler : public MmWaveMacScheduler
+    class MmWaveFlexTtiMacScheduler : public MmWaveFlexTtiSchedulerBase
     {
     public:
-	typedef std::vector < uint8_t > DlHarqProcessesStatus_t;
-	typedef std::vector < uint8_t > DlHarqProcessesTimer_t;
-	typedef std::vector < DciInfoElementTdma > DlHarqProcessesDciInfoList_t;
-	typedef std::vector < std::vector <struct RlcPduInfo> > DlHarqRlcPduList_t; // vector of the LCs per per UE HARQ process
-	//	typedef std::vector < RlcPduElement > DlHarqRlcPduList_t; // vector of the 8 HARQ processes per UE
-	typedef std::vector < uint8_t > UlHarqProcessesTimer_t;
-	typedef std::vector < DciInfoElementTdma > UlHarqProcessesDciInfoList_t;
-	typedef std::vector < uint8_t > UlHarqProcessesStatus_t;
-
 	MmWaveFlexTtiMacScheduler ();
 	virtual ~MmWaveFlexTtiMacScheduler ();
 	virtual void DoDispose (void);
 
 	static TypeId GetTypeId (void);
 
-	virtual void SetMacSchedSapUser (MmWaveMacSchedSapUser* sap);
-  	virtual void SetMacCschedSapUser (MmWaveMacCschedSapUser* s);
-
-	virtual MmWaveMacSchedSapProvider* GetMacSchedSapProvider ();
-  	virtual MmWaveMacCschedSapProvider* GetMacCschedSapProvider ();
-
-  	virtual void SetMmWaveUeMacCschedSapProvider(MmWaveUeMacCschedSapProvider* sap);
-  	virtual MmWaveUeMacCschedSapProvider* GetMmWaveUeMacCschedSapProvider();
-
 	virtual void ConfigureCommonParameters (Ptr<MmWavePhyMacCommon> config);
 
-	void SetIabScheduler(bool iabScheduler);
-
-	static bool SortRlcBufferReq (MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters i, MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters j);
-
-	void RefreshDlCqiMaps (void);
-	void RefreshUlCqiMaps (void);
-
-	void UpdateDlRlcBufferInfo (uint16_t rnti, uint8_t lcid, uint16_t size);
-	void UpdateUlRlcBufferInfo (uint16_t rnti, uint16_t size);
-
 	// give access to the interfaces implementation to private methods 
 	friend class MmWaveFlexTtiMacSchedSapProvider;
 	friend class MmWaveFlexTtiMacCschedSapProvider;
-	friend class MemberMmWaveUeMacCschedSapProvider<MmWaveFlexTtiMacScheduler>;
 
     private:
 	struct UeSchedInfo
@@ -116,240 +82,59 @@ namespace ns3 {
 	    bool	m_iab;
 	};
 
-	unsigned CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize, unsigned &tbSize);
-
-	uint32_t
-	BsrId2BufferSize (uint8_t val)
+	/*
+	 * Ranking policy of DoSchedTriggerReq: the symbols left after the HARQ
+	 * retransmissions are divided evenly between the active flows, starting
+	 * from the UE at which the previous TTI left off
+	 */
+	class RrRanking
 	{
-	  NS_ABORT_MSG_UNLESS (val < 64, "val = " << val << " is out of range");
-	  return BufferSizeLevelBsrTable[val];
-	}
+	public:
+	    RrRanking (MmWaveFlexTtiMacScheduler* scheduler);
 
-	uint8_t
-	BufferSize2BsrId (uint32_t val)
-	{
-	  int index = 0;
-	  if (BufferSizeLevelBsrTable[63] < val)
-	    {
-	      index = 63;
-	    }
-	  else
-	    {
-	      while (BufferSizeLevelBsrTable[index] < val)
-	        {
-	          NS_ASSERT (index < 64);
-	          index++;
-	        }
-	    }
+	    void NotifyRetx (const HarqRetx &retx);
+	    void RankUes (SchedTriggerState &state, std::vector<UeGrant> &grants);
+	    void Reset ();
 
-	  return (index);
-	}
+	private:
+	    MmWaveFlexTtiMacScheduler* m_scheduler;
+	    std::map <uint16_t, struct UeSchedInfo> m_ueInfo;
+	};
 
-	uint8_t UpdateDlHarqProcessId (uint16_t rnti);
-	uint8_t UpdateUlHarqProcessId (uint16_t rnti);
+	/**
+	 * \brief Divide the free symbols of the TTI between the active DL and UL flows
+	 * @params the state of the TTI
+	 * @params the UEs of the TTI, which already contain the HARQ retransmissions
+	 * @params the grants, per UE in round robin order
+	 */
+	void RankUes (SchedTriggerState &state, std::map <uint16_t, struct UeSchedInfo> &ueInfo, std::vector<UeGrant> &grants);
+
+	unsigned CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize, unsigned &tbSize);
 
 	//
 	// Implementation of the CSCHED API primitives
 	// (See 4.1 for description of the primitives)
 	//
 
-	void DoCschedCellConfigReq (const struct MmWaveMacCschedSapProvider::CschedCellConfigReqParameters& params);
-
 	void DoCschedUeConfigReq (const struct MmWaveMacCschedSapProvider::CschedUeConfigReqParameters& params);
 
 	void DoCschedLcConfigReq (const struct MmWaveMacCschedSapProvider::CschedLcConfigReqParameters& params);
 
-	void DoCschedLcReleaseReq (const struct MmWaveMacCschedSapProvider::CschedLcReleaseReqParameters& params);
-
-	void DoCschedUeReleaseReq (const struct MmWaveMacCschedSapProvider::CschedUeReleaseReqParameters& params);
-
 	//
 	// Implementation of the SCHED API primitives
 	// (See 4.2 for description of the primitives)
 	//
 
-	void DoSchedDlRlcBufferReq (const struct MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters& params);
-
-	void DoSchedDlCqiInfoReq (const MmWaveMacSchedSapProvider::SchedDlCqiInfoReqParameters& params); // Put in UML
-
-	void DoSchedUlCqiInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters& params);
-
-	void DoSchedUlMacCtrlInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters& params);
-
 	void DoSchedTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params);
 
-	bool DoSchedDlTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params,
-	                          MmWaveMacSchedSapUser::SchedConfigIndParameters& ret,
-	                          unsigned int frameNum,
-	                          unsigned int sfNum,
-	                          unsigned int islot);
-
-	bool DoSchedUlTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params,
-	                          MmWaveMacSchedSapUser::SchedConfigIndParameters& ret,
-	                          unsigned int frameNum,
-	                          unsigned int sfNum,
-	                          unsigned int islot);
-
-	void DoSchedSetMcs (int mcs);
-
-	// implementations of the APIs for backhaul
-	void DoIabBackhaulSchedNotify(const struct MmWaveUeMacCschedSapProvider::IabBackhaulSchedInfo& info);
-	// IAB: get the number of IAB devices with active BSRs
-	uint16_t GetNumIabRnti();
-	// IAB get the number of available symbols before a busy region in a subframe
-	int GetNumFreeSymbols(uint8_t symIdx, int numSymNeeded);
-	// IAB get the index of the first available symbol after a busy region in a subframe
-	uint8_t GetFirstFreeSymbol(uint8_t symIdx, int numSymNeeded);
-	// IAB check if there is an overlapping with the already allocated resources
-	bool CheckOverlapWithBusyResources(uint8_t symIdx, int numSymNeeded);
-	// IAB print the subframe allocation mask
-	std::string PrintSubframeAllocationMask(std::vector<bool> mask);
-	// IAB update the number of available symbols considering IAB allocation
-	int UpdateBusySymbolsForIab(uint8_t sfNum, uint8_t symIdx, int symAvail);
-	// HARQ allocation: update the mask with busy resources
-	void UpdateResourceMask(uint8_t start, int numSymbols);
-  /**
-   * \brief Refresh HARQ processes according to the timers
-   *
-   */
-	void RefreshHarqProcesses ();
-
 	TddSlotTypeList m_tddMap;
 
-	Ptr<MmWaveAmc> m_amc;
-
-	/*
-	 * Vectors of UE's RLC info
-	 */
-	std::list <MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters> m_rlcBufferReq;
-
-	/*
-	 * Map of UE's DL CQI WB received
-	 */
-	std::map <uint16_t,uint8_t> m_wbCqiRxed;
-	/*
-	 * Map of UE's timers on DL CQI WB received
-	 */
-	std::map <uint16_t,uint32_t> m_wbCqiTimers;
-
-	uint32_t m_cqiTimersThreshold; // # of TTIs for which a CQI can be considered valid
-
-	/*
-	 * Map of UEs' UL-CQI per RBG
-	 */
-	struct UlCqiMapElem
-	{
-		UlCqiMapElem (std::vector<double> ulCqi, uint8_t nSym, uint32_t tbs) :
-			m_ueUlCqi (ulCqi), m_numSym (nSym), m_tbSize (tbs)
-		{
-		}
-		std::vector <double> m_ueUlCqi;
-		uint8_t 	m_numSym;
-		uint32_t	m_tbSize;
-	};
-
-	std::map <uint16_t, struct UlCqiMapElem> m_ueUlCqi;
-	/*
-	 * Map of UEs' timers on UL-CQI per RBG
-	 */
-	std::map <uint16_t, uint32_t> m_ueCqiTimers;
-
-	/*
-	 * Map of UE's buffer status reports received
-	 */
-	std::map <uint16_t,uint32_t> m_ceBsrRxed;
-
 	uint16_t m_nextRnti;
-	uint64_t m_nextRntiDl;
-	uint64_t m_nextRntiUl;
 
 	uint32_t m_subframeNo;
 	uint32_t m_frameNo;
-	uint8_t m_tbUid;
 	uint32_t m_numChunks;
-	uint32_t m_numDataSymbols;
-
-	MmWaveMacSchedSapProvider* m_macSchedSapProvider;
-	MmWaveMacSchedSapUser* m_macSchedSapUser;
-	MmWaveMacCschedSapUser* m_macCschedSapUser;
-	MmWaveMacCschedSapProvider* m_macCschedSapProvider;
-	// for backhaul purposes
-	MmWaveUeMacCschedSapProvider* m_iabBackahulSapProvider;
-
-	MmWaveMacCschedSapProvider::CschedCellConfigReqParameters m_cschedCellConfig;
-
-	struct AllocMapElem
-	{
-		AllocMapElem (std::vector<uint16_t> rntiMap, uint8_t nSym, uint32_t tbs) :
-			m_rntiPerChunk (rntiMap), m_numSym (nSym), m_tbSize (tbs)
-		{
-		}
-
-		std::vector <uint16_t> m_rntiPerChunk;
-		uint8_t m_numSym;
-		uint32_t m_tbSize;
-	};
-	/*
-	 * Map of previous allocated UE per RBG
-	 * (used to retrieve info from UL-CQI)
-	 */
-	std::map <uint32_t, struct AllocMapElem> m_ulAllocationMap;
-
-	// HARQ attributes
-	/**
-	 * m_harqOn when false inhibit te HARQ mechanisms (by default active)
-	 */
-	bool    m_harqOn;
-	uint8_t m_numHarqProcess;
-	uint8_t m_harqTimeout;
-
-	std::map <uint16_t, uint8_t> m_dlHarqCurrentProcessId;
-	//HARQ status
-	// 0: process Id available
-	// x>0: process Id equal to `x` trasmission count
-	std::map <uint16_t, DlHarqProcessesStatus_t> m_dlHarqProcessesStatus;
-	std::map <uint16_t, DlHarqProcessesTimer_t> m_dlHarqProcessesTimer;
-	std::map <uint16_t, DlHarqProcessesDciInfoList_t> m_dlHarqProcessesDciInfoMap;
-	std::map <uint16_t, DlHarqRlcPduList_t> m_dlHarqProcessesRlcPduMap;
-	std::vector <DlHarqInfo> m_dlHarqInfoList; // HARQ retx buffered
-	std::vector <UlHarqInfo> m_ulHarqInfoList; // HARQ retx buffered
-
-	std::map <uint16_t, uint8_t> m_ulHarqCurrentProcessId;
-	//HARQ status
-	// 0: process Id available
-	// x>0: process Id equal to `x` trasmission count
-	std::map <uint16_t, UlHarqProcessesStatus_t> 	m_ulHarqProcessesStatus;
-	std::map <uint16_t, UlHarqProcessesTimer_t> 	m_ulHarqProcessesTimer;
-	std::map <uint16_t, UlHarqProcessesDciInfoList_t> m_ulHarqProcessesDciInfoMap;
-
-	// needed to keep track of uplink allocations in later slots
-	std::list <struct SfAllocInfo> m_ulSfAllocInfo;
-
-	std::map <uint16_t, IabInfo_t> m_rntiIabInfoMap;
-
-	static const unsigned m_macHdrSize;
-	static const unsigned m_subHdrSize;
-	static const unsigned m_rlcHdrSize;
-
-	static const double m_berDl;
-	bool 		m_fixedMcsDl;
-	bool 		m_fixedMcsUl;
-	uint8_t m_mcsDefaultDl;
-	uint8_t m_mcsDefaultUl;
-
-	bool m_dlOnly;
-	bool m_ulOnly; //for testing
-
-	bool m_fixedTti;		// one slot per TTI
-	uint8_t	m_symPerSlot; // symbols per slot
 
-	uint32_t m_maxSchedulingDelay; // scheduling delay (replaces MmWavePhyMacCommon GetUlSchedDelay) 
-								   // and is updated every time a new IAB device connects
-	bool m_iabScheduler;
-	bool m_split;
-	SfIabAllocInfo m_busyResourcesSchedSubframe;
-	std::vector<SfIabAllocInfo> m_iabBusySubframeAllocation;  // vector with IAB allocation info. By default, 10 elements
-	                                                          // are stored in the vector corresponding to 10 subframes.
 	/*
 	 * Out-of-band backhaul pre-computed optimal scheduling result.
 	 */
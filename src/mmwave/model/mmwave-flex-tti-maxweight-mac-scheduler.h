@@ -11,7 +11,7 @@
 
 #include "mmwave-mac-sched-sap.h"
 #include "mmwave-mac-csched-sap.h"
-#include "mmwave-mac-scheduler.h"
+#include "mmwave-flex-tti-scheduler-base.h"
 #include "mmwave-amc.h"
 #include "string"
 #include <vector>
@@ -21,44 +21,18 @@
 
 namespace ns3 {
 
-class MmWaveFlexTtiMaxWeightMacScheduler : public MmWaveMacScheduler
+class MmWaveFlexTtiMaxWeightMacScheduler : public MmWaveFlexTtiSchedulerBase
 {
 public:
-	typedef std::vector < uint8_t > DlHarqProcessesStatus_t;
-	typedef std::vector < uint8_t > DlHarqProcessesTimer_t;
-	typedef std::vector < DciInfoElementTdma > DlHarqProcessesDciInfoList_t;
-	typedef std::vector < std::vector <struct RlcPduInfo> > DlHarqRlcPduList_t; // vector of the LCs per per UE HARQ process
-	//	typedef std::vector < RlcPduElement > DlHarqRlcPduList_t; // vector of the 8 HARQ processes per UE
-
-	typedef std::vector < uint8_t > UlHarqProcessesTimer_t;
-	typedef std::vector < DciInfoElementTdma > UlHarqProcessesDciInfoList_t;
-	typedef std::vector < uint8_t > UlHarqProcessesStatus_t;
-
-
 	MmWaveFlexTtiMaxWeightMacScheduler ();
 
 	virtual ~MmWaveFlexTtiMaxWeightMacScheduler ();
 	virtual void DoDispose (void);
 	static TypeId GetTypeId (void);
 
-	virtual void SetMacSchedSapUser (MmWaveMacSchedSapUser* sap);
-  	virtual void SetMacCschedSapUser (MmWaveMacCschedSapUser* s);
-
-	virtual MmWaveMacSchedSapProvider* GetMacSchedSapProvider ();
-  	virtual MmWaveMacCschedSapProvider* GetMacCschedSapProvider ();
-
   	virtual void SetMmWaveUeMacCschedSapProvider(MmWaveUeMacCschedSapProvider* sap);
   	virtual MmWaveUeMacCschedSapProvider* GetMmWaveUeMacCschedSapProvider();
 
-	virtual void ConfigureCommonParameters (Ptr<MmWavePhyMacCommon> config);
-
-	void SetIabScheduler(bool iabScheduler);
-
-	static bool SortRlcBufferReq (MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters i, MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters j);
-
-	void RefreshDlCqiMaps (void);
-	void RefreshUlCqiMaps (void);
-
 	void UpdateDlRlcBufferInfo (uint16_t rnti, uint8_t lcid, uint16_t size);
 	void UpdateUlRlcBufferInfo (uint16_t rnti, uint16_t size);
 
@@ -187,67 +161,69 @@ private:
 		}
 	};*/
 
-	static bool CompareFlowWeightsEdf (FlowStats* lflow, FlowStats* rflow)
+	// the rankings are function objects rather than functions, so that
+	// std::sort is instantiated for each of them and inlines the comparison
+	struct CompareFlowWeightsEdf
 	{
-		int lRelDeadline = lflow->m_deadlineUs - lflow->m_txQueueHolDelay;
-		int rRelDeadline = rflow->m_deadlineUs - rflow->m_txQueueHolDelay;
-		return (lRelDeadline < rRelDeadline);	// earlier deadline = greater weight
-	}
+		bool operator() (const FlowStats* lflow, const FlowStats* rflow) const
+		{
+			int lRelDeadline = lflow->m_deadlineUs - lflow->m_txQueueHolDelay;
+			int rRelDeadline = rflow->m_deadlineUs - rflow->m_txQueueHolDelay;
+			return (lRelDeadline < rRelDeadline);	// earlier deadline = greater weight
+		}
+	};
 
-	static bool CompareFlowWeightsDeliveryDebt (FlowStats* lflow, FlowStats* rflow)
+	struct CompareFlowWeightsDeliveryDebt
 	{
-		int lflowDebt = (lflow->m_arrivalRate/(1-lflow->m_probErr)) - lflow->m_grantedRate;
-		int rflowDebt = (rflow->m_arrivalRate/(1-rflow->m_probErr)) - rflow->m_grantedRate;
-		return (lflowDebt > rflowDebt);
-	}
-
-	unsigned CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize, unsigned &tbSize);
+		bool operator() (const FlowStats* lflow, const FlowStats* rflow) const
+		{
+			int lflowDebt = (lflow->m_arrivalRate/(1-lflow->m_probErr)) - lflow->m_grantedRate;
+			int rflowDebt = (rflow->m_arrivalRate/(1-rflow->m_probErr)) - rflow->m_grantedRate;
+			return (lflowDebt > rflowDebt);
+		}
+	};
 
-	uint32_t
-	BsrId2BufferSize (uint8_t val)
+	/*
+	 * Ranking policy of DoSchedTriggerReq: the free symbols go to the flows
+	 * with the earliest deadline first, then the UEs are granted in RNTI
+	 * order, DL before UL
+	 */
+	class MaxWeightRanking
 	{
-	  NS_ABORT_MSG_UNLESS (val < 64, "val = " << val << " is out of range");
-	  return BufferSizeLevelBsrTable[val];
-	}
+	public:
+		MaxWeightRanking (MmWaveFlexTtiMaxWeightMacScheduler* scheduler);
 
-	uint8_t
-	BufferSize2BsrId (uint32_t val)
-	{
-	  int index = 0;
-	  if (BufferSizeLevelBsrTable[63] < val)
-	    {
-	      index = 63;
-	    }
-	  else
-	    {
-	      while (BufferSizeLevelBsrTable[index] < val)
-	        {
-	          NS_ASSERT (index < 64);
-	          index++;
-	        }
-	    }
-
-	  return (index);
-	}
-
-	uint8_t UpdateDlHarqProcessId (uint16_t rnti);
-	uint8_t UpdateUlHarqProcessId (uint16_t rnti);
+		void NotifyRetx (const HarqRetx &retx);
+		void RankUes (SchedTriggerState &state, std::vector<UeGrant> &grants);
+		void Reset ();
+
+	private:
+		MmWaveFlexTtiMaxWeightMacScheduler* m_scheduler;
+		std::map <uint16_t, UeSchedInfo*> m_ueAllocMap;	// map of allocated users for this SF
+	};
+
+	/**
+	 * \brief Assign the free symbols of the TTI to the HOL packets of the flows in order of weight
+	 * @params the state of the TTI
+	 * @params the UEs of the TTI, which already contain the HARQ retransmissions
+	 * @params the grants, DL before UL
+	 */
+	void RankUes (SchedTriggerState &state, std::map <uint16_t, UeSchedInfo*> &ueAllocMap, std::vector<UeGrant> &grants);
+
+	/**
+	 * \brief The trigger schedules its own subframe, since IAB is not supported
+	 */
+	uint32_t GetSchedulingDelay () const;
 
 	//
 	// Implementation of the CSCHED API primitives
 	// (See 4.1 for description of the primitives)
 	//
 
-	void DoCschedCellConfigReq (const struct MmWaveMacCschedSapProvider::CschedCellConfigReqParameters& params);
-
 	void DoCschedUeConfigReq (const struct MmWaveMacCschedSapProvider::CschedUeConfigReqParameters& params);
 
 	void DoCschedLcConfigReq (const struct MmWaveMacCschedSapProvider::CschedLcConfigReqParameters& params);
 
-	void DoCschedLcReleaseReq (const struct MmWaveMacCschedSapProvider::CschedLcReleaseReqParameters& params);
-
-	void DoCschedUeReleaseReq (const struct MmWaveMacCschedSapProvider::CschedUeReleaseReqParameters& params);
-
 	//
 	// Implementation of the SCHED API primitives
 	// (See 4.2 for description of the primitives)
@@ -255,157 +231,17 @@ private:
 
 	void DoSchedDlRlcBufferReq (const struct MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters& params);
 
-	void DoSchedDlCqiInfoReq (const MmWaveMacSchedSapProvider::SchedDlCqiInfoReqParameters& params); // Put in UML
-
-	void DoSchedUlCqiInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters& params);
-
 	void DoSchedUlMacCtrlInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters& params);
 
 	void DoSchedTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params);
 
-	bool DoSchedDlTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params,
-	                          MmWaveMacSchedSapUser::SchedConfigIndParameters& ret,
-	                          unsigned int frameNum,
-	                          unsigned int sfNum,
-	                          unsigned int islot);
-
-	bool DoSchedUlTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params,
-	                          MmWaveMacSchedSapUser::SchedConfigIndParameters& ret,
-	                          unsigned int frameNum,
-	                          unsigned int sfNum,
-	                          unsigned int islot);
-
-	void DoSchedSetMcs (int mcs);
-  /**
-   * \brief Refresh HARQ processes according to the timers
-   *
-   */
-	void RefreshHarqProcesses ();
-
 	TddSlotTypeList m_tddMap;
 
-	Ptr<MmWaveAmc> m_amc;
-
-	/*
-	 * Vectors of UE's RLC info
-	 */
-	std::list <MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters> m_rlcBufferReq;
-
-	/*
-	 * Map of UE's DL CQI WB received
-	 */
-	std::map <uint16_t,uint8_t> m_wbCqiRxed;
-	/*
-	 * Map of UE's timers on DL CQI WB received
-	 */
-	std::map <uint16_t,uint32_t> m_wbCqiTimers;
-
-	uint32_t m_cqiTimersThreshold; // # of TTIs for which a CQI can be considered valid
-
-	/*
-	 * Map of UEs' UL-CQI per RBG
-	 */
-	struct UlCqiMapElem
-	{
-		UlCqiMapElem (std::vector<double> ulCqi, uint8_t nSym, uint32_t tbs) :
-			m_ueUlCqi (ulCqi), m_numSym (nSym), m_tbSize (tbs)
-		{
-		}
-		std::vector <double> m_ueUlCqi;
-		uint8_t 	m_numSym;
-		uint32_t	m_tbSize;
-	};
-
-	std::map <uint16_t, struct UlCqiMapElem> m_ueUlCqi;
-	/*
-	 * Map of UEs' timers on UL-CQI per RBG
-	 */
-	std::map <uint16_t, uint32_t> m_ueCqiTimers;
-
-	/*
-	 * Map of UE's buffer status reports received
-	 */
-	std::map <uint16_t,uint32_t> m_ceBsrRxed;
-
 	uint16_t m_nextRnti;
-	uint64_t m_nextRntiDl;
-	uint64_t m_nextRntiUl;
 
 	uint32_t m_subframeNo;
 	uint32_t m_frameNo;
-	uint8_t m_tbUid;
 	uint32_t m_numChunks;
-	uint32_t m_numDataSymbols;
-
-	MmWaveMacSchedSapProvider* m_macSchedSapProvider;
-	MmWaveMacSchedSapUser* m_macSchedSapUser;
-	MmWaveMacCschedSapUser* m_macCschedSapUser;
-	MmWaveMacCschedSapProvider* m_macCschedSapProvider;
-
-	MmWaveUeMacCschedSapProvider* m_iabBackahulSapProvider;
-
-	MmWaveMacCschedSapProvider::CschedCellConfigReqParameters m_cschedCellConfig;
-
-	struct AllocMapElem
-	{
-		AllocMapElem (std::vector<uint16_t> rntiMap, uint8_t nSym, uint32_t tbs) :
-			m_rntiPerChunk (rntiMap), m_numSym (nSym), m_tbSize (tbs)
-		{
-		}
-
-		std::vector <uint16_t> m_rntiPerChunk;
-		uint8_t m_numSym;
-		uint32_t m_tbSize;
-	};
-	/*
-	 * Map of previous allocated UE per RBG
-	 * (used to retrieve info from UL-CQI)
-	 */
-	std::map <uint32_t, struct AllocMapElem> m_ulAllocationMap;
-
-	// HARQ attributes
-	/**
-	 * m_harqOn when false inhibit te HARQ mechanisms (by default active)
-	 */
-	bool m_harqOn;
-	uint8_t m_numHarqProcess;
-	uint8_t m_harqTimeout;
-
-	std::map <uint16_t, uint8_t> m_dlHarqCurrentProcessId;
-	//HARQ status
-	// 0: process Id available
-	// x>0: process Id equal to `x` trasmission count
-	std::map <uint16_t, DlHarqProcessesStatus_t> m_dlHarqProcessesStatus;
-	std::map <uint16_t, DlHarqProcessesTimer_t> m_dlHarqProcessesTimer;
-	std::map <uint16_t, DlHarqProcessesDciInfoList_t> m_dlHarqProcessesDciInfoMap;
-	std::map <uint16_t, DlHarqRlcPduList_t> m_dlHarqProcessesRlcPduMap;
-	std::vector <DlHarqInfo> m_dlHarqInfoList; // HARQ retx buffered
-	std::vector <UlHarqInfo> m_ulHarqInfoList; // HARQ retx buffered
-
-	std::map <uint16_t, uint8_t> m_ulHarqCurrentProcessId;
-	//HARQ status
-	// 0: process Id available
-	// x>0: process Id equal to `x` trasmission count
-	std::map <uint16_t, UlHarqProcessesStatus_t> 	m_ulHarqProcessesStatus;
-	std::map <uint16_t, UlHarqProcessesTimer_t> 	m_ulHarqProcessesTimer;
-	std::map <uint16_t, UlHarqProcessesDciInfoList_t> m_ulHarqProcessesDciInfoMap;
-
-	// needed to keep track of uplink allocations in later slots
-	std::list <struct SfAllocInfo> m_ulSfAllocInfo;
-
-	static const unsigned m_macHdrSize;
-	static const unsigned m_subHdrSize;
-	static const unsigned m_rlcHdrSize;
-
-	double m_berDl;		// used for	SNR-based AMC model
-
-	//for testing
-	bool 		m_fixedMcsDl;
-	bool 		m_fixedMcsUl;
-	uint8_t m_mcsDefaultDl;
-	uint8_t m_mcsDefaultUl;
-	bool m_dlOnly;
-	bool m_ulOnly;
 
 	std::map<uint16_t, UeSchedInfo> m_ueSchedInfoMap;
 
@@ -414,11 +250,6 @@ private:
 	//flowQueue_t m_flowQueue;
 
 	std::vector <FlowStats*> m_flowHeap;
-
-	bool m_fixedTti;		// one slot per TTI
-	uint8_t	m_symPerSlot; // symbols per slot
-
-	bool m_iabScheduler;
 };
 
 }
@@ -0,0 +1,1891 @@
+/*
+ * mmwave-flex-tti-scheduler-base.cc
+ *
+ *  Common part of the flex-TTI RR, PF, MaxRate and MaxWeight schedulers
+ */
+
+#include <ns3/log.h>
+#include <ns3/abort.h>
+#include "mmwave-flex-tti-scheduler-base.h"
+#include <ns3/lte-common.h>
+#include <stdlib.h>     /* abs */
+#include "mmwave-mac-pdu-header.h"
+#include "mmwave-spectrum-value-helper.h"
+#include <cmath>
+#include <sstream>      // std::stringstream
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveFlexTtiSchedulerBase");
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveFlexTtiSchedulerBase);
+
+const unsigned MmWaveFlexTtiSchedulerBase::m_macHdrSize = 0;
+const unsigned MmWaveFlexTtiSchedulerBase::m_subHdrSize = 4;
+const unsigned MmWaveFlexTtiSchedulerBase::m_rlcHdrSize = 3;
+
+const double MmWaveFlexTtiSchedulerBase::m_berDl = 0.001;  // TODO: Seems not used in the current code.
+
+const uint32_t MmWaveFlexTtiSchedulerBase::NO_UE_SLOT;
+
+MmWaveFlexTtiSchedulerBase::MmWaveFlexTtiSchedulerBase ()
+: m_nextRntiDl (0),
+  m_nextRntiUl (0),
+  m_tbUid (0),
+  m_macSchedSapProvider (0),
+  m_macSchedSapUser (0),
+  m_macCschedSapUser (0),
+  m_macCschedSapProvider (0),
+  m_dlSlotsFirst (false),
+  m_maxSchedulingDelay (1),
+  m_iabScheduler (false),
+  m_split (true)
+{
+	NS_LOG_FUNCTION (this);
+	// Specific Sap Provider defined for the backhaul usage. It uses UeMac's CschedSapProvider
+	m_iabBackahulSapProvider = new MemberMmWaveUeMacCschedSapProvider<MmWaveFlexTtiSchedulerBase> (this);
+	m_iabBusySubframeAllocation.clear();
+}
+
+MmWaveFlexTtiSchedulerBase::~MmWaveFlexTtiSchedulerBase ()
+{
+	NS_LOG_FUNCTION (this);
+}
+
+void
+MmWaveFlexTtiSchedulerBase::DoDispose (void)
+{
+	NS_LOG_FUNCTION (this);
+	m_ueSlot.clear ();
+	m_freeUeSlots.clear ();
+	m_ueRnti.clear ();
+	m_ueFields.clear ();
+	m_wbCqi.clear ();
+	m_wbCqiTimer.clear ();
+	m_ulCqi.clear ();
+	m_ulCqiNumSym.clear ();
+	m_ulCqiTbSize.clear ();
+	m_ulCqiTimer.clear ();
+	m_ceBsr.clear ();
+	m_iabInfo.clear ();
+	m_dlHarqProcessesStatus.clear ();
+	m_dlHarqProcessesDciInfo.clear ();
+	m_dlHarqProcessesTimer.clear ();
+	m_dlHarqProcessesRlcPdu.clear ();
+	m_dlHarqInfoList.clear ();
+	m_ulHarqProcessesStatus.clear ();
+	m_ulHarqProcessesTimer.clear ();
+	m_ulHarqProcessesDciInfo.clear ();
+	m_iabBusySubframeAllocation.clear();
+	MmWaveMacScheduler::DoDispose ();
+}
+
+uint32_t
+MmWaveFlexTtiSchedulerBase::FindUeSlot (uint16_t rnti, uint8_t fields) const
+{
+	if (rnti >= m_ueSlot.size ())
+	{
+		return NO_UE_SLOT;
+	}
+	uint32_t slot = m_ueSlot[rnti];
+	if (slot == NO_UE_SLOT || (m_ueFields[slot] & fields) != fields)
+	{
+		return NO_UE_SLOT;
+	}
+	return slot;
+}
+
+uint32_t
+MmWaveFlexTtiSchedulerBase::AddUeField (uint16_t rnti, uint8_t field)
+{
+	if (rnti >= m_ueSlot.size ())
+	{
+		m_ueSlot.resize (rnti + 1, NO_UE_SLOT);
+	}
+	uint32_t slot = m_ueSlot[rnti];
+	if (slot == NO_UE_SLOT)
+	{
+		if (!m_freeUeSlots.empty ())
+		{
+			slot = m_freeUeSlots.back ();
+			m_freeUeSlots.pop_back ();
+		}
+		else
+		{
+			slot = m_ueRnti.size ();
+			uint32_t numSlots = slot + 1;
+			m_ueRnti.resize (numSlots);
+			m_ueFields.resize (numSlots);
+			m_wbCqi.resize (numSlots);
+			m_wbCqiTimer.resize (numSlots);
+			m_ulCqi.resize (numSlots);
+			m_ulCqiNumSym.resize (numSlots);
+			m_ulCqiTbSize.resize (numSlots);
+			m_ulCqiTimer.resize (numSlots);
+			m_ceBsr.resize (numSlots);
+			m_iabInfo.resize (numSlots);
+			m_dlHarqProcessesStatus.resize (numSlots);
+			m_dlHarqProcessesTimer.resize (numSlots);
+			m_dlHarqProcessesDciInfo.resize (numSlots);
+			m_dlHarqProcessesRlcPdu.resize (numSlots);
+			m_ulHarqProcessesStatus.resize (numSlots);
+			m_ulHarqProcessesTimer.resize (numSlots);
+			m_ulHarqProcessesDciInfo.resize (numSlots);
+		}
+		m_ueRnti[slot] = rnti;
+		m_ueFields[slot] = 0;
+		m_ueSlot[rnti] = slot;
+	}
+	m_ueFields[slot] |= field;
+	return slot;
+}
+
+void
+MmWaveFlexTtiSchedulerBase::RemoveUeFields (uint32_t slot, uint8_t fields)
+{
+	m_ueFields[slot] &= ~fields;
+	// release the storage of the fields, so that a new entry starts empty
+	if (fields & UE_UL_CQI)
+	{
+		m_ulCqi[slot].clear ();
+	}
+	if (fields & UE_HARQ)
+	{
+		m_dlHarqProcessesStatus[slot].clear ();
+		m_dlHarqProcessesTimer[slot].clear ();
+		m_dlHarqProcessesDciInfo[slot].clear ();
+		m_dlHarqProcessesRlcPdu[slot].clear ();
+		m_ulHarqProcessesStatus[slot].clear ();
+		m_ulHarqProcessesTimer[slot].clear ();
+		m_ulHarqProcessesDciInfo[slot].clear ();
+	}
+	if (m_ueFields[slot] == 0)
+	{
+		m_ueSlot[m_ueRnti[slot]] = NO_UE_SLOT;
+		m_freeUeSlots.push_back (slot);
+	}
+}
+
+uint32_t
+MmWaveFlexTtiSchedulerBase::GetNumUes (uint8_t fields) const
+{
+	uint32_t numUes = 0;
+	for (uint32_t slot = 0; slot < m_ueFields.size (); slot++)
+	{
+		if (m_ueFields[slot] != 0 && (m_ueFields[slot] & fields) == fields)
+		{
+			numUes++;
+		}
+	}
+	return numUes;
+}
+
+
+TypeId
+MmWaveFlexTtiSchedulerBase::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::MmWaveFlexTtiSchedulerBase")
+	    .SetParent<MmWaveMacScheduler> ()
+		;
+
+	return tid;
+}
+
+/*
+ * Called by "InstallSingleIabDevice" and "InstallSingleEnbDevice" in "mmwave-helper.cc";
+ */
+void
+MmWaveFlexTtiSchedulerBase::SetMacSchedSapUser (MmWaveMacSchedSapUser* sap)
+{
+	m_macSchedSapUser = sap;  // Pointer to the primitives from "Scheduler" module to "Subframe" module in MAC
+}
+
+void
+MmWaveFlexTtiSchedulerBase::SetMacCschedSapUser (MmWaveMacCschedSapUser* sap)
+{
+	m_macCschedSapUser = sap;  // Pointer to the primitives from "Scheduler" module to "Control" module in MAC
+}
+
+void
+MmWaveFlexTtiSchedulerBase::SetIabScheduler(bool iabScheduler)
+{
+	m_iabScheduler = iabScheduler;
+}
+
+MmWaveMacSchedSapProvider*
+MmWaveFlexTtiSchedulerBase::GetMacSchedSapProvider ()
+{
+	return m_macSchedSapProvider;
+}
+
+MmWaveMacCschedSapProvider*
+MmWaveFlexTtiSchedulerBase::GetMacCschedSapProvider ()
+{
+	return m_macCschedSapProvider;
+}
+
+// IAB methods
+void
+MmWaveFlexTtiSchedulerBase::SetMmWaveUeMacCschedSapProvider(MmWaveUeMacCschedSapProvider* sap)
+{
+	m_iabBackahulSapProvider = sap;
+}
+
+MmWaveUeMacCschedSapProvider*
+MmWaveFlexTtiSchedulerBase::GetMmWaveUeMacCschedSapProvider()
+{
+	return m_iabBackahulSapProvider;
+}
+
+std::string
+MmWaveFlexTtiSchedulerBase::PrintSubframeAllocationMask(const SymbolAllocationMask &mask)
+{
+	std::stringstream strStream;
+	strStream << mask;
+	return strStream.str();
+}
+
+/*
+ * ================================================================================
+ * IAB Method: "mmwave-ue-mac" call this function to tell the current IAB scheduler
+ * the scheduling result of its previous hop. And update the "busy" region in the 
+ * specific subframe corresponding to the received DCI (i.e., "info").
+ * ================================================================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::DoIabBackhaulSchedNotify(const struct MmWaveUeMacCschedSapProvider::IabBackhaulSchedInfo& info)
+{
+	/*
+	 * MmWaveUeMacCschedSapProvider defines all primitives from "Control" to "Scheduler". 
+	 * As in an IAB node, the Ue stack functions the backhaul role, the scheduling information of IAB backhaul is transferred
+	 * through the Sap defined in the mmWave UE MAC.
+	 */
+	NS_LOG_FUNCTION(this << info.m_dciInfoElementTdma.m_rnti);  // The DCI's m_rnti identifies which "UE" should receive this DCI.
+	NS_ASSERT_MSG(m_iabScheduler, "Received DCI info for backhaul on a non IAB scheduler");  // This "Scheduler" must be an IAB one. 
+	NS_LOG_DEBUG("MmWaveFlexTtiMacScheduler received DCIs for the backhaul link");
+	// signal that the resources are busy
+	// In the default setting for mmWave module, 1 frame contains 10 subframes, each of which contains 24 symbols (or slots). 
+	NS_LOG_DEBUG("input info  frame " << info.m_sfnSf.m_frameNum << " subframe " << (uint16_t)info.m_sfnSf.m_sfNum <<  " slot/symbol " << (uint16_t)info.m_sfnSf.m_slotNum);
+
+	uint32_t subframe = info.m_sfnSf.m_sfNum;  // which subframe in the current frame of the received DCI
+	uint32_t frame = info.m_sfnSf.m_frameNum;  // the current frame number of the received DCI
+
+	// Get the already stored SfIabAllocInfo for this subframe index.
+	SfIabAllocInfo currentInfo = m_iabBusySubframeAllocation.at(subframe);
+	SfIabAllocInfo newInfo(m_phyMacConfig->GetSymbolsPerSubframe ());  // Each subframe contains 24 slots in the default setting.
+	NS_LOG_DEBUG("currentInfo frame " << currentInfo.m_sfnSf.m_frameNum << " subframe " << (uint16_t)currentInfo.m_sfnSf.m_sfNum);
+
+	if(currentInfo.m_sfnSf.m_frameNum == frame)
+	{
+		// another DCI has already been registered for this subframe, and the already stored "currentInfo" will be used to update the "newInfo".
+		newInfo = currentInfo;
+		NS_LOG_DEBUG("This frame/subframe had already a DCI stored with mask " << PrintSubframeAllocationMask(newInfo.m_symAllocationMask));
+		// TODOIAB plot relevant info
+		// newInfo.m_dlSymStart << " m_dlNumSymAlloc " << newInfo.m_dlNumSymAlloc << " m_ulSymStart " <<
+		// newInfo.m_ulSymStart << " m_ulSymStart " << newInfo.m_ulNumSymAlloc);
+	}
+	else
+	{
+		// The received DCI aims for the first time scheduling of this subframe.	
+		newInfo.m_sfnSf = info.m_sfnSf;
+	}
+
+	uint32_t firstAllocatedIdx = info.m_dciInfoElementTdma.m_symStart;
+	uint32_t nextFreeIdx = firstAllocatedIdx + info.m_dciInfoElementTdma.m_numSym;  // Reflects the continuous slots/symbols allocation.
+	// _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ _ 24 slots
+	//       |-----------------------| |
+	//       m_symStart  |             nextFreeIdx
+	//                   m_numSym
+
+	// check if it (i.e., the allocation in the DCI) overlaps with already busy regions
+	// A slot within a subframe cannot be allocated by more than one DCIs.
+	NS_ASSERT_MSG(!newInfo.m_symAllocationMask.Overlaps(firstAllocatedIdx, nextFreeIdx - firstAllocatedIdx), "DCI signals that a symbol is scheduled for IAB, but it was already scheduled");
+	newInfo.m_symAllocationMask.SetBusy(firstAllocatedIdx, nextFreeIdx - firstAllocatedIdx);
+	NS_LOG_DEBUG("This frame/subframe has updated the newInfo  with mask " << PrintSubframeAllocationMask(newInfo.m_symAllocationMask));
+
+	// if(info.m_dciInfoElementTdma.m_format == DciInfoElementTdma::DL_dci)
+	// {
+	// 	// downlink DCI
+	// 	if(newInfo.m_dlSymStart != 0 || newInfo.m_dlNumSymAlloc > 0)
+	// 	{
+	// 		NS_FATAL_ERROR("Trying to overwrite DL information on a SfIabAllocInfo");
+	// 	}
+	// 	newInfo.m_dlSymStart = info.m_dciInfoElementTdma.m_symStart;
+	// 	newInfo.m_dlNumSymAlloc = info.m_dciInfoElementTdma.m_numSym;
+	// 	NS_LOG_DEBUG("DL Num symbols used " << (uint16_t)info.m_dciInfoElementTdma.m_numSym << " from symbol "
+	// 				<< (uint16_t)info.m_dciInfoElementTdma.m_symStart);
+	// }
+	// else
+	// {
+	// 	// uplink DCI
+	// 	if(newInfo.m_ulSymStart != 0 || newInfo.m_ulNumSymAlloc > 0)
+	// 	{
+	// 		NS_FATAL_ERROR("Trying to overwrite UL information on a SfIabAllocInfo");
+	// 	}
+	// 	newInfo.m_ulSymStart = info.m_dciInfoElementTdma.m_symStart;
+	// 	newInfo.m_ulNumSymAlloc = info.m_dciInfoElementTdma.m_numSym;
+	// 	NS_LOG_DEBUG("UL Num symbols used " << (uint16_t)info.m_dciInfoElementTdma.m_numSym << " from symbol "
+	// 				<< (uint16_t)info.m_dciInfoElementTdma.m_symStart);	
+	// }
+	m_iabBusySubframeAllocation.at(subframe) = newInfo;  // Update the IAB allocation info vector.
+}
+
+/*
+ * ============================================================
+ * Called by "mmwave-helper" when installing single IAB or Enb.
+ * ============================================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::ConfigureCommonParameters (Ptr<MmWavePhyMacCommon> config)
+{
+	m_phyMacConfig = config;
+	m_amc = CreateObject <MmWaveAmc> (m_phyMacConfig);
+	m_numRbg = m_phyMacConfig->GetNumRb () / m_phyMacConfig->GetNumRbPerRbg ();  // By default, in TDMA, m_numRbg = 1;
+	m_numHarqProcess = m_phyMacConfig->GetNumHarqProcess ();
+	m_harqTimeout = m_phyMacConfig->GetHarqTimeout ();
+	m_numDataSymbols = m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetDlCtrlSymbols () - m_phyMacConfig->GetUlCtrlSymbols ();  // Dl ctrl, Ul ctrl, and data symbols
+	NS_ASSERT_MSG (m_phyMacConfig->GetNumRb () == 1, "System must be configured with numRb=1 for TDMA mode");
+
+	// Initialize the uplink and downlink subframe allocation information.
+	for (unsigned i = 0; i < m_phyMacConfig->GetUlSchedDelay(); i++)  // By default, it is 1.
+	{
+		m_ulSfAllocInfo.push_back (SfAllocInfo (SfnSf (0, i, 0)));
+	}
+
+	for (unsigned i = 0; i < m_phyMacConfig->GetSubframesPerFrame(); i++)
+	{
+		m_iabBusySubframeAllocation.push_back(SfIabAllocInfo(SfnSf (0, i, 0), false, m_phyMacConfig->GetSymbolsPerSubframe ()));
+	}
+}
+
+
+void
+MmWaveFlexTtiSchedulerBase::DoSchedDlRlcBufferReq (const struct MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters& params)
+{
+	NS_LOG_FUNCTION (this << params.m_rnti << (uint32_t) params.m_logicalChannelIdentity);
+	// API generated by RLC for updating RLC parameters on a LC (tx and retx queues)
+	std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it = m_rlcBufferReq.begin ();
+	bool newLc = true;  // Boolean varibale for identifying a new logical channel.
+	// Iterate through the vector of UE's RLC information to remove all existing entries belongs to the (UE,LC) of input "params".
+	while (it != m_rlcBufferReq.end ())
+	{
+		if (((*it).m_rnti == params.m_rnti) && ((*it).m_logicalChannelIdentity == params.m_logicalChannelIdentity))
+		{
+			it = m_rlcBufferReq.erase (it);  // Remove the old entry of this (UE,LC). 
+			newLc = false;                   // It is not a new logical channel.
+		}
+		else
+		{
+			++it;
+		}
+	}
+	// Due to the above operation, after a buffer request is scheduled and executed, there is only one entry of this (UE,LC) in the list.
+	// Add the new parameters at the end of the list "m_rlcBufferReq". 
+	m_rlcBufferReq.insert (it, params);
+	NS_LOG_DEBUG ("BSR for RNTI " << params.m_rnti << " LC " << (uint16_t)params.m_logicalChannelIdentity 
+				  << " RLC tx size " << params.m_rlcTransmissionQueueSize << " RLC retx size " << params.m_rlcRetransmissionQueueSize 
+				  << " RLC stat size " <<  params.m_rlcStatusPduSize);
+	// Initialize statistics of the flow in case of new flows. In the simulation, a new (UE,LC) corresponds to a new flow.
+	if (newLc == true)
+	{
+		if (FindUeSlot (params.m_rnti, UE_WB_CQI) == NO_UE_SLOT)
+		{
+			uint32_t slot = AddUeField (params.m_rnti, UE_WB_CQI);
+			m_wbCqi[slot] = 1;	// Only codeword 0 at this stage (SISO)
+			// Cqi is initialized to 1 (i.e., the lowest value for transmitting a signal).
+			m_wbCqiTimer[slot] = m_cqiTimersThreshold;
+		}
+	}
+}
+
+/*
+ * =============================================================================================
+ * Phy indicate to the enb mac about a subframe, and enb mac sends the cqi message to scheduler.
+ * =============================================================================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::DoSchedDlCqiInfoReq (const struct MmWaveMacSchedSapProvider::SchedDlCqiInfoReqParameters& params)
+{
+	NS_LOG_FUNCTION (this);
+
+	for (unsigned int i = 0; i < params.m_cqiList.size (); i++)
+	{
+		if ( params.m_cqiList.at (i).m_cqiType == DlCqiInfo::WB )
+		{
+			// wideband CQI reporting
+			// create the entry of the cqi from this enb/iab to the ue (rnti), or update it
+			uint32_t slot = AddUeField (params.m_cqiList.at (i).m_rnti, UE_WB_CQI);
+			m_wbCqi[slot] = params.m_cqiList.at (i).m_wbCqi; // only codeword 0 at this stage (SISO)
+			// generate or update correspondent timer
+			m_wbCqiTimer[slot] = m_cqiTimersThreshold;
+		}
+		else if ( params.m_cqiList.at (i).m_cqiType == DlCqiInfo::SB )
+		{
+			// subband CQI reporting high layer configured
+			// Not used by RR Scheduler
+		}
+		else
+		{
+			NS_LOG_ERROR (this << " CQI type unknown");
+		}
+	}
+}
+
+
+void
+MmWaveFlexTtiSchedulerBase::DoSchedUlCqiInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters& params)
+{
+	NS_LOG_FUNCTION (this);
+
+	unsigned frameNum = params.m_sfnSf.m_frameNum;
+	unsigned subframeNum =  params.m_sfnSf.m_sfNum;
+	unsigned startSymIdx =  params.m_sfnSf.m_slotNum;
+
+	switch (params.m_ulCqi.m_type)
+	{
+		case UlCqiInfo::PUSCH:
+		{
+			std::map <uint32_t, struct AllocMapElem>::iterator itMap;
+			itMap = m_ulAllocationMap.find (params.m_sfnSf.Encode ());
+			if (itMap == m_ulAllocationMap.end ())
+			{
+				NS_LOG_DEBUG (this << " UL CQI Does not find info on allocation, size : " << m_ulAllocationMap.size ());
+				return;
+			}
+			NS_ASSERT_MSG (itMap->second.m_rntiPerChunk.size () == m_phyMacConfig->GetTotalNumChunk (), "SINR chunk map must cover full BW in TDMA mode");
+			for (unsigned i = 0; i < itMap->second.m_rntiPerChunk.size (); i++)
+			{
+				// convert from fixed point notation Sxxxxxxxxxxx.xxx to double
+				// double sinr = LteFfConverter::fpS11dot3toDouble (params.m_ulCqi.m_sinr.at (i));
+				uint32_t slot = FindUeSlot (itMap->second.m_rntiPerChunk.at (i), UE_UL_CQI);
+				if (slot == NO_UE_SLOT)
+				{
+					// create a new entry
+					slot = AddUeField (itMap->second.m_rntiPerChunk.at (i), UE_UL_CQI);
+					std::vector <double> &newCqi = m_ulCqi[slot];
+					for (unsigned j = 0; j < m_phyMacConfig->GetTotalNumChunk (); j++)
+					{
+						unsigned chunkInd = i;
+						if (chunkInd == j)
+						{
+							newCqi.push_back (params.m_ulCqi.m_sinr.at (i));
+							NS_LOG_INFO ("UL CQI report for RNTI " << itMap->second.m_rntiPerChunk.at (i) << " chunk " << i << " SINR " << params.m_ulCqi.m_sinr.at (i) << \
+										 " frame " << frameNum << " subframe " << subframeNum << " startSym " << startSymIdx);
+						}
+						else
+						{
+							// initialize with NO_SINR value.
+							newCqi.push_back (30.0);
+						}
+					}
+					m_ulCqiNumSym[slot] = itMap->second.m_numSym;
+					m_ulCqiTbSize[slot] = itMap->second.m_tbSize;
+					// generate correspondent timer
+					m_ulCqiTimer[slot] = m_cqiTimersThreshold;
+				}
+				else
+				{
+					// update the value
+					m_ulCqi[slot].at (i) = params.m_ulCqi.m_sinr.at (i);
+					m_ulCqiNumSym[slot] = itMap->second.m_numSym;
+					m_ulCqiTbSize[slot] = itMap->second.m_tbSize;
+					// update correspondent timer
+					m_ulCqiTimer[slot] = m_cqiTimersThreshold;
+
+					NS_LOG_INFO ("UL CQI report for RNTI " << itMap->second.m_rntiPerChunk.at (i) << " chunk " << i << " SINR " << params.m_ulCqi.m_sinr.at (i) << \
+								 " frame " << frameNum << " subframe " << subframeNum << " startSym " << startSymIdx);
+
+				}
+
+			}
+			// remove obsolete info on allocation
+			m_ulAllocationMap.erase (itMap);
+		}
+		break;
+		default:
+			NS_FATAL_ERROR ("Unknown type of UL-CQI");
+	}
+	return;
+}
+
+
+void
+MmWaveFlexTtiSchedulerBase::RefreshHarqProcesses ()
+{
+	NS_LOG_FUNCTION (this);
+
+	// DL Harq processes
+	for (uint32_t slot = 0; slot < m_ueFields.size (); slot++)
+	{
+		if ((m_ueFields[slot] & UE_HARQ) == 0)
+		{
+			continue;
+		}
+		DlHarqProcessesTimer_t &dlTimers = m_dlHarqProcessesTimer[slot];
+		for (uint16_t i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
+		{
+			if (dlTimers.at (i) == m_phyMacConfig->GetHarqTimeout ())
+			{ // Time out, reset HARQ process
+				NS_LOG_INFO (this << " Reset HARQ proc " << i << " for RNTI " << m_ueRnti[slot]);
+				m_dlHarqProcessesStatus[slot].at (i) = 0;
+				dlTimers.at (i) = 0;
+			}
+			else
+			{
+				dlTimers.at (i)++;
+			}
+		}
+	}
+
+	// UL Harq processes
+	for (uint32_t slot = 0; slot < m_ueFields.size (); slot++)
+	{
+		if ((m_ueFields[slot] & UE_HARQ) == 0)
+		{
+			continue;
+		}
+		UlHarqProcessesTimer_t &ulTimers = m_ulHarqProcessesTimer[slot];
+		for (uint16_t i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
+		{
+			if (ulTimers.at (i) == m_phyMacConfig->GetHarqTimeout ())
+			{ // Time out, reset HARQ process
+				NS_LOG_INFO (this << " Reset HARQ proc " << i << " for RNTI " << m_ueRnti[slot]);
+				m_ulHarqProcessesStatus[slot].at (i) = 0;
+				ulTimers.at (i) = 0;
+			}
+			else
+			{
+				ulTimers.at (i)++;
+			}
+		}
+	}
+}
+
+uint8_t
+MmWaveFlexTtiSchedulerBase::UpdateDlHarqProcessId (uint16_t rnti)
+{
+	NS_LOG_FUNCTION (this << rnti);
+
+	if (m_harqOn == false)
+	{
+		uint8_t tbUid = m_tbUid;
+		m_tbUid = (m_tbUid+1) % m_phyMacConfig->GetNumHarqProcess ();
+		return tbUid;
+	}
+
+//    std::map <uint16_t, uint8_t>::iterator it = m_dlHarqCurrentProcessId.find (rnti);
+//    if (it == m_dlHarqCurrentProcessId.end ())
+//    {
+//        NS_FATAL_ERROR ("No Process Id found for this RNTI " << rnti);
+//    }
+	uint32_t slot = FindUeSlot (rnti, UE_HARQ);
+	if (slot == NO_UE_SLOT)
+	{
+		NS_FATAL_ERROR ("No Process Id Statusfound for this RNTI " << rnti);
+	}
+	DlHarqProcessesStatus_t &harqStatus = m_dlHarqProcessesStatus[slot];
+
+	// search for available process ID, if none available return numHarqProcess
+	// The "DlHarqProcessesStatus_t" records the usage of each harq process. "0" is available, "1" is not available.
+	uint8_t harqId = m_phyMacConfig->GetNumHarqProcess ();
+	for (unsigned i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
+	{
+		if(harqStatus[i] == 0)
+		{
+			harqStatus[i] = 1;
+			harqId = i;
+			break;
+		}
+	}
+	return harqId;
+
+//    uint8_t i = (*it).second;
+//    do
+//    {
+//        i = (i + 1) % m_phyMacConfig->GetNumHarqProcess ();
+//    }
+//    while ( ((*itStat).second.at (i) != 0)&&(i != (*it).second));
+//    if ((*itStat).second.at (i) == 0)
+//    {
+//        (*it).second = i;
+//        (*itStat).second.at (i) = 1;
+//    }
+//    else
+//    {
+//        return (m_phyMacConfig->GetNumHarqProcess () + 1); // return a not valid harq proc id
+//    }
+//
+//    return ((*it).second);
+}
+
+uint8_t
+MmWaveFlexTtiSchedulerBase::UpdateUlHarqProcessId (uint16_t rnti)
+{
+	NS_LOG_FUNCTION (this << rnti);
+
+	if (m_harqOn == false)
+	{
+		uint8_t tbUid = m_tbUid;
+		m_tbUid = (m_tbUid+1) % m_phyMacConfig->GetNumHarqProcess ();
+		return tbUid;
+	}
+
+//    std::map <uint16_t, uint8_t>::iterator it = m_ulHarqCurrentProcessId.find (rnti);
+//    if (it == m_ulHarqCurrentProcessId.end ())
+//    {
+//        NS_FATAL_ERROR ("No Process Id found for this RNTI " << rnti);
+//    }
+	uint32_t slot = FindUeSlot (rnti, UE_HARQ);
+	if (slot == NO_UE_SLOT)
+	{
+		NS_FATAL_ERROR ("No Process Id Statusfound for this RNTI " << rnti);
+	}
+	UlHarqProcessesStatus_t &harqStatus = m_ulHarqProcessesStatus[slot];
+
+	// search for available process ID, if none available return numHarqProcess+1
+	uint8_t harqId = m_phyMacConfig->GetNumHarqProcess ();
+	for (unsigned i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
+	{
+		if(harqStatus[i] == 0)
+		{
+			harqStatus[i] = 1;
+			harqId = i;
+			break;
+		}
+	}
+	return harqId;
+}
+
+unsigned MmWaveFlexTtiSchedulerBase::CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize, unsigned &tbSize)
+{
+	// bisection line search to find minimum number of slots needed to encode entire buffer
+	MmWaveMacPduHeader dummyMacHeader;
+	//unsigned macHdrSize = 10; //dummyMacHeader.GetSerializedSize ();
+	int numSymLow = 0;
+	int numSymHigh = m_phyMacConfig->GetSymbolsPerSubframe();
+
+	int diff = 0;
+	tbSize = (m_amc->GetTbSizeFromMcsSymbols (mcs, numSymHigh) / 8); // start with max value
+	while ((unsigned)tbSize > bufSize)
+	{
+		diff = abs(numSymHigh-numSymLow)/2;
+		if (diff == 0)
+		{
+			tbSize = (m_amc->GetTbSizeFromMcsSymbols (mcs, numSymHigh) / 8);
+			return numSymHigh;
+		}
+		tbSize = (m_amc->GetTbSizeFromMcsSymbols (mcs, numSymHigh - diff) / 8);
+		if ((unsigned)tbSize > bufSize)
+		{
+			numSymHigh -= diff;
+		}
+		while ((unsigned)tbSize < bufSize)
+		{
+			diff = abs(numSymHigh-numSymLow)/2;
+			if (diff == 0)
+			{
+				tbSize = (m_amc->GetTbSizeFromMcsSymbols (mcs, numSymHigh) / 8);
+				return numSymHigh;
+			}
+			//tmp2 = numSym;
+			tbSize = (m_amc->GetTbSizeFromMcsSymbols (mcs, numSymLow + diff) / 8);
+			if ((unsigned)tbSize < bufSize)
+			{
+				numSymLow += diff;
+			}
+		}
+	}
+
+	tbSize = (m_amc->GetTbSizeFromMcsSymbols (mcs, numSymHigh) / 8);
+	return (unsigned)numSymHigh;
+}
+
+/* 
+ * =====================
+ *   IAB Functionality
+ * =====================  
+ */
+uint16_t
+MmWaveFlexTtiSchedulerBase::GetNumIabRnti()
+{
+	uint16_t numIabDevs = 0;
+	// cycle through the list of BSRs, and check which RNTIs are for IAB devs
+	for(auto itRlcBuf : m_rlcBufferReq)
+	{
+		uint16_t rnti = itRlcBuf.m_rnti;
+		NS_LOG_INFO(this << " count rnti " << rnti);
+		// get IAB info
+		uint32_t slot = FindUeSlot (rnti, UE_IAB_INFO);
+		if(slot == NO_UE_SLOT || !m_iabInfo[slot].first)
+		{
+					// do nothing, as m_iabInfo[slot].first identifies whether this device is an IAB or not.
+		}
+		else
+		{
+			if(((itRlcBuf.m_rlcTransmissionQueueSize > 0) 
+				 || (itRlcBuf.m_rlcRetransmissionQueueSize > 0) 
+				 || (itRlcBuf.m_rlcStatusPduSize > 0)))
+			{
+				numIabDevs++;
+			}
+		}
+		NS_LOG_INFO(this << " numIabDevs " << numIabDevs);
+	}
+	return numIabDevs;
+}
+
+/*
+ * ====================================================================
+ * Get the available symbols in the current subframe for IAB scheduler.
+ * ====================================================================
+ */
+int
+MmWaveFlexTtiSchedulerBase::UpdateBusySymbolsForIab(uint8_t sfNum, uint8_t symIdx, int symAvail)
+{
+	// get the resources which are already set as busy for this subframe
+	// ----------------------------------------------
+	// Do not allow incontinuous resource allocation.
+	// ----------------------------------------------
+	if(m_iabScheduler && !m_split)
+	{
+		SfIabAllocInfo busyResources = m_iabBusySubframeAllocation.at(sfNum);  // Get the subframe allocation info of "sfNum"
+		NS_LOG_DEBUG("Before check for IAB resources: symIdx " << (uint16_t)symIdx << " symAvail " << symAvail);
+		if(busyResources.m_valid)
+		{
+			busyResources.m_valid = false; // signal that this SfIabAllocInfo has been used for a prev slot
+			NS_LOG_DEBUG("This subframe has a DCI stored, with " <<
+						 " frame " << busyResources.m_sfnSf.m_frameNum << 
+						 " subframe " << (uint16_t)busyResources.m_sfnSf.m_sfNum <<
+						 PrintSubframeAllocationMask(busyResources.m_symAllocationMask));
+
+			// " m_dlSymStart " << busyResources.m_dlSymStart << 
+			// " m_dlNumSymAlloc " << busyResources.m_dlNumSymAlloc << 
+			// " m_ulSymStart " << busyResources.m_ulSymStart << 
+			// " m_ulSymStart " << busyResources.m_ulNumSymAlloc);	
+
+			// NS_ASSERT_MSG(busyResources.m_sfnSf.m_sfNum == sfNum && 
+			// 		busyResources.m_sfnSf.m_frameNum == frameNum,
+			// 		"Mismatch between scheduled resource and SfIabAllocInfo");
+
+			// TODOIAB -> do smth better, since UL resources may be allocated after DL/UL
+			// resources of other users, so some previous symbols can be used
+
+			// get the max between DL and UL sym (usually UL if both present)
+			// if(busyResources.m_dlSymStart > busyResources.m_ulSymStart)
+			// {
+			//     // set the symIdx value to the first free available index
+			//     symIdx = busyResources.m_dlSymStart + busyResources.m_dlNumSymAlloc;
+			// 	   // subtract the DL and UL symbols from the available ones
+			//     // symAvail -= (busyResources.m_dlNumSymAlloc + busyResources.m_ulNumSymAlloc);
+			// }
+			// else
+			// {
+			// 	   // set the symIdx value to the first free available index
+			//     symIdx = busyResources.m_ulSymStart + busyResources.m_ulNumSymAlloc;
+			//     // subtract the DL and UL symbols from the available ones
+			//     // symAvail -= (busyResources.m_dlNumSymAlloc + busyResources.m_ulNumSymAlloc);
+			// }
+			// symAvail = m_phyMacConfig->GetSymbolsPerSubframe () - 1 - symIdx;
+		}
+		m_iabBusySubframeAllocation.at(sfNum) = busyResources;  // In the current implementation, nothing modified, unless m_valid is true.
+		NS_LOG_DEBUG("After check for IAB resources: symIdx " << (uint16_t)symIdx << " symAvail " << symAvail);
+	}
+	// ---------------------------------------
+	// Allow incontinuous resource allocation.
+	// ---------------------------------------
+	else if(m_iabScheduler && m_split)
+	{
+		NS_LOG_LOGIC("Before check for IAB resources: symIdx " << (uint16_t)symIdx << " symAvail " << symAvail);
+		SfIabAllocInfo busyResources = m_iabBusySubframeAllocation.at(sfNum);
+		if(busyResources.m_valid)
+		{
+			m_busyResourcesSchedSubframe = busyResources;
+			// count the number of symbols which are busy
+			int numBusySymbols = m_busyResourcesSchedSubframe.m_symAllocationMask.GetNumBusySymbols ();
+			symAvail -= numBusySymbols;  // The number of available free to use symbols
+			NS_LOG_DEBUG("This subframe has a DCI stored, with " << 
+						 " frame " << busyResources.m_sfnSf.m_frameNum << 
+						 " subframe " << (uint16_t)busyResources.m_sfnSf.m_sfNum << " " <<
+						 PrintSubframeAllocationMask(busyResources.m_symAllocationMask) << 
+						 " total number of busy symbols " << numBusySymbols <<
+						 " symAvail " << symAvail);
+		}
+		else
+		{
+			m_busyResourcesSchedSubframe.m_valid = false;
+		}
+		m_iabBusySubframeAllocation.at(sfNum).m_valid = false;
+	}
+	return symAvail;
+}
+
+/*
+ * ===================================================================================
+ * Steps of DoSchedTriggerReq. The ranking of the UEs is left to the derived scheduler.
+ * ===================================================================================
+ */
+uint32_t
+MmWaveFlexTtiSchedulerBase::GetSchedulingDelay () const
+{
+	return m_maxSchedulingDelay;
+}
+
+bool
+MmWaveFlexTtiSchedulerBase::StartSchedTrigger (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params, SchedTriggerState &state)
+{
+	NS_LOG_DEBUG("IAB info size " << GetNumUes (UE_IAB_INFO));
+
+	MmWaveMacSchedSapUser::SchedConfigIndParameters &ret = state.m_ret;
+	// ----------------------------------------------------------------------------
+	// Determine the Frame and Subframe for this specific schedule trigger request.
+	// ----------------------------------------------------------------------------
+	SfnSf dlSfn = params.m_sfnSf;  // Downlink frame and subframe number
+	SfnSf ulSfn = params.m_sfnSf;  // Uplink frame and subframe number
+	uint32_t schedulingDelay = GetSchedulingDelay ();
+	// downlink
+	if ((int)(dlSfn.m_sfNum + schedulingDelay) >=  (int)m_phyMacConfig->GetSubframesPerFrame ())
+	{
+		// As the scheduling message arrives at the most outside UE after "m_maxSchedulingDelay" subframe time,
+		// the scheduling of a specific subframe actually happens ahead of time.
+		// Update the frame number in case the to be scheduled subframe is in the next frame.
+		dlSfn.m_frameNum++;
+	}
+	dlSfn.m_sfNum = (uint8_t)((int)(dlSfn.m_sfNum + schedulingDelay)) % m_phyMacConfig->GetSubframesPerFrame ();
+	ret.m_sfnSf = dlSfn;
+	ret.m_sfAllocInfo.m_sfnSf = ret.m_sfnSf;
+	// uplink
+	if (ulSfn.m_sfNum + schedulingDelay >=  m_phyMacConfig->GetSubframesPerFrame ())
+	{
+		ulSfn.m_frameNum++;
+	}
+	ulSfn.m_sfNum = (ulSfn.m_sfNum + schedulingDelay) % m_phyMacConfig->GetSubframesPerFrame ();
+	state.m_ulSfn = ulSfn;
+	// Determine the frame number and subframe number based on the information from downlink.
+	uint16_t frameNum = ret.m_sfnSf.m_frameNum;
+	uint8_t sfNum = ret.m_sfnSf.m_sfNum;
+	NS_LOG_DEBUG ("Scheduling DL frame "<< (unsigned)frameNum << " subframe " << (unsigned)sfNum
+				  << " UL frame " << (unsigned)ulSfn.m_frameNum << " subframe " << (unsigned)ulSfn.m_sfNum);
+	// TODO: <TODOIAB> In this version, we only consider the same subframe for UL & DL
+	NS_ASSERT_MSG(sfNum == ulSfn.m_sfNum, "different subframes for DL and UL " << (uint32_t)sfNum << " " << (uint32_t)ulSfn.m_sfNum);
+
+	// --------------------------------------------------------------------------------
+	// Add slot for DL control symbol.
+	// It is specified at the first slot of a subframe.
+	// Along a multi-hop path, each node will independently add the DL control symbol
+	// at the same slot of a specific subframe. A duplicated task!!!
+	// --------------------------------------------------------------------------------
+	SlotAllocInfo dlCtrlSlot (0, SlotAllocInfo::DL_slotAllocInfo, SlotAllocInfo::CTRL, SlotAllocInfo::DIGITAL, 0);
+	// Each slot could transmit multiple QAM symbols on different subcarriers.
+	dlCtrlSlot.m_dci.m_numSym = 1;    // 1 symbol for the control symbol for DL
+	dlCtrlSlot.m_dci.m_symStart = 0;  // The control symbol is at the beginning of the subframe.
+	ret.m_sfAllocInfo.m_slotAllocInfo.push_back (dlCtrlSlot);  // "m_slotAllocInfo" is a deque which sequentially stores the allocation of each slot in a subframe.
+	int resvCtrl = m_phyMacConfig->GetDlCtrlSymbols() + m_phyMacConfig->GetUlCtrlSymbols();  // the total number of reserved control symbols in the subframe (i.e., 2)
+	state.m_symAvail = m_phyMacConfig->GetSymbolsPerSubframe () - resvCtrl;  // The number of available slots (OFDM symbols) in the subframe for data transmissions.
+	state.m_slotIdx = 1; // index of the 1st unassigned slot (SlotAllocInfo), one slot could cross several symbols.
+	state.m_symIdx = m_phyMacConfig->GetDlCtrlSymbols(); // the index of the first available OFDM symbol (i.e., slot).
+
+	// Get the resources which are already set as busy. "symIdx" does nothing. "symAvail" is updated.
+	state.m_symAvail = UpdateBusySymbolsForIab(sfNum, state.m_symIdx, state.m_symAvail);  // after this function, the stored scheduling of this subframe is "invalid";
+
+	// process received CQIs, erase the expired entries, and update the timer of each unexpired entry
+	RefreshDlCqiMaps ();
+	RefreshUlCqiMaps ();
+
+	// Process DL HARQ feedback, if time out, reset.
+	RefreshHarqProcesses ();
+
+	// If the first availble symbol is the last one, it should be reserved for UL control symbol.
+	if ((int)state.m_symIdx >= (int)(m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ()))
+	{
+		FinishSchedTrigger (state);  // As no more slot are available for allocation, send the scheduling result to "scheduler".
+		return false;
+	}
+	return true;
+}
+
+void
+MmWaveFlexTtiSchedulerBase::ScheduleHarqRetx (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params, SchedTriggerState &state, std::vector<HarqRetx> &retx)
+{
+	MmWaveMacSchedSapUser::SchedConfigIndParameters &ret = state.m_ret;
+	int &symAvail = state.m_symAvail;
+	uint8_t &slotIdx = state.m_slotIdx;
+	uint8_t &symIdx = state.m_symIdx;
+
+	// retrieve past HARQ retx buffered
+	if (m_dlHarqInfoList.size () > 0 && params.m_dlHarqInfoList.size () > 0)
+	{
+		m_dlHarqInfoList.insert (m_dlHarqInfoList.end (), params.m_dlHarqInfoList.begin (), params.m_dlHarqInfoList.end ());
+		// Add the incoming new dlHarqInfo items.
+	}
+	else if (params.m_dlHarqInfoList.size () > 0)
+	{
+		m_dlHarqInfoList = params.m_dlHarqInfoList;
+	}
+	if (m_ulHarqInfoList.size () > 0 && params.m_ulHarqInfoList.size () > 0)
+	{
+		m_ulHarqInfoList.insert (m_ulHarqInfoList.end (), params.m_ulHarqInfoList.begin (), params.m_ulHarqInfoList.end ());
+	}
+	else if (params.m_ulHarqInfoList.size () > 0)
+	{
+		m_ulHarqInfoList = params.m_ulHarqInfoList;
+	}
+
+	if (m_harqOn == false)  // Ignore HARQ feedback
+	{
+		m_dlHarqInfoList.clear ();
+		return;
+	}
+
+	// Process DL HARQ feedback and assign slots for RETX if resources available
+	std::vector <struct DlHarqInfo> dlInfoListUntxed;  // TBs not able to be retransmitted in this sf
+	std::vector <struct UlHarqInfo> ulInfoListUntxed;
+
+	for (unsigned i = 0; i < m_dlHarqInfoList.size (); i++)
+	{
+		if (symAvail == 0)
+		{
+			break;  // no symbols left to allocate
+		}
+		uint8_t harqId = m_dlHarqInfoList.at (i).m_harqProcessId;
+		uint16_t rnti = m_dlHarqInfoList.at (i).m_rnti;
+		uint32_t harqSlot = FindUeSlot (rnti, UE_HARQ);
+		if (harqSlot == NO_UE_SLOT)
+		{
+			NS_FATAL_ERROR ("No HARQ status info found for UE " << rnti);
+		}
+		DlHarqProcessesStatus_t &dlHarqStatus = m_dlHarqProcessesStatus[harqSlot];
+		DlHarqRlcPduList_t &dlHarqRlcPdu = m_dlHarqProcessesRlcPdu[harqSlot];
+		if(m_dlHarqInfoList.at (i).m_harqStatus == DlHarqInfo::ACK || dlHarqStatus.at (harqId) == 0)
+		{ // acknowledgment or process timeout, reset process
+			NS_LOG_DEBUG ("UE" << rnti << " DL harqId " << (unsigned)harqId << " HARQ-ACK received");
+			dlHarqStatus.at (harqId) = 0;    // release process ID
+			dlHarqRlcPdu.at (harqId).clear ();  // clear RLC buffers
+			continue;
+		}
+		else if(m_dlHarqInfoList.at (i).m_harqStatus == DlHarqInfo::NACK)
+		{
+			DlHarqProcessesDciInfoList_t &dlHarqDci = m_dlHarqProcessesDciInfo[harqSlot];
+			DciInfoElementTdma dciInfoReTx = dlHarqDci.at (harqId);
+			NS_LOG_DEBUG ("UE" << rnti << " DL harqId " << (unsigned)harqId << " HARQ-NACK received, rv " << (unsigned)dciInfoReTx.m_rv);
+			NS_ASSERT (harqId == dciInfoReTx.m_harqProcess);
+			NS_ASSERT(dlHarqStatus.at (harqId) - 1 == dciInfoReTx.m_rv);
+			if (dciInfoReTx.m_rv == 3) // maximum number of retx reached -> drop process
+			{
+				NS_LOG_INFO ("Max number of retransmissions reached -> drop process");
+				dlHarqStatus.at (harqId) = 0;
+				dlHarqRlcPdu.at (harqId).clear ();
+				continue;
+			}
+
+			// allocate retx if enough symbols are available
+			if (symAvail >= dciInfoReTx.m_numSym)
+			{
+				// find the first free symbols, the RETX cannot be split
+				uint8_t retxSymIdx = symIdx;
+				bool later = CheckOverlapWithBusyResources(symIdx, dciInfoReTx.m_numSym); // TODOIAB: check if it can be allocated later
+				bool found = !later || FindRetxSymbols (retxSymIdx, dciInfoReTx.m_numSym);
+				if (found)
+				{
+					symAvail -= dciInfoReTx.m_numSym;  // reduce the number of available symbol slots in this subframe.
+					dciInfoReTx.m_symStart = retxSymIdx;
+					if (!later)
+					{
+						symIdx += dciInfoReTx.m_numSym;    // update the first available symbol's index
+					}
+					else
+					{
+						UpdateResourceMask(retxSymIdx, dciInfoReTx.m_numSym);
+					}
+					NS_ASSERT (retxSymIdx + dciInfoReTx.m_numSym <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
+					dciInfoReTx.m_rv++;                // m_rv could be thinked as times of retransmit.
+					dciInfoReTx.m_ndi = 0;             // 0 means old data
+					dlHarqDci.at (harqId) = dciInfoReTx;
+					dlHarqStatus.at (harqId) = dlHarqStatus.at (harqId) + 1;  // Update the harq status of the specific harq process of this user.
+					SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, rnti);
+					slotInfo.m_dci = dciInfoReTx;
+					NS_LOG_DEBUG ("UE" << dciInfoReTx.m_rnti << " gets DL slots " << (unsigned)dciInfoReTx.m_symStart << "-" << (unsigned)(dciInfoReTx.m_symStart+dciInfoReTx.m_numSym-1) <<
+								  " tbs " << dciInfoReTx.m_tbSize << " harqId " << (unsigned)dciInfoReTx.m_harqProcess <<
+								  " rv " << (unsigned)dciInfoReTx.m_rv << " in frame " << ret.m_sfnSf.m_frameNum << " subframe " << (unsigned)ret.m_sfnSf.m_sfNum << " RETX");
+					for (uint16_t k = 0; k < dlHarqRlcPdu.at(dciInfoReTx.m_harqProcess).size (); k++)
+					{
+						slotInfo.m_rlcPduInfo.push_back (dlHarqRlcPdu.at (dciInfoReTx.m_harqProcess).at (k));
+					}
+					ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
+					ret.m_sfAllocInfo.m_numSymAlloc += dciInfoReTx.m_numSym;
+					HarqRetx dlRetx = { rnti, false, dciInfoReTx.m_numSym };
+					retx.push_back (dlRetx);
+				}
+				else
+				{
+					NS_LOG_DEBUG ("No resource for this retx (even later) -> buffer it");
+					dlInfoListUntxed.push_back (m_dlHarqInfoList.at (i));
+				}
+			}
+			else
+			{
+				NS_LOG_DEBUG ("No resource for this retx -> buffer it");
+				dlInfoListUntxed.push_back (m_dlHarqInfoList.at (i));
+			}
+		}
+	}
+
+	m_dlHarqInfoList.clear ();
+	m_dlHarqInfoList = dlInfoListUntxed;
+
+	// Process UL HARQ feedback
+	for (uint16_t i = 0; i < m_ulHarqInfoList.size (); i++)
+	{
+		if (symAvail == 0)
+		{
+			break;	// no symbols left to allocate
+		}
+		UlHarqInfo harqInfo = m_ulHarqInfoList.at (i);
+		uint8_t harqId = harqInfo.m_harqProcessId;
+		uint16_t rnti = harqInfo.m_rnti;
+		uint32_t harqSlot = FindUeSlot (rnti, UE_HARQ);
+		if (harqSlot == NO_UE_SLOT)
+		{
+			NS_LOG_ERROR ("No info found in HARQ buffer for UE (might have changed eNB) " << rnti);
+			continue;
+		}
+		UlHarqProcessesStatus_t &ulHarqStatus = m_ulHarqProcessesStatus[harqSlot];
+		if (harqInfo.m_receptionStatus == UlHarqInfo::Ok || ulHarqStatus.at (harqId) == 0)
+		{
+			ulHarqStatus.at (harqId) = 0;  // release process ID
+		}
+		else if (harqInfo.m_receptionStatus == UlHarqInfo::NotOk)
+		{
+			UlHarqProcessesDciInfoList_t &ulHarqDci = m_ulHarqProcessesDciInfo[harqSlot];
+			// retx correspondent block: retrieve the UL-DCI
+			DciInfoElementTdma dciInfoReTx = ulHarqDci.at (harqId);
+			NS_LOG_DEBUG ("UE" << rnti << " UL harqId " << (unsigned)harqId << " TX not ok, rv" << (unsigned)dciInfoReTx.m_rv);
+			NS_ASSERT (harqId == dciInfoReTx.m_harqProcess);
+			NS_ASSERT(ulHarqStatus.at (harqId) > 0);  // It must be retransmitted at least once already.
+			NS_ASSERT(ulHarqStatus.at (harqId)-1 == dciInfoReTx.m_rv);  // First attempt: status == 1, m_rv == 0.
+			if (dciInfoReTx.m_rv == 3)
+			{
+				NS_LOG_INFO ("Max number of retransmissions reached (UL)-> drop process");
+				ulHarqStatus.at (harqId) = 0;
+				continue;
+			}
+
+			NS_LOG_DEBUG("Num sym needed " << dciInfoReTx.m_numSym << " symIdx " << (uint16_t)symIdx);
+			if (symAvail >= dciInfoReTx.m_numSym)
+			{
+				// find the first free symbols, the RETX cannot be split
+				uint8_t retxSymIdx = symIdx;
+				bool later = CheckOverlapWithBusyResources(symIdx, dciInfoReTx.m_numSym); // TODOIAB: check if it can be allocated later
+				bool found = !later || FindRetxSymbols (retxSymIdx, dciInfoReTx.m_numSym);
+				if (found)
+				{
+					symAvail -= dciInfoReTx.m_numSym;
+					dciInfoReTx.m_symStart = retxSymIdx;
+					if (!later)
+					{
+						symIdx += dciInfoReTx.m_numSym;
+					}
+					else
+					{
+						UpdateResourceMask(retxSymIdx, dciInfoReTx.m_numSym);
+					}
+					NS_ASSERT (retxSymIdx + dciInfoReTx.m_numSym <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
+					dciInfoReTx.m_rv++;     // Another retransmission, so that m_rv is increased by 1.
+					dciInfoReTx.m_ndi = 0;  // Not new data.
+					ulHarqStatus.at (harqId) = ulHarqStatus.at (harqId) + 1;
+					ulHarqDci.at (harqId) = dciInfoReTx;  // Update the corresponding dci info in the uplink harq buffer
+					SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, rnti);
+					slotInfo.m_dci = dciInfoReTx;
+					NS_LOG_DEBUG ("UE" << dciInfoReTx.m_rnti << " gets UL slots " << (unsigned)dciInfoReTx.m_symStart << "-"
+								  << (unsigned)(dciInfoReTx.m_symStart+dciInfoReTx.m_numSym-1) << " tbs " << dciInfoReTx.m_tbSize
+								  << " harqId " << (unsigned)dciInfoReTx.m_harqProcess << " rv " << (unsigned)dciInfoReTx.m_rv
+								  << " in frame " << state.m_ulSfn.m_frameNum << " subframe " << (unsigned)state.m_ulSfn.m_sfNum << " RETX");
+					ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
+					ret.m_sfAllocInfo.m_numSymAlloc += dciInfoReTx.m_numSym;
+					HarqRetx ulRetx = { rnti, true, dciInfoReTx.m_numSym };
+					retx.push_back (ulRetx);
+				}
+				else
+				{
+					NS_LOG_DEBUG ("No resource for this UL retx (even later) -> buffer it");
+					ulInfoListUntxed.push_back (m_ulHarqInfoList.at (i));
+				}
+			}
+			else
+			{
+				NS_LOG_DEBUG ("No resource for this retx -> buffer it");
+				ulInfoListUntxed.push_back (m_ulHarqInfoList.at (i));
+			}
+		}
+	}
+
+	m_ulHarqInfoList.clear ();
+	m_ulHarqInfoList = ulInfoListUntxed;
+
+	NS_LOG_DEBUG("After HARQ allocation symAvail " << symAvail << " mask " << PrintSubframeAllocationMask(m_busyResourcesSchedSubframe.m_symAllocationMask));
+}
+
+bool
+MmWaveFlexTtiSchedulerBase::FindRetxSymbols (uint8_t &symIdx, int numSymNeeded)
+{
+	// find if there are other resources later
+	// we cannot split RETX!
+	int numFreeSymbols = 0;
+	uint8_t tmpSymIdx = symIdx;
+
+	while(numFreeSymbols == 0 && tmpSymIdx < m_phyMacConfig->GetSymbolsPerSubframe()-1)
+	{
+		numFreeSymbols = GetNumFreeSymbols(tmpSymIdx, numSymNeeded); // this is equal to numSymNeeded if there is no overlap, otherwise smaller
+		NS_LOG_LOGIC("RETX numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " tmpSymIdx " << (uint16_t)tmpSymIdx);
+		if(numFreeSymbols < numSymNeeded)
+		{
+			numFreeSymbols = 0;
+			tmpSymIdx = GetFirstFreeSymbol(tmpSymIdx, numSymNeeded); // get the next symIdx
+			if((int)(tmpSymIdx + numSymNeeded) > (int)m_phyMacConfig->GetSymbolsPerSubframe()-1)
+			{
+				NS_LOG_DEBUG("No way to fit this retx in the available resources");
+				break;
+			}
+		}
+	}
+
+	if(numFreeSymbols >= numSymNeeded && (int)(tmpSymIdx + numSymNeeded) < (int)(m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ()))
+	{
+		NS_LOG_LOGIC("Found resources for HARQ RETX at " << (uint16_t)tmpSymIdx);
+		symIdx = tmpSymIdx;
+		return true;
+	}
+	return false;
+}
+
+/*
+ * =========================================================================
+ * Create the DCIs of a DL grant, split around the busy symbols if needed,
+ * distribute the TBs between the RLC PDUs of the UE and add the slots.
+ * =========================================================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::AllocateDlGrant (SchedTriggerState &state, const UeGrant &grant)
+{
+	MmWaveMacSchedSapUser::SchedConfigIndParameters &ret = state.m_ret;
+	int &symAvail = state.m_symAvail;
+	uint8_t &slotIdx = state.m_slotIdx;
+	uint8_t &symIdx = state.m_symIdx;
+
+	std::vector<SlotAllocInfo> tmpSlotAllocVector;
+	int numSymNeeded = grant.m_numSym;
+	int totalTbSize = 0;
+	NS_LOG_DEBUG("UE " << grant.m_rnti << " numSymNeeded " << numSymNeeded);
+	do
+	{
+		// if there is overlapping, split allocation
+		// get the number of symbols that could be allocated
+		int numFreeSymbols = GetNumFreeSymbols(symIdx, numSymNeeded); // this is equal to numSymNeeded if there is no overlap, otherwise smaller
+		if(numFreeSymbols == 0)
+		{
+			// symIdx is inside a busy interval, get the next free symIdx and retry
+			NS_LOG_DEBUG("symIdx is in a busy interval, get the first free symIdx and retry");
+			symIdx = GetFirstFreeSymbol(symIdx, 0); // get the next symIdx
+			NS_LOG_DEBUG("new symIdx " << (uint16_t)symIdx);
+			numFreeSymbols = GetNumFreeSymbols(symIdx, numSymNeeded);
+		}
+		symAvail -= numFreeSymbols;
+		numSymNeeded -= numFreeSymbols;
+		NS_LOG_DEBUG("UE " << grant.m_rnti << " numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " symAvail " << symAvail);
+
+		// create the DCI
+		DciInfoElementTdma dci;
+		dci.m_rnti = grant.m_rnti;
+		dci.m_format = 0;
+		dci.m_symStart = symIdx;
+		dci.m_numSym = numFreeSymbols;
+		symIdx = GetFirstFreeSymbol(symIdx, numFreeSymbols); // get the next symIdx
+		NS_LOG_LOGIC("Next symIdx " << (uint16_t)symIdx);
+		dci.m_ndi = 1;
+		dci.m_mcs = grant.m_mcs;
+		dci.m_tbSize = m_amc->GetTbSizeFromMcsSymbols (dci.m_mcs, dci.m_numSym) / 8;
+		totalTbSize += dci.m_tbSize;
+
+		NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
+		dci.m_rv = 0;
+		dci.m_harqProcess = UpdateDlHarqProcessId (grant.m_rnti);
+		NS_ASSERT (dci.m_harqProcess < m_phyMacConfig->GetNumHarqProcess ());
+		NS_LOG_DEBUG ("UE" << grant.m_rnti << " DL harqId " << (unsigned)dci.m_harqProcess << " HARQ process assigned");
+		SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, grant.m_rnti);
+		slotInfo.m_dci = dci;
+		NS_LOG_DEBUG (this << " UE " << dci.m_rnti << " gets DL slots " << (unsigned)dci.m_symStart << "-" << (unsigned)(dci.m_symStart+dci.m_numSym-1)
+					  << " tbs " << dci.m_tbSize << " mcs " << (unsigned)dci.m_mcs << " harqId " << (unsigned)dci.m_harqProcess
+					  << " rv " << (unsigned)dci.m_rv << " in frame " << ret.m_sfnSf.m_frameNum << " subframe " << (unsigned)ret.m_sfnSf.m_sfNum);
+
+		if (m_harqOn == true)
+		{	// store DCI for HARQ buffer
+			uint32_t harqSlot = FindUeSlot (dci.m_rnti, UE_HARQ);
+			if (harqSlot == NO_UE_SLOT)
+			{
+				NS_FATAL_ERROR ("Unable to find RNTI entry in DCI HARQ buffer for RNTI " << dci.m_rnti);
+			}
+			m_dlHarqProcessesDciInfo[harqSlot].at (dci.m_harqProcess) = dci;
+			// refresh timer
+			m_dlHarqProcessesTimer[harqSlot].at (dci.m_harqProcess) = 0;
+		}
+
+		tmpSlotAllocVector.push_back(slotInfo);
+
+	} while(numSymNeeded > 0);
+
+	FillDlRlcPdus (grant, tmpSlotAllocVector, totalTbSize);
+
+	for (unsigned i = 0; i < tmpSlotAllocVector.size (); i++)
+	{
+		SlotAllocInfo &slotInfo = tmpSlotAllocVector[i];
+		// the slots are sorted by symbol index in FinishSchedTrigger, so that DL is before UL
+		if (slotInfo.m_rlcPduInfo.size() > 0) // TODOIAB understand why a TB may be in excess with respect to the RLC size
+		{
+			if (m_dlSlotsFirst && m_harqOn == true)
+			{
+				// reorder/reindex slots to maintain DL before UL slot order
+				bool reordered = false;
+				std::deque <SlotAllocInfo>::iterator itSlot = ret.m_sfAllocInfo.m_slotAllocInfo.begin ();
+				for (unsigned islot = 0; islot < ret.m_sfAllocInfo.m_slotAllocInfo.size (); islot++)
+				{
+					if (ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_tddMode == SlotAllocInfo::UL_slotAllocInfo)
+					{
+						slotInfo.m_slotIdx = ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_slotIdx;
+						slotInfo.m_dci.m_symStart = ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_dci.m_symStart;
+						ret.m_sfAllocInfo.m_slotAllocInfo.insert (itSlot, slotInfo);
+						for (unsigned jslot = islot+1; jslot < ret.m_sfAllocInfo.m_slotAllocInfo.size (); jslot++)
+						{
+							ret.m_sfAllocInfo.m_slotAllocInfo[jslot].m_slotIdx++;	// increase indices of UL slots
+							ret.m_sfAllocInfo.m_slotAllocInfo[jslot].m_dci.m_symStart =
+									ret.m_sfAllocInfo.m_slotAllocInfo[jslot-1].m_dci.m_symStart +
+									ret.m_sfAllocInfo.m_slotAllocInfo[jslot-1].m_dci.m_numSym;
+						}
+						reordered = true;
+						break;
+					}
+					itSlot++;
+				}
+				if (!reordered)
+				{
+					ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
+				}
+			}
+			else
+			{
+				ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
+			}
+		}
+		ret.m_sfAllocInfo.m_numSymAlloc += slotInfo.m_dci.m_numSym;
+	}
+}
+
+/*
+ * =========================================================================
+ * Distribute the TBs of a DL grant between the RLC PDUs of the UE, taking
+ * into account the possible split of the resources.
+ * =========================================================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::FillDlRlcPdus (const UeGrant &grant, std::vector<SlotAllocInfo> &slots, int totalTbSize)
+{
+	std::vector <struct RlcPduInfo> &rlcPduInfo = *grant.m_rlcPduInfo;
+
+	uint16_t avgPduSize = 0;
+	if (grant.m_splitEvenly)
+	{
+		// distribute bytes between active RLC queues
+		unsigned numLc = rlcPduInfo.size ();
+		unsigned bytesRem = totalTbSize;
+		unsigned numFulfilled = 0;
+		avgPduSize = bytesRem / numLc;
+		NS_LOG_DEBUG("numLc " << numLc << " bytesRem " << bytesRem << " avgPduSize " << avgPduSize);
+
+		// first for loop computes extra to add to average if some flows are less than average
+		for (unsigned i = 0; i < rlcPduInfo.size (); i++)
+		{
+			if (rlcPduInfo[i].m_size < avgPduSize)
+			{
+				bytesRem -= rlcPduInfo[i].m_size;
+				numFulfilled++;
+			}
+		}
+
+		if (numFulfilled < rlcPduInfo.size ())
+		{
+			avgPduSize = bytesRem / (rlcPduInfo.size () - numFulfilled);
+		}
+
+		NS_LOG_DEBUG("numFulfilled " << numFulfilled << " new avgPduSize " << avgPduSize);
+	}
+	else
+	{
+		// give remaining bytes to the default bearer
+		unsigned totalBytesAlloc = 0;
+		for (unsigned i = 0; i < rlcPduInfo.size (); i++)
+		{
+			totalBytesAlloc += rlcPduInfo[i].m_size;
+		}
+		for (unsigned i = 0; i < rlcPduInfo.size (); i++)
+		{
+			if (rlcPduInfo[i].m_lcid == 3 && totalBytesAlloc < (unsigned)totalTbSize)
+			{
+				rlcPduInfo[i].m_size += totalTbSize - totalBytesAlloc;
+				break;
+			}
+		}
+	}
+
+	// fill the RlcPduInfo taking into account the possible split of resources
+	for (unsigned islot = 0; islot < slots.size (); islot++)
+	{
+		SlotAllocInfo &slotInfo = slots[islot];
+		// distribute bytes between active RLC queues and slots allocated
+		int remTbSize = slotInfo.m_dci.m_tbSize;
+		NS_LOG_DEBUG("slotInfo starting from " << (uint16_t)slotInfo.m_dci.m_symStart << " with tbSize " << remTbSize << " num PDU " << rlcPduInfo.size());
+
+		auto pduIterator = rlcPduInfo.begin();
+		while (remTbSize > 0 && pduIterator != rlcPduInfo.end())
+		{
+			NS_LOG_DEBUG("PDU with initial size " << pduIterator->m_size);
+			// allocate as many bytes for this currentTbSize
+			if (grant.m_splitEvenly && pduIterator->m_size > avgPduSize)
+			{
+				pduIterator->m_size = avgPduSize;
+				NS_LOG_LOGIC("Clip PDU to avgPduSize");
+			}
+			// else tbSize equals RLC queue size
+			NS_ASSERT(pduIterator->m_size > 0);
+
+			NS_LOG_DEBUG("Update RLC buffer with size (plus hdr)" << std::min(remTbSize, (int)pduIterator->m_size));
+			// update RLC buffer info with expected queue size after scheduling
+			UpdateDlRlcBufferInfo (grant.m_rnti, pduIterator->m_lcid, std::min(remTbSize, (int)pduIterator->m_size) - m_subHdrSize);
+
+			if((int)pduIterator->m_size > remTbSize)
+			{
+				// max amount of bytes that can be allocated
+				slotInfo.m_rlcPduInfo.push_back (RlcPduInfo(pduIterator->m_lcid, remTbSize));
+				pduIterator->m_size -= remTbSize - m_subHdrSize - 10; // TODOIAB add the size of a subheader (+10 understand why!)
+				remTbSize = 0;
+			}
+			else
+			{
+				slotInfo.m_rlcPduInfo.push_back ((*pduIterator));
+				remTbSize -= pduIterator->m_size;
+
+				// we need to remove this m_rlcPduInfo since it has been satisfied
+				rlcPduInfo.erase(pduIterator);
+				pduIterator = rlcPduInfo.begin();
+			}
+
+			NS_LOG_DEBUG("Added RLC PDU with size " << slotInfo.m_rlcPduInfo.back().m_size << " remTbSize " << remTbSize);
+
+			if (m_harqOn == true)
+			{
+				// store RLC PDU list for HARQ
+				uint32_t harqSlot = FindUeSlot (grant.m_rnti, UE_HARQ);
+				if (harqSlot == NO_UE_SLOT)
+				{
+					NS_FATAL_ERROR ("Unable to find RlcPdcList in HARQ buffer for RNTI " << grant.m_rnti);
+				}
+				m_dlHarqProcessesRlcPdu[harqSlot].at (slotInfo.m_dci.m_harqProcess).push_back (slotInfo.m_rlcPduInfo.back());
+			}
+		}
+	}
+}
+
+/*
+ * ============================================================
+ * Create the DCIs of an UL grant, which applies to subframe
+ * i+Tsched, split around the busy symbols if needed.
+ * ============================================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::AllocateUlGrant (SchedTriggerState &state, const UeGrant &grant)
+{
+	MmWaveMacSchedSapUser::SchedConfigIndParameters &ret = state.m_ret;
+	int &symAvail = state.m_symAvail;
+	uint8_t &slotIdx = state.m_slotIdx;
+	uint8_t &symIdx = state.m_symIdx;
+
+	int numSymNeeded = grant.m_numSym;
+	do
+	{
+		// if there is overlapping, split allocation
+		// get the number of symbols that could be allocated
+		NS_LOG_DEBUG("UE " << grant.m_rnti << " numSymNeeded " << numSymNeeded);
+		int numFreeSymbols = GetNumFreeSymbols(symIdx, numSymNeeded); // this is equal to numSymNeeded if there is no overlap, otherwise smaller
+		if(numFreeSymbols == 0)
+		{
+			// symIdx is inside a busy interval, get the next free symIdx and retry
+			NS_LOG_DEBUG("symIdx is in a busy interval, get the first free symIdx and retry (UL)");
+			symIdx = GetFirstFreeSymbol(symIdx, 0); // get the next symIdx
+			NS_LOG_DEBUG("new symIdx " << (uint16_t)symIdx);
+			numFreeSymbols = GetNumFreeSymbols(symIdx, numSymNeeded);
+		}
+
+		symAvail -= numFreeSymbols;
+		numSymNeeded -= numFreeSymbols;
+		NS_LOG_DEBUG("UE " << grant.m_rnti << " numSymNeeded " << numSymNeeded << " numFreeSymbols " << numFreeSymbols << " symAvail " << symAvail);
+
+		DciInfoElementTdma dci;
+		dci.m_rnti = grant.m_rnti;
+		dci.m_format = 1;
+		dci.m_numSym = numFreeSymbols;
+		dci.m_symStart = symIdx;
+		symIdx = GetFirstFreeSymbol(symIdx, numFreeSymbols); // get the next free symbol
+		NS_LOG_LOGIC("Next symIdx " << (uint16_t)symIdx);
+		dci.m_mcs = grant.m_mcs;
+		dci.m_ndi = 1;
+		dci.m_tbSize = m_amc->GetTbSizeFromMcsSymbols (dci.m_mcs, dci.m_numSym) / 8;
+
+		NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
+		dci.m_harqProcess = UpdateUlHarqProcessId (grant.m_rnti);
+		NS_LOG_DEBUG ("UE" << grant.m_rnti << " UL harqId " << (unsigned)dci.m_harqProcess << " HARQ process assigned");
+		NS_ASSERT (dci.m_harqProcess < m_phyMacConfig->GetNumHarqProcess ());
+		SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, grant.m_rnti);
+		slotInfo.m_dci = dci;
+		NS_LOG_DEBUG (this << " UE" << dci.m_rnti << " gets UL slots " << (unsigned)dci.m_symStart << "-" << (unsigned)(dci.m_symStart+dci.m_numSym-1) <<
+					  " tbs " << dci.m_tbSize << " mcs " << (unsigned)dci.m_mcs << " harqId " << (unsigned)dci.m_harqProcess << " rv " << (unsigned)dci.m_rv <<
+					  " in frame " << state.m_ulSfn.m_frameNum << " subframe " << (unsigned)state.m_ulSfn.m_sfNum);
+		UpdateUlRlcBufferInfo (grant.m_rnti, dci.m_tbSize - m_subHdrSize);
+		ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
+		ret.m_sfAllocInfo.m_numSymAlloc += dci.m_numSym;
+		std::vector<uint16_t> ueChunkMap;
+		for (unsigned i = 0; i < m_phyMacConfig->GetTotalNumChunk (); i++)
+		{
+			ueChunkMap.push_back (dci.m_rnti);
+		}
+		SfnSf slotSfn = ret.m_sfAllocInfo.m_sfnSf;
+		slotSfn.m_slotNum = dci.m_symStart;  // use the start symbol index of the slot because the absolute UL slot index depends on the future DL allocation
+		// insert into allocation map to recall previous allocations upon receiving UL-CQI
+		m_ulAllocationMap.insert ( std::pair<uint32_t, struct AllocMapElem> (slotSfn.Encode (), AllocMapElem(ueChunkMap, dci.m_numSym, dci.m_tbSize)) );
+
+		if (m_harqOn == true)
+		{
+			uint8_t harqId = dci.m_harqProcess;
+			uint32_t harqSlot = FindUeSlot (dci.m_rnti, UE_HARQ);
+			if (harqSlot == NO_UE_SLOT)
+			{
+				NS_FATAL_ERROR ("Unable to find RNTI entry in UL DCI HARQ buffer for RNTI " << dci.m_rnti);
+			}
+			m_ulHarqProcessesDciInfo[harqSlot].at (harqId) = dci;
+			// Update HARQ process status (RV 0)
+			NS_ASSERT (m_ulHarqProcessesStatus[harqSlot][dci.m_harqProcess] > 0);
+			// refresh timer
+			m_ulHarqProcessesTimer[harqSlot].at (dci.m_harqProcess) = 0;
+		}
+	} while(numSymNeeded > 0);
+}
+
+void
+MmWaveFlexTtiSchedulerBase::FinishSchedTrigger (SchedTriggerState &state)
+{
+	// add slot for UL control
+	SlotAllocInfo ulCtrlSlot (0xFF, SlotAllocInfo::UL_slotAllocInfo, SlotAllocInfo::CTRL, SlotAllocInfo::DIGITAL, 0);
+	ulCtrlSlot.m_dci.m_numSym = 1;
+	ulCtrlSlot.m_dci.m_symStart = m_phyMacConfig->GetSymbolsPerSubframe()-1;
+	state.m_ret.m_sfAllocInfo.m_slotAllocInfo.push_back (ulCtrlSlot);
+
+	// Sort the slot allocation info by "m_dci.m_symStart"
+	std::sort(state.m_ret.m_sfAllocInfo.m_slotAllocInfo.begin(), state.m_ret.m_sfAllocInfo.m_slotAllocInfo.end(), BySymIndex());
+
+	m_macSchedSapUser->SchedConfigInd (state.m_ret);
+}
+
+int
+MmWaveFlexTtiSchedulerBase::GetNumFreeSymbols(uint8_t symIdx, int numSymNeeded)
+{
+	NS_LOG_LOGIC("symIdx " << (uint16_t)symIdx << " numSymNeeded " << numSymNeeded);
+
+	if(!m_iabScheduler || !m_busyResourcesSchedSubframe.m_valid)
+	{
+		// If this is not an Iab scheduler or the subframe has been used already.
+		return numSymNeeded;
+	}
+
+	// contiguous symbol assignment, the search ends at the first busy symbol
+	int numFreeSymbols = m_busyResourcesSchedSubframe.m_symAllocationMask.GetNumFreeSymbols(symIdx, numSymNeeded);
+	if(numFreeSymbols < numSymNeeded)
+	{
+		NS_LOG_LOGIC("Symbol busy, allocated " << numFreeSymbols << " out of " << numSymNeeded);
+	}
+	return numFreeSymbols;
+}
+
+void
+MmWaveFlexTtiSchedulerBase::UpdateResourceMask(uint8_t start, int numSymbols)
+{
+	if(!m_iabScheduler)
+	{
+		NS_FATAL_ERROR("Try to update the mask for a non IAB scheduler");
+	}
+
+	m_busyResourcesSchedSubframe.m_symAllocationMask.SetBusy(start, numSymbols);
+}
+
+uint8_t
+MmWaveFlexTtiSchedulerBase::GetFirstFreeSymbol(uint8_t symIdx, int numFreeSymbols)
+{
+	NS_LOG_LOGIC("symIdx " << (uint16_t)symIdx << " numFreeSymbols " << numFreeSymbols);
+
+	if(!m_iabScheduler || !m_busyResourcesSchedSubframe.m_valid)
+	{
+		return symIdx + numFreeSymbols;  // here first free means the next first free after numFreeSymbols.
+	}
+
+	uint32_t index = m_busyResourcesSchedSubframe.m_symAllocationMask.GetFirstFreeSymbol(symIdx + numFreeSymbols);
+	NS_LOG_LOGIC("First free symbol at " << index);
+	return static_cast<uint8_t>(index);
+}
+
+bool
+MmWaveFlexTtiSchedulerBase::CheckOverlapWithBusyResources(uint8_t symIdx, int numSymNeeded)
+{
+	NS_LOG_LOGIC("symIdx " << (uint16_t)symIdx << " numSymNeeded " << numSymNeeded);
+
+	if(!m_iabScheduler || !m_busyResourcesSchedSubframe.m_valid)
+	{
+		return false;
+	}
+
+	return m_busyResourcesSchedSubframe.m_symAllocationMask.Overlaps(symIdx, numSymNeeded);
+}
+
+
+void
+MmWaveFlexTtiSchedulerBase::DoSchedUlMacCtrlInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters& params)
+{
+	NS_LOG_FUNCTION (this);
+
+	for (unsigned int i = 0; i < params.m_macCeList.size (); i++)
+	{
+		if ( params.m_macCeList.at (i).m_macCeType == MacCeElement::BSR )
+		{
+			// buffer status report
+			// note that this scheduler does not differentiate the
+			// allocation according to which LCGs have more/less bytes
+			// to send.
+			// Hence the BSR of different LCGs are just summed up to get
+			// a total queue size that is used for allocation purposes.
+
+			uint32_t buffer = 0;
+			for (uint8_t lcg = 0; lcg < 4; ++lcg)
+			{
+				uint8_t bsrId = params.m_macCeList.at (i).m_macCeValue.m_bufferStatus.at (lcg);
+				buffer += BsrId2BufferSize (bsrId);
+			}
+
+			uint16_t rnti = params.m_macCeList.at (i).m_rnti;
+			if (FindUeSlot (rnti, UE_BSR) == NO_UE_SLOT)
+			{
+				// create the new entry
+				m_ceBsr[AddUeField (rnti, UE_BSR)] = buffer;
+				NS_LOG_DEBUG (this << " Insert RNTI " << rnti << " queue " << buffer);
+			}
+			else
+			{
+				// update the buffer size value
+				m_ceBsr[FindUeSlot (rnti, UE_BSR)] = buffer;
+				NS_LOG_DEBUG (this << " Update RNTI " << rnti << " queue " << buffer);
+			}
+		}
+	}
+
+	return;
+}
+
+void
+MmWaveFlexTtiSchedulerBase::DoSchedSetMcs (int mcs)
+{
+	if (mcs >= 0 && mcs <= 28)
+	{
+		m_mcsDefaultDl = mcs;
+		m_mcsDefaultUl = mcs;
+	}
+}
+
+bool
+MmWaveFlexTtiSchedulerBase::SortRlcBufferReq (MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters i, MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters j)
+{
+  return (i.m_rnti < j.m_rnti);
+}
+
+/*
+ * ==================================================================
+ * Update the Downlink Cqi map. Update timer and clear expired items.
+ * ==================================================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::RefreshDlCqiMaps (void)
+{
+	NS_LOG_FUNCTION (this << GetNumUes (UE_WB_CQI));
+	// refresh DL CQI P01 Map
+	for (uint32_t slot = 0; slot < m_ueFields.size (); slot++)
+	{
+		if ((m_ueFields[slot] & UE_WB_CQI) == 0)
+		{
+			continue;
+		}
+		NS_LOG_INFO (this << " P10-CQI for user " << m_ueRnti[slot] << " is " << m_wbCqiTimer[slot] << " thr " << (uint32_t)m_cqiTimersThreshold);
+		if (m_wbCqiTimer[slot] == 0)
+		{
+			// delete correspondent entries, which is expired, as timer reaches 0
+			NS_LOG_INFO (this << " P10-CQI exired for user " << m_ueRnti[slot]);
+			RemoveUeFields (slot, UE_WB_CQI);
+		}
+		else
+		{
+			m_wbCqiTimer[slot]--;
+		}
+	}
+	return;
+}
+
+/*
+ * ================================================================
+ * Update the Uplink Cqi map. Update timer and clear expired items.
+ * ================================================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::RefreshUlCqiMaps (void)
+{
+	// refresh UL CQI  Map
+	for (uint32_t slot = 0; slot < m_ueFields.size (); slot++)
+	{
+		if ((m_ueFields[slot] & UE_UL_CQI) == 0)
+		{
+			continue;
+		}
+		NS_LOG_INFO (this << " UL-CQI for user " << m_ueRnti[slot] << " is " << m_ulCqiTimer[slot] << " thr " << (uint32_t)m_cqiTimersThreshold);
+		if (m_ulCqiTimer[slot] == 0)
+		{
+			// delete correspondent entries
+			NS_LOG_DEBUG (this << " UL-CQI expired for user " << m_ueRnti[slot]);
+			RemoveUeFields (slot, UE_UL_CQI);
+		}
+		else
+		{
+			m_ulCqiTimer[slot]--;
+		}
+	}
+	return;
+}
+
+
+/*
+ * ===========================================
+ * Update the Downlink RLC buffer information.
+ * ===========================================
+ */
+void
+MmWaveFlexTtiSchedulerBase::UpdateDlRlcBufferInfo (uint16_t rnti, uint8_t lcid, uint16_t size)
+{
+	NS_LOG_FUNCTION (this);
+	std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it;
+	// m_rlcBufferReq stores UE's RLC buffer information. It is a list of RLC buffer information. 
+	for (it = m_rlcBufferReq.begin (); it != m_rlcBufferReq.end (); it++)
+	{
+		// An entry of RLC buffer information is identified by the tuple of "RNTI"(UE id)+"LCID"(logical channel id).
+		if (((*it).m_rnti == rnti) && ((*it).m_logicalChannelIdentity == lcid))
+		{
+			// "BSR" is "Buffer Status Report" (In LTE, it is sent from UE to eNodeB)
+			NS_LOG_INFO (this << " Update DL RLC BSR UE " << rnti << " LC " << (uint16_t)lcid 
+							<< " txqueue " << (*it).m_rlcTransmissionQueueSize << " retxqueue " << (*it).m_rlcRetransmissionQueueSize 
+							<< " status " << (*it).m_rlcStatusPduSize << " decrease " << size);
+			// Update queues: RLC tx order Status, ReTx, Tx
+			// Update status queue
+			if (((*it).m_rlcStatusPduSize > 0) && (size >= (*it).m_rlcStatusPduSize))
+			{
+				(*it).m_rlcStatusPduSize = 0;  // 
+			}
+			// Update retransmission queue
+			if ((*it).m_rlcRetransmissionQueueSize > 0)
+			{
+				// TODO: Figure out why a cast is needed here. Any chance of overflow? 
+				if ((*it).m_rlcRetransmissionQueueSize <= (unsigned)(size - (*it).m_rlcStatusPduSize))
+				{
+					(*it).m_rlcRetransmissionQueueSize = 0;
+				}
+				else
+				{
+					(*it).m_rlcRetransmissionQueueSize -= (size - (*it).m_rlcStatusPduSize);
+				}
+			}
+			// Update transmission queue.
+			// TODO: In this "if-elseif" clause, the logic behind is that if UE has retransmission to do (i.e., m_rlcRetransmissionQueueSize > 0),
+			// it will not update its transmission queue. Because retransmission has a higher priority than transmitting new data.
+			else if ((*it).m_rlcTransmissionQueueSize > 0)
+			{
+				uint32_t rlcOverhead;
+				if (lcid == 1)
+				{
+					// For SRB1 (using RLC AM) it's better to overestimate RLC overhead rather than underestimate it 
+					// and risk unneeded segmentation which increases delay.
+					// "SRB" is "Signaling Radio Bearer"
+					rlcOverhead = 4;
+				}
+				else
+				{
+					// minimum RLC overhead due to header
+					rlcOverhead = 2;
+				}
+				// TODO: Why is no cast here? "size" seems to already contain the overhead due to header.
+				if ((*it).m_rlcTransmissionQueueSize <= (size - rlcOverhead - (*it).m_rlcStatusPduSize))
+				{
+					(*it).m_rlcTransmissionQueueSize = 0;
+				}
+				else
+				{
+					(*it).m_rlcTransmissionQueueSize -= (size - rlcOverhead - (*it).m_rlcStatusPduSize);
+				}
+			}
+			return;
+		}
+	}
+}
+
+void
+MmWaveFlexTtiSchedulerBase::UpdateUlRlcBufferInfo (uint16_t rnti, uint16_t size)
+{
+
+  size = size - 2; // remove the minimum RLC overhead
+  uint32_t slot = FindUeSlot (rnti, UE_BSR);
+  if (slot != NO_UE_SLOT)
+	{
+	  NS_LOG_INFO (this << " Update UL RLC BSR UE " << rnti << " size " << size << " BSR " << m_ceBsr[slot]);
+	  if (m_ceBsr[slot] >= size)
+		{
+		  m_ceBsr[slot] -= size;
+		}
+	  else
+		{
+		  m_ceBsr[slot] = 0;
+		}
+	}
+  else
+	{
+	  NS_LOG_ERROR (this << " Does not find BSR report info of UE " << rnti);
+	}
+
+}
+
+
+void
+MmWaveFlexTtiSchedulerBase::DoCschedCellConfigReq (const struct MmWaveMacCschedSapProvider::CschedCellConfigReqParameters& params)
+{
+  NS_LOG_FUNCTION (this);
+  // Read the subset of parameters used
+  m_cschedCellConfig = params;
+  //m_rachAllocationMap.resize (m_cschedCellConfig.m_ulBandwidth, 0);
+  MmWaveMacCschedSapUser::CschedUeConfigCnfParameters cnf;
+  cnf.m_result = SUCCESS;
+  m_macCschedSapUser->CschedUeConfigCnf (cnf);
+  return;
+}
+
+void
+MmWaveFlexTtiSchedulerBase::CreateUeHarqProcesses (uint16_t rnti)
+{
+	if (FindUeSlot (rnti, UE_HARQ) == NO_UE_SLOT)
+	{
+		uint32_t slot = AddUeField (rnti, UE_HARQ);
+		m_dlHarqProcessesStatus[slot].resize (m_phyMacConfig->GetNumHarqProcess (), 0);
+		m_dlHarqProcessesTimer[slot].resize (m_phyMacConfig->GetNumHarqProcess (), 0);
+		m_dlHarqProcessesDciInfo[slot].resize (m_phyMacConfig->GetNumHarqProcess ());
+		m_dlHarqProcessesRlcPdu[slot].resize (m_phyMacConfig->GetNumHarqProcess ());
+
+		m_ulHarqProcessesStatus[slot].resize (m_phyMacConfig->GetNumHarqProcess (), 0);
+		m_ulHarqProcessesTimer[slot].resize (m_phyMacConfig->GetNumHarqProcess (), 0);
+		m_ulHarqProcessesDciInfo[slot].resize (m_phyMacConfig->GetNumHarqProcess ());
+	}
+}
+
+
+void
+MmWaveFlexTtiSchedulerBase::ConfigureIabInfo (const struct MmWaveMacCschedSapProvider::CschedUeConfigReqParameters& params)
+{
+	// IAB configure if this rnti is an IAB dev or not!
+	if(params.m_reconfigureFlag)
+	{
+		uint32_t prevNumDevs = 0;
+		uint32_t slot = FindUeSlot (params.m_rnti, UE_IAB_INFO);
+		if(slot != NO_UE_SLOT)
+		{
+			prevNumDevs = m_iabInfo[slot].second;
+		}
+		else
+		{
+			slot = AddUeField (params.m_rnti, UE_IAB_INFO);
+		}
+		m_iabInfo[slot] = std::make_pair (params.m_ueCapabilities.m_iab, params.m_ueCapabilities.m_numIabDevsPerRnti);
+		NS_LOG_DEBUG(this << " Reconfiguration of UE " << params.m_rnti << " iab " << params.m_ueCapabilities.m_iab
+					 << " numDevs " << params.m_ueCapabilities.m_numIabDevsPerRnti << " prevNumDevs " << prevNumDevs);
+
+		if(params.m_ueCapabilities.m_numIabDevsPerRnti + 1 > (int)m_maxSchedulingDelay) // + 1 since we need at least 1 TTI without no downstream IAB nodes
+		{
+			NS_LOG_WARN(this << " !!! --- !!! Updating m_maxSchedulingDelay from " << m_maxSchedulingDelay << " to " << params.m_ueCapabilities.m_numIabDevsPerRnti + 1);
+			m_maxSchedulingDelay = params.m_ueCapabilities.m_numIabDevsPerRnti + 1;
+		}
+	}
+}
+
+void
+MmWaveFlexTtiSchedulerBase::DoCschedLcReleaseReq (const struct MmWaveMacCschedSapProvider::CschedLcReleaseReqParameters& params)
+{
+  NS_LOG_FUNCTION (this);
+	for (uint16_t i = 0; i < params.m_logicalChannelIdentity.size (); i++)
+	{
+	 std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it = m_rlcBufferReq.begin ();
+	  while (it!=m_rlcBufferReq.end ())
+		{
+		  if (((*it).m_rnti == params.m_rnti)&&((*it).m_logicalChannelIdentity == params.m_logicalChannelIdentity.at (i)))
+			{
+			  it = m_rlcBufferReq.erase (it);
+			}
+		  else
+			{
+			  it++;
+			}
+		}
+	}
+  return;
+}
+
+void
+MmWaveFlexTtiSchedulerBase::DoCschedUeReleaseReq (const struct MmWaveMacCschedSapProvider::CschedUeReleaseReqParameters& params)
+{
+  NS_LOG_FUNCTION (this << " Release RNTI " << params.m_rnti);
+
+  // the CQIs and the IAB info of the UE are kept
+  uint32_t slot = FindUeSlot (params.m_rnti, 0);
+  if (slot != NO_UE_SLOT)
+	{
+	  RemoveUeFields (slot, UE_HARQ | UE_BSR);
+	}
+  std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it = m_rlcBufferReq.begin ();
+  while (it != m_rlcBufferReq.end ())
+	{
+	  if ((*it).m_rnti == params.m_rnti)
+		{
+		  NS_LOG_INFO (this << " Erase RNTI " << (*it).m_rnti << " LC " << (uint16_t)(*it).m_logicalChannelIdentity);
+		  it = m_rlcBufferReq.erase (it);
+		}
+	  else
+		{
+		  it++;
+		}
+	}
+  if (m_nextRntiUl == params.m_rnti)
+	{
+	  m_nextRntiUl = 0;
+	}
+
+  if (m_nextRntiDl == params.m_rnti)
+	{
+	  m_nextRntiDl = 0;
+	}
+
+  return;
+}
+
+}
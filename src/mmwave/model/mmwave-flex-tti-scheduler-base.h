@@ -0,0 +1,448 @@
+/*
+ * mmwave-flex-tti-scheduler-base.h
+ *
+ *  Common part of the flex-TTI RR, PF, MaxRate and MaxWeight schedulers
+ */
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_SCHEDULER_BASE_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_SCHEDULER_BASE_H_
+
+
+#include "mmwave-mac-sched-sap.h"
+#include "mmwave-mac-csched-sap.h"
+#include "mmwave-mac-scheduler.h"
+#include "mmwave-amc.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+
+namespace ns3 {
+
+/**
+ * \brief Bookkeeping and allocation shared by the flex-TTI schedulers: the
+ * per-UE slot table (DL and UL HARQ processes, wideband DL CQI, UL CQI,
+ * BSRs and IAB info), the RLC buffer requests, the IAB busy resources and
+ * the SAP plumbing.
+ *
+ * The scheduling of a TTI is done by the DoSchedTriggerReq template, which
+ * runs the steps common to all the schedulers (HARQ retransmissions, DCI
+ * creation, split around the IAB busy symbols, HARQ buffering) and leaves
+ * the ranking of the UEs to a policy object. A derived scheduler creates its
+ * SAP providers in its constructor and implements its ranking as a policy
+ * class, which is a template parameter so that the compiler can inline it
+ * in the skeleton.
+ */
+class MmWaveFlexTtiSchedulerBase : public MmWaveMacScheduler
+{
+public:
+	typedef std::vector < uint8_t > DlHarqProcessesStatus_t;
+	typedef std::vector < uint8_t > DlHarqProcessesTimer_t;
+	typedef std::vector < DciInfoElementTdma > DlHarqProcessesDciInfoList_t;
+	typedef std::vector < std::vector <struct RlcPduInfo> > DlHarqRlcPduList_t; // vector of the LCs per per UE HARQ process
+
+	typedef std::vector < uint8_t > UlHarqProcessesTimer_t;
+	typedef std::vector < DciInfoElementTdma > UlHarqProcessesDciInfoList_t;
+	typedef std::vector < uint8_t > UlHarqProcessesStatus_t;
+
+	MmWaveFlexTtiSchedulerBase ();
+
+	virtual ~MmWaveFlexTtiSchedulerBase ();
+	virtual void DoDispose (void);
+	static TypeId GetTypeId (void);
+
+	virtual void SetMacSchedSapUser (MmWaveMacSchedSapUser* sap);
+	virtual void SetMacCschedSapUser (MmWaveMacCschedSapUser* s);
+
+	virtual MmWaveMacSchedSapProvider* GetMacSchedSapProvider ();
+	virtual MmWaveMacCschedSapProvider* GetMacCschedSapProvider ();
+
+	virtual void SetMmWaveUeMacCschedSapProvider(MmWaveUeMacCschedSapProvider* sap);
+	virtual MmWaveUeMacCschedSapProvider* GetMmWaveUeMacCschedSapProvider();
+
+	virtual void ConfigureCommonParameters (Ptr<MmWavePhyMacCommon> config);
+
+	virtual void SetIabScheduler(bool iabScheduler);
+
+	static bool SortRlcBufferReq (MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters i, MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters j);
+
+	void RefreshDlCqiMaps (void);
+	void RefreshUlCqiMaps (void);
+
+	virtual void UpdateDlRlcBufferInfo (uint16_t rnti, uint8_t lcid, uint16_t size);
+	virtual void UpdateUlRlcBufferInfo (uint16_t rnti, uint16_t size);
+
+	friend class MemberMmWaveUeMacCschedSapProvider<MmWaveFlexTtiSchedulerBase>;
+
+protected:
+	/*
+	 * State of the TTI being scheduled, shared by the steps of DoSchedTriggerReq
+	 */
+	struct SchedTriggerState
+	{
+		MmWaveMacSchedSapUser::SchedConfigIndParameters m_ret;
+		SfnSf m_ulSfn;
+		int m_symAvail;       // number of free data symbols
+		uint8_t m_slotIdx;    // index of the next SlotAllocInfo
+		uint8_t m_symIdx;     // index of the first unassigned symbol
+	};
+
+	/*
+	 * A HARQ retransmission scheduled in the TTI
+	 */
+	struct HarqRetx
+	{
+		uint16_t m_rnti;
+		bool m_uplink;
+		uint8_t m_numSym;
+	};
+
+	/*
+	 * A new data grant decided by the ranking policy
+	 */
+	struct UeGrant
+	{
+		uint16_t m_rnti;
+		bool m_uplink;
+		uint8_t m_numSym;
+		uint8_t m_mcs;
+		std::vector <struct RlcPduInfo>* m_rlcPduInfo; // DL only, consumed by the allocation
+		bool m_splitEvenly;   // DL only, clip the PDUs to an even share of the TB
+	};
+
+	/**
+	 * \brief Schedule a TTI
+	 *
+	 * The RankingPolicy must provide
+	 *  - void NotifyRetx (const HarqRetx &retx), called for each HARQ
+	 *    retransmission scheduled in the TTI
+	 *  - void RankUes (SchedTriggerState &state, std::vector<UeGrant> &grants),
+	 *    which fills the new data grants in allocation order
+	 *  - void Reset (), called once the grants are allocated
+	 * @params the parameters of the trigger request
+	 * @params the ranking policy of the scheduler
+	 */
+	template <class RankingPolicy>
+	void DoSchedTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params, RankingPolicy &ranking);
+
+	/**
+	 * \brief Set up the subframe to schedule and the control symbols, and refresh the CQI and HARQ timers
+	 * @returns false if no data symbol is left, in which case the TTI is already finished
+	 */
+	bool StartSchedTrigger (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params, SchedTriggerState &state);
+	/**
+	 * \brief Get the number of subframes between a trigger request and the subframe it schedules
+	 * @returns the scheduling delay, which grows with the number of IAB devices downstream
+	 */
+	virtual uint32_t GetSchedulingDelay () const;
+	/**
+	 * \brief Process the HARQ feedback and schedule the retransmissions which fit in the TTI
+	 * @params the parameters of the trigger request
+	 * @params the state of the TTI
+	 * @params the retransmissions scheduled
+	 */
+	void ScheduleHarqRetx (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params, SchedTriggerState &state, std::vector<HarqRetx> &retx);
+	/**
+	 * \brief Find the first free symbols after a busy region for a HARQ retransmission, which cannot be split
+	 * @params the symbol index to start from, updated with the one found
+	 * @params the number of symbols of the retransmission
+	 * @returns true if the retransmission fits in the subframe
+	 */
+	bool FindRetxSymbols (uint8_t &symIdx, int numSymNeeded);
+	/**
+	 * \brief Create the DCIs of a grant, split around the busy symbols, and update the RLC buffers and the HARQ processes
+	 */
+	void AllocateDlGrant (SchedTriggerState &state, const UeGrant &grant);
+	void AllocateUlGrant (SchedTriggerState &state, const UeGrant &grant);
+	/**
+	 * \brief Distribute the TBs of a DL grant between the RLC PDUs of the UE
+	 * @params the grant
+	 * @params the slots created for the grant, whose PDU lists are filled
+	 * @params the sum of the TB sizes of the slots
+	 */
+	virtual void FillDlRlcPdus (const UeGrant &grant, std::vector<SlotAllocInfo> &slots, int totalTbSize);
+	/**
+	 * \brief Add the UL control symbol, sort the slots and send the scheduling result to the MAC
+	 */
+	void FinishSchedTrigger (SchedTriggerState &state);
+
+	unsigned CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize, unsigned &tbSize);
+
+	uint32_t
+	BsrId2BufferSize (uint8_t val)
+	{
+	  NS_ABORT_MSG_UNLESS (val < 64, "val = " << val << " is out of range");
+	  return BufferSizeLevelBsrTable[val];
+	}
+
+	uint8_t
+	BufferSize2BsrId (uint32_t val)
+	{
+	  int index = 0;
+	  if (BufferSizeLevelBsrTable[63] < val)
+	    {
+	      index = 63;
+	    }
+	  else
+	    {
+	      while (BufferSizeLevelBsrTable[index] < val)
+	        {
+	          NS_ASSERT (index < 64);
+	          index++;
+	        }
+	    }
+
+	  return (index);
+	}
+
+	uint8_t UpdateDlHarqProcessId (uint16_t rnti);
+	uint8_t UpdateUlHarqProcessId (uint16_t rnti);
+
+	/**
+	 * \brief Allocate the DL and UL HARQ processes of a UE, if not done yet
+	 */
+	void CreateUeHarqProcesses (uint16_t rnti);
+	/**
+	 * \brief Store the IAB capabilities of a reconfigured UE and update the scheduling delay
+	 */
+	void ConfigureIabInfo (const struct MmWaveMacCschedSapProvider::CschedUeConfigReqParameters& params);
+
+	//
+	// CSCHED and SCHED primitives which do not depend on the per-UE state of
+	// the derived scheduler
+	//
+
+	void DoCschedCellConfigReq (const struct MmWaveMacCschedSapProvider::CschedCellConfigReqParameters& params);
+
+	void DoCschedLcReleaseReq (const struct MmWaveMacCschedSapProvider::CschedLcReleaseReqParameters& params);
+
+	void DoCschedUeReleaseReq (const struct MmWaveMacCschedSapProvider::CschedUeReleaseReqParameters& params);
+
+	void DoSchedDlRlcBufferReq (const struct MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters& params);
+
+	void DoSchedDlCqiInfoReq (const MmWaveMacSchedSapProvider::SchedDlCqiInfoReqParameters& params);
+
+	void DoSchedUlCqiInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters& params);
+
+	void DoSchedUlMacCtrlInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters& params);
+
+	void DoSchedSetMcs (int mcs);
+
+	// implementations of the APIs for backhaul
+	void DoIabBackhaulSchedNotify(const struct MmWaveUeMacCschedSapProvider::IabBackhaulSchedInfo& info);
+	// IAB: get the number of IAB devices with active BSRs
+	uint16_t GetNumIabRnti();
+	// IAB get the number of available symbols before a busy region in a subframe
+	int GetNumFreeSymbols(uint8_t symIdx, int numSymNeeded);
+	// IAB get the index of the first available symbol after a busy region in a subframe
+	uint8_t GetFirstFreeSymbol(uint8_t symIdx, int numSymNeeded);
+	// IAB check if there is an overlapping with the already allocated resources
+	bool CheckOverlapWithBusyResources(uint8_t symIdx, int numSymNeeded);
+	// IAB print the subframe allocation mask
+	std::string PrintSubframeAllocationMask(const SymbolAllocationMask &mask);
+	// IAB update the number of available symbols considering IAB allocation
+	int UpdateBusySymbolsForIab(uint8_t sfNum, uint8_t symIdx, int symAvail);
+	// HARQ allocation: update the mask with busy resources
+	void UpdateResourceMask(uint8_t start, int numSymbols);
+  /**
+   * \brief Refresh HARQ processes according to the timers
+   *
+   */
+	void RefreshHarqProcesses ();
+
+	Ptr<MmWaveAmc> m_amc;
+
+	/*
+	 * Vectors of UE's RLC info
+	 */
+	std::list <MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters> m_rlcBufferReq;
+
+	uint32_t m_cqiTimersThreshold; // # of TTIs for which a CQI can be considered valid
+
+	/*
+	 * Per-UE state of the scheduler. Each field is stored in its own vector,
+	 * indexed by the slot of the UE, and m_ueSlot maps an RNTI to its slot.
+	 * A slot is allocated when the first field of a UE becomes valid and is
+	 * released (and later reused) when none is valid anymore.
+	 */
+	enum UeStateField
+	{
+		UE_WB_CQI = 1,      // m_wbCqi, m_wbCqiTimer
+		UE_UL_CQI = 2,      // m_ulCqi, m_ulCqiNumSym, m_ulCqiTbSize, m_ulCqiTimer
+		UE_BSR = 4,         // m_ceBsr
+		UE_HARQ = 8,        // DL and UL HARQ processes
+		UE_IAB_INFO = 16    // m_iabInfo
+	};
+	static const uint32_t NO_UE_SLOT = 0xFFFFFFFF;
+
+	/**
+	 * \brief Get the slot of a UE
+	 * @params the RNTI of the UE
+	 * @params the UeStateField flags that must be valid for the UE
+	 * @returns the slot, or NO_UE_SLOT if the UE is unknown or lacks one of the fields
+	 */
+	uint32_t FindUeSlot (uint16_t rnti, uint8_t fields) const;
+	/**
+	 * \brief Mark a field of a UE as valid, allocating a slot to the UE if needed
+	 * @params the RNTI of the UE
+	 * @params the UeStateField flag
+	 * @returns the slot of the UE
+	 */
+	uint32_t AddUeField (uint16_t rnti, uint8_t field);
+	/**
+	 * \brief Invalidate fields of a UE, releasing its slot if no field is left
+	 * @params the slot of the UE
+	 * @params the UeStateField flags
+	 */
+	void RemoveUeFields (uint32_t slot, uint8_t fields);
+	/**
+	 * @params the UeStateField flags
+	 * @returns the number of UEs for which all the fields are valid
+	 */
+	uint32_t GetNumUes (uint8_t fields) const;
+
+	std::vector <uint32_t> m_ueSlot;              // slot of each RNTI
+	std::vector <uint32_t> m_freeUeSlots;
+	std::vector <uint16_t> m_ueRnti;              // RNTI of each slot
+	std::vector <uint8_t> m_ueFields;             // valid UeStateField flags of each slot
+
+	std::vector <uint8_t> m_wbCqi;                // DL CQI WB received
+	std::vector <uint32_t> m_wbCqiTimer;          // timers on DL CQI WB received
+
+	std::vector <std::vector <double> > m_ulCqi;  // UL-CQI per chunk
+	std::vector <uint8_t> m_ulCqiNumSym;
+	std::vector <uint32_t> m_ulCqiTbSize;
+	std::vector <uint32_t> m_ulCqiTimer;          // timers on UL-CQI
+
+	std::vector <uint32_t> m_ceBsr;               // buffer status reports received
+
+	std::vector <IabInfo_t> m_iabInfo;
+
+	uint64_t m_nextRntiDl;
+	uint64_t m_nextRntiUl;
+
+	uint8_t m_tbUid;
+	uint32_t m_numDataSymbols;
+
+	MmWaveMacSchedSapProvider* m_macSchedSapProvider;
+	MmWaveMacSchedSapUser* m_macSchedSapUser;
+	MmWaveMacCschedSapUser* m_macCschedSapUser;
+	MmWaveMacCschedSapProvider* m_macCschedSapProvider;
+	// for backhaul purposes
+	MmWaveUeMacCschedSapProvider* m_iabBackahulSapProvider;
+
+	MmWaveMacCschedSapProvider::CschedCellConfigReqParameters m_cschedCellConfig;
+
+	struct AllocMapElem
+	{
+		AllocMapElem (std::vector<uint16_t> rntiMap, uint8_t nSym, uint32_t tbs) :
+			m_rntiPerChunk (rntiMap), m_numSym (nSym), m_tbSize (tbs)
+		{
+		}
+
+		std::vector <uint16_t> m_rntiPerChunk;
+		uint8_t m_numSym;
+		uint32_t m_tbSize;
+	};
+	/*
+	 * Map of previous allocated UE per RBG
+	 * (used to retrieve info from UL-CQI)
+	 */
+	std::map <uint32_t, struct AllocMapElem> m_ulAllocationMap;
+
+	// HARQ attributes
+	/**
+	 * m_harqOn when false inhibit te HARQ mechanisms (by default active)
+	 */
+	bool m_harqOn;
+	bool m_dlSlotsFirst;  // with HARQ, insert the new DL slots before the UL retransmissions
+	uint8_t m_numHarqProcess;
+	uint8_t m_harqTimeout;
+
+	// HARQ processes of each UE, indexed by its slot
+	//HARQ status
+	// 0: process Id available
+	// x>0: process Id equal to `x` trasmission count
+	std::vector <DlHarqProcessesStatus_t> m_dlHarqProcessesStatus;
+	std::vector <DlHarqProcessesTimer_t> m_dlHarqProcessesTimer;
+	std::vector <DlHarqProcessesDciInfoList_t> m_dlHarqProcessesDciInfo;
+	std::vector <DlHarqRlcPduList_t> m_dlHarqProcessesRlcPdu;
+	std::vector <DlHarqInfo> m_dlHarqInfoList; // HARQ retx buffered
+	std::vector <UlHarqInfo> m_ulHarqInfoList; // HARQ retx buffered
+
+	std::vector <UlHarqProcessesStatus_t> m_ulHarqProcessesStatus;
+	std::vector <UlHarqProcessesTimer_t> m_ulHarqProcessesTimer;
+	std::vector <UlHarqProcessesDciInfoList_t> m_ulHarqProcessesDciInfo;
+
+	// needed to keep track of uplink allocations in later slots
+	std::list <struct SfAllocInfo> m_ulSfAllocInfo;
+
+	static const unsigned m_macHdrSize;
+	static const unsigned m_subHdrSize;
+	static const unsigned m_rlcHdrSize;
+
+	static const double m_berDl;
+	bool m_fixedMcsDl;
+	bool m_fixedMcsUl;
+	uint8_t m_mcsDefaultDl;
+	uint8_t m_mcsDefaultUl;
+
+	bool m_dlOnly;
+	bool m_ulOnly; //for testing
+
+	bool m_fixedTti;		// one slot per TTI
+	uint8_t	m_symPerSlot; // symbols per slot
+
+	uint32_t m_maxSchedulingDelay; // scheduling delay (replaces MmWavePhyMacCommon GetUlSchedDelay)
+								   // and is updated every time a new IAB device connects
+	bool m_iabScheduler;
+	bool m_split;
+	SfIabAllocInfo m_busyResourcesSchedSubframe;
+	std::vector<SfIabAllocInfo> m_iabBusySubframeAllocation;  // vector with IAB allocation info. By default, 10 elements
+	                                                          // are stored in the vector corresponding to 10 subframes.
+};
+
+template <class RankingPolicy>
+void
+MmWaveFlexTtiSchedulerBase::DoSchedTriggerReq (const struct MmWaveMacSchedSapProvider::SchedTriggerReqParameters& params, RankingPolicy &ranking)
+{
+	SchedTriggerState state;
+	if (!StartSchedTrigger (params, state))
+	{
+		return;
+	}
+
+	std::vector<HarqRetx> retx;
+	ScheduleHarqRetx (params, state, retx);
+	for (unsigned i = 0; i < retx.size (); i++)
+	{
+		ranking.NotifyRetx (retx[i]);
+	}
+
+	std::vector<UeGrant> grants;
+	ranking.RankUes (state, grants);
+
+	// create the DCIs in the order of the grants, skipping the busy symbols
+	NS_ASSERT (state.m_symIdx > 0);
+	for (unsigned i = 0; i < grants.size (); i++)
+	{
+		if (grants[i].m_uplink)
+		{
+			AllocateUlGrant (state, grants[i]);
+		}
+		else
+		{
+			AllocateDlGrant (state, grants[i]);
+		}
+	}
+
+	// reset the alloc info for the next scheduler call
+	ranking.Reset ();
+
+	FinishSchedTrigger (state);
+}
+
+}
+
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_SCHEDULER_BASE_H_ */
@@ -97,6 +97,10 @@ namespace ns3 {
 			   PointerValue (),
 			   MakePointerAccessor (&MmWaveIabNetDevice::m_scheduler),
 			   MakePointerChecker <MmWaveMacScheduler> ())
+	    .AddTraceSource ("BackhaulTargetEnb",
+			   "The backhaul was attached to a gNB or an IAB node",
+			   MakeTraceSourceAccessor (&MmWaveIabNetDevice::m_backhaulTargetEnbTrace),
+			   "ns3::MmWaveIabNetDevice::BackhaulTargetEnbTracedCallback")
 	    ;
         //;
 
@@ -404,6 +408,7 @@ void
 MmWaveIabNetDevice::SetBackhaulTargetEnb (Ptr<NetDevice> enb)
 {
 	m_donorEnb = enb;
+	m_backhaulTargetEnbTrace (m_cellId, enb);
 }
 
 Ptr<NetDevice> 
@@ -128,6 +128,15 @@ namespace ns3 {
 
 	Ptr<NetDevice> GetBackhaulTargetEnb (void);
 
+	/**
+	 * TracedCallback signature for the attachment of the backhaul.
+	 *
+	 * \param [in] cellId the cell of the IAB node in the access
+	 * \param [in] enb the gNB or IAB node the backhaul is attached to
+	 */
+	typedef void (* BackhaulTargetEnbTracedCallback)
+	  (const uint16_t cellId, const Ptr<NetDevice> enb);
+
         void SetBackhaulAntennaNum (uint16_t antennaNum);
 
         uint16_t GetBackhaulAntennaNum () const;
@@ -174,6 +183,7 @@ namespace ns3 {
 	Ptr<MmWaveUeMac> m_backhaulMac;
 	Ptr<LteUeRrc> m_backhaulRrc;
 	uint16_t m_backhaulAntennaNum;
+	TracedCallback<uint16_t, Ptr<NetDevice> > m_backhaulTargetEnbTrace;
 
 	// Access
 	Ptr<MmWaveEnbPhy> m_accessPhy;
@@ -0,0 +1,193 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MMWAVE_INDEXED_HEAP_H_
+#define MMWAVE_INDEXED_HEAP_H_
+
+#include <ns3/assert.h>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3{
+
+/**
+ * \brief Binary max-heap of the ids 0..N-1, each with a double key, which
+ * keeps the position of every id so that its key can be changed in place.
+ *
+ * Push, Pop and Update are O(log N) and Top is O(1). Among equal keys the
+ * smallest id is on top, so the order of extraction is deterministic.
+ * The storage is kept across Clear, so a heap rebuilt every TTI does not
+ * allocate once it has reached its largest size.
+ */
+class MmWaveIndexedHeap
+{
+public:
+	bool IsEmpty () const
+	{
+		return m_heap.empty ();
+	}
+
+	uint32_t GetSize () const
+	{
+		return m_heap.size ();
+	}
+
+	/**
+	 * Remove all the ids
+	 */
+	void Clear ()
+	{
+		for (uint32_t i = 0; i < m_heap.size (); i++)
+		{
+			m_pos[m_heap[i]] = NOT_IN_HEAP;
+		}
+		m_heap.clear ();
+	}
+
+	bool Contains (uint32_t id) const
+	{
+		return id < m_pos.size () && m_pos[id] != NOT_IN_HEAP;
+	}
+
+	/**
+	 * Insert an id which is not in the heap
+	 * @params the id
+	 * @params its key
+	 */
+	void Push (uint32_t id, double key)
+	{
+		if (id >= m_pos.size ())
+		{
+			m_pos.resize (id + 1, static_cast<uint32_t> (NOT_IN_HEAP));
+			m_key.resize (id + 1);
+		}
+		NS_ASSERT (m_pos[id] == NOT_IN_HEAP);
+		m_key[id] = key;
+		m_pos[id] = m_heap.size ();
+		m_heap.push_back (id);
+		SiftUp (m_pos[id]);
+	}
+
+	/**
+	 * @returns the id with the largest key
+	 */
+	uint32_t Top () const
+	{
+		NS_ASSERT (!m_heap.empty ());
+		return m_heap[0];
+	}
+
+	/**
+	 * Remove the id with the largest key
+	 */
+	void Pop ()
+	{
+		NS_ASSERT (!m_heap.empty ());
+		m_pos[m_heap[0]] = NOT_IN_HEAP;
+		uint32_t last = m_heap.back ();
+		m_heap.pop_back ();
+		if (!m_heap.empty ())
+		{
+			m_heap[0] = last;
+			m_pos[last] = 0;
+			SiftDown (0);
+		}
+	}
+
+	/**
+	 * Change the key of an id in the heap, moving it up or down as needed
+	 * @params the id
+	 * @params its new key
+	 */
+	void Update (uint32_t id, double key)
+	{
+		NS_ASSERT (Contains (id));
+		double oldKey = m_key[id];
+		m_key[id] = key;
+		if (key > oldKey)
+		{
+			SiftUp (m_pos[id]);
+		}
+		else
+		{
+			SiftDown (m_pos[id]);
+		}
+	}
+
+private:
+	static const uint32_t NOT_IN_HEAP = 0xFFFFFFFF;
+
+	bool Before (uint32_t a, uint32_t b) const
+	{
+		return m_key[a] > m_key[b] || (m_key[a] == m_key[b] && a < b);
+	}
+
+	void Place (uint32_t pos, uint32_t id)
+	{
+		m_heap[pos] = id;
+		m_pos[id] = pos;
+	}
+
+	void SiftUp (uint32_t pos)
+	{
+		uint32_t id = m_heap[pos];
+		while (pos > 0)
+		{
+			uint32_t parent = (pos - 1) / 2;
+			if (!Before (id, m_heap[parent]))
+			{
+				break;
+			}
+			Place (pos, m_heap[parent]);
+			pos = parent;
+		}
+		Place (pos, id);
+	}
+
+	void SiftDown (uint32_t pos)
+	{
+		uint32_t id = m_heap[pos];
+		uint32_t size = m_heap.size ();
+		while (2 * pos + 1 < size)
+		{
+			uint32_t child = 2 * pos + 1;
+			if (child + 1 < size && Before (m_heap[child + 1], m_heap[child]))
+			{
+				child++;
+			}
+			if (!Before (m_heap[child], id))
+			{
+				break;
+			}
+			Place (pos, m_heap[child]);
+			pos = child;
+		}
+		Place (pos, id);
+	}
+
+	std::vector<uint32_t> m_heap;	// ids in heap order
+	std::vector<uint32_t> m_pos;	// position of each id in m_heap, NOT_IN_HEAP if absent
+	std::vector<double> m_key;		// key of each id
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_INDEXED_HEAP_H_ */
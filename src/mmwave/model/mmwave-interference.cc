@@ -61,6 +61,9 @@ namespace ns3 {
         m_rxSignal = 0;
         m_allSignals = 0;
         m_noise = 0;
+        m_sinr = 0;
+        m_endingSignals.clear ();
+        m_freeEndingLists.clear ();
         Object::DoDispose ();
     }
 
@@ -80,7 +83,15 @@ namespace ns3 {
         if (m_receiving == false)
         {
 	    NS_LOG_LOGIC ("first signal");
-	    m_rxSignal = rxPsd->Copy ();
+	    if (m_rxSignal != 0 && m_rxSignal->GetSpectrumModel () == rxPsd->GetSpectrumModel ())
+	    {
+	        // reuse the buffer of the previous reception
+	        *m_rxSignal = *rxPsd;
+	    }
+	    else
+	    {
+	        m_rxSignal = rxPsd->Copy ();
+	    }
 	    m_lastChangeTime = Now ();
 	    m_receiving = true;
 	    for (std::list<Ptr<MmWaveChunkProcessor> >::const_iterator it = m_PowerChunkProcessorList.begin (); it != m_PowerChunkProcessorList.end (); ++it)
@@ -142,7 +153,23 @@ namespace ns3 {
 	    m_lastSignalIdBeforeReset += 0x10000000;
         }
 	// When the new signal expires, it has to be substracted from "m_allSignals".
-        Simulator::Schedule (duration, &mmWaveInterference::DoSubtractSignal, this, spd, signalId);
+	// All the signals ending at the same time are subtracted by the same event.
+	Time endTime = Now () + duration;
+	std::map<Time, std::vector<EndingSignal> >::iterator it = m_endingSignals.find (endTime);
+	if (it == m_endingSignals.end ())
+	{
+	    it = m_endingSignals.insert (std::make_pair (endTime, std::vector<EndingSignal> ())).first;
+	    if (!m_freeEndingLists.empty ())
+	    {
+	        it->second.swap (m_freeEndingLists.back ());
+	        m_freeEndingLists.pop_back ();
+	    }
+	    Simulator::Schedule (duration, &mmWaveInterference::DoSubtractEndedSignals, this);
+	}
+	EndingSignal signal;
+	signal.m_spd = spd;
+	signal.m_signalId = signalId;
+	it->second.push_back (signal);
     }
 
     void
@@ -169,6 +196,22 @@ namespace ns3 {
         }
     }
 
+    void
+    mmWaveInterference::DoSubtractEndedSignals ()
+    {
+        NS_LOG_FUNCTION (this);
+        std::map<Time, std::vector<EndingSignal> >::iterator it = m_endingSignals.find (Now ());
+        NS_ASSERT (it != m_endingSignals.end ());
+        for (std::vector<EndingSignal>::const_iterator signal = it->second.begin (); signal != it->second.end (); ++signal)
+        {
+	    DoSubtractSignal (signal->m_spd, signal->m_signalId);
+        }
+        it->second.clear ();
+        m_freeEndingLists.push_back (std::vector<EndingSignal> ());
+        m_freeEndingLists.back ().swap (it->second);
+        m_endingSignals.erase (it);
+    }
+
     void
     mmWaveInterference::ConditionallyEvaluateChunk ()
     {
@@ -181,8 +224,21 @@ namespace ns3 {
         if (m_receiving && (Now () > m_lastChangeTime))
         {
 	    NS_LOG_LOGIC (this << " signal = " << *m_rxSignal << " allSignals = " << *m_allSignals << " noise = " << *m_noise);
-	    SpectrumValue interf =  (*m_allSignals) - (*m_rxSignal) + (*m_noise);
-	    SpectrumValue sinr = (*m_rxSignal) / interf;
+	    // sinr = signal / (allSignals - signal + noise), in a single pass over the preallocated buffer
+	    if (m_sinr == 0 || m_sinr->GetSpectrumModel () != m_rxSignal->GetSpectrumModel ())
+	    {
+	        m_sinr = Create<SpectrumValue> (m_rxSignal->GetSpectrumModel ());
+	    }
+	    NS_ASSERT (m_allSignals->GetSpectrumModel () == m_rxSignal->GetSpectrumModel ()
+	               && m_noise->GetSpectrumModel () == m_rxSignal->GetSpectrumModel ());
+	    Values::const_iterator signalIt = m_rxSignal->ConstValuesBegin ();
+	    Values::const_iterator allIt = m_allSignals->ConstValuesBegin ();
+	    Values::const_iterator noiseIt = m_noise->ConstValuesBegin ();
+	    for (Values::iterator sinrIt = m_sinr->ValuesBegin (); sinrIt != m_sinr->ValuesEnd (); ++sinrIt, ++signalIt, ++allIt, ++noiseIt)
+	    {
+	        *sinrIt = *signalIt / ((*allIt - *signalIt) + *noiseIt);
+	    }
+	    const SpectrumValue &sinr = *m_sinr;
 	    Time duration = Now () - m_lastChangeTime;
 	    for (std::list<Ptr<MmWaveChunkProcessor> >::const_iterator it = m_PowerChunkProcessorList.begin (); it != m_PowerChunkProcessorList.end (); ++it)
 	    {
@@ -36,6 +36,8 @@
 #include <ns3/spectrum-value.h>
 #include <string.h>
 #include <ns3/mmwave-chunk-processor.h>
+#include <map>
+#include <vector>
 
 
 namespace ns3 {
@@ -93,6 +95,20 @@ namespace ns3 {
 	 * @param signalId the id of the new signal
          */
 	void DoSubtractSignal  (Ptr<const SpectrumValue> spd, uint32_t signalId);
+        /**
+         * Removes all the signals ending at the current time, in the order
+         * in which they were added.
+         */
+	void DoSubtractEndedSignals ();
+
+        /**
+         * A signal to be subtracted from m_allSignals when it ends
+         */
+        struct EndingSignal
+        {
+	  Ptr<const SpectrumValue> m_spd;
+	  uint32_t m_signalId;
+        };
         
 	std::list<Ptr<MmWaveChunkProcessor> > m_PowerChunkProcessorList;
         std::list<Ptr<MmWaveChunkProcessor> > m_sinrChunkProcessorList;
@@ -113,6 +129,14 @@ namespace ns3 {
 
         uint32_t m_lastSignalId;
         uint32_t m_lastSignalIdBeforeReset;
+
+        /**
+         * Signals grouped by end time: a single event subtracts all the
+         * signals ending at the same time, e.g., at a slot boundary
+         */
+        std::map<Time, std::vector<EndingSignal> > m_endingSignals;
+        std::vector<std::vector<EndingSignal> > m_freeEndingLists;  //!< cleared lists, reused to avoid allocations
+        Ptr<SpectrumValue> m_sinr;  //!< buffer of the SINR of the last chunk
     };
 
 } // namespace ns3
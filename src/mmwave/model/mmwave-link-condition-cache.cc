@@ -0,0 +1,134 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "mmwave-link-condition-cache.h"
+#include <ns3/log.h>
+#include <ns3/callback.h>
+
+namespace ns3{
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveLinkConditionCache");
+
+MmWaveLinkConditionCache::MmWaveLinkConditionCache ()
+	: m_updateDistance (0)
+{
+}
+
+MmWaveLinkConditionCache::~MmWaveLinkConditionCache ()
+{
+	Clear ();
+}
+
+void
+MmWaveLinkConditionCache::SetUpdateDistance (double distance)
+{
+	m_updateDistance = distance;
+	m_links.clear ();
+}
+
+double
+MmWaveLinkConditionCache::GetUpdateDistance () const
+{
+	return m_updateDistance;
+}
+
+bool
+MmWaveLinkConditionCache::Lookup (Ptr<MobilityModel> a, Ptr<MobilityModel> b, bool &los)
+{
+	if (PeekPointer (b) < PeekPointer (a))
+	{
+		std::swap (a, b);
+	}
+	std::map<LinkKey, LinkEntry>::const_iterator it = m_links.find (std::make_pair (a, b));
+	if (it == m_links.end ())
+	{
+		return false;
+	}
+	const LinkEntry &entry = it->second;
+	if (entry.m_courseChangesFirst != m_courseChanges[a] || entry.m_courseChangesSecond != m_courseChanges[b])
+	{
+		NS_LOG_LOGIC ("Course change of " << a << " or " << b);
+		return false;
+	}
+	if (IsMoved (entry.m_positionFirst, a->GetPosition ()) || IsMoved (entry.m_positionSecond, b->GetPosition ()))
+	{
+		NS_LOG_LOGIC ("Link between " << a << " and " << b << " moved");
+		return false;
+	}
+	los = entry.m_los;
+	return true;
+}
+
+void
+MmWaveLinkConditionCache::Store (Ptr<MobilityModel> a, Ptr<MobilityModel> b, bool los)
+{
+	if (PeekPointer (b) < PeekPointer (a))
+	{
+		std::swap (a, b);
+	}
+	LinkEntry &entry = m_links[std::make_pair (a, b)];
+	entry.m_positionFirst = a->GetPosition ();
+	entry.m_positionSecond = b->GetPosition ();
+	entry.m_courseChangesFirst = GetCourseChanges (a);
+	entry.m_courseChangesSecond = GetCourseChanges (b);
+	entry.m_los = los;
+}
+
+void
+MmWaveLinkConditionCache::Clear ()
+{
+	for (std::map<Ptr<MobilityModel>, uint32_t>::iterator it = m_courseChanges.begin (); it != m_courseChanges.end (); ++it)
+	{
+		it->first->TraceDisconnectWithoutContext ("CourseChange",
+				MakeCallback (&MmWaveLinkConditionCache::NotifyCourseChange, this));
+	}
+	m_courseChanges.clear ();
+	m_links.clear ();
+}
+
+bool
+MmWaveLinkConditionCache::IsMoved (const Vector &stored, const Vector &current) const
+{
+	if (m_updateDistance == 0)
+	{
+		return stored.x != current.x || stored.y != current.y || stored.z != current.z;
+	}
+	return CalculateDistance (stored, current) > m_updateDistance;
+}
+
+uint32_t
+MmWaveLinkConditionCache::GetCourseChanges (Ptr<MobilityModel> mobility)
+{
+	std::map<Ptr<MobilityModel>, uint32_t>::iterator it = m_courseChanges.find (mobility);
+	if (it == m_courseChanges.end ())
+	{
+		mobility->TraceConnectWithoutContext ("CourseChange",
+				MakeCallback (&MmWaveLinkConditionCache::NotifyCourseChange, this));
+		it = m_courseChanges.insert (std::make_pair (mobility, 0)).first;
+	}
+	return it->second;
+}
+
+void
+MmWaveLinkConditionCache::NotifyCourseChange (Ptr<const MobilityModel> mobility)
+{
+	m_courseChanges[ConstCast<MobilityModel> (mobility)]++;
+}
+
+}  //namespace ns3
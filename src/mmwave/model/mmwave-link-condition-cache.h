@@ -0,0 +1,98 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MMWAVE_LINK_CONDITION_CACHE_H_
+#define MMWAVE_LINK_CONDITION_CACHE_H_
+
+#include <ns3/mobility-model.h>
+#include <ns3/vector.h>
+#include <map>
+#include <stdint.h>
+
+namespace ns3{
+
+/**
+ * \brief LOS/NLOS state of the links between pairs of mobility models,
+ * stored together with the positions of the two ends when it was computed.
+ *
+ * The state of a link is reused until one of its ends moves more than the
+ * update distance from its stored position, or fires its CourseChange
+ * trace. The links are reciprocal, so (a,b) and (b,a) share one entry.
+ * With the default update distance of 0, any displacement invalidates the
+ * entry, so that a geometric LOS test gives the same decision whether or
+ * not it is cached, and only the links whose ends are static (e.g., the IAB
+ * backhaul) are served from the cache.
+ */
+class MmWaveLinkConditionCache
+{
+public:
+	MmWaveLinkConditionCache ();
+	~MmWaveLinkConditionCache ();
+
+	/**
+	 * @params distance [m] an end can move before its links are recomputed
+	 */
+	void SetUpdateDistance (double distance);
+	double GetUpdateDistance () const;
+
+	/**
+	 * Get the stored state of a link, if it is still valid
+	 * @params first end of the link
+	 * @params second end of the link
+	 * @params set to whether the link is LOS
+	 * @returns false if the state must be computed and stored again
+	 */
+	bool Lookup (Ptr<MobilityModel> a, Ptr<MobilityModel> b, bool &los);
+
+	/**
+	 * Store the state of a link for the current positions of its ends
+	 */
+	void Store (Ptr<MobilityModel> a, Ptr<MobilityModel> b, bool los);
+
+	/**
+	 * Drop all the links and disconnect from the CourseChange traces
+	 */
+	void Clear ();
+
+private:
+	typedef std::pair<Ptr<MobilityModel>, Ptr<MobilityModel> > LinkKey;
+
+	struct LinkEntry
+	{
+		Vector m_positionFirst;
+		Vector m_positionSecond;
+		uint32_t m_courseChangesFirst;		// course changes of the ends when the state was stored
+		uint32_t m_courseChangesSecond;
+		bool m_los;
+	};
+
+	bool IsMoved (const Vector &stored, const Vector &current) const;
+	uint32_t GetCourseChanges (Ptr<MobilityModel> mobility);
+	void NotifyCourseChange (Ptr<const MobilityModel> mobility);
+
+	double m_updateDistance;
+	std::map<LinkKey, LinkEntry> m_links;		// keyed with the lower pointer first
+	std::map<Ptr<MobilityModel>, uint32_t> m_courseChanges;	// ends connected to the CourseChange trace
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_LINK_CONDITION_CACHE_H_ */
@@ -0,0 +1,132 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+
+
+#include "mmwave-link-table.h"
+#include <ns3/assert.h>
+#include <algorithm>
+
+namespace ns3{
+
+const uint32_t LinkIndex::NO_LINK;
+
+LinkIndex::LinkIndex ()
+{
+}
+
+uint64_t
+LinkIndex::GetPairKey (uint32_t id1, uint32_t id2)
+{
+	return id1 < id2 ? (uint64_t (id1) << 32) | id2 : (uint64_t (id2) << 32) | id1;
+}
+
+uint32_t
+LinkIndex::GetDeviceId (const Ptr<NetDevice> &dev)
+{
+	std::unordered_map<const NetDevice*, uint32_t>::iterator it = m_deviceId.find (PeekPointer (dev));
+	if (it != m_deviceId.end ())
+	{
+		return it->second;
+	}
+	uint32_t id = m_devices.size ();
+	m_deviceId.insert (std::make_pair (PeekPointer (dev), id));
+	m_devices.push_back (dev);
+	return id;
+}
+
+uint32_t
+LinkIndex::FindDeviceId (const Ptr<NetDevice> &dev) const
+{
+	std::unordered_map<const NetDevice*, uint32_t>::const_iterator it = m_deviceId.find (PeekPointer (dev));
+	if (it != m_deviceId.end ())
+	{
+		return it->second;
+	}
+	return NO_LINK;
+}
+
+uint32_t
+LinkIndex::GetLinkId (const Ptr<NetDevice> &tx, const Ptr<NetDevice> &rx)
+{
+	uint32_t txId = GetDeviceId (tx);
+	uint32_t rxId = GetDeviceId (rx);
+	uint64_t key = GetPairKey (txId, rxId);
+	uint32_t pair;
+	std::unordered_map<uint64_t, uint32_t>::iterator it = m_pairId.find (key);
+	if (it != m_pairId.end ())
+	{
+		pair = it->second;
+	}
+	else
+	{
+		pair = m_pairDevices.size ();
+		NS_ASSERT_MSG (pair < NO_LINK / 2, "too many links");
+		m_pairId.insert (std::make_pair (key, pair));
+		m_pairDevices.push_back (std::make_pair (std::min (txId, rxId), std::max (txId, rxId)));
+	}
+	// the direction from the lower to the higher device identifier is the even one
+	return 2 * pair + (txId > rxId ? 1 : 0);
+}
+
+uint32_t
+LinkIndex::FindLinkId (const Ptr<NetDevice> &tx, const Ptr<NetDevice> &rx) const
+{
+	uint32_t txId = FindDeviceId (tx);
+	uint32_t rxId = FindDeviceId (rx);
+	if (txId == NO_LINK || rxId == NO_LINK)
+	{
+		return NO_LINK;
+	}
+	std::unordered_map<uint64_t, uint32_t>::const_iterator it = m_pairId.find (GetPairKey (txId, rxId));
+	if (it == m_pairId.end ())
+	{
+		return NO_LINK;
+	}
+	return 2 * it->second + (txId > rxId ? 1 : 0);
+}
+
+uint32_t
+LinkIndex::GetNLinks () const
+{
+	return 2 * m_pairDevices.size ();
+}
+
+Ptr<NetDevice>
+LinkIndex::GetTxDevice (uint32_t linkId) const
+{
+	NS_ASSERT (linkId < GetNLinks ());
+	const std::pair<uint32_t, uint32_t> &devices = m_pairDevices[linkId / 2];
+	return m_devices[(linkId & 1) ? devices.second : devices.first];
+}
+
+Ptr<NetDevice>
+LinkIndex::GetRxDevice (uint32_t linkId) const
+{
+	NS_ASSERT (linkId < GetNLinks ());
+	const std::pair<uint32_t, uint32_t> &devices = m_pairDevices[linkId / 2];
+	return m_devices[(linkId & 1) ? devices.first : devices.second];
+}
+
+}  //namespace ns3
@@ -0,0 +1,162 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+
+
+#ifndef MMWAVE_LINK_TABLE_H_
+#define MMWAVE_LINK_TABLE_H_
+
+#include <ns3/ptr.h>
+#include <ns3/net-device.h>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+namespace ns3{
+
+/**
+ * Assigns a dense identifier to every directed link (tx device, rx device) seen by a
+ * channel model. The two directions of a link get adjacent identifiers, so that the
+ * reverse link is obtained without any lookup. The identifiers are never released.
+ */
+class LinkIndex
+{
+public:
+	static const uint32_t NO_LINK = 0xffffffff;
+
+	LinkIndex ();
+
+	/**
+	 * Get the identifier of a link, assigning a new one if the link was never seen before
+	 * @params the transmitting device
+	 * @params the receiving device
+	 * @returns the link identifier
+	 */
+	uint32_t GetLinkId (const Ptr<NetDevice> &tx, const Ptr<NetDevice> &rx);
+
+	/**
+	 * Get the identifier of a link
+	 * @params the transmitting device
+	 * @params the receiving device
+	 * @returns the link identifier, or NO_LINK if the link was never seen before
+	 */
+	uint32_t FindLinkId (const Ptr<NetDevice> &tx, const Ptr<NetDevice> &rx) const;
+
+	/**
+	 * @params a link identifier
+	 * @returns the identifier of the same link in the opposite direction
+	 */
+	static uint32_t GetReverseLinkId (uint32_t linkId)
+	{
+		return linkId ^ 1;
+	}
+
+	/**
+	 * @returns the number of identifiers assigned so far, i.e., an upper bound for all of them
+	 */
+	uint32_t GetNLinks () const;
+
+	Ptr<NetDevice> GetTxDevice (uint32_t linkId) const;
+	Ptr<NetDevice> GetRxDevice (uint32_t linkId) const;
+
+private:
+	uint32_t GetDeviceId (const Ptr<NetDevice> &dev);
+	uint32_t FindDeviceId (const Ptr<NetDevice> &dev) const;
+	static uint64_t GetPairKey (uint32_t id1, uint32_t id2);
+
+	std::unordered_map<const NetDevice*, uint32_t> m_deviceId;
+	std::vector< Ptr<NetDevice> > m_devices; // device of each device identifier
+	std::unordered_map<uint64_t, uint32_t> m_pairId; // (lower, higher) device identifiers -> pair
+	std::vector< std::pair<uint32_t, uint32_t> > m_pairDevices; // (lower, higher) device identifiers of each pair
+};
+
+/**
+ * Flat array of per-link values indexed by the identifiers of a LinkIndex.
+ * The pointers returned by Find are invalidated by Insert.
+ */
+template <class T>
+class LinkTable
+{
+public:
+	/**
+	 * @params a link identifier, possibly NO_LINK
+	 * @returns a pointer to the value of the link, or 0 if the link has no value
+	 */
+	T* Find (uint32_t linkId)
+	{
+		if (linkId < m_present.size () && m_present[linkId])
+		{
+			return &m_values[linkId];
+		}
+		return 0;
+	}
+
+	const T* Find (uint32_t linkId) const
+	{
+		if (linkId < m_present.size () && m_present[linkId])
+		{
+			return &m_values[linkId];
+		}
+		return 0;
+	}
+
+	/**
+	 * @params a link identifier
+	 * @returns the value of the link, which is default-constructed if not present
+	 */
+	T& operator[] (uint32_t linkId)
+	{
+		if (linkId >= m_present.size ())
+		{
+			m_values.resize (linkId + 1);
+			m_present.resize (linkId + 1, false);
+		}
+		m_present[linkId] = true;
+		return m_values[linkId];
+	}
+
+	void Erase (uint32_t linkId)
+	{
+		if (linkId < m_present.size () && m_present[linkId])
+		{
+			m_values[linkId] = T ();
+			m_present[linkId] = false;
+		}
+	}
+
+	void Clear ()
+	{
+		m_values.clear ();
+		m_present.clear ();
+	}
+
+private:
+	std::vector<T> m_values;
+	std::vector<bool> m_present;
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_LINK_TABLE_H_ */
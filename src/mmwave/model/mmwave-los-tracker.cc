@@ -37,6 +37,7 @@
 #include "ns3/mobility-model.h"
 #include <ns3/mobility-building-info.h>
 #include <ns3/building-list.h>
+#include "mmwave-buildings-index.h"
 #include <ns3/angles.h>
 #include "ns3/config-store.h"
 #include <utility>
@@ -59,6 +60,13 @@ MmWaveLosTracker::GetTypeId (void)
 {
 	static TypeId tid = TypeId("ns3::MmWaveLosTracker")
 	.SetParent<Object>()
+	.AddAttribute ("UpdateDistance",
+				"Distance [m] a node can move before the los/nlos condition of its links is updated, "
+				"0 to update it at any movement",
+				DoubleValue (0),
+				MakeDoubleAccessor (&MmWaveLosTracker::SetUpdateDistance,
+									&MmWaveLosTracker::GetUpdateDistance),
+				MakeDoubleChecker<double> (0))
 	;
 
 	return tid;
@@ -70,6 +78,37 @@ MmWaveLosTracker::~MmWaveLosTracker ()
 
 }
 
+void
+MmWaveLosTracker::DoDispose ()
+{
+	m_linkCache.Clear ();
+	Object::DoDispose ();
+}
+
+void
+MmWaveLosTracker::SetUpdateDistance (double distance)
+{
+	m_linkCache.SetUpdateDistance (distance);
+}
+
+double
+MmWaveLosTracker::GetUpdateDistance () const
+{
+	return m_linkCache.GetUpdateDistance ();
+}
+
+bool
+MmWaveLosTracker::IsLos (Ptr<MobilityModel> a, Ptr<MobilityModel> b)
+{
+	bool los;
+	if (!m_linkCache.Lookup (a, b, los))
+	{
+		los = !MmWaveBuildingsIndex::Get ()->IsLinkObstructed (a->GetPosition (), b->GetPosition ());
+		m_linkCache.Store (a, b, los);
+	}
+	return los;
+}
+
 void
 MmWaveLosTracker::UpdateLosNlosState(Ptr<MobilityModel> a, Ptr<MobilityModel> b)
 {
@@ -81,47 +120,7 @@ MmWaveLosTracker::UpdateLosNlosState(Ptr<MobilityModel> a, Ptr<MobilityModel> b)
 
 
 	/*Determine LOS or NLOS*/
-	bool los = true;
-	for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
-	{
-		Box boundaries = (*bit)->GetBoundaries ();
-		Vector locationA = a->GetPosition ();
-		Vector locationB = b->GetPosition ();
-		Angles pathAngles (locationB, locationA);
-		double angle = pathAngles.phi;
-		if (angle >= M_PI/2 || angle < -M_PI/2)
-		{
-			locationA = b->GetPosition ();
-			locationB = a->GetPosition ();
-			Angles pathAngles (locationB, locationA);
-			angle = pathAngles.phi;
-		}
-
-		if (angle >=0 && angle < M_PI/2 )
-		{
-			Vector loc1(boundaries.xMax,boundaries.yMin,boundaries.zMin);
-			Vector loc2(boundaries.xMin,boundaries.yMax,boundaries.zMin);
-			Angles angles1 (loc1,locationA);
-			Angles angles2 (loc2,locationA);
-			if (angle > angles1.phi && angle < angles2.phi && locationB.x > boundaries.xMin && locationB.y > boundaries.yMin)
-			{
-				los = false;
-				break;
-			}
-		}
-		else if (angle >= -M_PI/2 && angle < 0)
-		{
-			Vector loc1(boundaries.xMin,boundaries.yMin,boundaries.zMin);
-			Vector loc2(boundaries.xMax,boundaries.yMax,boundaries.zMin);
-			Angles angles1 (loc1,locationA);
-			Angles angles2 (loc2,locationA);
-			if (angle > angles1.phi && angle < angles2.phi && locationB.x > boundaries.xMin && locationB.y < boundaries.yMax)
-			{
-				los = false;
-				break;
-			}
-		}
-	}
+	bool los = IsLos (a, b);
 
 
 	/*
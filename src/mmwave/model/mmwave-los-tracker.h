@@ -24,6 +24,7 @@
 
 #include <ns3/buildings-propagation-loss-model.h>
 #include <ns3/simulator.h>
+#include "mmwave-link-condition-cache.h"
 
 namespace ns3 {
 
@@ -42,8 +43,19 @@ public:
 	void UpdateLosNlosState (Ptr<MobilityModel> a, Ptr<MobilityModel> b);
 	int GetNlosSamples(Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
 	int GetLosSamples(Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+	/**
+	 *	Check if the link is LOS, reusing the last result while its ends do not move
+	 */
+	bool IsLos (Ptr<MobilityModel> a, Ptr<MobilityModel> b);
+
+	void SetUpdateDistance (double distance);
+	double GetUpdateDistance () const;
+
+protected:
+	virtual void DoDispose ();
 
 private:
+	MmWaveLinkConditionCache m_linkCache; // los/nlos of the links, shared with BuildingsObstaclePropagationLossModel
 	std::map< keyMob_t, int > m_mapNlos; // map for counting number of slots in NLOS for 'drop phase'
 	std::map< keyMob_t, int > m_mapLos; // map for counting number of slots in LOS for 'raise phase'
 };
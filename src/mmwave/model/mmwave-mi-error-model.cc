@@ -47,85 +47,97 @@ NS_LOG_COMPONENT_DEFINE ("MmWaveMiErrorModel");
 
 namespace ns3 {
 
-    double 
-    MmWaveMiErrorModel::Mib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs)
+    /**
+     * MI of one RB, given the table of its modulation. Since the values of the table axis
+     * are uniformly spaced, index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
+     */
+    static inline double
+    MiLookup (double sinrLin, const double *table, uint16_t size, double axisFirst, double axisLast, double scalingCoeff)
     {
-        NS_LOG_FUNCTION (sinr << &map << (uint32_t) mcs);
-  
-        double MI;
+        if (sinrLin > axisLast)
+        {
+            return 1;
+        }
+        double sinrIndexDouble = (sinrLin - axisFirst) * scalingCoeff + 1;
+        uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
+        NS_ASSERT_MSG (sinrIndex < size, "MI map out of data");
+        return table[sinrIndex];
+    }
+
+    double
+    MmWaveMiErrorModel::MiSum (const double *sinr, const int *map, uint32_t n, uint8_t mcs)
+    {
+        // the modulation is the same for all the RBs of the TB, so the table is selected once
+        const double *table;
+        const double *axis;
+        uint16_t size;
+        if (mcs <= MMWAVE_MI_QPSK_MAX_ID) // QPSK
+        {
+            table = MI_map_qpsk;
+            axis = MI_map_qpsk_axis;
+            size = MMWAVE_MI_MAP_QPSK_SIZE;
+        }
+        else if (mcs <= MMWAVE_MI_16QAM_MAX_ID) // 16-QAM
+        {
+            table = MI_map_16qam;
+            axis = MI_map_16qam_axis;
+            size = MMWAVE_MI_MAP_16QAM_SIZE;
+        }
+        else // 64-QAM
+        {
+            table = MI_map_64qam;
+            axis = MI_map_64qam_axis;
+            size = MMWAVE_MI_MAP_64QAM_SIZE;
+        }
+        const double axisFirst = axis[0];
+        const double axisLast = axis[size-1];
+        const double scalingCoeff = (size - 1) / (axisLast - axisFirst);
+
+        // the RBs are processed in blocks of 4: the SINRs are gathered first, then the
+        // lookups of the block are independent. The MIs are summed in the RB order, as
+        // done by the scalar loop, so that the result does not depend on the blocking
         double MIsum = 0.0;
-        SpectrumValue sinrCopy = sinr;
-  
-        for (uint32_t i = 0; i < map.size (); i++)
+        uint32_t i = 0;
+        for (; i + 4 <= n; i += 4)
         {
-            double sinrLin = sinrCopy[map.at (i)];
-            if (mcs <= MMWAVE_MI_QPSK_MAX_ID) // QPSK
+            double sinrLin[4];
+            double MI[4];
+            for (uint8_t k = 0; k < 4; k++)
+            {
+                sinrLin[k] = sinr[map[i+k]];
+            }
+            for (uint8_t k = 0; k < 4; k++)
             {
-		if (sinrLin > MI_map_qpsk_axis[MMWAVE_MI_MAP_QPSK_SIZE-1])
-                {
-                    MI = 1;
-                }
-                else 
-                { 
-                    // since the values in MI_map_qpsk_axis are uniformly spaced, we have
-                    // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-                    // the scaling coefficient is always the same, so we use a static const
-                    // to speed up the calculation
-                    static const double scalingCoeffQpsk = 
-                        (MMWAVE_MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MMWAVE_MI_MAP_QPSK_SIZE-1] - MI_map_qpsk_axis[0]);
-                    double sinrIndexDouble = (sinrLin -  MI_map_qpsk_axis[0]) * scalingCoeffQpsk + 1;
-                    uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-                    NS_ASSERT_MSG (sinrIndex < MMWAVE_MI_MAP_QPSK_SIZE, "MI map out of data");
-                    MI = MI_map_qpsk[sinrIndex];
-                }
+                MI[k] = MiLookup (sinrLin[k], table, size, axisFirst, axisLast, scalingCoeff);
             }
-            else
+            for (uint8_t k = 0; k < 4; k++)
             {
-                if (mcs > MMWAVE_MI_QPSK_MAX_ID && mcs <= MMWAVE_MI_16QAM_MAX_ID )	// 16-QAM
-                {
-                    if (sinrLin > MI_map_16qam_axis[MMWAVE_MI_MAP_16QAM_SIZE-1])
-                    {
-                        MI = 1;
-                    }
-                    else 
-                    {
-                        // since the values in MI_map_16QAM_axis are uniformly spaced, we have
-                        // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-                        // the scaling coefficient is always the same, so we use a static const
-                        // to speed up the calculation
-                        static const double scalingCoeff16qam = 
-                            (MMWAVE_MI_MAP_16QAM_SIZE - 1) / (MI_map_16qam_axis[MMWAVE_MI_MAP_16QAM_SIZE-1] - MI_map_16qam_axis[0]);
-                        double sinrIndexDouble = (sinrLin -  MI_map_16qam_axis[0]) * scalingCoeff16qam + 1;
-                        uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-                        NS_ASSERT_MSG (sinrIndex < MMWAVE_MI_MAP_16QAM_SIZE, "MI map out of data");
-                        MI = MI_map_16qam[sinrIndex];
-                    }
-                }
-                else // 64-QAM
-                {
-                    if (sinrLin > MI_map_64qam_axis[MMWAVE_MI_MAP_64QAM_SIZE-1])
-                    {
-                        MI = 1;
-                    }
-                    else
-                    {
-                        // since the values in MI_map_64QAM_axis are uniformly spaced, we have
-                        // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-                        // the scaling coefficient is always the same, so we use a static const
-                        // to speed up the calculation
-                        static const double scalingCoeff64qam = 
-                            (MMWAVE_MI_MAP_64QAM_SIZE - 1) / (MI_map_64qam_axis[MMWAVE_MI_MAP_64QAM_SIZE-1] - MI_map_64qam_axis[0]);
-                        double sinrIndexDouble = (sinrLin -  MI_map_64qam_axis[0]) * scalingCoeff64qam + 1;
-                        uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-                        NS_ASSERT_MSG (sinrIndex < MMWAVE_MI_MAP_64QAM_SIZE, "MI map out of data");
-                        MI = MI_map_64qam[sinrIndex];
-                    }
-                }
+                NS_LOG_LOGIC (" RB " << map[i+k] << "Minimum SNR = " << 10 * std::log10 (sinrLin[k]) << " dB, " << sinrLin[k] << " V, MCS = " << (uint16_t)mcs << ", MI = " << MI[k]);
+                MIsum += MI[k];
             }
-            NS_LOG_LOGIC (" RB " << map.at (i) << "Minimum SNR = " << 10 * std::log10 (sinrLin) << " dB, " << sinrLin << " V, MCS = " << (uint16_t)mcs << ", MI = " << MI);
+        }
+        for (; i < n; i++)
+        {
+            double sinrLin = sinr[map[i]];
+            double MI = MiLookup (sinrLin, table, size, axisFirst, axisLast, scalingCoeff);
+            NS_LOG_LOGIC (" RB " << map[i] << "Minimum SNR = " << 10 * std::log10 (sinrLin) << " dB, " << sinrLin << " V, MCS = " << (uint16_t)mcs << ", MI = " << MI);
             MIsum += MI;
         }
-        MI = MIsum / map.size ();  // Assume a flat response within the RB, thus, the overall MI of a TB is the average MI evaluated per RB in the TB. 
+        return MIsum;
+    }
+
+    double 
+    MmWaveMiErrorModel::Mib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs)
+    {
+        NS_LOG_FUNCTION (sinr << &map << (uint32_t) mcs);
+  
+        double MIsum = 0.0;
+        if (!map.empty ())
+        {
+            // the values are read in place, without copying the SpectrumValue
+            MIsum = MiSum (&(*sinr.ConstValuesBegin ()), &map[0], map.size (), mcs);
+        }
+        double MI = MIsum / map.size ();  // Assume a flat response within the RB, thus, the overall MI of a TB is the average MI evaluated per RB in the TB. 
         NS_LOG_LOGIC (" MI = " << MI);
         return MI;
     }
@@ -181,6 +193,14 @@ MmWaveMiErrorModel::MappingMiBler (double mib, uint8_t ecrId, uint32_t cbSize)
         NS_LOG_FUNCTION (sinr << &map << (uint32_t) size << (uint32_t) mcs);
 
         double tbMi = Mib(sinr, map, mcs);
+        return GetTbDecodificationStats (tbMi, size, mcs, miHistory);
+    }
+
+    MmWaveTbStats_t
+    MmWaveMiErrorModel::GetTbDecodificationStats (double tbMi, uint32_t size, uint8_t mcs, const MmWaveHarqProcessInfoList_t &miHistory)
+    {
+        NS_LOG_FUNCTION (tbMi << (uint32_t) size << (uint32_t) mcs);
+
         double MI = 0.0;
         double Reff = 0.0;
         NS_ASSERT (mcs < 29);
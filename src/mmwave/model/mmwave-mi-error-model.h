@@ -339,6 +339,15 @@ public:
    * \return the mmib
    */
   static double Mib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs);
+  /**
+   * \brief sum the mutual information of a set of RBs modulated with the same MCS
+   * \param sinr the linear sinrs of all the RBs
+   * \param map the RBs to be evaluated
+   * \param n the number of RBs in map
+   * \param mcs the MCS of the RBs
+   * \return the sum of the MI of the RBs
+   */
+  static double MiSum (const double *sinr, const int *map, uint32_t n, uint8_t mcs);
   /** 
    * \brief map the mmib (mean mutual information per bit) for different MCS
    * \param mib mean mutual information per bit of a code-block
@@ -358,6 +367,17 @@ public:
    */
   static MmWaveTbStats_t GetTbDecodificationStats (const SpectrumValue& sinr, const std::vector<int>& map, uint32_t size, uint8_t mcs, MmWaveHarqProcessInfoList_t miHistory);
 
+  /**
+   * \brief run the error-model algorithm for the specified TB, whose MI was already
+   * evaluated with Mib (the MI only depends on the modulation order of the MCS)
+   * \param tbMi the mmib of the TB
+   * \param size the size in bytes of the TB
+   * \param mcs the MCS of the TB
+   * \param miHistory the MI of the previous transmissions of the TB
+   * \return the TB error rate and MI
+   */
+  static MmWaveTbStats_t GetTbDecodificationStats (double tbMi, uint32_t size, uint8_t mcs, const MmWaveHarqProcessInfoList_t &miHistory);
+
 
 //private:
 
@@ -38,10 +38,13 @@
 #include <list>
 #include <map>
 #include <deque>
+#include <algorithm>
+#include <ostream>
 #include <ns3/object.h>
 #include <ns3/packet.h>
 #include <ns3/string.h>
 #include <ns3/log.h>
+#include <ns3/abort.h>
 //#include "mmwave-mac-pdu-header.h"
 //#include "mmwave-mac-pdu-tag.h"
 
@@ -309,6 +312,141 @@ struct SfAllocInfo
     bool m_valid;
 };
 
+    /**
+     * \brief Busy symbols of a subframe, one bit per symbol (bit i of word i / 64
+     * is symbol i). The lookups used by the IAB schedulers to fit allocations
+     * around the resources already taken by the backhaul work on whole words
+     * with popcount and count-trailing-zeros, and the mask is copied without
+     * allocating.
+     */
+    class SymbolAllocationMask
+    {
+    public:
+	static const uint32_t MAX_SYMBOLS = 256;
+
+	SymbolAllocationMask () : m_numSymbols (0)
+	{
+	    Clear ();
+	}
+
+	SymbolAllocationMask (uint32_t numSymbols) : m_numSymbols (numSymbols)
+	{
+	    NS_ABORT_MSG_IF (numSymbols > MAX_SYMBOLS, "A subframe mask holds at most " << MAX_SYMBOLS
+			     << " symbols, " << numSymbols << " requested");
+	    Clear ();
+	}
+
+	uint32_t GetNumSymbols () const
+	{
+	    return m_numSymbols;
+	}
+
+	void Clear ()
+	{
+	    for (uint32_t i = 0; i < NUM_WORDS; i++)
+	    {
+		m_words[i] = 0;
+	    }
+	}
+
+	bool IsBusy (uint32_t index) const
+	{
+	    NS_ABORT_MSG_IF (index >= m_numSymbols, "Symbol " << index << " out of a mask of "
+			     << m_numSymbols << " symbols");
+	    return (m_words[index / 64] >> (index % 64)) & 1;
+	}
+
+	// mark the numSymbols symbols from start as busy
+	void SetBusy (uint32_t start, uint32_t numSymbols)
+	{
+	    // written so that start + numSymbols cannot wrap around
+	    NS_ABORT_MSG_IF (start > m_numSymbols || numSymbols > m_numSymbols - start, numSymbols
+			     << " symbols from " << start << " out of a mask of " << m_numSymbols << " symbols");
+	    uint32_t end = start + numSymbols;
+	    for (uint32_t i = start / 64; i * 64 < end; i++)
+	    {
+		m_words[i] |= WordRange (i, start, end);
+	    }
+	}
+
+	uint32_t GetNumBusySymbols () const
+	{
+	    uint32_t count = 0;
+	    for (uint32_t i = 0; i < NUM_WORDS; i++)
+	    {
+		count += __builtin_popcountll (m_words[i]);
+	    }
+	    return count;
+	}
+
+	// true if any of the numSymbols symbols from start (within the subframe) is busy
+	bool Overlaps (uint32_t start, uint32_t numSymbols) const
+	{
+	    uint32_t end = std::min (start + numSymbols, m_numSymbols);
+	    return Find (true, start, end) < end;
+	}
+
+	// number of contiguous free symbols from start, at most numSymbols and within the subframe
+	uint32_t GetNumFreeSymbols (uint32_t start, uint32_t numSymbols) const
+	{
+	    uint32_t end = std::min (start + numSymbols, m_numSymbols);
+	    if (start >= end)
+	    {
+		return 0;
+	    }
+	    return Find (true, start, end) - start;
+	}
+
+	// index of the first free symbol from start, or start if it is past the last symbol,
+	// or the number of symbols if there is none
+	uint32_t GetFirstFreeSymbol (uint32_t start) const
+	{
+	    if (start >= m_numSymbols)
+	    {
+		return start;
+	    }
+	    return Find (false, start, m_numSymbols);
+	}
+
+	friend std::ostream& operator << (std::ostream &os, const SymbolAllocationMask &mask)
+	{
+	    for (uint32_t index = 0; index < mask.m_numSymbols; index++)
+	    {
+		os << mask.IsBusy (index) << " ";
+	    }
+	    return os;
+	}
+
+    private:
+	static const uint32_t NUM_WORDS = MAX_SYMBOLS / 64;
+
+	// bits of word i within the symbols [begin, end)
+	static uint64_t WordRange (uint32_t i, uint32_t begin, uint32_t end)
+	{
+	    uint32_t lo = std::max (begin, i * 64) - i * 64;
+	    uint32_t hi = std::min (end, i * 64 + 64) - i * 64;
+	    uint64_t upTo = hi == 64 ? ~(uint64_t)0 : (((uint64_t)1 << hi) - 1);
+	    return upTo & ~(((uint64_t)1 << lo) - 1);
+	}
+
+	// first busy (or free) symbol in [begin, end), end if there is none
+	uint32_t Find (bool busy, uint32_t begin, uint32_t end) const
+	{
+	    for (uint32_t i = begin / 64; i * 64 < end; i++)
+	    {
+		uint64_t word = (busy ? m_words[i] : ~m_words[i]) & WordRange (i, begin, end);
+		if (word != 0)
+		{
+		    return i * 64 + __builtin_ctzll (word);
+		}
+	    }
+	    return end;
+	}
+
+	uint32_t m_numSymbols;
+	uint64_t m_words[NUM_WORDS];
+    };
+
     struct SfIabAllocInfo
     {
 	SfIabAllocInfo () : m_sfnSf (SfnSf()), m_valid(true)
@@ -316,23 +454,20 @@ struct SfAllocInfo
 
 	}
 
-	SfIabAllocInfo (uint32_t size) : m_sfnSf (SfnSf()), m_valid(true)
+	SfIabAllocInfo (uint32_t size) : m_sfnSf (SfnSf()), m_symAllocationMask (size), m_valid(true)
 	{
-	    m_symAllocationMask = std::vector<bool>(size, false);
 	}
 
-	SfIabAllocInfo (SfnSf sfn, uint32_t size) : m_sfnSf (sfn), m_valid(true)
+	SfIabAllocInfo (SfnSf sfn, uint32_t size) : m_sfnSf (sfn), m_symAllocationMask (size), m_valid(true)
 	{
-	    m_symAllocationMask = std::vector<bool>(size, false);
 	}
 
-	SfIabAllocInfo (SfnSf sfn, bool valid, uint32_t size) : m_sfnSf (sfn), m_valid(valid)
+	SfIabAllocInfo (SfnSf sfn, bool valid, uint32_t size) : m_sfnSf (sfn), m_symAllocationMask (size), m_valid(valid)
 	{
-	    m_symAllocationMask = std::vector<bool>(size, false);
 	}
 
 	SfnSf m_sfnSf;
-	std::vector<bool> m_symAllocationMask; // vector of bools, 
+	SymbolAllocationMask m_symAllocationMask; // busy symbols of the subframe
 	// uint32_t m_ulNumSymAlloc;              // number of allocated slots in the IAB uplink
 	// uint32_t m_ulSymStart;		  // start of UL IAB region
 	// uint32_t m_dlNumSymAlloc;              // number of allocated slots in the IAB downlink
@@ -39,6 +39,10 @@
 #include "mmwave-phy-sap.h"
 #include "mmwave-mac-pdu-tag.h"
 #include "mmwave-mac-pdu-header.h"
+#include "mmwave-beamforming.h"
+#include "mmwave-channel-matrix.h"
+#include "mmwave-channel-raytracing.h"
+#include "mmwave-3gpp-channel.h"
 #include <sstream>
 #include <vector>
 
@@ -132,6 +136,7 @@ MmWavePhy::MmWavePhy(Ptr<MmWaveSpectrumPhy> dlChannelPhy, Ptr<MmWaveSpectrumPhy>
 	 m_sfNum (0),
 	 m_slotNum (0),
 	 m_sfAllocInfoUpdated (false),
+	 m_spectrumPropagationLossModelKind (OTHER_SPECTRUM_MODEL),
 	 m_schedulingDelay (0)
 {
 	NS_LOG_FUNCTION(this);
@@ -375,6 +380,26 @@ void
 MmWavePhy::AddSpectrumPropagationLossModel(Ptr<SpectrumPropagationLossModel> model)
 {
 	m_spectrumPropagationLossModel = model;
+	if (DynamicCast<MmWaveBeamforming> (model) != 0)
+	{
+		m_spectrumPropagationLossModelKind = BEAMFORMING_MODEL;
+	}
+	else if (DynamicCast<MmWaveChannelMatrix> (model) != 0)
+	{
+		m_spectrumPropagationLossModelKind = CHANNEL_MATRIX_MODEL;
+	}
+	else if (DynamicCast<MmWaveChannelRaytracing> (model) != 0)
+	{
+		m_spectrumPropagationLossModelKind = RAYTRACING_MODEL;
+	}
+	else if (DynamicCast<MmWave3gppChannel> (model) != 0)
+	{
+		m_spectrumPropagationLossModelKind = CHANNEL_3GPP_MODEL;
+	}
+	else
+	{
+		m_spectrumPropagationLossModelKind = OTHER_SPECTRUM_MODEL;
+	}
 }
 
 }
@@ -126,6 +126,19 @@ public:
 	void AddLosTracker(Ptr<MmWaveLosTracker>);
 
 protected:
+	/**
+	 * The mmWave channel model of m_spectrumPropagationLossModel, detected when it is set
+	 * so that the SINR estimation does not need to cast the model for every UE
+	 */
+	enum SpectrumPropagationLossModelKind
+	{
+		OTHER_SPECTRUM_MODEL = 0,
+		BEAMFORMING_MODEL,
+		CHANNEL_MATRIX_MODEL,
+		RAYTRACING_MODEL,
+		CHANNEL_3GPP_MODEL
+	};
+
 	Ptr<NetDevice> m_netDevice;
 
 	Ptr<MmWaveSpectrumPhy> m_spectrumPhy;
@@ -167,6 +180,7 @@ protected:
 
 	// hack to allow eNB to compute the SINR, periodically, without pilots 
 	Ptr<SpectrumPropagationLossModel> m_spectrumPropagationLossModel;
+	SpectrumPropagationLossModelKind m_spectrumPropagationLossModelKind;
 	Ptr<PropagationLossModel> m_propagationLoss;
 	Ptr<MmWaveLosTracker> m_losTracker;
 
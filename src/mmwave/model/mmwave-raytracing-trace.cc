@@ -0,0 +1,236 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+
+#include "mmwave-raytracing-trace.h"
+#include <ns3/log.h>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ns3{
+
+NS_LOG_COMPONENT_DEFINE ("RaytracingTrace");
+
+const char RaytracingTrace::MAGIC[8] = {'M', 'M', 'W', 'R', 'T', 'R', 'C', '1'};
+
+RaytracingTrace::RaytracingTrace ()
+	:m_numTraces (0),
+	 m_entries (0),
+	 m_data (0),
+	 m_mapping (0),
+	 m_mappingSize (0)
+{
+}
+
+RaytracingTrace::~RaytracingTrace ()
+{
+	Clear ();
+}
+
+void
+RaytracingTrace::Clear ()
+{
+	if (m_mapping != 0)
+	{
+		munmap (m_mapping, m_mappingSize);
+		m_mapping = 0;
+		m_mappingSize = 0;
+	}
+	m_textEntries.clear ();
+	m_textData.clear ();
+	m_numTraces = 0;
+	m_entries = 0;
+	m_data = 0;
+}
+
+bool
+RaytracingTrace::Load (const std::string &filename)
+{
+	NS_LOG_FUNCTION (this << filename);
+	Clear ();
+
+	int fd = open (filename.c_str (), O_RDONLY);
+	if (fd < 0)
+	{
+		NS_LOG_INFO ("Cannot open " << filename);
+		return false;
+	}
+	struct stat st;
+	Header header;
+	bool binary = fstat (fd, &st) == 0
+			&& static_cast<std::size_t> (st.st_size) >= sizeof (Header)
+			&& pread (fd, &header, sizeof (Header), 0) == sizeof (Header)
+			&& std::memcmp (header.m_magic, MAGIC, sizeof (MAGIC)) == 0;
+
+	bool ok;
+	if (binary)
+	{
+		ok = LoadBinary (fd, st.st_size);
+	}
+	else
+	{
+		ok = LoadText (filename);
+	}
+	close (fd);
+	return ok;
+}
+
+bool
+RaytracingTrace::LoadBinary (int fd, std::size_t size)
+{
+	void *mapping = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		NS_LOG_INFO ("mmap failed");
+		return false;
+	}
+
+	const Header *header = static_cast<const Header*> (mapping);
+	std::size_t dataStart = sizeof (Header) + header->m_numTraces * sizeof (TraceEntry);
+	if (header->m_byteOrder != BYTE_ORDER_MARK || size < dataStart)
+	{
+		NS_LOG_INFO ("Malformed binary trace file");
+		munmap (mapping, size);
+		return false;
+	}
+
+	const TraceEntry *entries = reinterpret_cast<const TraceEntry*> (
+			static_cast<const char*> (mapping) + sizeof (Header));
+	std::size_t dataSize = (size - dataStart) / sizeof (double);
+	for (uint32_t i = 0; i < header->m_numTraces; i++)
+	{
+		for (uint8_t row = 0; row < NUM_ROWS; row++)
+		{
+			if (entries[i].m_offset[row] + entries[i].m_rowLength[row] > dataSize)
+			{
+				NS_LOG_INFO ("Trace " << i << " exceeds the size of the file");
+				munmap (mapping, size);
+				return false;
+			}
+		}
+	}
+
+	m_mapping = mapping;
+	m_mappingSize = size;
+	m_numTraces = header->m_numTraces;
+	m_entries = entries;
+	m_data = reinterpret_cast<const double*> (static_cast<const char*> (mapping) + dataStart);
+	NS_LOG_INFO ("Mapped " << m_numTraces << " traces");
+	return true;
+}
+
+bool
+RaytracingTrace::LoadText (const std::string &filename)
+{
+	std::ifstream file (filename.c_str (), std::ifstream::in);
+	if (!file.good ())
+	{
+		return false;
+	}
+
+	std::string line;
+	std::string token;
+	uint16_t counter = 0;
+	TraceEntry entry;
+	std::memset (&entry, 0, sizeof (TraceEntry));
+	while (std::getline (file, line)) //Parse each line of the file
+	{
+		uint64_t offset = m_textData.size ();
+		std::istringstream stream (line);
+		while (getline (stream, token, ',')) //Parse each comma separated string in a line
+		{
+			double value = 0.00;
+			std::stringstream valueStream (token);
+			valueStream >> value;
+			m_textData.push_back (value);
+		}
+
+		if (counter == 0)
+		{
+			if (m_textData.size () == offset)
+			{
+				NS_LOG_INFO ("Missing number of paths");
+				Clear ();
+				return false;
+			}
+			entry.m_numPaths = m_textData.back ();
+			m_textData.resize (offset);
+		}
+		else
+		{
+			entry.m_offset[counter - 1] = offset;
+			entry.m_rowLength[counter - 1] = m_textData.size () - offset;
+		}
+
+		if (++counter == NUM_ROWS + 1)
+		{
+			m_textEntries.push_back (entry);
+			counter = 0;
+		}
+	}
+
+	m_numTraces = m_textEntries.size ();
+	m_entries = m_textEntries.empty () ? 0 : &m_textEntries[0];
+	m_data = m_textData.empty () ? 0 : &m_textData[0];
+	NS_LOG_INFO ("Parsed " << m_numTraces << " traces");
+	return true;
+}
+
+bool
+RaytracingTrace::ConvertTextFile (const std::string &textFile, const std::string &binaryFile)
+{
+	NS_LOG_FUNCTION (textFile << binaryFile);
+	RaytracingTrace trace;
+	if (!trace.LoadText (textFile))
+	{
+		return false;
+	}
+
+	Header header;
+	std::memcpy (header.m_magic, MAGIC, sizeof (MAGIC));
+	header.m_byteOrder = BYTE_ORDER_MARK;
+	header.m_numTraces = trace.m_numTraces;
+
+	std::ofstream file (binaryFile.c_str (), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	file.write (reinterpret_cast<const char*> (&header), sizeof (Header));
+	if (!trace.m_textEntries.empty ())
+	{
+		file.write (reinterpret_cast<const char*> (&trace.m_textEntries[0]),
+				trace.m_textEntries.size () * sizeof (TraceEntry));
+	}
+	if (!trace.m_textData.empty ())
+	{
+		file.write (reinterpret_cast<const char*> (&trace.m_textData[0]),
+				trace.m_textData.size () * sizeof (double));
+	}
+	file.close ();
+	return !file.fail ();
+}
+
+}  //namespace ns3
@@ -0,0 +1,173 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *   Author: Marco Mezzavilla < mezzavilla@nyu.edu>
+ *        	 Sourjya Dutta <sdutta@nyu.edu>
+ *        	 Russell Ford <russell.ford@nyu.edu>
+ *        	 Menglei Zhang <menglei@nyu.edu>
+ */
+
+
+#ifndef MMWAVE_RAYTRACING_TRACE_H_
+#define MMWAVE_RAYTRACING_TRACE_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+namespace ns3{
+
+/**
+ * \brief Read-only store of the ray-tracing traces used by MmWaveChannelRaytracing.
+ *
+ * Every trace describes the multipath components of one position of the receiver
+ * with 8 rows: the number of paths, then the delay (ns), pathloss (dB), phase,
+ * AoD elevation, AoD azimuth, AoA elevation and AoA azimuth (degrees) of every path.
+ *
+ * The traces are read either from the original text file (8 comma-separated lines
+ * per trace) or from a binary file produced by ConvertTextFile. The binary file is
+ * memory mapped and the rows are returned as pointers into the mapping, so that
+ * loading it does not parse or copy anything and concurrent simulations on the
+ * same host share the same pages.
+ *
+ * Binary layout (native byte order, every field aligned to 8 bytes):
+ *   - header: magic "MMWRTRC1", byte order mark (uint32), number of traces (uint32)
+ *   - trace table: one TraceEntry per trace
+ *   - data: the rows of every trace, as contiguous arrays of doubles
+ */
+class RaytracingTrace
+{
+public:
+	enum Row
+	{
+		DELAY = 0,
+		PATHLOSS,
+		PHASE,
+		AOD_ELEVATION,
+		AOD_AZIMUTH,
+		AOA_ELEVATION,
+		AOA_AZIMUTH,
+		NUM_ROWS
+	};
+
+	RaytracingTrace ();
+	~RaytracingTrace ();
+
+	/**
+	 * Load a trace file, memory mapping it if it is in the binary format and parsing
+	 * it otherwise. Any previously loaded trace is released.
+	 * @params the name of the file
+	 * @returns false if the file could not be opened or is malformed
+	 */
+	bool Load (const std::string &filename);
+
+	/**
+	 * Release the loaded traces
+	 */
+	void Clear ();
+
+	bool IsMapped () const
+	{
+		return m_mapping != 0;
+	}
+
+	uint32_t GetNumTraces () const
+	{
+		return m_numTraces;
+	}
+
+	/**
+	 * @params the trace index
+	 * @returns the number of paths of the trace
+	 */
+	uint32_t GetNumPaths (uint32_t traceIndex) const
+	{
+		return m_entries[traceIndex].m_numPaths;
+	}
+
+	/**
+	 * @params the trace index
+	 * @params the row
+	 * @returns the number of values stored in the row
+	 */
+	uint32_t GetRowLength (uint32_t traceIndex, Row row) const
+	{
+		return m_entries[traceIndex].m_rowLength[row];
+	}
+
+	/**
+	 * @params the trace index
+	 * @params the row
+	 * @returns a pointer to the GetRowLength values of the row, valid until the
+	 * traces are released
+	 */
+	const double* GetRow (uint32_t traceIndex, Row row) const
+	{
+		return m_data + m_entries[traceIndex].m_offset[row];
+	}
+
+	/**
+	 * Convert a text trace file to the binary format
+	 * @params the name of the text file
+	 * @params the name of the binary file to be written
+	 * @returns false if the text file could not be read or the binary file written
+	 */
+	static bool ConvertTextFile (const std::string &textFile, const std::string &binaryFile);
+
+private:
+	struct TraceEntry
+	{
+		uint64_t m_offset[NUM_ROWS]; // offset of each row in the data section, in doubles
+		uint32_t m_rowLength[NUM_ROWS];
+		uint32_t m_numPaths;
+	};
+
+	struct Header
+	{
+		char m_magic[8];
+		uint32_t m_byteOrder;
+		uint32_t m_numTraces;
+	};
+
+	RaytracingTrace (const RaytracingTrace &);
+	RaytracingTrace& operator= (const RaytracingTrace &);
+
+	bool LoadBinary (int fd, std::size_t size);
+	bool LoadText (const std::string &filename);
+
+	static const char MAGIC[8];
+	static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	uint32_t m_numTraces;
+	const TraceEntry *m_entries;
+	const double *m_data;
+
+	// memory mapped binary file
+	void *m_mapping;
+	std::size_t m_mappingSize;
+
+	// storage of the traces parsed from a text file
+	std::vector<TraceEntry> m_textEntries;
+	std::vector<double> m_textData;
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_RAYTRACING_TRACE_H_ */
@@ -0,0 +1,150 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   Copyright (c) 2015, NYU WIRELESS, Tandon School of Engineering, New York University
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MMWAVE_RING_BUFFER_H_
+#define MMWAVE_RING_BUFFER_H_
+
+#include <ns3/assert.h>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3{
+
+/**
+ * \brief FIFO queue of at most a fixed number of values, stored in a circular
+ * buffer. When the queue is full, pushing a new value drops the oldest one.
+ *
+ * The storage is allocated at the first push and then reused, so a queue
+ * which is refilled at every report does not allocate in the steady state.
+ */
+template <typename T>
+class MmWaveRingBuffer
+{
+public:
+	/**
+	 * @params the maximum number of values kept
+	 */
+	explicit MmWaveRingBuffer (uint32_t capacity)
+		:m_capacity (capacity),
+		 m_head (0),
+		 m_size (0)
+	{
+		NS_ASSERT (capacity > 0);
+	}
+
+	bool empty () const
+	{
+		return m_size == 0;
+	}
+
+	uint32_t size () const
+	{
+		return m_size;
+	}
+
+	uint32_t capacity () const
+	{
+		return m_capacity;
+	}
+
+	void clear ()
+	{
+		m_head = 0;
+		m_size = 0;
+	}
+
+	/**
+	 * Append a value, dropping the oldest one if the queue is full
+	 */
+	void push_back (const T &value)
+	{
+		if (m_data.empty ())
+		{
+			m_data.resize (m_capacity);
+		}
+		if (m_size < m_capacity)
+		{
+			m_data[Index (m_size)] = value;
+			m_size++;
+		}
+		else
+		{
+			m_data[m_head] = value;
+			m_head = Index (1);
+		}
+	}
+
+	void pop_front ()
+	{
+		NS_ASSERT (m_size > 0);
+		m_head = Index (1);
+		m_size--;
+	}
+
+	T& front ()
+	{
+		NS_ASSERT (m_size > 0);
+		return m_data[m_head];
+	}
+
+	const T& front () const
+	{
+		NS_ASSERT (m_size > 0);
+		return m_data[m_head];
+	}
+
+	T& back ()
+	{
+		NS_ASSERT (m_size > 0);
+		return m_data[Index (m_size - 1)];
+	}
+
+	const T& back () const
+	{
+		NS_ASSERT (m_size > 0);
+		return m_data[Index (m_size - 1)];
+	}
+
+	/**
+	 * @params position from the oldest value
+	 */
+	const T& operator[] (uint32_t i) const
+	{
+		NS_ASSERT (i < m_size);
+		return m_data[Index (i)];
+	}
+
+private:
+	uint32_t Index (uint32_t i) const
+	{
+		uint32_t index = m_head + i;
+		return index < m_capacity ? index : index - m_capacity;
+	}
+
+	uint32_t m_capacity;
+	uint32_t m_head;	// index of the oldest value
+	uint32_t m_size;
+	std::vector<T> m_data;
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_RING_BUFFER_H_ */
@@ -164,24 +164,26 @@ namespace ns3 {
     {
         m_device = d;
 
-        Ptr<MmWaveEnbNetDevice> enbNetDev = DynamicCast<MmWaveEnbNetDevice> (GetDevice ());
-        Ptr<MmWaveIabNetDevice> iabNetDev = DynamicCast<MmWaveIabNetDevice> (GetDevice ());
-        Ptr<MmWaveUeNetDevice> ueNetDev = DynamicCast<MmWaveUeNetDevice> (GetDevice ());
-        Ptr<McUeNetDevice> mcNetDev = DynamicCast<McUeNetDevice> (GetDevice ());
-
-        if(enbNetDev != 0)
+        // the kind of device is resolved here once, the receive path only
+        // switches on m_deviceType and uses the typed pointers
+        m_enbDevice = DynamicCast<MmWaveEnbNetDevice> (GetDevice ());
+        m_iabDevice = DynamicCast<MmWaveIabNetDevice> (GetDevice ());
+        m_ueDevice = DynamicCast<MmWaveUeNetDevice> (GetDevice ());
+        m_mcUeDevice = DynamicCast<McUeNetDevice> (GetDevice ());
+
+        if(m_enbDevice != 0)
         {
 	    m_deviceType = ENB;
         }
-        else if(iabNetDev != 0)
+        else if(m_iabDevice != 0)
         {
 	    m_deviceType = IAB;
         }
-        else if(ueNetDev != 0)
+        else if(m_ueDevice != 0)
         {
 	    m_deviceType = UE;
         }
-        else if(mcNetDev != 0)
+        else if(m_mcUeDevice != 0)
         {
 	    m_deviceType = MCUE;
         }
@@ -329,83 +331,102 @@ MmWaveSpectrumPhy::AddExpectedTb (uint16_t rnti, uint16_t size, uint8_t mcs, std
         m_phyUlHarqFeedbackCallback = c;
     }
 
-    void
-    MmWaveSpectrumPhy::StartRx (Ptr<SpectrumSignalParameters> params)
+    bool
+    MmWaveSpectrumPhy::IsNeglectedTransmission (Ptr<SpectrumPhy> spectrumPhy)
     {
-        NS_LOG_FUNCTION(this);
-        // Get the transmit device info.
-        Ptr<MmWaveEnbNetDevice> EnbTx  = DynamicCast<MmWaveEnbNetDevice> (params->txPhy->GetDevice ());
-        Ptr<MmWaveUeNetDevice>  UeTx   = DynamicCast<MmWaveUeNetDevice> (params->txPhy->GetDevice ());
-        Ptr<McUeNetDevice>      McUeTx = DynamicCast<McUeNetDevice> (params->txPhy->GetDevice ());
-        Ptr<MmWaveIabNetDevice> iabTx  = DynamicCast<MmWaveIabNetDevice> (params->txPhy->GetDevice ());
-
-        if(GetDeviceType() == ENB && EnbTx != 0)
-        {
-	    // eNB to eNB, skip
-	    NS_LOG_INFO ("BS to BS or UE to UE transmission neglected.");
-	    return;
-        }
-        else if(GetDeviceType() == UE && UeTx != 0)
-        {
-	    // UE to UE, skip
-	    NS_LOG_INFO ("BS to BS or UE to UE transmission neglected.");
-	    return;
-        }
-        else if(GetDeviceType() == MCUE && McUeTx != 0)
-        {
-	    // MC to MC, skip
-	    NS_LOG_INFO ("BS to BS or UE to UE transmission neglected.");
-	    return;
-        }
-        else if(GetDeviceType() == IAB && (m_device == iabTx)) // check that this is not a TX of the same IAB device and for now discard it
+        // the kinds of both devices were resolved in SetDevice, so this is a
+        // switch on the receiver kind rather than a chain of casts of the devices
+        Ptr<MmWaveSpectrumPhy> txPhy = DynamicCast<MmWaveSpectrumPhy> (spectrumPhy);
+        if (txPhy == 0)
         {
-	    // transmisssion and reception in the same device, skip it!
-	    NS_LOG_INFO ("Transmission and reception in the SAME IAB neglected. Tx spectrum phy " << params->txPhy << " " <<  Simulator::Now().GetSeconds());
-	    return;
+	    return false;
         }
-        else
+
+        DeviceType_t txType = txPhy->GetDeviceType ();
+        // the following are not valid options
+        // eNB to eNB, UE to UE, MC UE to MC UE
+        // IAB backhaul to IAB backhaul
+        // IAB access to IAB access
+        // eNB access to IAB access
+        // IAB access to eNB access
+        // UE to IAB backhaul
+        // IAB backhaul to UE
+        switch (m_deviceType)
         {
-	    // the following are not valid options
-	    // IAB backhaul to IAB backhaul
-	    // IAB access to IAB access
-	    // eNB access to IAB access
-	    // IAB access to eNB access
-	    // UE to IAB backhaul
-	    // IAB backhaul to UE
-            if(iabTx && !(DynamicCast<MmWaveSpectrumPhy>(params->txPhy)->GetAccessSpectrumPhy()) && (GetDeviceType() == UE || GetDeviceType() == MCUE))
+        case ENB:
+	    if (txType == ENB)
 	    {
-	        // the TX is an IAB device in the backhaul and the RX is an UE, do not receive the ctrl
-	        NS_LOG_INFO("IAB backhaul to UE - neglect"<< " " <<  Simulator::Now().GetSeconds());
-	        return;
+		NS_LOG_INFO ("BS to BS or UE to UE transmission neglected.");
+		return true;
 	    }
-	    else if(iabTx && !(DynamicCast<MmWaveSpectrumPhy>(params->txPhy)->GetAccessSpectrumPhy()) && GetDeviceType() == IAB && !GetAccessSpectrumPhy())
+	    if (txType == IAB && txPhy->GetAccessSpectrumPhy ())
 	    {
-	        NS_LOG_INFO("IAB backhaul to IAB backhaul - neglect"<< " " <<  Simulator::Now().GetSeconds());
-	        return;
+		NS_LOG_INFO("IAB access to eNB access - neglect" << " " <<  Simulator::Now().GetSeconds());
+		return true;
 	    }
-	    else if((GetDeviceType() == IAB) && !GetAccessSpectrumPhy() && (UeTx || McUeTx))
+	    break;
+        case UE:
+        case MCUE:
+	    if (txType == m_deviceType)
 	    {
-	        // the TX is an UE and the RX is the IAB in backhaul, ignore
-	        NS_LOG_INFO(this << " UE to IAB backhaul - neglect " << GetAccessSpectrumPhy() << " " <<  Simulator::Now().GetSeconds());
-	        return;
+		NS_LOG_INFO ("BS to BS or UE to UE transmission neglected.");
+		return true;
 	    }
-	    else if(iabTx && (DynamicCast<MmWaveSpectrumPhy>(params->txPhy)->GetAccessSpectrumPhy()) && GetDeviceType() == IAB && GetAccessSpectrumPhy())
+	    if (txType == IAB && !txPhy->GetAccessSpectrumPhy ())
+	    {
+		// the TX is an IAB device in the backhaul and the RX is an UE, do not receive the ctrl
+		NS_LOG_INFO("IAB backhaul to UE - neglect"<< " " <<  Simulator::Now().GetSeconds());
+		return true;
+	    }
+	    break;
+        case IAB:
+	    if (txPhy->m_device == m_device) // check that this is not a TX of the same IAB device and for now discard it
 	    {
-	        NS_LOG_INFO("IAB access to IAB access - neglect" << " " <<  Simulator::Now().GetSeconds());
-	        return;
+		// transmisssion and reception in the same device, skip it!
+		NS_LOG_INFO ("Transmission and reception in the SAME IAB neglected. Tx spectrum phy " << txPhy << " " <<  Simulator::Now().GetSeconds());
+		return true;
 	    }
-	    else if(EnbTx && GetDeviceType() == IAB && GetAccessSpectrumPhy())
+	    if (!GetAccessSpectrumPhy ())
 	    {
-	        NS_LOG_INFO("eNB access to IAB access - neglect" << " " <<  Simulator::Now().GetSeconds());
-	        return;
+		if (txType == IAB && !txPhy->GetAccessSpectrumPhy ())
+		{
+		    NS_LOG_INFO("IAB backhaul to IAB backhaul - neglect"<< " " <<  Simulator::Now().GetSeconds());
+		    return true;
+		}
+		if (txType == UE || txType == MCUE)
+		{
+		    // the TX is an UE and the RX is the IAB in backhaul, ignore
+		    NS_LOG_INFO(this << " UE to IAB backhaul - neglect " << GetAccessSpectrumPhy() << " " <<  Simulator::Now().GetSeconds());
+		    return true;
+		}
 	    }
-	    else if(iabTx && (DynamicCast<MmWaveSpectrumPhy>(params->txPhy)->GetAccessSpectrumPhy()) && GetDeviceType() == ENB)
+	    else
 	    {
-	        NS_LOG_INFO("IAB access to eNB access - neglect" << " " <<  Simulator::Now().GetSeconds());
-	        return;
+		if (txType == IAB && txPhy->GetAccessSpectrumPhy ())
+		{
+		    NS_LOG_INFO("IAB access to IAB access - neglect" << " " <<  Simulator::Now().GetSeconds());
+		    return true;
+		}
+		if (txType == ENB)
+		{
+		    NS_LOG_INFO("eNB access to IAB access - neglect" << " " <<  Simulator::Now().GetSeconds());
+		    return true;
+		}
 	    }
+	    break;
         }
-    
+        return false;
+    }
+
+    void
+    MmWaveSpectrumPhy::StartRx (Ptr<SpectrumSignalParameters> params)
+    {
+        NS_LOG_FUNCTION(this);
+        if (IsNeglectedTransmission (params->txPhy))
+        {
+	    return;
+        }
+
         // other IAB to IAB can be valid
         Ptr<MmwaveSpectrumSignalParametersDataFrame> mmwaveDataRxParams = DynamicCast<MmwaveSpectrumSignalParametersDataFrame> (params);
     
@@ -417,7 +438,7 @@ MmWaveSpectrumPhy::AddExpectedTb (uint16_t rnti, uint16_t size, uint8_t mcs, std
 	    if(GetDeviceType() == UE)
 	    {
 	        // UE RX
-	        Ptr<MmWaveUeNetDevice> ueRx = DynamicCast<MmWaveUeNetDevice> (GetDevice ());
+	        Ptr<MmWaveUeNetDevice> ueRx = m_ueDevice;
 	        if ((ueRx!=0) && (ueRx->GetPhy ()->IsReceptionEnabled () == false))
 	        {  // if the first cast is 0 (the device is MC) then this if will not be executed
 		    isAllocated = false;
@@ -425,8 +446,7 @@ MmWaveSpectrumPhy::AddExpectedTb (uint16_t rnti, uint16_t size, uint8_t mcs, std
 	    }
 	    else if(GetDeviceType() == MCUE)
 	    {
-	        Ptr<McUeNetDevice> rxMcUe = 0;
-	        rxMcUe = DynamicCast<McUeNetDevice> (GetDevice ());
+	        Ptr<McUeNetDevice> rxMcUe = m_mcUeDevice;
 	        if ((rxMcUe != 0) && (rxMcUe->GetMmWavePhy()->IsReceptionEnabled() == false))
 	        {  // this is executed if the device is MC and is transmitting
 		    isAllocated = false;
@@ -435,8 +455,7 @@ MmWaveSpectrumPhy::AddExpectedTb (uint16_t rnti, uint16_t size, uint8_t mcs, std
 	    else if(GetDeviceType() == IAB)
 	    {
 	        // if the backhaul is transmitting, then set isAllocated to false
-	        Ptr<MmWaveIabNetDevice> rxIabDev = 0;
-	        rxIabDev = DynamicCast<MmWaveIabNetDevice> (GetDevice());
+	        Ptr<MmWaveIabNetDevice> rxIabDev = m_iabDevice;
 
 	        if(rxIabDev != 0)
 	        {
@@ -609,11 +628,7 @@ MmWaveSpectrumPhy::StartRxCtrl (Ptr<SpectrumSignalParameters> params)
 	    {
 		if(m_state == RX_CTRL)
 		{
-		    Ptr<MmWaveUeNetDevice> ueRx = DynamicCast<MmWaveUeNetDevice> (GetDevice ());
-		    Ptr<McUeNetDevice> rxMcUe =	DynamicCast<McUeNetDevice> (GetDevice ());
-		    Ptr<MmWaveIabNetDevice> rxIab = DynamicCast<MmWaveIabNetDevice> (GetDevice ());
-
-		    if (ueRx || rxMcUe || (rxIab && !GetAccessSpectrumPhy())) // need to check if the RX_CTRL is in the ACCESS PART, in this case it is ok
+		    if (m_deviceType == UE || m_deviceType == MCUE || (m_deviceType == IAB && !GetAccessSpectrumPhy())) // need to check if the RX_CTRL is in the ACCESS PART, in this case it is ok
 		    {
 			NS_FATAL_ERROR ("UE already receiving control data from serving cell");
 		    }
@@ -662,10 +677,10 @@ MmWaveSpectrumPhy::StartRxCtrl (Ptr<SpectrumSignalParameters> params)
 	    }
 	}
 
-	Ptr<MmWaveEnbNetDevice> enbRx = DynamicCast<MmWaveEnbNetDevice> (GetDevice ());
-	Ptr<MmWaveUeNetDevice> ueRx = DynamicCast<MmWaveUeNetDevice> (GetDevice ());
-	Ptr<McUeNetDevice> rxMcUe = DynamicCast<McUeNetDevice> (GetDevice ());
-	Ptr<MmWaveIabNetDevice> iabRx = DynamicCast<MmWaveIabNetDevice> (GetDevice ());
+	Ptr<MmWaveEnbNetDevice> enbRx = m_enbDevice;
+	Ptr<MmWaveUeNetDevice> ueRx = m_ueDevice;
+	Ptr<McUeNetDevice> rxMcUe = m_mcUeDevice;
+	Ptr<MmWaveIabNetDevice> iabRx = m_iabDevice;
 
 	NS_ASSERT(m_state = RX_DATA);
 	ExpectedTbMap_t::iterator itTb = m_expectedTbs.begin ();
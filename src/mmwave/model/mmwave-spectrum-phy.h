@@ -57,6 +57,11 @@
 
 namespace ns3{
 
+class MmWaveEnbNetDevice;
+class MmWaveUeNetDevice;
+class McUeNetDevice;
+class MmWaveIabNetDevice;
+
 struct ExpectedTbInfo_t
 {
   uint8_t ndi;
@@ -164,13 +169,24 @@ public:
 	void SetAccessSpectrumPhy ();
 	bool GetAccessSpectrumPhy ();
 
+	DeviceType_t GetDeviceType() const;
+
+	/**
+	 * \brief Check whether a signal has to be ignored by this PHY because of the
+	 * kinds of the transmitting and receiving devices (e.g., eNB to eNB, UE to UE,
+	 * IAB backhaul to UE or a transmission of the same IAB device).
+	 * Signals from a PHY which is not a MmWaveSpectrumPhy are never ignored.
+	 * @params the PHY which transmitted the signal
+	 * @returns true if the signal must not be received
+	 */
+	bool IsNeglectedTransmission (Ptr<SpectrumPhy> txPhy);
+
 
 private:
 	void ChangeState (State newState);
 	void EndTx ();
 	void EndRxData ();
 	void EndRxCtrl ();
-	DeviceType_t GetDeviceType() const;
 
 	Ptr<mmWaveInterference> m_interferenceData;
 	Ptr<MobilityModel> m_mobility;
@@ -219,6 +235,12 @@ private:
   	std::string m_fileName;
 
   	DeviceType_t m_deviceType;
+  	// m_device cast to its actual class once in SetDevice, only the one
+  	// matching m_deviceType is set
+  	Ptr<MmWaveEnbNetDevice> m_enbDevice;
+  	Ptr<MmWaveUeNetDevice> m_ueDevice;
+  	Ptr<McUeNetDevice> m_mcUeDevice;
+  	Ptr<MmWaveIabNetDevice> m_iabDevice;
 
 };
 
@@ -26,6 +26,7 @@
 #include <ns3/net-device.h>
 #include <ns3/node.h>
 #include <ns3/double.h>
+#include <ns3/boolean.h>
 #include <ns3/mobility-model.h>
 #include <ns3/spectrum-phy.h>
 #include <ns3/spectrum-converter.h>
@@ -36,6 +37,9 @@
 #include <ns3/angles.h>
 #include <iostream>
 #include <utility>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "multi-model-spectrum-channel.h"
 
 
@@ -81,6 +85,262 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 }
 
 
+ReceiverGrid::ReceiverGrid ()
+  : m_cellSize (0),
+    m_refreshTime (Seconds (-1))
+{
+}
+
+ReceiverGrid::ReceiverGrid (const ReceiverGrid &grid)
+  : m_cellSize (grid.m_cellSize),
+    m_refreshTime (grid.m_refreshTime)
+{
+  NS_ASSERT_MSG (grid.m_receivers.empty (), "a ReceiverGrid with receivers cannot be copied");
+}
+
+ReceiverGrid::~ReceiverGrid ()
+{
+  Clear ();
+}
+
+void
+ReceiverGrid::Clear ()
+{
+  for (std::map<Ptr<const MobilityModel>, std::vector<Ptr<SpectrumPhy> > >::iterator it = m_mobilityReceivers.begin ();
+       it != m_mobilityReceivers.end ();
+       ++it)
+    {
+      ConstCast<MobilityModel> (it->first)->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&ReceiverGrid::CourseChanged, this));
+    }
+  m_mobilityReceivers.clear ();
+  m_cells.clear ();
+  m_moving.clear ();
+  m_unlocated.clear ();
+  m_receivers.clear ();
+}
+
+void
+ReceiverGrid::Add (Ptr<SpectrumPhy> receiver)
+{
+  NS_LOG_FUNCTION (this << receiver);
+  std::pair<ReceiverMap_t::iterator, bool> ret = m_receivers.insert (std::make_pair (receiver, ReceiverInfo ()));
+  NS_ASSERT (ret.second);
+  if (!Locate (ret.first))
+    {
+      m_unlocated.insert (receiver);
+    }
+}
+
+void
+ReceiverGrid::Remove (Ptr<SpectrumPhy> receiver)
+{
+  NS_LOG_FUNCTION (this << receiver);
+  ReceiverMap_t::iterator it = m_receivers.find (receiver);
+  if (it == m_receivers.end ())
+    {
+      return;
+    }
+  m_unlocated.erase (receiver);
+  m_moving.erase (receiver);
+  Ptr<MobilityModel> mobility = it->second.m_mobility;
+  if (mobility)
+    {
+      if (m_cellSize > 0)
+        {
+          RemoveFromCell (it, it->second.m_cell);
+        }
+      std::map<Ptr<const MobilityModel>, std::vector<Ptr<SpectrumPhy> > >::iterator mobilityIt = m_mobilityReceivers.find (mobility);
+      NS_ASSERT (mobilityIt != m_mobilityReceivers.end ());
+      std::vector<Ptr<SpectrumPhy> > &receivers = mobilityIt->second;
+      receivers.erase (std::find (receivers.begin (), receivers.end (), receiver));
+      if (receivers.empty ())
+        {
+          mobility->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&ReceiverGrid::CourseChanged, this));
+          m_mobilityReceivers.erase (mobilityIt);
+        }
+    }
+  m_receivers.erase (it);
+}
+
+ReceiverGrid::CellId_t
+ReceiverGrid::GetCellId (const Vector &position) const
+{
+  return CellId_t (static_cast<int64_t> (std::floor (position.x / m_cellSize)),
+                   static_cast<int64_t> (std::floor (position.y / m_cellSize)));
+}
+
+bool
+ReceiverGrid::UpdatePosition (ReceiverMap_t::iterator receiver, bool placed)
+{
+  ReceiverInfo &info = receiver->second;
+  info.m_position = info.m_mobility->GetPosition ();
+  if (m_cellSize > 0)
+    {
+      CellId_t cell = GetCellId (info.m_position);
+      if (!placed || cell != info.m_cell)
+        {
+          if (placed)
+            {
+              RemoveFromCell (receiver, info.m_cell);
+            }
+          m_cells[cell].push_back (receiver);
+          info.m_cell = cell;
+        }
+    }
+  Vector velocity = info.m_mobility->GetVelocity ();
+  return velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+}
+
+bool
+ReceiverGrid::Locate (ReceiverMap_t::iterator receiver)
+{
+  Ptr<MobilityModel> mobility = receiver->first->GetMobility ();
+  if (!mobility)
+    {
+      return false;
+    }
+  receiver->second.m_mobility = mobility;
+  if (UpdatePosition (receiver, false))
+    {
+      m_moving.insert (receiver->first);
+    }
+  // registered after the first update, so that a course change notified
+  // while getting the position does not find the receiver out of its cell
+  std::vector<Ptr<SpectrumPhy> > &receivers = m_mobilityReceivers[mobility];
+  if (receivers.empty ())
+    {
+      mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&ReceiverGrid::CourseChanged, this));
+    }
+  receivers.push_back (receiver->first);
+  return true;
+}
+
+void
+ReceiverGrid::RemoveFromCell (ReceiverMap_t::iterator receiver, const CellId_t &cell)
+{
+  std::map<CellId_t, std::vector<ReceiverMap_t::iterator> >::iterator cellIt = m_cells.find (cell);
+  NS_ASSERT (cellIt != m_cells.end ());
+  std::vector<ReceiverMap_t::iterator> &receivers = cellIt->second;
+  std::vector<ReceiverMap_t::iterator>::iterator it = std::find (receivers.begin (), receivers.end (), receiver);
+  NS_ASSERT (it != receivers.end ());
+  // the order within a cell does not matter, Query sorts the candidates
+  *it = receivers.back ();
+  receivers.pop_back ();
+  if (receivers.empty ())
+    {
+      m_cells.erase (cellIt);
+    }
+}
+
+void
+ReceiverGrid::Build (double cellSize)
+{
+  NS_LOG_FUNCTION (this << cellSize);
+  NS_ASSERT (cellSize > 0);
+  m_cellSize = cellSize;
+  m_cells.clear ();
+  for (ReceiverMap_t::iterator it = m_receivers.begin (); it != m_receivers.end (); ++it)
+    {
+      if (it->second.m_mobility)
+        {
+          it->second.m_cell = GetCellId (it->second.m_position);
+          m_cells[it->second.m_cell].push_back (it);
+        }
+    }
+}
+
+void
+ReceiverGrid::Refresh ()
+{
+  Time now = Simulator::Now ();
+  if (now == m_refreshTime)
+    {
+      return;
+    }
+  m_refreshTime = now;
+
+  // receivers whose mobility model was set after they were added
+  for (std::set<Ptr<SpectrumPhy> >::iterator it = m_unlocated.begin (); it != m_unlocated.end (); )
+    {
+      if (Locate (m_receivers.find (*it)))
+        {
+          m_unlocated.erase (it++);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+
+  // a course change notified while getting a position may update m_moving,
+  // so the receivers to move are copied first
+  m_refreshed.assign (m_moving.begin (), m_moving.end ());
+  for (std::vector<Ptr<SpectrumPhy> >::const_iterator it = m_refreshed.begin (); it != m_refreshed.end (); ++it)
+    {
+      ReceiverMap_t::iterator receiver = m_receivers.find (*it);
+      if (receiver != m_receivers.end () && !UpdatePosition (receiver, true))
+        {
+          m_moving.erase (*it);
+        }
+    }
+}
+
+void
+ReceiverGrid::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  std::map<Ptr<const MobilityModel>, std::vector<Ptr<SpectrumPhy> > >::const_iterator mobilityIt = m_mobilityReceivers.find (mobility);
+  if (mobilityIt == m_mobilityReceivers.end ())
+    {
+      return;
+    }
+  for (std::vector<Ptr<SpectrumPhy> >::const_iterator it = mobilityIt->second.begin (); it != mobilityIt->second.end (); ++it)
+    {
+      if (UpdatePosition (m_receivers.find (*it), true))
+        {
+          m_moving.insert (*it);
+        }
+      else
+        {
+          m_moving.erase (*it);
+        }
+    }
+}
+
+void
+ReceiverGrid::Query (const Vector &position, double range, std::vector<Ptr<SpectrumPhy> > &candidates)
+{
+  NS_ASSERT (range > 0);
+  Refresh ();
+  if (range > m_cellSize)
+    {
+      Build (range);
+    }
+  candidates.assign (m_unlocated.begin (), m_unlocated.end ());
+  CellId_t center = GetCellId (position);
+  for (int64_t x = center.first - 1; x <= center.first + 1; ++x)
+    {
+      for (int64_t y = center.second - 1; y <= center.second + 1; ++y)
+        {
+          std::map<CellId_t, std::vector<ReceiverMap_t::iterator> >::const_iterator cell = m_cells.find (CellId_t (x, y));
+          if (cell == m_cells.end ())
+            {
+              continue;
+            }
+          for (std::vector<ReceiverMap_t::iterator>::const_iterator it = cell->second.begin (); it != cell->second.end (); ++it)
+            {
+              if (CalculateDistance (position, (*it)->second.m_position) <= range)
+                {
+                  candidates.push_back ((*it)->first);
+                }
+            }
+        }
+    }
+  // keep the order of the receiver set, so that the receptions are
+  // scheduled in the same order as without culling
+  std::sort (candidates.begin (), candidates.end ());
+}
+
+
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
 {
   NS_LOG_FUNCTION (this);
@@ -119,6 +379,36 @@ MultiModelSpectrumChannel::GetTypeId (void)
                    DoubleValue (1.0e9),
                    MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("ReceiverCulling",
+                   "If true, the receivers that are farther from the "
+                   "transmitter than the distance at which the free space "
+                   "loss, at the lowest frequency of the transmitted signal, "
+                   "reduced by MaxAntennaGainDb and CullingMarginDb, equals "
+                   "MaxLossDb, are discarded using a spatial index over the "
+                   "receiver positions, before copying the signal or "
+                   "evaluating the antenna gains and the propagation loss. "
+                   "The PathLoss trace is not fired for the discarded "
+                   "receivers. The positions of the receivers with a "
+                   "non-zero velocity are sampled at most once per "
+                   "simulation time instant, those of the others when "
+                   "their MobilityModel fires CourseChange. It has no "
+                   "effect unless MaxLossDb is set.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MultiModelSpectrumChannel::m_receiverCulling),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxAntennaGainDb",
+                   "Upper bound of the sum of the TX and RX antenna gains "
+                   "in dB, used by ReceiverCulling.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxAntennaGainDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("CullingMarginDb",
+                   "Maximum amount in dB by which the loss of the "
+                   "PropagationLossModel may be lower than the free space "
+                   "loss, e.g., due to shadowing, used by ReceiverCulling.",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_cullingMarginDb),
+                   MakeDoubleChecker<double> (0.0))
     .AddTraceSource ("PathLoss",
                      "This trace is fired whenever a new path loss value "
                      "is calculated. The first and second parameters "
@@ -163,6 +453,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
       if (phyIt !=  rxInfoIterator->second.m_rxPhySet.end ())
         {
           rxInfoIterator->second.m_rxPhySet.erase (phyIt);
+          rxInfoIterator->second.m_receiverGrid.Remove (phy);
           --m_numDevices;
           break; // there should be at most one entry
         }       
@@ -181,6 +472,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
       // also add the phy to the newly created set of SpectrumPhy for this RxSpectrumModel
       std::pair<std::set<Ptr<SpectrumPhy> >::iterator, bool> ret2 = ret.first->second.m_rxPhySet.insert (phy);
       NS_ASSERT (ret2.second);
+      ret.first->second.m_receiverGrid.Add (phy);
 
       // and create the necessary converters for all the TX spectrum models that we know of
       for (TxSpectrumModelInfoMap_t::iterator txInfoIterator = m_txSpectrumModelInfoMap.begin ();
@@ -205,10 +497,30 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
       // spectrum model is already known, just add the device to the corresponding list
       std::pair<std::set<Ptr<SpectrumPhy> >::iterator, bool> ret2 = rxInfoIterator->second.m_rxPhySet.insert (phy);
       NS_ASSERT (ret2.second);
+      rxInfoIterator->second.m_receiverGrid.Add (phy);
     }
 
 }
 
+void
+MultiModelSpectrumChannel::RemoveRx (Ptr<SpectrumPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  for (RxSpectrumModelInfoMap_t::iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
+       rxInfoIterator !=  m_rxSpectrumModelInfoMap.end ();
+       ++rxInfoIterator)
+    {
+      std::set<Ptr<SpectrumPhy> >::iterator phyIt = rxInfoIterator->second.m_rxPhySet.find (phy);
+      if (phyIt !=  rxInfoIterator->second.m_rxPhySet.end ())
+        {
+          rxInfoIterator->second.m_rxPhySet.erase (phyIt);
+          rxInfoIterator->second.m_receiverGrid.Remove (phy);
+          --m_numDevices;
+          break; // there should be at most one entry
+        }
+    }
+}
+
 
 TxSpectrumModelInfoMap_t::const_iterator
 MultiModelSpectrumChannel::FindAndEventuallyAddTxSpectrumModel (Ptr<const SpectrumModel> txSpectrumModel)
@@ -275,7 +587,14 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
-  for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
+  double cullingRange = GetCullingRange (txParams);
+  Vector txPosition;
+  if (cullingRange >= 0)
+    {
+      txPosition = txMobility->GetPosition ();
+    }
+
+  for (RxSpectrumModelInfoMap_t::iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
     {
@@ -301,6 +620,25 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
         }
 
 
+      if (cullingRange >= 0)
+        {
+          rxInfoIterator->second.m_receiverGrid.Query (txPosition, cullingRange, m_rxCandidates);
+          NS_LOG_LOGIC (m_rxCandidates.size () << " of " << rxInfoIterator->second.m_rxPhySet.size () << " receivers within " << cullingRange << " m");
+          for (std::vector<Ptr<SpectrumPhy> >::const_iterator candidateIterator = m_rxCandidates.begin ();
+               candidateIterator != m_rxCandidates.end ();
+               ++candidateIterator)
+            {
+              Ptr<SpectrumPhy> rxPhy = *candidateIterator;
+              NS_ASSERT_MSG (rxPhy->GetRxSpectrumModel ()->GetUid () == rxSpectrumModelUid,
+                             "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
+              if (rxPhy != txParams->txPhy)
+                {
+                  PropagateToReceiver (txParams, txMobility, convertedTxPowerSpectrum, rxPhy);
+                }
+            }
+          continue;
+        }
+
       for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
            rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
            ++rxPhyIterator)
@@ -310,77 +648,127 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
           if ((*rxPhyIterator) != txParams->txPhy)
             {
-              NS_LOG_LOGIC (" copying signal parameters " << txParams);
-              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
-              rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
-              Time delay = MicroSeconds (0);
+              PropagateToReceiver (txParams, txMobility, convertedTxPowerSpectrum, *rxPhyIterator);
+            }
+        }
 
-              Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+    }
 
-              if (txMobility && receiverMobility)
-                {
-                  double pathLossDb = 0;
-                  if (rxParams->txAntenna != 0)
-                    {
-                      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                      pathLossDb -= txAntennaGain;
-                    }
-                  Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-                  if (rxAntenna != 0)
-                    {
-                      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
-                      double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                      pathLossDb -= rxAntennaGain;
-                    }
-                  if (m_propagationLoss)
-                    {
-                      double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
-                      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                      pathLossDb -= propagationGainDb;
-                    }                    
-                  NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
-                  m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-                  if ( pathLossDb > m_maxLossDb)
-                    {
-                      // beyond range
-                      continue;
-                    }
-                  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-                  *(rxParams->psd) *= pathGainLinear;              
-
-                  if (m_spectrumPropagationLoss)
-                    {
-                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
-                    }
-
-                  if (m_propagationDelay)
-                    {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
-                    }
-                }
+}
 
-              Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-              if (netDev)
-                {
-                  // the receiver has a NetDevice, so we expect that it is attached to a Node
-                  uint32_t dstNode =  netDev->GetNode ()->GetId ();
-                  Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
-                                                  rxParams, *rxPhyIterator);
-                }
-              else
-                {
-                  // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-                  Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
-                                       rxParams, *rxPhyIterator);
-                }
-            }
+void
+MultiModelSpectrumChannel::PropagateToReceiver (Ptr<SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                                                Ptr<SpectrumValue> convertedTxPowerSpectrum, Ptr<SpectrumPhy> rxPhy)
+{
+  Time delay = MicroSeconds (0);
+  Ptr<SpectrumSignalParameters> rxParams;
+
+  Ptr<MobilityModel> receiverMobility = rxPhy->GetMobility ();
+
+  if (txMobility && receiverMobility)
+    {
+      double pathLossDb = 0;
+      if (txParams->txAntenna != 0)
+        {
+          Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
+          double txAntennaGain = txParams->txAntenna->GetGainDb (txAngles);
+          NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+          pathLossDb -= txAntennaGain;
+        }
+      Ptr<AntennaModel> rxAntenna = rxPhy->GetRxAntenna ();
+      if (rxAntenna != 0)
+        {
+          Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
+          double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+          NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+          pathLossDb -= rxAntennaGain;
+        }
+      if (m_propagationLoss)
+        {
+          double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
+          NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+          pathLossDb -= propagationGainDb;
+        }                    
+      NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
+      m_pathLossTrace (txParams->txPhy, rxPhy, pathLossDb);
+      if ( pathLossDb > m_maxLossDb)
+        {
+          // beyond range
+          return;
+        }
+
+      rxParams = CopySignalParameters (txParams, convertedTxPowerSpectrum);
+      double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+      *(rxParams->psd) *= pathGainLinear;              
+
+      if (m_spectrumPropagationLoss)
+        {
+          // the psd has just been copied for this receiver, so the loss can be applied in place
+          rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensityInPlace (rxParams->psd, txMobility, receiverMobility);
         }
 
+      if (m_propagationDelay)
+        {
+          delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+        }
+    }
+  else
+    {
+      rxParams = CopySignalParameters (txParams, convertedTxPowerSpectrum);
+    }
+
+  Ptr<NetDevice> netDev = rxPhy->GetDevice ();
+  if (netDev)
+    {
+      // the receiver has a NetDevice, so we expect that it is attached to a Node
+      uint32_t dstNode =  netDev->GetNode ()->GetId ();
+      Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
+                                      rxParams, rxPhy);
+    }
+  else
+    {
+      // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+      Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
+                           rxParams, rxPhy);
+    }
+}
+
+Ptr<SpectrumSignalParameters>
+MultiModelSpectrumChannel::CopySignalParameters (Ptr<SpectrumSignalParameters> txParams,
+                                                 Ptr<SpectrumValue> convertedTxPowerSpectrum) const
+{
+  NS_LOG_LOGIC (" copying signal parameters " << txParams);
+  // the copy of the parameters includes a copy of their psd, which can
+  // be used as it is unless the psd had to be converted
+  Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+  if (convertedTxPowerSpectrum != txParams->psd)
+    {
+      rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
     }
+  return rxParams;
+}
 
+double
+MultiModelSpectrumChannel::GetCullingRange (Ptr<const SpectrumSignalParameters> txParams) const
+{
+  if (!m_receiverCulling || !txParams->txPhy->GetMobility ())
+    {
+      return -1;
+    }
+  double minFrequency = txParams->psd->ConstBandsBegin ()->fl;
+  if (minFrequency <= 0)
+    {
+      return -1;
+    }
+  // free space loss: 20 log10 (4 pi d f / c)
+  static const double c = 299792458.0;
+  double range = c / (4 * M_PI * minFrequency)
+    * std::pow (10.0, (m_maxLossDb + m_maxAntennaGainDb + m_cullingMarginDb) / 20.0);
+  if (!(range < std::numeric_limits<double>::max ()))
+    {
+      return -1;
+    }
+  return range;
 }
 
 void
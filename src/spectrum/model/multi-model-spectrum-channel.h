@@ -27,8 +27,12 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/mobility-model.h>
+#include <ns3/vector.h>
+#include <ns3/nstime.h>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -65,6 +69,132 @@ public:
 typedef std::map<SpectrumModelUid_t, TxSpectrumModelInfo> TxSpectrumModelInfoMap_t;
 
 
+/**
+ * \ingroup spectrum
+ * Uniform grid over the positions of the receivers of one RX spectrum
+ * model, used by MultiModelSpectrumChannel to find the receivers that
+ * may be within range of a transmitter without visiting all of them.
+ *
+ * The grid is kept up to date as receivers are added and removed. A
+ * receiver changes cell when its MobilityModel fires CourseChange, and
+ * the receivers with a non-zero velocity are moved at most once per
+ * simulation time instant. The static receivers are never visited again.
+ */
+class ReceiverGrid
+{
+public:
+  ReceiverGrid ();
+  /**
+   * Copy an empty grid, e.g., into the RxSpectrumModelInfoMap_t. A grid
+   * with receivers cannot be copied, since it is registered to their
+   * mobility models.
+   * \param grid the grid to copy
+   */
+  ReceiverGrid (const ReceiverGrid &grid);
+  ~ReceiverGrid ();
+
+  /**
+   * Add a receiver to the grid.
+   * \param receiver the receiver
+   */
+  void Add (Ptr<SpectrumPhy> receiver);
+
+  /**
+   * Remove a receiver from the grid, if present.
+   * \param receiver the receiver
+   */
+  void Remove (Ptr<SpectrumPhy> receiver);
+
+  /**
+   * Remove all the receivers.
+   */
+  void Clear ();
+
+  /**
+   * Find the receivers that may be within a given range of a position.
+   * The receivers without a MobilityModel are always reported. The grid
+   * is only rebuilt if the range exceeds the current cell size.
+   *
+   * \param position the position of the transmitter
+   * \param range the range [m]
+   * \param candidates filled with the receivers, in the order of std::set<Ptr<SpectrumPhy> >
+   */
+  void Query (const Vector &position, double range, std::vector<Ptr<SpectrumPhy> > &candidates);
+
+private:
+  /// Not implemented, see the copy constructor
+  ReceiverGrid &operator= (const ReceiverGrid &);
+
+  /// Cell coordinates
+  typedef std::pair<int64_t, int64_t> CellId_t;
+
+  /// Position of a receiver and its cell
+  struct ReceiverInfo
+  {
+    Ptr<MobilityModel> m_mobility;  //!< Mobility model of the receiver, null if unlocated
+    Vector m_position;              //!< Last known position
+    CellId_t m_cell;                //!< Cell containing m_position, if m_cellSize > 0
+  };
+
+  /// Receivers and their position
+  typedef std::map<Ptr<SpectrumPhy>, ReceiverInfo> ReceiverMap_t;
+
+  /**
+   * \param position a position
+   * \return the cell containing the position
+   */
+  CellId_t GetCellId (const Vector &position) const;
+
+  /**
+   * Sample the position of a receiver and move it to the cell of that position.
+   * \param receiver the receiver and its info
+   * \param placed true if the receiver is already in the cell of its previous position
+   * \return true if the receiver has a non-zero velocity
+   */
+  bool UpdatePosition (ReceiverMap_t::iterator receiver, bool placed);
+
+  /**
+   * Start tracking the position of a receiver, if it has a mobility model.
+   * \param receiver the receiver and its info
+   * \return true if the receiver has a mobility model
+   */
+  bool Locate (ReceiverMap_t::iterator receiver);
+
+  /**
+   * \param receiver the receiver
+   * \param cell the cell to remove the receiver from
+   */
+  void RemoveFromCell (ReceiverMap_t::iterator receiver, const CellId_t &cell);
+
+  /**
+   * Put all the receivers in the cells of a new cell size.
+   * \param cellSize the cell size [m]
+   */
+  void Build (double cellSize);
+
+  /**
+   * Move the receivers with a non-zero velocity, and locate the receivers
+   * which got a mobility model, once per simulation time instant.
+   */
+  void Refresh ();
+
+  /**
+   * CourseChange trace sink of the mobility models of the receivers.
+   * \param mobility the mobility model
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+
+  double m_cellSize;                                            //!< Cell size [m], 0 until the first query
+  Time m_refreshTime;                                           //!< Time of the last refresh
+  ReceiverMap_t m_receivers;                                    //!< All the receivers
+  std::set<Ptr<SpectrumPhy> > m_unlocated;                      //!< Receivers without a MobilityModel
+  std::set<Ptr<SpectrumPhy> > m_moving;                         //!< Receivers with a non-zero velocity
+  std::vector<Ptr<SpectrumPhy> > m_refreshed;                   //!< Receivers being moved by Refresh
+  std::map<CellId_t, std::vector<ReceiverMap_t::iterator> > m_cells; //!< Receivers in each (x, y) cell
+  std::map<Ptr<const MobilityModel>, std::vector<Ptr<SpectrumPhy> > > m_mobilityReceivers; //!< Receivers of each tracked mobility model
+};
+
+
 /**
  * \ingroup spectrum
  * The Rx spectrum model information. This class is used to convert
@@ -81,6 +211,7 @@ public:
 
   Ptr<const SpectrumModel> m_rxSpectrumModel;  //!< Rx Spectrum model.
   std::set<Ptr<SpectrumPhy> > m_rxPhySet;      //!< Container of the Rx Spectrum phy objects.
+  ReceiverGrid m_receiverGrid;                 //!< Spatial index of m_rxPhySet, used for receiver culling.
 };
 
 /**
@@ -102,6 +233,15 @@ typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap
  * for this to work is that, after the SpectrumPhy switched its
  * SpectrumModel,  MultiModelSpectrumChannel::AddRx () is
  * called again passing the pointer to that SpectrumPhy.
+ *
+ * When the ReceiverCulling attribute is enabled, the receivers whose
+ * distance from the transmitter makes the free space loss, reduced by
+ * MaxAntennaGainDb and CullingMarginDb, exceed MaxLossDb are discarded
+ * before the signal parameters are copied and before any antenna gain
+ * or propagation loss is evaluated. The candidate receivers are looked
+ * up in a uniform grid over their positions, so that the cost of a
+ * transmission depends on the number of receivers in range rather than
+ * on the total number of receivers.
  */
 class MultiModelSpectrumChannel : public SpectrumChannel
 {
@@ -122,6 +262,12 @@ public:
   virtual void AddRx (Ptr<SpectrumPhy> phy);
   virtual void StartTx (Ptr<SpectrumSignalParameters> params);
 
+  /**
+   * Remove a SpectrumPhy from the receivers of the channel, if present.
+   * \param phy the SpectrumPhy instance to be removed
+   */
+  void RemoveRx (Ptr<SpectrumPhy> phy);
+
 
   // inherited from Channel
   virtual uint32_t GetNDevices (void) const;
@@ -158,6 +304,35 @@ private:
    */
   virtual void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /**
+   * Apply the propagation loss to a transmitted signal and schedule its
+   * reception by one receiver.
+   *
+   * \param txParams the parameters of the transmitted signal
+   * \param txMobility the mobility model of the transmitter
+   * \param convertedTxPowerSpectrum the transmitted PSD, converted to the receiver SpectrumModel
+   * \param rxPhy the receiver
+   */
+  void PropagateToReceiver (Ptr<SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                            Ptr<SpectrumValue> convertedTxPowerSpectrum, Ptr<SpectrumPhy> rxPhy);
+
+  /**
+   * Copy the signal parameters for one receiver.
+   *
+   * \param txParams the parameters of the transmitted signal
+   * \param convertedTxPowerSpectrum the transmitted PSD, converted to the receiver SpectrumModel
+   * \return the parameters, with an exclusively owned copy of convertedTxPowerSpectrum
+   */
+  Ptr<SpectrumSignalParameters> CopySignalParameters (Ptr<SpectrumSignalParameters> txParams,
+                                                      Ptr<SpectrumValue> convertedTxPowerSpectrum) const;
+
+  /**
+   * \param txParams the parameters of the transmitted signal
+   * \return the distance [m] beyond which the loss of the signal exceeds
+   * m_maxLossDb, or a negative value if receivers cannot be culled
+   */
+  double GetCullingRange (Ptr<const SpectrumSignalParameters> txParams) const;
+
   /**
    * Propagation delay model to be used with this channel.
    */
@@ -201,6 +376,28 @@ private:
    */
   double m_maxLossDb;
 
+  /**
+   * True if the receivers out of range are culled using the grid.
+   */
+  bool m_receiverCulling;
+
+  /**
+   * Upper bound of the sum of the TX and RX antenna gains [dB], used
+   * for receiver culling.
+   */
+  double m_maxAntennaGainDb;
+
+  /**
+   * Margin [dB] by which the propagation loss may be lower than the
+   * free space loss, used for receiver culling.
+   */
+  double m_cullingMarginDb;
+
+  /**
+   * Candidate receivers of the current transmission.
+   */
+  std::vector<Ptr<SpectrumPhy> > m_rxCandidates;
+
   /**
    * \deprecated The non-const \c Ptr<SpectrumPhy> argument
    * is deprecated and will be changed to \c Ptr<const SpectrumPhy>
@@ -73,4 +73,33 @@ SpectrumPropagationLossModel::CalcRxPowerSpectralDensity (Ptr<const SpectrumValu
   return rxPsd;
 }
 
+Ptr<SpectrumValue>
+SpectrumPropagationLossModel::CalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> psd,
+                                                                 Ptr<const MobilityModel> a,
+                                                                 Ptr<const MobilityModel> b) const
+{
+  Ptr<SpectrumValue> rxPsd = DoCalcRxPowerSpectralDensityInPlace (psd, a, b);
+  if (m_next != 0)
+    {
+      // only the psd of the caller is known to be exclusively owned
+      if (rxPsd == psd)
+        {
+          rxPsd = m_next->CalcRxPowerSpectralDensityInPlace (rxPsd, a, b);
+        }
+      else
+        {
+          rxPsd = m_next->CalcRxPowerSpectralDensity (rxPsd, a, b);
+        }
+    }
+  return rxPsd;
+}
+
+Ptr<SpectrumValue>
+SpectrumPropagationLossModel::DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> psd,
+                                                                   Ptr<const MobilityModel> a,
+                                                                   Ptr<const MobilityModel> b) const
+{
+  return DoCalcRxPowerSpectralDensity (psd, a, b);
+}
+
 } // namespace ns3
@@ -78,6 +78,25 @@ public:
                                                  Ptr<const MobilityModel> a,
                                                  Ptr<const MobilityModel> b) const;
 
+  /**
+   * Same as CalcRxPowerSpectralDensity, for a power spectral density
+   * which is owned by the caller and not referenced anywhere else,
+   * e.g., the copy made for a single receiver by a SpectrumChannel.
+   * Models may apply the loss in place instead of allocating a new
+   * SpectrumValue, hence the caller must use only the returned value
+   * after the call.
+   *
+   * @param psd the power spectral density of the transmission
+   * @param a sender mobility
+   * @param b receiver mobility
+   *
+   * @return set of values Vs frequency representing the received
+   * power, possibly psd itself.
+   */
+  Ptr<SpectrumValue> CalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> psd,
+                                                        Ptr<const MobilityModel> a,
+                                                        Ptr<const MobilityModel> b) const;
+
 protected:
   virtual void DoDispose ();
 
@@ -97,6 +116,22 @@ private:
                                                            Ptr<const MobilityModel> a,
                                                            Ptr<const MobilityModel> b) const = 0;
 
+  /**
+   * The default implementation calls DoCalcRxPowerSpectralDensity,
+   * models that can apply the loss in place override it.
+   *
+   * @param psd power spectral density of the transmission, owned by
+   * the caller and not referenced anywhere else.
+   * @param a sender mobility
+   * @param b receiver mobility
+   *
+   * @return set of values Vs frequency representing the received
+   * power, possibly psd itself.
+   */
+  virtual Ptr<SpectrumValue> DoCalcRxPowerSpectralDensityInPlace (Ptr<SpectrumValue> psd,
+                                                                  Ptr<const MobilityModel> a,
+                                                                  Ptr<const MobilityModel> b) const;
+
   Ptr<SpectrumPropagationLossModel> m_next; //!< SpectrumPropagationLossModel chained to this one.
 };
 